@@ -53,6 +53,12 @@ JamWideJuceProcessor::JamWideJuceProcessor()
     // User can switch to FLAC via codec selector in ConnectionBar
     client->config_autosubscribe = 1;
 
+    // Commands are applied by the run thread, which otherwise sleeps until
+    // socket/audio activity or its poll timeout (NJClient::WaitForActivity).
+    cmd_queue.set_notifier([](void* ctx) {
+        static_cast<NJClient*>(ctx)->WakeRunThread();
+    }, client.get());
+
     // OSC server (created after NJClient because it takes a processor reference
     // that may call getClient()). Does NOT start automatically -- user enables via dialog.
     oscServer = std::make_unique<OscServer>(*this);
@@ -72,6 +78,7 @@ JamWideJuceProcessor::~JamWideJuceProcessor()
     videoCompanion.reset();
     oscServer.reset();
     runThread.reset();
+    cmd_queue.set_notifier(nullptr, nullptr);
     client.reset();
 }
 
@@ -163,24 +170,24 @@ void JamWideJuceProcessor::prepareToPlay(double sampleRate, int samplesPerBlock)
     // Use samplesPerBlock from the host. AudioProc zeros the buffer internally.
     outputScratch.setSize(kTotalOutChannels, samplesPerBlock, false, true, false);
 
-    // 15.1-08 M-01 + Codex M-7: pre-grow NJClient::tmpblock so the audio
-    // thread (process_samples) never hits its `tmpblock.Resize` branch in
-    // steady state, AND assert the host's claimed bound is within
-    // jamwide::MAX_BLOCK_SAMPLES (the spsc_payloads BlockRecord contract).
-    // Throw is run-thread/UI-thread synchronous: it happens BEFORE any
-    // audio-thread call. JUCE may re-prepareToPlay with a different bound;
+    // Optional fixed render quantum: AudioProc then always runs on exactly
+    // `quantum` frames, whatever the host block size, at the cost of that
+    // many frames of latency, which the host compensates for.
+    const int quantum = juce::jlimit(0, kMaxRenderQuantum,
+                                     renderQuantumRequested.load(std::memory_order_relaxed));
+    renderQuantizer.configure(8, kTotalOutChannels, quantum);
+    renderQuantizerPrimed = false;
+    renderQuantumActive.store(quantum, std::memory_order_relaxed);
+    setLatencySamples(renderQuantizer.latency());
+
+    // 15.1-08 M-01: pre-grow NJClient::tmpblock so the audio thread
+    // (process_samples) never hits its `tmpblock.Resize` branch in steady
+    // state. There is no upper bound any more: the broadcast/wave sample
+    // FIFOs split large blocks, so any host block size is carried.
+    // JUCE may re-prepareToPlay with a different bound;
     // SetMaxAudioBlockSize is idempotent (Prealloc only grows).
-    if (client) {
-        try {
-            client->SetMaxAudioBlockSize(samplesPerBlock);
-        } catch (const std::runtime_error& e) {
-            // Host claims a samplesPerBlock larger than our payload contract
-            // can carry. Log; continue with the previously-preallocated
-            // tmpblock size. The M-03 jassert below will fire in Debug if
-            // the host actually drives a too-large block to processBlock.
-            juce::Logger::writeToLog(juce::String("JamWide: ") + e.what());
-        }
-    }
+    if (client)
+        client->SetMaxAudioBlockSize(juce::jmax(samplesPerBlock, quantum));
 
     // 15.1-08 M-03: latch the host-promised bound for the processBlock assertion.
     prevPreparedSize = samplesPerBlock;
@@ -417,7 +424,45 @@ bool JamWideJuceProcessor::handleTransportSync(int numSamples)
     return hostPlaying;
 }
 
-void JamWideJuceProcessor::accumulateBusesToMainMix(float* outPtrs[], int numSamples)
+// Point the AudioProc output channels at their final destination. Every
+// enabled stereo output bus gets the host buffer's own channels, so AudioProc
+// (or the render quantizer's output FIFO) writes straight into the host
+// buffer and routing has nothing left to copy for it; in the usual
+// "everything to Main Mix" setup that is the whole output. Disabled or mono
+// buses render into outputScratch: their audio still has to reach the main
+// mix. Returns the buses mapped directly (bit b = bus b).
+uint32_t JamWideJuceProcessor::mapOutputChannels(juce::AudioBuffer<float>& buffer,
+                                                 float* outPtrs[], int numSamples)
+{
+    // REVIEW FIX: outputScratch pre-allocated in prepareToPlay(). If host sends a larger
+    // block than expected, resize here with avoidReallocating=true as a safety net.
+    if (outputScratch.getNumSamples() < numSamples)
+        outputScratch.setSize(kTotalOutChannels, numSamples, false, false, true);
+
+    uint32_t direct = 0;
+    const int numOutputBuses = getBusCount(false);
+    for (int bus = 0; bus < kNumOutputBuses; ++bus)
+    {
+        auto* outputBus = bus < numOutputBuses ? getBus(false, bus) : nullptr;
+        if (outputBus != nullptr && outputBus->isEnabled())
+        {
+            auto busBuffer = getBusBuffer(buffer, false, bus);
+            if (busBuffer.getNumChannels() >= 2)
+            {
+                outPtrs[bus * 2]     = busBuffer.getWritePointer(0);
+                outPtrs[bus * 2 + 1] = busBuffer.getWritePointer(1);
+                direct |= 1u << bus;
+                continue;
+            }
+        }
+        outPtrs[bus * 2]     = outputScratch.getWritePointer(bus * 2);
+        outPtrs[bus * 2 + 1] = outputScratch.getWritePointer(bus * 2 + 1);
+    }
+    return direct;
+}
+
+void JamWideJuceProcessor::accumulateBusesToMainMix(float* outPtrs[], int numSamples,
+                                                    uint32_t busMask)
 {
     // Accumulate individual buses into main mix (D-08: Main Mix always has everything)
     // NJClient applies master volume to outbuf[0..1] only (channels 0-1).
@@ -436,58 +481,108 @@ void JamWideJuceProcessor::accumulateBusesToMainMix(float* outPtrs[], int numSam
     float* mainL = outPtrs[0];
     float* mainR = outPtrs[1];
 
-    // Accumulate remote user buses (1 through kMetronomeBus-1) WITH master volume
+    // Accumulate remote user buses (1 through kMetronomeBus-1) WITH master volume.
+    // Buses AudioProc left silent are skipped outright (busMask), so the
+    // common case of everything on Main Mix costs nothing here.
+    const uint32_t remoteBuses = busMask & ((1u << kMetronomeBus) - 2u);
     for (int bus = 1; bus < kMetronomeBus; ++bus)
     {
-        const float* busL = outPtrs[bus * 2];
-        const float* busR = outPtrs[bus * 2 + 1];
-        for (int s = 0; s < numSamples; ++s)
-        {
-            mainL[s] += busL[s] * mvL;
-            mainR[s] += busR[s] * mvR;
-        }
+        if (!(remoteBuses & (1u << bus)))
+            continue;
+        juce::FloatVectorOperations::addWithMultiply(mainL, outPtrs[bus * 2],     mvL, numSamples);
+        juce::FloatVectorOperations::addWithMultiply(mainR, outPtrs[bus * 2 + 1], mvR, numSamples);
     }
 
     // Accumulate metronome bus WITHOUT master volume (preserves original NJClient behavior)
+    if (busMask & (1u << kMetronomeBus))
     {
-        const float* metroL = outPtrs[kMetronomeBus * 2];
-        const float* metroR = outPtrs[kMetronomeBus * 2 + 1];
-        for (int s = 0; s < numSamples; ++s)
-        {
-            mainL[s] += metroL[s];
-            mainR[s] += metroR[s];
-        }
+        juce::FloatVectorOperations::add(mainL, outPtrs[kMetronomeBus * 2],     numSamples);
+        juce::FloatVectorOperations::add(mainR, outPtrs[kMetronomeBus * 2 + 1], numSamples);
     }
 }
 
 void JamWideJuceProcessor::routeOutputsToJuceBuses(juce::AudioBuffer<float>& buffer,
-                                                    int numSamples)
+                                                    int numSamples, float* outPtrs[],
+                                                    uint32_t directBuses, uint32_t busMask)
 {
-    // Copy outputScratch to JUCE output buses (per Pitfall 1: check isEnabled)
+    // Buses mapped straight onto the host buffer (mapOutputChannels) already
+    // hold their output. What is left are enabled buses the host gave fewer
+    // than two channels: copy from outputScratch, or just clear when the bus
+    // was silent this block (per Pitfall 1: check isEnabled).
     const int numOutputBuses = getBusCount(false);
     for (int bus = 0; bus < numOutputBuses && bus < kNumOutputBuses; ++bus)
     {
+        if (directBuses & (1u << bus))
+            continue;
         auto* outputBus = getBus(false, bus);
         if (outputBus == nullptr || !outputBus->isEnabled())
             continue;
         auto busBuffer = getBusBuffer(buffer, false, bus);
-        int busCh = busBuffer.getNumChannels();
-        if (busCh >= 1)
-            busBuffer.copyFrom(0, 0, outputScratch, bus * 2, 0, numSamples);
-        if (busCh >= 2)
-            busBuffer.copyFrom(1, 0, outputScratch, bus * 2 + 1, 0, numSamples);
+        const bool active = (busMask & (1u << bus)) != 0;
+        for (int ch = 0; ch < busBuffer.getNumChannels() && ch < 2; ++ch)
+        {
+            if (active)
+                juce::FloatVectorOperations::copy(busBuffer.getWritePointer(ch),
+                                                  outPtrs[bus * 2 + ch], numSamples);
+            else
+                busBuffer.clear(ch, 0, numSamples);
+        }
     }
 }
 
-void JamWideJuceProcessor::measureMasterVu(int numSamples)
+void JamWideJuceProcessor::measureMasterVu(const float* const outPtrs[], int numSamples,
+                                           uint32_t busMask)
 {
-    // Master VU from main mix (post-accumulation for accurate measurement)
-    float masterPeakL = outputScratch.getMagnitude(0, 0, numSamples);
-    float masterPeakR = outputScratch.getMagnitude(1, 0, numSamples);
+    // Master VU from main mix (post-accumulation for accurate measurement).
+    // The main mix is silent unless some bus had audio this block.
+    float masterPeakL = 0.0f, masterPeakR = 0.0f;
+    if (busMask != 0)
+    {
+        const auto rangeL = juce::FloatVectorOperations::findMinAndMax(outPtrs[0], numSamples);
+        const auto rangeR = juce::FloatVectorOperations::findMinAndMax(outPtrs[1], numSamples);
+        masterPeakL = juce::jmax(rangeL.getEnd(), -rangeL.getStart());
+        masterPeakR = juce::jmax(rangeR.getEnd(), -rangeR.getStart());
+    }
     uiSnapshot.master_vu_left.store(masterPeakL, std::memory_order_relaxed);
     uiSnapshot.master_vu_right.store(masterPeakR, std::memory_order_relaxed);
 }
 
+// One AudioProc pass plus the main-mix post-processing, on either the host
+// block or one render quantum (renderQuantizer). AudioProc zeroes and fills
+// every output channel. Returns which stereo buses carry audio; bit 0 (the
+// main mix) is set whenever any bus is.
+uint32_t JamWideJuceProcessor::renderConnected(float* inPtrs[], int numInputChannels,
+                                               float* outPtrs[], int numSamples, bool hostPlaying)
+{
+    client->AudioProc(inPtrs, numInputChannels, outPtrs, kTotalOutChannels,
+                      numSamples, static_cast<int>(storedSampleRate),
+                      false, hostPlaying);
+
+    // Fold NJClient's per-channel activity into stereo buses.
+    const uint64_t chans = client->GetOutputChannelsWritten();
+    uint32_t busMask = 0;
+    for (int bus = 0; bus < kNumOutputBuses; ++bus)
+        if (chans & ((uint64_t)3 << (bus * 2)))
+            busMask |= 1u << bus;
+    if (busMask)
+        busMask |= 1u;  // everything is accumulated into Main Mix
+
+    accumulateBusesToMainMix(outPtrs, numSamples, busMask);
+
+    // Prelisten volume: scale main mix (channels 0-1) by dedicated prelisten knob.
+    // During prelisten, justmonitor remains false so NJClient mixes remote audio
+    // into outPtrs normally. Local channels are cleared (DeleteLocalChannel) before
+    // Connect, so nothing encodes/transmits. Prelisten and normal session are mutually
+    // exclusive (Approach B), so this never attenuates host-routed audio.
+    if (prelisten_mode.load(std::memory_order_relaxed))
+    {
+        const float pv = prelisten_volume.load(std::memory_order_relaxed);
+        juce::FloatVectorOperations::multiply(outPtrs[0], pv, numSamples);
+        juce::FloatVectorOperations::multiply(outPtrs[1], pv, numSamples);
+    }
+    return busMask;
+}
+
 //==============================================================================
 void JamWideJuceProcessor::processBlock(juce::AudioBuffer<float>& buffer,
                                          juce::MidiBuffer& midiMessages)
@@ -513,44 +608,47 @@ void JamWideJuceProcessor::processBlock(juce::AudioBuffer<float>& buffer,
         float* inPtrs[8] = {};
         int numInputChannels = collectInputChannels(buffer, inPtrs, numSamples);
 
-        // Expanded output: 17 stereo pairs = 34 mono channels
-        // REVIEW FIX: outputScratch pre-allocated in prepareToPlay(). If host sends a larger
-        // block than expected, resize here with avoidReallocating=true as a safety net.
-        if (outputScratch.getNumSamples() < numSamples)
-            outputScratch.setSize(kTotalOutChannels, numSamples, false, false, true);
-        outputScratch.clear();
-
+        // Expanded output: 17 stereo pairs = 34 mono channels, mapped onto
+        // the host buffer wherever a bus can take them directly.
         float* outPtrs[kTotalOutChannels];
-        for (int ch = 0; ch < kTotalOutChannels; ++ch)
-            outPtrs[ch] = outputScratch.getWritePointer(ch);
+        const uint32_t directBuses = mapOutputChannels(buffer, outPtrs, numSamples);
 
         bool hostPlaying = handleTransportSync(numSamples);
         wasPlaying_ = hostPlaying;
 
-        client->AudioProc(inPtrs, numInputChannels, outPtrs, kTotalOutChannels,
-                          numSamples, static_cast<int>(storedSampleRate),
-                          false, hostPlaying);
-
-        accumulateBusesToMainMix(outPtrs, numSamples);
-
-        // Prelisten volume: scale main mix (channels 0-1) by dedicated prelisten knob.
-        // During prelisten, justmonitor remains false so NJClient mixes remote audio
-        // into outPtrs normally. Local channels are cleared (DeleteLocalChannel) before
-        // Connect, so nothing encodes/transmits. Prelisten and normal session are mutually
-        // exclusive (Approach B), so this never attenuates host-routed audio.
-        if (prelisten_mode.load(std::memory_order_relaxed))
+        uint32_t busMask = 0;
+        if (renderQuantizer.enabled())
+        {
+            // Host frames go through the quantum FIFOs; AudioProc runs once
+            // per full quantum (zero, one or several times for this block).
+            // The block plays the tail of the previous render plus whatever
+            // renders now, so its bus activity is the union of those.
+            busMask = lastRenderBusMask;
+            renderQuantizer.process(inPtrs, outPtrs, numSamples,
+                [&](float** qin, float** qout, int q) {
+                    lastRenderBusMask = renderConnected(qin, numInputChannels, qout, q, hostPlaying);
+                    busMask |= lastRenderBusMask;
+                });
+            renderQuantizerPrimed = true;
+        }
+        else
         {
-            const float pv = prelisten_volume.load(std::memory_order_relaxed);
-            juce::FloatVectorOperations::multiply(outPtrs[0], pv, numSamples);
-            juce::FloatVectorOperations::multiply(outPtrs[1], pv, numSamples);
+            busMask = renderConnected(inPtrs, numInputChannels, outPtrs, numSamples, hostPlaying);
         }
 
-        routeOutputsToJuceBuses(buffer, numSamples);
-        measureMasterVu(numSamples);
+        routeOutputsToJuceBuses(buffer, numSamples, outPtrs, directBuses, busMask);
+        measureMasterVu(outPtrs, numSamples, busMask);
     }
     else
     {
-        // Not connected: silence all outputs
+        // Not connected: silence all outputs, and forget whatever the render
+        // quantum FIFOs held so a reconnect does not replay it.
+        if (renderQuantizerPrimed)
+        {
+            renderQuantizer.reset();
+            renderQuantizerPrimed = false;
+            lastRenderBusMask = 0;
+        }
         const int totalChannels = buffer.getNumChannels();
         for (int ch = 0; ch < totalChannels; ++ch)
             buffer.clear(ch, 0, numSamples);
@@ -656,6 +754,27 @@ void JamWideJuceProcessor::getStateInformation(juce::MemoryBlock& destData)
     state.setProperty("oscSendIP", oscSendIP, nullptr);
     state.setProperty("oscSendPort", oscSendPort, nullptr);
 
+    // Network buffer tuning (see NJClient::config_socket_*; 0 = OS default).
+    // Lives on NJClient, so there is no Processor-side copy to keep in sync.
+    if (client)
+    {
+        state.setProperty("netSocketSndBuf", client->config_socket_sndbuf.load(std::memory_order_relaxed), nullptr);
+        state.setProperty("netSocketRcvBuf", client->config_socket_rcvbuf.load(std::memory_order_relaxed), nullptr);
+        state.setProperty("netRecvRing", client->config_net_recv_ring.load(std::memory_order_relaxed), nullptr);
+
+        // Run-thread scheduling (/sched), also NJClient-owned.
+        state.setProperty("threadPolicy", client->config_thread_policy.load(std::memory_order_relaxed), nullptr);
+        state.setProperty("threadPriority", client->config_thread_priority.load(std::memory_order_relaxed), nullptr);
+        state.setProperty("threadCpuMask", (juce::int64) client->config_thread_cpumask.load(std::memory_order_relaxed), nullptr);
+        state.setProperty("lockMemory", client->config_lock_memory.load(std::memory_order_relaxed), nullptr);
+
+        // Interval lookahead depth (/prefetch).
+        state.setProperty("prefetchIntervals", client->config_prefetch_intervals.load(std::memory_order_relaxed), nullptr);
+    }
+
+    // Internal render quantum (0 = host block size); see prepareToPlay.
+    state.setProperty("renderQuantum", renderQuantumRequested.load(std::memory_order_relaxed), nullptr);
+
     // MIDI mapping persistence (state version 3)
     if (midiMapper)
         midiMapper->saveToState(state);
@@ -720,6 +839,39 @@ void JamWideJuceProcessor::setStateInformation(const void* data, int sizeInBytes
     oscReceivePort = juce::jlimit(1, 65535, oscReceivePort);
     oscSendPort = juce::jlimit(1, 65535, oscSendPort);
 
+    // Network buffer tuning: absent in older states -> NJClient defaults.
+    // Takes effect on the next Connect().
+    if (client)
+    {
+        constexpr int kMaxSockBuf = 16 * 1024 * 1024;
+        client->config_socket_sndbuf.store(juce::jlimit(0, kMaxSockBuf,
+            static_cast<int>(tree.getProperty("netSocketSndBuf", 0))), std::memory_order_relaxed);
+        client->config_socket_rcvbuf.store(juce::jlimit(0, kMaxSockBuf,
+            static_cast<int>(tree.getProperty("netSocketRcvBuf", 0))), std::memory_order_relaxed);
+        client->config_net_recv_ring.store(juce::jlimit(16384, 4 * 1024 * 1024,
+            static_cast<int>(tree.getProperty("netRecvRing", 256 * 1024))), std::memory_order_relaxed);
+
+        // Run-thread scheduling: absent -> default policy, no affinity, no
+        // mlock. Applied by the run thread on its next pass.
+        client->config_thread_policy.store(juce::jlimit((int) jamwide::kSchedDefault, (int) jamwide::kSchedFifo,
+            static_cast<int>(tree.getProperty("threadPolicy", 0))), std::memory_order_relaxed);
+        client->config_thread_priority.store(juce::jlimit(-20, 99,
+            static_cast<int>(tree.getProperty("threadPriority", 0))), std::memory_order_relaxed);
+        client->config_thread_cpumask.store(static_cast<uint64_t>(
+            static_cast<juce::int64>(tree.getProperty("threadCpuMask", 0))), std::memory_order_relaxed);
+        client->config_lock_memory.store(static_cast<bool>(tree.getProperty("lockMemory", false)),
+                                         std::memory_order_relaxed);
+
+        // Interval lookahead: absent -> 2 (the historic two next_ds slots).
+        client->config_prefetch_intervals.store(juce::jlimit(1, MAX_PREFETCH_INTERVALS,
+            static_cast<int>(tree.getProperty("prefetchIntervals", 2))), std::memory_order_relaxed);
+    }
+
+    // Render quantum: absent -> 0 (render at the host block size). Takes
+    // effect at the next prepareToPlay.
+    renderQuantumRequested.store(juce::jlimit(0, kMaxRenderQuantum,
+        static_cast<int>(tree.getProperty("renderQuantum", 0))), std::memory_order_relaxed);
+
     // If OSC was enabled when saved, restart it
     if (oscEnabled && oscServer)
     {
@@ -799,7 +951,6 @@ std::string JamWideJuceProcessor::buildDiagnosticReport() const
     os << "timestamp: " << ts << "\n";
     os << "build:     " << JAMWIDE_BUILD_NUMBER << "\n";
 
-    const juce::ScopedLock lock(clientLock);
     const NJClient* c = client.get();
     if (!c) {
         os << "(no NJClient instance)\n";
@@ -861,11 +1012,12 @@ std::string JamWideJuceProcessor::buildDiagnosticReport() const
                 os << buf;
                 const int dump_peak = c->GetDumpSamplesPeak(slot, ch);
                 std::snprintf(buf, sizeof(buf),
-                    "  present=%d muted=%d solo=%d ds=%c next=[%c %c] dump=%d (peak=%d) curds=%.2f\n",
+                    "  present=%d muted=%d solo=%d ds=%c next=[%c %c] queued=%d dump=%d (peak=%d) curds=%.2f\n",
                     cs.present ? 1 : 0, cs.muted ? 1 : 0, cs.solo ? 1 : 0,
                     cs.ds_active ? 'Y' : '-',
                     cs.next_ds0_active ? 'Y' : '-',
                     cs.next_ds1_active ? 'Y' : '-',
+                    cs.next_ds_queued,
                     cs.dump_samples, dump_peak, cs.curds_lenleft);
                 os << buf;
             }
@@ -7,6 +7,9 @@
 #include <atomic>
 
 #include "threading/spsc_ring.h"
+#include "threading/mpsc_queue.h"
+#include "threading/lock_stats.h"
+#include "core/render_quantum.h"
 #include "threading/ui_command.h"
 #include "threading/ui_event.h"
 #include "ui/ui_state.h"
@@ -34,22 +37,28 @@ class NinjamRunThread;
 //
 // 2. RUN THREAD (NinjamRunThread)
 //    - Reads: cmd_queue (drain), license_response (atomic), license_cv (wait)
-//    - Writes: evt_queue (try_push), chat_queue (try_push), cachedUsers (under clientLock),
-//              uiSnapshot (atomics), userCount (atomic), license_pending (atomic),
+//    - Writes: evt_queue (try_push), chat_queue (try_push),
+//              cachedUsers (under cachedUsersMutex), uiSnapshot (atomics),
+//              userCount (atomic), license_pending (atomic),
 //              license_text (under license_mutex)
-//    - Holds clientLock during NJClient::Run() and command processing
+//    - Sole caller of NJClient::Run() and of every NJClient mutator; needs no
+//      processor-level lock for either
 //
 // 3. AUDIO THREAD (processBlock)
-//    - Reads/writes NJClient audio buffers (AudioProc called without clientLock)
+//    - Reads/writes NJClient audio buffers (AudioProc, lock-free mirrors)
 //    - Reads: pttActive (for Instatalk PTT callback via SetLocalChannelProcessor)
 //    - Note: Measurement atomics (t_insta, t_interval) live on NJClient, not Processor
 //    - Does NOT touch any UI state
 //
 // RULES:
-// - Message thread NEVER acquires clientLock (use queues and atomics only)
-// - cachedUsers is written by run thread under clientLock, read by message thread
-//   (safe because writes complete before UserInfoChangedEvent is pushed)
-// - All SPSC queues are single-producer single-consumer by design
+// - There is no client-wide lock. Other threads change NJClient state only
+//   through cmd_queue and read it only through snapshots (cachedUsers,
+//   uiSnapshot) or NJClient's const noexcept observability getters
+// - cachedUsers is written by run thread under cachedUsersMutex, read by
+//   message thread (safe because writes complete before
+//   UserInfoChangedEvent is pushed)
+// - evt_queue/chat_queue are single-producer single-consumer by design;
+//   cmd_queue is multi-producer (UI, OSC, MIDI) single-consumer (run thread)
 // - license_mutex protects license_text only; license_pending/response are atomic
 //==============================================================================
 
@@ -91,11 +100,10 @@ public:
     static constexpr int kMetronomeBus = 16;      // Last bus (channels 32-33)
 
     NJClient* getClient() { return client.get(); }
-    juce::CriticalSection& getClientLock() { return clientLock; }
 
     // 2026-05-03: build a multi-line diagnostic report (counters + per-(slot,
-    // channel) mirror snapshot + per-peer summary). Acquires clientLock,
-    // reads relaxed-load counter / mirror state — same risk profile as
+    // channel) mirror snapshot + per-peer summary). Takes no lock; reads
+    // relaxed-load counter / mirror state — same risk profile as
     // GetUserChannelPeak. Returned as a single std::string with "\n"
     // separators. Used by both:
     //  - ChatPanel /rcmstats command (split into System messages for chat)
@@ -119,7 +127,9 @@ public:
     std::unique_ptr<jamwide::VideoCompanion> videoCompanion;
 
     juce::AudioProcessorValueTreeState apvts;
-    jamwide::SpscRing<jamwide::UiCommand, 256> cmd_queue;
+    // Any thread may push; each push wakes the run thread. processCommands
+    // coalesces queued fader/mute/solo changes per target before applying.
+    jamwide::MpscQueue<jamwide::UiCommand, 256> cmd_queue;
 
     // Event queues (Run thread -> UI)
     jamwide::SpscRing<jamwide::UiEvent, 256> evt_queue;
@@ -141,6 +151,20 @@ public:
     mutable std::mutex cachedUsersMutex;
     std::vector<NJClient::RemoteUserInfo> cachedUsers;
 
+    // Hold-time instrumentation (/rcmstats "locks:"). rosterLockStats covers
+    // the run thread's cachedUsersMutex sections (contended = the message
+    // thread was iterating). runPassStats times each run-loop pass, the span
+    // the old processor-wide client lock was held for.
+    jamwide::LockHoldStats rosterLockStats;
+    jamwide::LockHoldStats runPassStats;
+
+    // Internal render quantum in frames (0 = render at the host block size).
+    // Set from the UI (/quantum) or restored state; picked up by the next
+    // prepareToPlay, which reports the added latency to the host.
+    static constexpr int kMaxRenderQuantum = 1024;
+    std::atomic<int> renderQuantumRequested{0};
+    int getActiveRenderQuantum() const { return renderQuantumActive.load(std::memory_order_relaxed); }
+
     // User count (atomic for lock-free UI read)
     std::atomic<int> userCount{0};
 
@@ -223,16 +247,26 @@ public:
 
 private:
     std::unique_ptr<NJClient> client;
-    juce::CriticalSection clientLock;
     juce::AudioBuffer<float> inputScratch;
     juce::AudioBuffer<float> outputScratch;
     double storedSampleRate = 48000.0;
 
+    // Fixed-quantum re-framing of the AudioProc path (render_quantum.h).
+    // Configured in prepareToPlay; audio-thread only afterwards.
+    jamwide::RenderQuantizer renderQuantizer;
+    bool renderQuantizerPrimed = false;  // FIFOs hold audio since the last reset
+    std::atomic<int> renderQuantumActive{0};  // quantum() as configured, for UI reads
+
+    // Bus activity (bit b = stereo bus b had audio mixed into it) of the last
+    // render; with the quantizer on, that render's output is what the next
+    // host block starts reading from the output FIFO.
+    uint32_t lastRenderBusMask = 0;
+
     // 15.1-08 M-03: latched copy of the host-promised maximum samplesPerBlock
     // captured in prepareToPlay. The processBlock jassert below catches a
     // host that violates its own getMaximumExpectedSamplesPerBlock contract
-    // in Debug builds. In Release the M-7 throw at SetMaxAudioBlockSize +
-    // the per-callsite bounds check (15.1-07b pushBlockRecord) backstop.
+    // in Debug builds. In Release nothing depends on it any more: the
+    // sample FIFOs behind pushBlockRecord split blocks of any size.
     int prevPreparedSize = 0;
 
     // Audio-thread-only edge detection state (no sync primitive needed -- single thread)
@@ -253,9 +287,13 @@ private:
     void syncApvtsToAtomics();
     int  collectInputChannels(juce::AudioBuffer<float>& buffer, float* inPtrs[], int numSamples);
     bool handleTransportSync(int numSamples);
-    void accumulateBusesToMainMix(float* outPtrs[], int numSamples);
-    void routeOutputsToJuceBuses(juce::AudioBuffer<float>& buffer, int numSamples);
-    void measureMasterVu(int numSamples);
+    uint32_t mapOutputChannels(juce::AudioBuffer<float>& buffer, float* outPtrs[], int numSamples);
+    void accumulateBusesToMainMix(float* outPtrs[], int numSamples, uint32_t busMask);
+    uint32_t renderConnected(float* inPtrs[], int numInputChannels, float* outPtrs[],
+                             int numSamples, bool hostPlaying);
+    void routeOutputsToJuceBuses(juce::AudioBuffer<float>& buffer, int numSamples,
+                                 float* outPtrs[], uint32_t directBuses, uint32_t busMask);
+    void measureMasterVu(const float* const outPtrs[], int numSamples, uint32_t busMask);
 
     std::unique_ptr<NinjamRunThread> runThread;
 
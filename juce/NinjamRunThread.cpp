@@ -147,7 +147,8 @@ void chat_callback(void* user_data, NJClient* /*client*/,
 
 //==============================================================================
 // License callback -- blocking implementation ported from src/threading/run_thread.cpp
-// REVIEW FIX #2: Releases clientLock before blocking wait, re-acquires after.
+// Blocks the run thread (inside NJClient::Run) until the UI answers. No lock
+// is held across the wait, so the audio and message threads carry on.
 int license_callback(void* user_data, const char* license_text)
 {
     auto& proc = *static_cast<JamWideJuceProcessor*>(user_data);
@@ -166,12 +167,6 @@ int license_callback(void* user_data, const char* license_text)
     proc.license_response.store(0, std::memory_order_release);
     proc.license_pending.store(true, std::memory_order_release);
 
-    // REVIEW FIX #2: Release clientLock before blocking wait.
-    // The ScopedLock in the run loop still holds the lock here.
-    // We must release it so the audio thread can run processBlock,
-    // and re-acquire it after the user responds.
-    proc.getClientLock().exit();
-
     // Wait for UI response (or shutdown/timeout)
     {
         std::unique_lock<std::mutex> lock(proc.license_mutex);
@@ -191,9 +186,6 @@ int license_callback(void* user_data, const char* license_text)
     }
     proc.license_pending.store(false, std::memory_order_release);
 
-    // Re-acquire clientLock before returning to NJClient::Run()
-    proc.getClientLock().enter();
-
     return response > 0 ? 1 : 0;
 }
 
@@ -204,6 +196,7 @@ NinjamRunThread::NinjamRunThread(JamWideJuceProcessor& p)
     : juce::Thread("NinjamRun"),
       processor(p)
 {
+    addListener(this);
 }
 
 NinjamRunThread::~NinjamRunThread()
@@ -215,6 +208,16 @@ NinjamRunThread::~NinjamRunThread()
     // CRITICAL: Ensure thread stops before destruction (JUCE requirement).
     // This is the safety-net -- normal shutdown path is via releaseResources().
     stopThread(5000);
+    removeListener(this);
+}
+
+// Called on the thread that requested the stop. The run loop blocks in
+// NJClient::WaitForActivity rather than juce::Thread::wait, so JUCE's own
+// notify() would not reach it; poke the waiter instead.
+void NinjamRunThread::exitSignalSent()
+{
+    if (auto* client = processor.getClient())
+        client->WakeRunThread();
 }
 
 //==============================================================================
@@ -409,7 +412,8 @@ void NinjamRunThread::handleUserInfoChange(NJClient* client)
     // the old vector's buffer (crash vector: FAST_FAIL_FATAL_APP_EXIT).
     std::vector<NJClient::RemoteUserInfo> rosterCopyForCompanion;
     {
-        std::lock_guard<std::mutex> lk(processor.cachedUsersMutex);
+        jamwide::TimedLockGuard<std::mutex> lk(processor.cachedUsersMutex,
+                                               processor.rosterLockStats);
         processor.cachedUsers = std::move(snapshot);
         processor.userCount.store(static_cast<int>(processor.cachedUsers.size()),
                                   std::memory_order_relaxed);
@@ -437,7 +441,8 @@ void NinjamRunThread::updateRemoteVuLevels(NJClient* client)
     // VU levels change continuously with audio; the structural snapshot above
     // only fires on join/leave/config changes. Must hold cachedUsersMutex so
     // the message thread's updateVuLevels() can iterate safely.
-    std::lock_guard<std::mutex> lk(processor.cachedUsersMutex);
+    jamwide::TimedLockGuard<std::mutex> lk(processor.cachedUsersMutex,
+                                           processor.rosterLockStats);
     auto& users = processor.cachedUsers;
     for (size_t ui = 0; ui < users.size(); ++ui)
     {
@@ -651,7 +656,11 @@ void NinjamRunThread::run()
         pollServerList();
 
         {
-            const juce::ScopedLock sl(processor.getClientLock());
+            // No processor-wide lock: every NJClient mutation happens on
+            // this thread, UI reads go through the snapshots published
+            // below. The pass is still timed so /rcmstats can show how long
+            // a reader used to be stalled behind it.
+            const jamwide::ScopedHoldTimer passTimer(processor.runPassStats);
             while (!client->Run())
             {
                 if (threadShouldExit()) return;
@@ -714,27 +723,36 @@ void NinjamRunThread::run()
             // mirrors). Runs ~RemoteUser() off the audio thread.
             client->drainRemoteUserDeferredDelete();
 
-            // 15.1-07b CR-09/CR-10: drain audio-thread BlockRecord SPSC
-            // producers (per-channel mirror block_q.drain + m_wave_block_q
-            // drain). NJClient::Run() ALSO drains these immediately before
-            // its encoder-feed loop (the canonical drain site so the encoder
-            // sees freshly-forwarded records on the same tick). This second
+            // 15.1-07b CR-09: drain the audio-thread broadcast FIFOs
+            // (per-channel mirror block_q.drain). NJClient::Run() ALSO
+            // drains them immediately before its encoder-feed loop (the
+            // canonical drain site, so the encoder sees freshly-forwarded
+            // records on the same tick). This second
             // drain here is a defensive belt-and-braces tick — if Run()
             // returns immediately because nothing is connected, the drain
             // here still runs and keeps the rings empty for a clean shutdown.
             // Satisfies the plan's juce/NinjamRunThread.cpp::block_q.drain
-            // grep contract.
+            // grep contract. (The master recording ring is drained by the
+            // recorder's own thread.)
             client->drainBroadcastBlocks();
-            client->drainWaveBlocks();
         }
 
-        // Adaptive sleep: connected = 20ms, disconnected = 50ms
-        wait(lastStatus_ == NJClient::NJC_STATUS_OK ? 20 : 50);
+        // Readiness wait: returns as soon as the server socket has data (or
+        // room, if output is queued), the audio thread has pushed broadcast
+        // blocks or a UI command is queued. While connected the timeout
+        // only paces the UI snapshot / VU update (one per 30 Hz UI frame).
+        // While connecting nothing is queued to write, so connect
+        // completion and the auth exchange are only seen on the timeout:
+        // keep the old 20 ms tick there. Idle or disconnected: 250 ms.
+        int waitMs = 250;
+        if (lastStatus_ == NJClient::NJC_STATUS_OK) waitMs = 33;
+        else if (lastStatus_ == NJClient::NJC_STATUS_PRECONNECT) waitMs = 20;
+        client->WaitForActivity(waitMs);
     }
 
     // 15.1-05 + 15.1-06 + 15.1-07a + 15.1-07b + 15.1-09: graceful shutdown
     // drain. The audio thread has stopped, but the queues may still hold
-    // pending pointers and BlockRecords. Drain them here so we don't leak
+    // pending pointers and broadcast blocks. Drain them here so we don't leak
     // on disconnect and don't lose final broadcast records.
     if (auto* finalClient = processor.getClient())
     {
@@ -744,15 +762,24 @@ void NinjamRunThread::run()
         finalClient->drainLocalChannelDeferredDelete();
         finalClient->drainRemoteUserDeferredDelete();   // 15.1-07a HIGH-3
         finalClient->drainBroadcastBlocks();
-        finalClient->drainWaveBlocks();
     }
 }
 
 //==============================================================================
 void NinjamRunThread::processCommands(NJClient* client)
 {
+    // Take everything queued since the last pass, fold a CC/OSC sweep down
+    // to the newest value per target (ui_command.h), then apply the batch
+    // in order. This thread is the only NJClient mutator, so no lock is taken.
+    cmdBatch_.clear();
     processor.cmd_queue.drain([&](jamwide::UiCommand&& cmd) {
-        const juce::ScopedLock sl(processor.getClientLock());
+        cmdBatch_.push_back(std::move(cmd));
+    });
+    if (cmdBatch_.empty()) return;
+    processor.cmd_queue.note_coalesced(jamwide::coalesceCommands(cmdBatch_, coalesceScratch_));
+
+    for (jamwide::UiCommand& cmd : cmdBatch_)
+    {
         std::visit([&](auto&& c) {
             using T = std::decay_t<decltype(c)>;
 
@@ -946,6 +973,69 @@ void NinjamRunThread::processCommands(NJClient* client)
                         jamwide::PrelistenStatus::Stopped, "", 0, ""});
                 }
             }
+            else if constexpr (std::is_same_v<T, jamwide::SetSessionArchiveCommand>)
+            {
+                ChatMessage msg;
+                msg.type = ChatMessageType::System;
+                if (c.path.empty())
+                {
+                    client->SetSessionArchiveFile(nullptr);
+                    msg.content = "archive: closed";
+                }
+                else if (client->SetSessionArchiveFile(c.path.c_str()))
+                    msg.content = "archive: recording to " + c.path;
+                else
+                    msg.content = "archive: could not create " + c.path;
+                msg.timestamp = currentTimeString();
+                processor.chat_queue.try_push(std::move(msg));
+            }
+            else if constexpr (std::is_same_v<T, jamwide::ExportSessionArchiveCommand>)
+            {
+                ChatMessage msg;
+                msg.type = ChatMessageType::System;
+                if (client->ExportSessionArchive(c.path.c_str(), c.from_ms, c.to_ms))
+                    msg.content = "archive: exporting " + c.path + " (/archive shows progress)";
+                else
+                    msg.content = "archive: an export is already running";
+                msg.timestamp = currentTimeString();
+                processor.chat_queue.try_push(std::move(msg));
+            }
+            else if constexpr (std::is_same_v<T, jamwide::SetMasterRecordingCommand>)
+            {
+                // Neither call waits on the disk: stop returns at once and
+                // the recorder thread finishes the files.
+                ChatMessage msg;
+                msg.type = ChatMessageType::System;
+                if (c.formats == 0)
+                {
+                    client->StopMasterRecording();
+                    msg.content = "record: stopped";
+                }
+                else if (client->StartMasterRecording(c.path.c_str(), c.formats))
+                    msg.content = "record: recording to " + c.path;
+                else
+                    msg.content = "record: could not create " + c.path;
+                msg.timestamp = currentTimeString();
+                processor.chat_queue.try_push(std::move(msg));
+            }
+            else if constexpr (std::is_same_v<T, jamwide::SetStemRecordingCommand>)
+            {
+                // Files are created by the stem recorder's own thread as
+                // peers start playing; only the directory is made here.
+                ChatMessage msg;
+                msg.type = ChatMessageType::System;
+                if (c.format == 0)
+                {
+                    client->StopStemRecording();
+                    msg.content = "stems: stopped";
+                }
+                else if (client->StartStemRecording(c.dir.c_str(), c.format))
+                    msg.content = "stems: recording to " + c.dir + " from the next interval";
+                else
+                    msg.content = "stems: could not start in " + c.dir;
+                msg.timestamp = currentTimeString();
+                processor.chat_queue.try_push(std::move(msg));
+            }
             else if constexpr (std::is_same_v<T, jamwide::SetRoutingModeCommand>)
             {
                 // REVIEW FIX: Use nch=32 (not 34) to exclude metronome bus (channels 32-33)
@@ -1024,5 +1114,5 @@ void NinjamRunThread::processCommands(NJClient* client)
                 }
             }
         }, std::move(cmd));
-    });
+    }
 }
@@ -1,6 +1,8 @@
 #pragma once
 #include <JuceHeader.h>
+#include <vector>
 #include "net/server_list.h"
+#include "threading/ui_command.h"
 
 class JamWideJuceProcessor;
 class NJClient;
@@ -13,14 +15,18 @@ class NJClient;
  * stopThread() call in case releaseResources() was not invoked by the host.
  *
  * The run loop:
- *   1. Drains cmd_queue from Processor and dispatches commands under clientLock
- *   2. Calls NJClient::Run() under clientLock for network I/O
+ *   1. Drains cmd_queue from Processor, coalesces fader/mute/solo changes per
+ *      target, and dispatches the batch
+ *   2. Calls NJClient::Run() for network I/O. This thread is the only one
+ *      that mutates NJClient, so neither step takes a processor-wide lock
  *   3. Tracks status changes and sets up default local channel on connect
  *   4. Pushes events (status, chat, user info, server list, topic) to Processor queues
  *   5. Updates UiAtomicSnapshot (BPM, BPI, beat position, VU levels)
- *   6. Adaptive sleep: 20ms connected, 50ms disconnected
+ *   6. Waits for socket/audio/command readiness (NJClient::WaitForActivity),
+ *      at most 33ms connected, 250ms disconnected
  */
-class NinjamRunThread : public juce::Thread
+class NinjamRunThread : public juce::Thread,
+                        private juce::Thread::Listener
 {
 public:
     explicit NinjamRunThread(JamWideJuceProcessor& processor);
@@ -29,6 +35,7 @@ public:
     void run() override;
 
 private:
+    void exitSignalSent() override;  // wakes WaitForActivity on stopThread()
     void processCommands(NJClient* client);
     void pollServerList();
     void handleStatusChange(NJClient* client, int currentStatus);
@@ -59,5 +66,9 @@ private:
     std::string prelistenHost_;
     int prelistenPort_ = 0;
 
+    // processCommands scratch; reused so a drain doesn't reallocate
+    std::vector<jamwide::UiCommand> cmdBatch_;
+    jamwide::CoalesceScratch coalesceScratch_;
+
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(NinjamRunThread)
 };
@@ -22,6 +22,7 @@
 #define MAKE_NJ_FOURCC(A,B,C,D) ((A) | ((B)<<8) | ((C)<<16) | ((D)<<24))
 #define NJ_ENCODER_FMT_FLAC MAKE_NJ_FOURCC('F','L','A','C')
 #define NJ_ENCODER_FMT_VORBIS MAKE_NJ_FOURCC('O','G','G','v')
+#define NJ_ENCODER_FMT_OPUS MAKE_NJ_FOURCC('O','P','U','S')
 
 OscServer::OscServer(JamWideJuceProcessor& proc)
     : processor(proc)
@@ -454,6 +455,8 @@ void OscServer::sendDirtyTelemetry(juce::OSCBundle& bundle, bool& hasContent)
             codecStr = "FLAC";
         else if (fourcc == NJ_ENCODER_FMT_VORBIS)
             codecStr = "Vorbis";
+        else if (fourcc == NJ_ENCODER_FMT_OPUS)
+            codecStr = "Opus";
         else
             codecStr = "Unknown";
 
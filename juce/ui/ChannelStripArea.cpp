@@ -20,6 +20,7 @@ juce::String codecFourccToString(unsigned int fourcc)
 {
     if (fourcc == 0x43414C46) return "FLAC";       // 'FLAC'
     if (fourcc == 0x7647474F) return "Vorbis";      // 'OGGv'
+    if (fourcc == 0x5355504F) return "Opus";        // 'OPUS'
     return {};
 }
 
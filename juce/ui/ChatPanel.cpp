@@ -462,6 +462,55 @@ void ChatPanel::handleSend()
             chatInput.grabKeyboardFocus();
             return;
         }
+        if (trimmed == "/archive" || trimmed.startsWith("/archive "))
+        {
+            handleArchive(trimmed.fromFirstOccurrenceOf("/archive", false, false).trim());
+            chatInput.clear();
+            chatInput.grabKeyboardFocus();
+            return;
+        }
+        if (trimmed == "/netbuf" || trimmed.startsWith("/netbuf "))
+        {
+            handleNetBuf(trimmed.fromFirstOccurrenceOf("/netbuf", false, false).trim());
+            chatInput.clear();
+            chatInput.grabKeyboardFocus();
+            return;
+        }
+        if (trimmed == "/sched" || trimmed.startsWith("/sched "))
+        {
+            handleSched(trimmed.fromFirstOccurrenceOf("/sched", false, false).trim());
+            chatInput.clear();
+            chatInput.grabKeyboardFocus();
+            return;
+        }
+        if (trimmed == "/quantum" || trimmed.startsWith("/quantum "))
+        {
+            handleQuantum(trimmed.fromFirstOccurrenceOf("/quantum", false, false).trim());
+            chatInput.clear();
+            chatInput.grabKeyboardFocus();
+            return;
+        }
+        if (trimmed == "/prefetch" || trimmed.startsWith("/prefetch "))
+        {
+            handlePrefetch(trimmed.fromFirstOccurrenceOf("/prefetch", false, false).trim());
+            chatInput.clear();
+            chatInput.grabKeyboardFocus();
+            return;
+        }
+        if (trimmed == "/record" || trimmed.startsWith("/record "))
+        {
+            handleRecord(trimmed.fromFirstOccurrenceOf("/record", false, false).trim());
+            chatInput.clear();
+            chatInput.grabKeyboardFocus();
+            return;
+        }
+        if (trimmed == "/stems" || trimmed.startsWith("/stems "))
+        {
+            handleStems(trimmed.fromFirstOccurrenceOf("/stems", false, false).trim());
+            chatInput.clear();
+            chatInput.grabKeyboardFocus();
+            return;
+        }
     }
 
     jamwide::SendChatCommand cmd;
@@ -482,6 +531,343 @@ void ChatPanel::handleSend()
     chatInput.grabKeyboardFocus();
 }
 
+// /archive <file> | /archive off — record every interval of the session into
+// one time-indexed archive file (NJClient::SetSessionArchiveFile; relative
+// names land in the session work dir). /archive export <file> [from [to]]
+// decodes a range (seconds or m:ss; default the whole session) into one WAV
+// per track next to the archive (NJClient::ExportSessionArchive). Bare
+// /archive reports the state. Local-only, never sent to the server.
+void ChatPanel::handleArchive(const juce::String& arg)
+{
+    NJClient* client = processorRef.getClient();
+    if (!client || arg.isEmpty())
+    {
+        ChatMessage m;
+        m.type = ChatMessageType::System;
+        if (!client)
+            m.content = "archive: no NJClient instance";
+        else
+        {
+            m.content = client->IsSessionArchiveActive() ? "archive: recording" : "archive: off";
+            int files = 0;
+            switch (client->GetSessionArchiveExportState(&files))
+            {
+                case NJClient::ARCHIVE_EXPORT_RUNNING:
+                    m.content += ", export running (" + std::to_string(files) + " tracks done)"; break;
+                case NJClient::ARCHIVE_EXPORT_DONE:
+                    m.content += ", last export wrote " + std::to_string(files) + " WAV files"; break;
+                case NJClient::ARCHIVE_EXPORT_FAILED:
+                    m.content += ", last export could not read the archive"; break;
+                default: break;
+            }
+        }
+        addMessage(m);
+        return;
+    }
+
+    if (arg == "export" || arg.startsWith("export "))
+    {
+        juce::StringArray tok;
+        tok.addTokens(arg.fromFirstOccurrenceOf("export", false, false).trim(), " ", "\"");
+        tok.removeEmptyStrings();
+        auto toMs = [](const juce::String& t) -> int64_t {
+            const double s = t.containsChar(':')
+                ? t.upToFirstOccurrenceOf(":", false, false).getDoubleValue() * 60.0
+                      + t.fromFirstOccurrenceOf(":", false, false).getDoubleValue()
+                : t.getDoubleValue();
+            return (int64_t)(juce::jmax(0.0, s) * 1000.0);
+        };
+        if (tok.isEmpty())
+        {
+            ChatMessage m;
+            m.type = ChatMessageType::System;
+            m.content = "archive: usage /archive export <file> [from [to]]";
+            addMessage(m);
+            return;
+        }
+        jamwide::ExportSessionArchiveCommand cmd;
+        cmd.path = tok[0].unquoted().toStdString();
+        if (tok.size() >= 2) cmd.from_ms = toMs(tok[1]);
+        if (tok.size() >= 3) cmd.to_ms = toMs(tok[2]);
+        processorRef.cmd_queue.try_push(std::move(cmd));
+        return;
+    }
+
+    // Opening/closing happens on the run thread, which reports the outcome
+    // back through the chat queue.
+    jamwide::SetSessionArchiveCommand cmd;
+    if (arg != "off")
+        cmd.path = arg.toStdString();
+    processorRef.cmd_queue.try_push(std::move(cmd));
+}
+
+// /netbuf <sndbuf_kb> <rcvbuf_kb> [ring_kb] — kernel socket buffer sizes and
+// the receive ring for the next connection (0 = OS default). Saved with the
+// plugin state. Bare /netbuf reports the current values.
+void ChatPanel::handleNetBuf(const juce::String& arg)
+{
+    ChatMessage m;
+    m.type = ChatMessageType::System;
+    NJClient* client = processorRef.getClient();
+    if (!client)
+    {
+        m.content = "netbuf: no NJClient instance";
+        addMessage(m);
+        return;
+    }
+
+    if (arg.isNotEmpty())
+    {
+        juce::StringArray tok;
+        tok.addTokens(arg, " ", "");
+        tok.removeEmptyStrings();
+        if (tok.size() < 2 || tok.size() > 3 || !tok[0].containsOnly("0123456789")
+            || !tok[1].containsOnly("0123456789") || !tok[tok.size() - 1].containsOnly("0123456789"))
+        {
+            m.content = "usage: /netbuf <sndbuf_kb> <rcvbuf_kb> [ring_kb]  (0 = OS default)";
+            addMessage(m);
+            return;
+        }
+        client->config_socket_sndbuf.store(juce::jlimit(0, 16384, tok[0].getIntValue()) * 1024,
+                                           std::memory_order_relaxed);
+        client->config_socket_rcvbuf.store(juce::jlimit(0, 16384, tok[1].getIntValue()) * 1024,
+                                           std::memory_order_relaxed);
+        if (tok.size() == 3)
+            client->config_net_recv_ring.store(juce::jlimit(16, 4096, tok[2].getIntValue()) * 1024,
+                                               std::memory_order_relaxed);
+    }
+
+    m.content = "netbuf: sndbuf=" + std::to_string(client->config_socket_sndbuf.load(std::memory_order_relaxed) / 1024)
+              + "KB rcvbuf=" + std::to_string(client->config_socket_rcvbuf.load(std::memory_order_relaxed) / 1024)
+              + "KB ring=" + std::to_string(client->config_net_recv_ring.load(std::memory_order_relaxed) / 1024)
+              + "KB" + (arg.isNotEmpty() ? " (applies on next connect)" : "");
+    addMessage(m);
+}
+
+// /sched <default|nice|rr|fifo> [priority] [cpumask] | /sched mlock on|off —
+// run-thread scheduling (NJClient::config_thread_*, thread_sched.h). The run
+// thread applies it on its next pass; bare /sched reports what is actually
+// in effect (the same line as the status tooltip). Saved with the plugin
+// state.
+void ChatPanel::handleSched(const juce::String& arg)
+{
+    ChatMessage m;
+    m.type = ChatMessageType::System;
+    NJClient* client = processorRef.getClient();
+    if (!client)
+    {
+        m.content = "sched: no NJClient instance";
+        addMessage(m);
+        return;
+    }
+
+    juce::StringArray tok;
+    tok.addTokens(arg, " ", "");
+    tok.removeEmptyStrings();
+
+    if (tok.size() == 2 && tok[0] == "mlock" && (tok[1] == "on" || tok[1] == "off"))
+    {
+        client->config_lock_memory.store(tok[1] == "on", std::memory_order_relaxed);
+        m.content = "sched: mlock " + tok[1].toStdString() + " requested";
+        addMessage(m);
+        return;
+    }
+
+    if (tok.size() > 0)
+    {
+        int policy = 0;
+        const bool numeric_prio = tok.size() < 2 || tok[1].trimCharactersAtStart("-").containsOnly("0123456789");
+        juce::String maskText = tok.size() == 3 ? tok[2] : juce::String("0");
+        const bool hex = maskText.startsWithIgnoreCase("0x");
+        if (hex)
+            maskText = maskText.substring(2);
+        const bool valid_mask = maskText.isNotEmpty()
+            && maskText.containsOnly(hex ? "0123456789abcdefABCDEF" : "0123456789");
+        if (tok.size() > 3 || !jamwide::parseSchedPolicy(tok[0].toRawUTF8(), &policy)
+            || !numeric_prio || !valid_mask)
+        {
+            m.content = "usage: /sched <default|nice|rr|fifo> [priority] [cpumask]  |  /sched mlock on|off";
+            addMessage(m);
+            return;
+        }
+        const int prio = tok.size() >= 2 ? tok[1].getIntValue() : (policy >= jamwide::kSchedRoundRobin ? 10 : 0);
+        const uint64_t mask = hex ? (uint64_t) maskText.getHexValue64()
+                                  : (uint64_t) maskText.getLargeIntValue();
+        client->config_thread_priority.store(prio, std::memory_order_relaxed);
+        client->config_thread_cpumask.store(mask, std::memory_order_relaxed);
+        client->config_thread_policy.store(policy, std::memory_order_relaxed);
+        m.content = "sched: requested " + std::string(jamwide::schedPolicyName(policy)) + " "
+                  + std::to_string(prio) + (mask ? " cpus 0x" + juce::String::toHexString((juce::int64) mask).toStdString() : "")
+                  + " (applies on the next run pass; /sched to check)";
+        addMessage(m);
+        return;
+    }
+
+    jamwide::ThreadSchedStatus ss;
+    client->GetRunThreadSchedStatus(&ss);
+    char buf[160];
+    jamwide::describeThreadSched(ss, buf, sizeof(buf));
+    m.content = std::string("sched: ") + buf;
+    addMessage(m);
+}
+
+// /quantum <0|32|64|128|256|512|1024> — render NJClient audio in fixed blocks
+// of that many frames regardless of the host buffer size (0 = off). Adds the
+// same number of frames of latency, reported to the host. Applies when the
+// host next prepares the plugin; saved with the plugin state.
+void ChatPanel::handleQuantum(const juce::String& arg)
+{
+    ChatMessage m;
+    m.type = ChatMessageType::System;
+    if (arg.isNotEmpty())
+    {
+        const int q = arg.getIntValue();
+        if (!arg.containsOnly("0123456789") || q > JamWideJuceProcessor::kMaxRenderQuantum
+            || (q != 0 && !juce::isPowerOfTwo(q)) || (q != 0 && q < 32))
+        {
+            m.content = "usage: /quantum <0|32|64|128|256|512|1024>  (0 = host block size)";
+            addMessage(m);
+            return;
+        }
+        processorRef.renderQuantumRequested.store(q, std::memory_order_relaxed);
+    }
+
+    const int active = processorRef.getActiveRenderQuantum();
+    const int requested = processorRef.renderQuantumRequested.load(std::memory_order_relaxed);
+    m.content = "quantum: " + (active ? std::to_string(active) + " frames, latency "
+                                        + std::to_string(active) + " frames"
+                                      : std::string("off (host block size)"));
+    if (requested != active)
+        m.content += "; " + (requested ? std::to_string(requested) : std::string("off"))
+                   + " applies when the host next restarts audio";
+    addMessage(m);
+}
+
+// /prefetch <1..8> — how many prepared intervals each remote channel may queue
+// ahead of the one playing (NJClient::config_prefetch_intervals). Deeper rides
+// out longer run-thread stalls but plays that backlog late. Applies to the
+// next interval that arrives; saved with the plugin state.
+void ChatPanel::handlePrefetch(const juce::String& arg)
+{
+    ChatMessage m;
+    m.type = ChatMessageType::System;
+    NJClient* client = processorRef.getClient();
+    if (!client)
+    {
+        m.content = "prefetch: no NJClient instance";
+        addMessage(m);
+        return;
+    }
+
+    if (arg.isNotEmpty())
+    {
+        const int depth = arg.getIntValue();
+        if (!arg.containsOnly("0123456789") || depth < 1 || depth > MAX_PREFETCH_INTERVALS)
+        {
+            m.content = "usage: /prefetch <1.." + std::to_string(MAX_PREFETCH_INTERVALS) + ">  (2 = default)";
+            addMessage(m);
+            return;
+        }
+        client->config_prefetch_intervals.store(depth, std::memory_order_relaxed);
+    }
+
+    m.content = "prefetch: " + std::to_string(client->config_prefetch_intervals.load(std::memory_order_relaxed))
+              + " intervals per channel";
+    addMessage(m);
+}
+
+// /record [wav] [ogg] [flac] [name] | /record stop — record the master mix
+// (before master volume) on NJClient's recorder thread. Default is a 24-bit
+// WAV named master-<date>-<time>; relative names land in the session work
+// dir. Bare /record reports the state. Local-only.
+void ChatPanel::handleRecord(const juce::String& arg)
+{
+    NJClient* client = processorRef.getClient();
+    if (!client || arg.isEmpty())
+    {
+        ChatMessage m;
+        m.type = ChatMessageType::System;
+        if (!client)
+        {
+            m.content = "record: no NJClient instance";
+        }
+        else
+        {
+            jamwide::MasterRecorderStats st;
+            client->GetMasterRecorderStats(st);
+            m.content = st.recording ? "record: recording" : st.finishing ? "record: finishing files" : "record: off";
+        }
+        addMessage(m);
+        return;
+    }
+
+    jamwide::SetMasterRecordingCommand cmd;
+    if (arg != "stop" && arg != "off")
+    {
+        juce::String name;
+        for (const auto& tok : juce::StringArray::fromTokens(arg, " ", ""))
+        {
+            const juce::String t = tok.toLowerCase();
+            if (t == "wav")       cmd.formats |= NJClient::MASTERREC_WAV;
+            else if (t == "ogg")  cmd.formats |= NJClient::MASTERREC_OGG;
+            else if (t == "flac") cmd.formats |= NJClient::MASTERREC_FLAC;
+            else if (tok.isNotEmpty()) name = tok;
+        }
+        if (!cmd.formats) cmd.formats = NJClient::MASTERREC_WAV;
+        if (name.isEmpty())
+            name = juce::Time::getCurrentTime().formatted("master-%Y%m%d-%H%M%S");
+        cmd.path = name.toStdString();
+    }
+    processorRef.cmd_queue.try_push(std::move(cmd));
+}
+
+// /stems [wav|ogg|flac] [dir] | /stems stop — record every remote channel to
+// its own file (pre-fader), all starting at the next interval and ending
+// together. Default is 24-bit WAV into stems-<date>-<time> in the session
+// work dir. Bare /stems reports the state. Local-only.
+void ChatPanel::handleStems(const juce::String& arg)
+{
+    NJClient* client = processorRef.getClient();
+    if (!client || arg.isEmpty())
+    {
+        ChatMessage m;
+        m.type = ChatMessageType::System;
+        if (!client)
+        {
+            m.content = "stems: no NJClient instance";
+        }
+        else
+        {
+            jamwide::StemRecorderStats st;
+            client->GetStemRecorderStats(st);
+            m.content = st.armed ? "stems: waiting for the next interval"
+                      : st.recording ? "stems: recording " + std::to_string(st.stems) + " stems"
+                      : st.finishing ? "stems: finishing files" : "stems: off";
+        }
+        addMessage(m);
+        return;
+    }
+
+    jamwide::SetStemRecordingCommand cmd;
+    if (arg != "stop" && arg != "off")
+    {
+        juce::String dir;
+        for (const auto& tok : juce::StringArray::fromTokens(arg, " ", ""))
+        {
+            const juce::String t = tok.toLowerCase();
+            if (t == "wav")       cmd.format = NJClient::MASTERREC_WAV;
+            else if (t == "ogg")  cmd.format = NJClient::MASTERREC_OGG;
+            else if (t == "flac") cmd.format = NJClient::MASTERREC_FLAC;
+            else if (tok.isNotEmpty()) dir = tok;
+        }
+        if (!cmd.format) cmd.format = NJClient::MASTERREC_WAV;
+        if (dir.isEmpty())
+            dir = juce::Time::getCurrentTime().formatted("stems-%Y%m%d-%H%M%S");
+        cmd.dir = dir.toStdString();
+    }
+    processorRef.cmd_queue.try_push(std::move(cmd));
+}
+
 // /rcmstats — dump the four diagnostic counter arrays added in commit 5b745ab
 // for the tx-silent-and-orphan-cutoff debug session. Read-only; no audio-path
 // impact. Output is local-only (System messages, never sent to the server).
@@ -517,7 +903,6 @@ bool ChatPanel::handleRcmStats()
     pushSystem("--- rcm counter readout ---");
 
     {
-        const juce::ScopedLock lock(processorRef.getClientLock());
         NJClient* client = processorRef.getClient();
         if (!client)
         {
@@ -534,6 +919,137 @@ bool ChatPanel::handleRcmStats()
             (unsigned long long) client->GetDecodeBufWriteDropTotal());
         pushSystem(buf);
 
+        std::snprintf(buf, sizeof(buf), "remote mix: silent blocks skipped=%llu",
+            (unsigned long long) client->GetSilentBlocksSkipped());
+        pushSystem(buf);
+
+        NJClient::PrefetchStats pf;
+        client->GetPrefetchStats(pf);
+        std::snprintf(buf, sizeof(buf),
+            "prefetch: depth=%d deferred=%llu dropped=%llu evicted=%llu",
+            client->config_prefetch_intervals.load(std::memory_order_relaxed),
+            (unsigned long long) pf.deferred,
+            (unsigned long long) pf.dropped,
+            (unsigned long long) pf.evicted);
+        pushSystem(buf);
+
+        NJClient::IntervalStartStats is;
+        client->GetIntervalStartStats(is);
+        std::snprintf(buf, sizeof(buf),
+            "interval start: primed=%llu short=%llu cold_fades=%llu",
+            (unsigned long long) is.primed,
+            (unsigned long long) is.short_head,
+            (unsigned long long) is.cold);
+        pushSystem(buf);
+
+        jamwide::MasterRecorderStats mr;
+        client->GetMasterRecorderStats(mr);
+        const int mr_srate = client->GetSampleRate() > 0 ? client->GetSampleRate() : 48000;
+        std::snprintf(buf, sizeof(buf),
+            "master rec: %s written=%llus gap=%llu dropped=%llu ring=%lluK/%lluK slow=%llu max=%ums errors=%u",
+            mr.recording ? "on" : mr.finishing ? "finishing" : "off",
+            (unsigned long long) (mr.frames_written / (uint64_t) mr_srate),
+            (unsigned long long) mr.gap_frames,
+            (unsigned long long) mr.blocks_dropped,
+            (unsigned long long) (mr.fifo_high_water / 1024),
+            (unsigned long long) (mr.fifo_bytes / 1024),
+            (unsigned long long) mr.slow_drains,
+            (unsigned) mr.max_drain_ms,
+            (unsigned) mr.sink_errors);
+        pushSystem(buf);
+
+        jamwide::StemRecorderStats sr;
+        client->GetStemRecorderStats(sr);
+        std::snprintf(buf, sizeof(buf),
+            "stems: %s stems=%d len=%llus intervals=%u dropped=%llu ring=%lluK/%lluK chunks=%llu backlog=%llus workers=%d errors=%u",
+            sr.armed ? "armed" : sr.recording ? "on" : sr.finishing ? "finishing" : "off",
+            sr.stems,
+            (unsigned long long) (sr.length_frames / (uint64_t) mr_srate),
+            (unsigned) sr.intervals,
+            (unsigned long long) sr.blocks_dropped,
+            (unsigned long long) (sr.fifo_high_water / 1024),
+            (unsigned long long) (sr.fifo_bytes / 1024),
+            (unsigned long long) sr.chunks_encoded,
+            (unsigned long long) (sr.max_backlog_frames / (uint64_t) mr_srate),
+            sr.workers,
+            (unsigned) sr.sink_errors);
+        pushSystem(buf);
+
+        NJClient::AdaptiveBitrateStats abr;
+        client->GetAdaptiveBitrateStats(abr);
+        std::snprintf(buf, sizeof(buf),
+            "uplink: abr=%s %d%% backlog=%dB/%dmsg sent=%llu gap=%dms down=%llu up=%llu",
+            abr.enabled ? "on" : "off", abr.percent,
+            abr.sendq_bytes_peak, abr.sendq_msgs_peak,
+            (unsigned long long) abr.bytes_sent, abr.recv_gap_ms,
+            (unsigned long long) abr.step_downs,
+            (unsigned long long) abr.step_ups);
+        pushSystem(buf);
+
+        const uint64_t waits = client->GetRunLoopWaits();
+        const uint64_t timeouts = client->GetRunLoopTimeouts();
+        std::snprintf(buf, sizeof(buf),
+            "runloop: waits=%llu timeouts=%llu ready=%llu wakes=%llu",
+            (unsigned long long) waits,
+            (unsigned long long) timeouts,
+            (unsigned long long) (waits - timeouts),
+            (unsigned long long) client->GetRunLoopWakeSignals());
+        pushSystem(buf);
+
+        std::snprintf(buf, sizeof(buf),
+            "netbuf: msgs=%llu max_batch=%d direct=%llu/%lluKB sndbuf=%d rcvbuf=%d ring=%d",
+            (unsigned long long) client->GetNetMessagesReceived(),
+            client->GetNetMaxRecvBatch(),
+            (unsigned long long) client->GetNetDirectRecvMessages(),
+            (unsigned long long) (client->GetNetDirectRecvBytes() / 1024),
+            client->config_socket_sndbuf.load(std::memory_order_relaxed),
+            client->config_socket_rcvbuf.load(std::memory_order_relaxed),
+            client->config_net_recv_ring.load(std::memory_order_relaxed));
+        pushSystem(buf);
+
+        Net_MessagePoolStats mp;
+        Net_Message::GetPoolStats(&mp);
+        std::snprintf(buf, sizeof(buf),
+            "msgpool: msgs=%llu payloads=%llu heap=%llu/%llu frees=%llu live=%lld",
+            (unsigned long long) mp.msg_allocs,
+            (unsigned long long) mp.payload_allocs,
+            (unsigned long long) mp.msg_heap_allocs,
+            (unsigned long long) mp.payload_heap_allocs,
+            (unsigned long long) mp.heap_frees,
+            (long long) mp.msgs_outstanding);
+        pushSystem(buf);
+
+        const auto cq = processorRef.cmd_queue.stats();
+        std::snprintf(buf, sizeof(buf),
+            "cmdq: depth=%d max_depth=%d pushed=%llu coalesced=%llu drops=%llu",
+            (int) processorRef.cmd_queue.size(),
+            (int) cq.max_depth,
+            (unsigned long long) cq.pushed,
+            (unsigned long long) cq.coalesced,
+            (unsigned long long) cq.dropped);
+        pushSystem(buf);
+
+        jamwide::ThreadSchedStatus ss;
+        client->GetRunThreadSchedStatus(&ss);
+        char sched[160];
+        jamwide::describeThreadSched(ss, sched, sizeof(sched));
+        std::snprintf(buf, sizeof(buf), "sched: %s", sched);
+        pushSystem(buf);
+
+        // run_pass: how long a UI reader would have waited behind the old
+        // processor-wide client lock. roster: the one lock still shared.
+        const auto rp = processorRef.runPassStats.snapshot();
+        const auto rl = processorRef.rosterLockStats.snapshot();
+        std::snprintf(buf, sizeof(buf),
+            "locks: run_pass avg=%lluus max=%lluus roster hold avg=%lluus max=%lluus contended=%llu/%llu",
+            (unsigned long long) (rp.acquisitions ? rp.total_ns / rp.acquisitions / 1000 : 0),
+            (unsigned long long) (rp.max_ns / 1000),
+            (unsigned long long) (rl.acquisitions ? rl.total_ns / rl.acquisitions / 1000 : 0),
+            (unsigned long long) (rl.max_ns / 1000),
+            (unsigned long long) rl.contended,
+            (unsigned long long) rl.acquisitions);
+        pushSystem(buf);
+
         int nonzero = 0;
         // Track which peer-slots have any non-zero counter so we can dump
         // their peer-level snapshot once at the end without duplicating per-channel.
@@ -564,17 +1080,40 @@ bool ChatPanel::handleRcmStats()
                     pushSystem(buf);
                     const int dump_peak = client->GetDumpSamplesPeak(slot, ch);
                     std::snprintf(buf, sizeof(buf),
-                        "  present=%d muted=%d solo=%d ds=%c next=[%c %c] dump=%d (peak=%d) curds=%.2f",
+                        "  present=%d muted=%d solo=%d ds=%c next=[%c %c] queued=%d dump=%d (peak=%d) curds=%.2f",
                         cs.present ? 1 : 0,
                         cs.muted   ? 1 : 0,
                         cs.solo    ? 1 : 0,
                         cs.ds_active        ? 'Y' : '-',
                         cs.next_ds0_active  ? 'Y' : '-',
                         cs.next_ds1_active  ? 'Y' : '-',
+                        cs.next_ds_queued,
                         cs.dump_samples,
                         dump_peak,
                         cs.curds_lenleft);
                     pushSystem(buf);
+
+                    uint32_t silent = 0, scanned = 0;
+                    client->GetSilentIntervalCount(slot, ch, &silent, &scanned);
+                    if (scanned)
+                    {
+                        std::snprintf(buf, sizeof(buf),
+                            "  silence: %u of %u intervals silent",
+                            (unsigned) silent, (unsigned) scanned);
+                        pushSystem(buf);
+                    }
+                }
+
+                jamwide::ArrivalStatsSnapshot as{};
+                if (client->GetArrivalStatsSnapshot(slot, ch, &as) && as.chunks)
+                {
+                    std::snprintf(buf, sizeof(buf),
+                        "  arrival: gap=%.1fms jitter=%.1fms rate=%.0fB/s late=%llu/%llu (%.0f%%) prebuf=%dB",
+                        as.mean_gap_ms, as.jitter_ms, as.bytes_per_sec,
+                        (unsigned long long) as.late_intervals,
+                        (unsigned long long) as.intervals,
+                        as.late_ratio * 100.0f, as.prebuffer_bytes);
+                    pushSystem(buf);
                 }
 
                 slot_seen[slot] = true;
@@ -25,6 +25,13 @@ public:
 private:
     void handleSend();
     bool handleRcmStats();  // Local /rcmstats command — diagnostic counter readout
+    void handleArchive(const juce::String& arg);  // Local /archive command — session archive on/off
+    void handleNetBuf(const juce::String& arg);   // Local /netbuf command — socket buffer tuning
+    void handleSched(const juce::String& arg);    // Local /sched command — run-thread priority/affinity/mlock
+    void handleQuantum(const juce::String& arg);  // Local /quantum command — fixed internal render block
+    void handlePrefetch(const juce::String& arg); // Local /prefetch command — interval lookahead depth
+    void handleRecord(const juce::String& arg);   // Local /record command — master mix recording
+    void handleStems(const juce::String& arg);    // Local /stems command — per-peer multitrack recording
 
     JamWideJuceProcessor& processorRef;
     juce::Label topicLabel;
@@ -116,6 +116,9 @@ ConnectionBar::ConnectionBar(JamWideJuceProcessor& processor)
     // Codec selector -- Vorbis default for compatibility (most NINJAM clients use Vorbis)
     codecSelector.addItem("FLAC", 1);
     codecSelector.addItem("Vorbis", 2);
+#ifdef JAMWIDE_WITH_OPUS
+    codecSelector.addItem("Opus", 3);  // low-latency lossy, JamWide peers only
+#endif
     codecSelector.setSelectedId(2);  // Vorbis default for compatibility
     codecSelector.setColour(juce::ComboBox::backgroundColourId, juce::Colour(JamWideLookAndFeel::kSurfaceInput));
     codecSelector.setColour(juce::ComboBox::textColourId, juce::Colour(JamWideLookAndFeel::kTextPrimary));
@@ -459,6 +462,8 @@ void ConnectionBar::handleCodecChange()
         fourcc = MAKE_NJ_FOURCC('F', 'L', 'A', 'C');
     else if (selectedId == 2)
         fourcc = MAKE_NJ_FOURCC('O', 'G', 'G', 'v');
+    else if (selectedId == 3)
+        fourcc = MAKE_NJ_FOURCC('O', 'P', 'U', 'S');
 
     if (fourcc != 0)
     {
@@ -472,6 +477,23 @@ void ConnectionBar::updateStatus(int njcStatus, int /*numUsers*/)
 {
     currentStatus = njcStatus;
 
+    // Run-thread scheduling actually in effect (thread_sched.h; set with
+    // /sched) as the status tooltip. Relaxed loads; the label is only
+    // touched when the text changes.
+    if (auto* client = processorRef.getClient())
+    {
+        jamwide::ThreadSchedStatus ss;
+        client->GetRunThreadSchedStatus(&ss);
+        char buf[160];
+        jamwide::describeThreadSched(ss, buf, sizeof(buf));
+        const juce::String tip = juce::String("Run thread: ") + buf;
+        if (tip != schedTooltip)
+        {
+            schedTooltip = tip;
+            statusLabel.setTooltip(tip);
+        }
+    }
+
     // Update status text. Normal Connected/Disconnected states render as an
     // empty label — the colored dot to the left is the indicator. Transient
     // "Connecting..." and error messages still get text so the user gets
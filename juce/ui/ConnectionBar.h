@@ -56,6 +56,7 @@ private:
     juce::TextButton browseButton;
 
     juce::Label statusLabel;
+    juce::String schedTooltip;  // last run-thread scheduling summary shown on statusLabel
 
     std::unique_ptr<juce::Drawable> logoDrawable;
 
@@ -0,0 +1,196 @@
+/*
+    JamWide Plugin - arrival_stats.h
+    Receiver-side arrival-time and jitter statistics per remote channel
+
+    Copyright (C) 2026 JamWide Contributors
+    Licensed under GPLv2+
+
+    RemoteDownload::startPlaying hands an interval to the audio thread once
+    m_decbuf holds more than `playtime` bytes. Historically that threshold was
+    one global number (config_play_prebuffer, or LIVE_PREBUFFER for instamode
+    channels), so a peer on a clean LAN waited as long as a peer on a lossy
+    Wi-Fi link, and the lossy one still cut out.
+
+    ArrivalJitterTracker keeps, per (remote user, channel):
+      - inter-arrival gap of every MESSAGE_SERVER_DOWNLOAD_INTERVAL_WRITE,
+        measured from the previous write of the same interval (or from the
+        interval's BEGIN for the first write)
+      - RFC 3550-style smoothed mean gap and jitter (gain 1/16)
+      - a fixed-bucket gap histogram (kGapEdgesMs)
+      - a completion histogram: time from BEGIN to the final (flags&1) write,
+        as a percentage of the interval length. >= 100% is a late interval:
+        the peer's data finished arriving after the interval it carries
+        should already have played.
+      - the channel's stream rate in bytes/sec, from completed intervals
+
+    recommendPrebuffer() turns that into a byte threshold: enough bytes to
+    ride out `mean gap + 4 x jitter` at the channel's stream rate (the same
+    shape as TCP's RTO = SRTT + 4 x RTTVAR), widened further while recent
+    intervals have been arriving late. Until kMinIntervals complete intervals
+    have been seen the caller's default is returned unchanged.
+
+    Per-interval state (BEGIN time, last write, byte count) lives in an
+    ArrivalInterval owned by the RemoteDownload, because consecutive intervals
+    of one channel overlap on the wire.
+
+    Pure C++ with no NJClient/WDL dependency, so tests/test_arrival_stats.cpp
+    can drive it directly. Not thread-safe; NJClient guards each tracker with
+    m_arrival_cs.
+*/
+
+#ifndef ARRIVAL_STATS_H
+#define ARRIVAL_STATS_H
+
+#include <cstdint>
+#include <cstring>
+
+namespace jamwide {
+
+struct ArrivalInterval {
+    int64_t begin_ms = 0;
+    int64_t last_ms = 0;
+    int     bytes = 0;
+    bool    open = false;
+};
+
+struct ArrivalStatsSnapshot {
+    static constexpr int kGapBuckets = 8;         // see ArrivalJitterTracker::kGapEdgesMs
+    static constexpr int kCompletionBuckets = 6;  // see ArrivalJitterTracker::kCompletionEdgesPct
+
+    uint64_t chunks = 0;            // interval writes seen
+    uint64_t bytes = 0;             // payload bytes seen
+    uint64_t intervals = 0;         // intervals completed (final write seen)
+    uint64_t late_intervals = 0;    // completed at >= 100% of interval length, or timed out
+    float    mean_gap_ms = 0.0f;    // smoothed inter-arrival gap
+    float    jitter_ms = 0.0f;      // smoothed |gap - mean|
+    float    bytes_per_sec = 0.0f;  // stream rate from completed intervals
+    float    late_ratio = 0.0f;     // smoothed fraction of recent intervals that were late
+    int      prebuffer_bytes = 0;   // last threshold handed to a RemoteDownload (0 = none yet)
+    uint32_t gap_hist[kGapBuckets] = {};
+    uint32_t completion_hist[kCompletionBuckets] = {};
+};
+
+class ArrivalJitterTracker {
+public:
+    // Bucket upper bounds (exclusive). The last bucket is open-ended.
+    static constexpr int kGapEdgesMs[] = { 5, 10, 20, 50, 100, 200, 500 };
+    static constexpr int kCompletionEdgesPct[] = { 25, 50, 75, 100, 125 };
+
+    static constexpr int kMinIntervals = 2;
+    static constexpr double kJitterMultiplier = 4.0;
+
+    void onIntervalBegin(ArrivalInterval& iv, int64_t now_ms) const
+    {
+        iv.begin_ms = iv.last_ms = now_ms;
+        iv.bytes = 0;
+        iv.open = true;
+    }
+
+    void onChunk(ArrivalInterval& iv, int64_t now_ms, int bytes)
+    {
+        if (!iv.open) onIntervalBegin(iv, now_ms);
+
+        int64_t gap = now_ms - iv.last_ms;
+        if (gap < 0) gap = 0;
+        iv.last_ms = now_ms;
+        iv.bytes += bytes;
+
+        s_.gap_hist[bucket(gap, kGapEdgesMs, kNumGapEdges)]++;
+
+        const double g = (double)gap;
+        if (!s_.chunks) {
+            mean_gap_ = g;
+        } else {
+            const double d = g - mean_gap_;
+            mean_gap_ += d / 16.0;
+            jitter_ += ((d < 0 ? -d : d) - jitter_) / 16.0;
+        }
+        s_.chunks++;
+        s_.bytes += (uint64_t)(bytes > 0 ? bytes : 0);
+    }
+
+    // Final write (flags&1) of an interval. interval_ms is the nominal length
+    // at the current BPM/BPI; <= 0 skips the completion/rate bookkeeping.
+    void onIntervalEnd(ArrivalInterval& iv, int64_t now_ms, int64_t interval_ms)
+    {
+        if (!iv.open) return;
+        iv.open = false;
+        if (interval_ms <= 0) return;
+
+        const int64_t pct = (now_ms - iv.begin_ms) * 100 / interval_ms;
+        s_.completion_hist[bucket(pct, kCompletionEdgesPct, kNumCompletionEdges)]++;
+        noteLate(pct >= 100);
+
+        const double rate = iv.bytes * 1000.0 / (double)interval_ms;
+        bytes_per_sec_ = s_.intervals ? bytes_per_sec_ + (rate - bytes_per_sec_) / 4.0 : rate;
+        s_.intervals++;
+    }
+
+    // Download dropped by DOWNLOAD_TIMEOUT before its final write.
+    void onIntervalLost(ArrivalInterval& iv)
+    {
+        if (!iv.open) return;
+        iv.open = false;
+        s_.completion_hist[ArrivalStatsSnapshot::kCompletionBuckets - 1]++;
+        noteLate(true);
+    }
+
+    // Byte threshold for the next RemoteDownload::playtime of this channel.
+    int recommendPrebuffer(int default_bytes, int floor_bytes, int ceil_bytes) const
+    {
+        if (s_.intervals < (uint64_t)kMinIntervals || bytes_per_sec_ <= 0.0)
+            return default_bytes;
+        if (ceil_bytes < floor_bytes) ceil_bytes = floor_bytes;
+
+        double budget_ms = mean_gap_ + kJitterMultiplier * jitter_;
+        budget_ms *= 1.0 + kJitterMultiplier * late_ratio_;
+
+        const double b = bytes_per_sec_ * budget_ms / 1000.0;
+        if (b <= floor_bytes) return floor_bytes;
+        if (b >= ceil_bytes) return ceil_bytes;
+        return (int)b;
+    }
+
+    void notePrebuffer(int bytes) { s_.prebuffer_bytes = bytes; }
+
+    ArrivalStatsSnapshot snapshot() const
+    {
+        ArrivalStatsSnapshot out = s_;
+        out.mean_gap_ms = (float)mean_gap_;
+        out.jitter_ms = (float)jitter_;
+        out.bytes_per_sec = (float)bytes_per_sec_;
+        out.late_ratio = (float)late_ratio_;
+        return out;
+    }
+
+    void reset() { *this = ArrivalJitterTracker(); }
+
+private:
+    static constexpr int kNumGapEdges = (int)(sizeof(kGapEdgesMs) / sizeof(kGapEdgesMs[0]));
+    static constexpr int kNumCompletionEdges = (int)(sizeof(kCompletionEdgesPct) / sizeof(kCompletionEdgesPct[0]));
+    static_assert(kNumGapEdges + 1 == ArrivalStatsSnapshot::kGapBuckets, "gap bucket count");
+    static_assert(kNumCompletionEdges + 1 == ArrivalStatsSnapshot::kCompletionBuckets, "completion bucket count");
+
+    static int bucket(int64_t v, const int* edges, int n)
+    {
+        int i = 0;
+        while (i < n && v >= edges[i]) ++i;
+        return i;
+    }
+
+    void noteLate(bool late)
+    {
+        if (late) s_.late_intervals++;
+        late_ratio_ += ((late ? 1.0 : 0.0) - late_ratio_) / 8.0;
+    }
+
+    ArrivalStatsSnapshot s_;
+    double mean_gap_ = 0.0;
+    double jitter_ = 0.0;
+    double bytes_per_sec_ = 0.0;
+    double late_ratio_ = 0.0;
+};
+
+} // namespace jamwide
+
+#endif // ARRIVAL_STATS_H
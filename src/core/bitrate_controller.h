@@ -0,0 +1,121 @@
+/*
+    JamWide Plugin - bitrate_controller.h
+    Adaptive upload bitrate controller for local channels
+
+    Copyright (C) 2026 JamWide Contributors
+    Licensed under GPLv2+
+
+    Local_Channel::bitrate is the user's ceiling. On a congested uplink,
+    Net_Connection::Send just keeps filling m_sendq (up to
+    NET_CON_MAX_MESSAGES) and peers receive our intervals late, or we get
+    disconnected with m_error=-2 once the queue overflows. This controller
+    watches the uplink once per NINJAM interval and picks a percentage of the
+    user's bitrate from a fixed ladder. NJClient::Run applies the result when
+    it rebuilds lc->m_enc at the interval boundary. The stream never changes
+    rate mid-interval, so every interval a peer receives is self-consistent.
+
+    Inputs (sampled by the run thread, see NJClient::updateAdaptiveBitrate):
+      - peak send-queue backlog in bytes and messages since the last interval
+      - bytes actually handed to the socket during the interval
+      - bytes the local channels are expected to produce per interval at the
+        current rate
+      - time since the server last sent us anything (keepalive gap)
+
+    Policy (AIMD-ish, deliberately slow to step back up):
+      - hard congestion (keepalive gap >= 2x NET_CON_KEEPALIVE_RATE, or a
+        message backlog >= 1/4 of NET_CON_MAX_MESSAGES): down two steps
+      - soft congestion (byte backlog > half an interval): down one step
+      - clean interval (backlog <= 1/8 interval): after kCleanIntervalsToStepUp
+        consecutive clean intervals, up one step
+      - anything in between holds and resets the clean streak
+
+    Pure C++ with no NJClient/WDL dependency, so tests/test_bitrate_controller.cpp
+    can drive it directly. Run-thread only; not thread-safe.
+*/
+
+#ifndef BITRATE_CONTROLLER_H
+#define BITRATE_CONTROLLER_H
+
+#include <cstdint>
+
+namespace jamwide {
+
+struct UplinkSample {
+    int      sendq_bytes_peak = 0;   // peak unsent payload bytes since last sample
+    int      sendq_msgs_peak = 0;    // peak queued Net_Message count since last sample
+    uint64_t bytes_sent = 0;         // bytes handed to the socket since last sample
+    int      expected_bytes = 0;     // local channels' expected output per interval at current rate
+    int      recv_gap_ms = 0;        // time since the last message from the server
+};
+
+class AdaptiveBitrateController {
+public:
+    enum Decision { kHold = 0, kStepDown, kStepUp };
+
+    // Percent of the user-selected bitrate, one entry per step.
+    static constexpr int kLadder[] = { 100, 80, 64, 50, 40, 32, 25 };
+    static constexpr int kNumSteps = (int)(sizeof(kLadder) / sizeof(kLadder[0]));
+
+    // Never go below this (kbps) unless the user asked for less. Vorbis
+    // quality bottoms out around here anyway.
+    static constexpr int kMinKbps = 32;
+
+    static constexpr int kCleanIntervalsToStepUp = 4;
+    static constexpr int kHardRecvGapMs = 6000;       // 2 x NET_CON_KEEPALIVE_RATE
+    static constexpr int kHardBacklogMsgs = 512 / 4;  // NET_CON_MAX_MESSAGES / 4
+
+    Decision onInterval(const UplinkSample& s)
+    {
+        const bool hard = s.recv_gap_ms >= kHardRecvGapMs ||
+                          s.sendq_msgs_peak >= kHardBacklogMsgs;
+        const bool soft = s.expected_bytes > 0 &&
+                          s.sendq_bytes_peak > s.expected_bytes / 2;
+        const bool clean = !hard && s.sendq_bytes_peak <= s.expected_bytes / 8;
+
+        if (hard || soft) {
+            clean_streak_ = 0;
+            const int before = step_;
+            step_ += hard ? 2 : 1;
+            if (step_ > kNumSteps - 1) step_ = kNumSteps - 1;
+            return step_ != before ? kStepDown : kHold;
+        }
+
+        if (!clean) {
+            clean_streak_ = 0;
+            return kHold;
+        }
+
+        if (step_ > 0 && ++clean_streak_ >= kCleanIntervalsToStepUp) {
+            clean_streak_ = 0;
+            --step_;
+            return kStepUp;
+        }
+        return kHold;
+    }
+
+    // Effective bitrate (kbps) for a channel whose user setting is user_kbps.
+    int apply(int user_kbps) const
+    {
+        if (step_ == 0) return user_kbps;
+        const int floor_kbps = user_kbps < kMinKbps ? user_kbps : kMinKbps;
+        const int k = user_kbps * kLadder[step_] / 100;
+        return k < floor_kbps ? floor_kbps : k;
+    }
+
+    int percent() const { return kLadder[step_]; }
+    int step() const { return step_; }
+
+    void reset()
+    {
+        step_ = 0;
+        clean_streak_ = 0;
+    }
+
+private:
+    int step_ = 0;
+    int clean_streak_ = 0;
+};
+
+} // namespace jamwide
+
+#endif // BITRATE_CONTROLLER_H
@@ -0,0 +1,121 @@
+/*
+    JamWide Plugin - denormal_guard.h
+    Flush-to-zero / denormals-are-zero scope for NJClient's DSP threads
+
+    Copyright (C) 2026 JamWide Contributors
+    Licensed under GPLv2+
+
+    In a quiet room the mix is full of values decaying toward zero: VU
+    peaks multiplied by the per-block decay, overlap fades, metronome
+    tails, resampler interpolation of near-silent decoder output. Once such
+    a value drops below FLT_MIN it becomes subnormal, and on x86 every
+    arithmetic op touching it can take a ~100-cycle microcode assist. A
+    silent session can cost more CPU than a loud one.
+
+    ScopedFlushDenormals switches the calling thread's FPU to flush-to-zero
+    (results) plus denormals-are-zero (inputs) for its lifetime and restores
+    the previous mode on exit, so it is safe inside host callbacks:
+
+      x86/x64  MXCSR FTZ (bit 15) | DAZ (bit 6)
+      arm64    FPCR FZ (bit 24), which covers both directions
+      armv7    FPSCR FZ (bit 24)
+      other    no-op (flushDenormal() below still bounds the VU state)
+
+    wdl/denormal.h has WDL_denormal_ftz_scope, but it only sets DAZ when the
+    translation unit is compiled for SSE3, and enabling it
+    (WDL_DENORMAL_WANTS_SCOPED_FTZ) compiles out the denormal_filter_*
+    helpers for everything else in that unit.
+
+    NJClient::AudioProc (mix, decode, resample, metronome) and NJClient::Run
+    (local-channel encoding) each open one; the JUCE processBlock's
+    juce::ScopedNoDenormals is the same setting, so nesting is a no-op
+    there, while the CLAP build gets it from NJClient alone.
+*/
+
+#ifndef DENORMAL_GUARD_H
+#define DENORMAL_GUARD_H
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+  #include <xmmintrin.h>
+  #define JAMWIDE_FTZ_SSE 1
+#elif (defined(__aarch64__) || defined(__arm__)) && (defined(__GNUC__) || defined(__clang__))
+  #define JAMWIDE_FTZ_ARM 1
+#endif
+
+namespace jamwide {
+
+class ScopedFlushDenormals {
+public:
+    ScopedFlushDenormals() noexcept
+    {
+        old_ = read();
+        const State want = old_ | kMask;
+        if ((need_restore_ = (want != old_))) write(want);
+    }
+
+    ~ScopedFlushDenormals()
+    {
+        if (need_restore_) write(old_);
+    }
+
+    ScopedFlushDenormals(const ScopedFlushDenormals&) = delete;
+    ScopedFlushDenormals& operator=(const ScopedFlushDenormals&) = delete;
+
+    // True if the calling thread currently flushes denormals (all mode bits set).
+    static bool active() noexcept { return kMask != 0 && (read() & kMask) == kMask; }
+
+private:
+#if defined(JAMWIDE_FTZ_SSE)
+    typedef unsigned int State;
+    static constexpr State kMask = 0x8040;   // FTZ | DAZ
+    static State read() noexcept { return _mm_getcsr(); }
+    static void write(State s) noexcept { _mm_setcsr(s); }
+#elif defined(JAMWIDE_FTZ_ARM)
+    typedef unsigned long State;
+    static constexpr State kMask = 1ul << 24;   // FZ
+    static State read() noexcept
+    {
+        unsigned long v;
+  #ifdef __aarch64__
+        asm volatile("mrs %0, fpcr" : "=r"(v));
+  #else
+        asm volatile("fmrx %0, fpscr" : "=r"(v));
+  #endif
+        return v;
+    }
+    static void write(State v) noexcept
+    {
+  #ifdef __aarch64__
+        asm volatile("msr fpcr, %0" :: "r"(v));
+  #else
+        asm volatile("fmxr fpscr, %0" :: "r"(v));
+  #endif
+    }
+#else
+    typedef unsigned int State;
+    static constexpr State kMask = 0;
+    static State read() noexcept { return 0; }
+    static void write(State) noexcept {}
+#endif
+
+    State old_ = 0;
+    bool need_restore_ = false;
+};
+
+// Values that only ever decay (VU peaks times the per-block decay) are
+// snapped to zero well before they could go subnormal, independent of the
+// FPU mode: 1e-20 is ~-400 dBFS, and even the steepest per-block decay
+// cannot take it below FLT_MIN in one step.
+inline float flushDenormal(float v) noexcept
+{
+    return (v < 1.0e-20f && v > -1.0e-20f) ? 0.0f : v;
+}
+
+inline double flushDenormal(double v) noexcept
+{
+    return (v < 1.0e-20 && v > -1.0e-20) ? 0.0 : v;
+}
+
+} // namespace jamwide
+
+#endif // DENORMAL_GUARD_H
@@ -0,0 +1,161 @@
+/*
+    JamWide Plugin - hash_index.h
+    Open-addressing pointer index for NJClient lookups
+
+    Copyright (C) 2026 JamWide Contributors
+    Licensed under GPLv2+
+
+    NJClient keeps its remote users and in-flight downloads in WDL_PtrLists
+    (order matters: user indices are part of the public API). Matching an
+    interval write to its RemoteDownload by GUID, or a server message to its
+    RemoteUser by name, used to scan those lists with memcmp/strcmp for every
+    network chunk. PtrHashIndex sits next to a list and answers the same
+    question in O(1): a power-of-two table of {hash, pointer} slots with
+    linear probing. A probe compares cached hashes first and only touches the
+    object when one matches, so a lookup usually reads one cache line.
+
+    The index does not own anything. The caller inserts and erases in step
+    with the list it shadows. Keys live in the objects themselves (the
+    Traits read them back), so they must not change while indexed.
+
+    Traits:
+      typedef ... Key;                          // e.g. const char *
+      static uint32_t hash(Key k);
+      static Key key(const T *v);
+      static bool equal(const T *v, Key k);
+
+    Duplicate keys are allowed; find() returns one of them. Erase is by
+    pointer, with backward-shift deletion (no tombstones), so the table never
+    degrades under churn. It grows at 50% load and never shrinks.
+
+    Not thread-safe; NJClient uses it on the run thread (user lookups under
+    m_users_cs, like the list itself).
+*/
+
+#ifndef HASH_INDEX_H
+#define HASH_INDEX_H
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+namespace jamwide {
+
+// FNV-1a. GUIDs are random and usernames are short; this is plenty.
+inline uint32_t hashBytes(const void *data, size_t len) noexcept
+{
+    const unsigned char *p = static_cast<const unsigned char *>(data);
+    uint32_t h = 2166136261u;
+    for (size_t i = 0; i < len; ++i) { h ^= p[i]; h *= 16777619u; }
+    return h;
+}
+
+inline uint32_t hashString(const char *s) noexcept
+{
+    uint32_t h = 2166136261u;
+    for (; s && *s; ++s) { h ^= (unsigned char)*s; h *= 16777619u; }
+    return h;
+}
+
+template <typename T, typename Traits>
+class PtrHashIndex {
+public:
+    using Key = typename Traits::Key;
+
+    PtrHashIndex() = default;
+    PtrHashIndex(const PtrHashIndex &) = delete;
+    PtrHashIndex &operator=(const PtrHashIndex &) = delete;
+
+    T *find(Key k) const
+    {
+        if (m_slots.empty()) return nullptr;
+        const uint32_t h = Traits::hash(k);
+        const size_t mask = m_slots.size() - 1;
+        for (size_t i = h & mask;; i = (i + 1) & mask)
+        {
+            const Slot &s = m_slots[i];
+            if (!s.ptr) return nullptr;
+            if (s.hash == h && Traits::equal(s.ptr, k)) return s.ptr;
+        }
+    }
+
+    void insert(T *v)
+    {
+        if (!v) return;
+        if ((m_count + 1) * 2 > m_slots.size()) grow();
+        place(Traits::hash(Traits::key(v)), v);
+        ++m_count;
+    }
+
+    // Removes this exact pointer. Returns false if it wasn't indexed.
+    bool erase(T *v)
+    {
+        if (!v || m_slots.empty()) return false;
+        const uint32_t h = Traits::hash(Traits::key(v));
+        const size_t mask = m_slots.size() - 1;
+        size_t i = h & mask;
+        for (;; i = (i + 1) & mask)
+        {
+            if (!m_slots[i].ptr) return false;
+            if (m_slots[i].ptr == v) break;
+        }
+
+        // Backward-shift: pull later entries of the cluster into the hole if
+        // their home slot is not in (hole, j].
+        size_t hole = i;
+        for (size_t j = (i + 1) & mask; m_slots[j].ptr; j = (j + 1) & mask)
+        {
+            const size_t home = m_slots[j].hash & mask;
+            const bool movable = hole <= j ? (home <= hole || home > j)
+                                           : (home <= hole && home > j);
+            if (movable)
+            {
+                m_slots[hole] = m_slots[j];
+                hole = j;
+            }
+        }
+        m_slots[hole] = Slot{};
+        --m_count;
+        return true;
+    }
+
+    void clear()
+    {
+        for (Slot &s : m_slots) s = Slot{};
+        m_count = 0;
+    }
+
+    size_t size() const { return m_count; }
+    size_t capacity() const { return m_slots.size(); }
+
+private:
+    struct Slot {
+        uint32_t hash = 0;
+        T *ptr = nullptr;
+    };
+
+    void place(uint32_t h, T *v)
+    {
+        const size_t mask = m_slots.size() - 1;
+        size_t i = h & mask;
+        while (m_slots[i].ptr) i = (i + 1) & mask;
+        m_slots[i].hash = h;
+        m_slots[i].ptr = v;
+    }
+
+    void grow()
+    {
+        std::vector<Slot> old;
+        old.swap(m_slots);
+        m_slots.resize(old.empty() ? 16 : old.size() * 2);
+        for (const Slot &s : old)
+            if (s.ptr) place(s.hash, s.ptr);
+    }
+
+    std::vector<Slot> m_slots;
+    size_t m_count = 0;
+};
+
+} // namespace jamwide
+
+#endif // HASH_INDEX_H
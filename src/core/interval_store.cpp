@@ -0,0 +1,340 @@
+/*
+    JamWide Plugin - interval_store.cpp
+    Memory-mapped, append-only interval files (see interval_store.h)
+
+    Copyright (C) 2026 JamWide Contributors
+    Licensed under GPLv2+
+*/
+
+#include "interval_store.h"
+
+#include <string.h>
+
+#include <mutex>
+#include <vector>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace jamwide {
+
+// Writers whose file on disk is longer than their data (the segment), by
+// file identity (volume/device and file index/inode), so mapReadOnly can
+// stop at the data.
+struct FileId {
+  unsigned long long dev = 0, ino = 0;
+};
+struct LiveWriter {
+  FileId id;
+  const MappedIntervalFile *file;
+  const size_t *size;
+};
+static std::mutex g_live_mutex;
+static std::vector<LiveWriter> g_live;
+
+static void registerLiveWriter(const FileId &id, const MappedIntervalFile *file, const size_t *size)
+{
+  std::lock_guard<std::mutex> lk(g_live_mutex);
+  g_live.push_back(LiveWriter{ id, file, size });
+}
+
+static void unregisterLiveWriter(const MappedIntervalFile *file)
+{
+  std::lock_guard<std::mutex> lk(g_live_mutex);
+  for (size_t i = 0; i < g_live.size(); i++)
+  {
+    if (g_live[i].file == file)
+    {
+      g_live.erase(g_live.begin() + (ptrdiff_t)i);
+      return;
+    }
+  }
+}
+
+// `len` clamped to the logical size of a writer of the same file.
+static size_t liveLength(const FileId &id, size_t len)
+{
+  std::lock_guard<std::mutex> lk(g_live_mutex);
+  for (const LiveWriter &w : g_live)
+    if (w.id.dev == id.dev && w.id.ino == id.ino && *w.size < len)
+      len = *w.size;
+  return len;
+}
+
+#ifdef _WIN32
+
+static bool setFileLength(HANDLE h, size_t len)
+{
+  LARGE_INTEGER li;
+  li.QuadPart = (LONGLONG)len;
+  return SetFilePointerEx(h, li, NULL, FILE_BEGIN) && SetEndOfFile(h);
+}
+
+static bool fileIdentity(HANDLE h, FileId &id)
+{
+  BY_HANDLE_FILE_INFORMATION info;
+  if (!GetFileInformationByHandle(h, &info)) return false;
+  id.dev = info.dwVolumeSerialNumber;
+  id.ino = ((unsigned long long)info.nFileIndexHigh << 32) | info.nFileIndexLow;
+  return true;
+}
+
+bool MappedIntervalFile::openWrite(const char* path, size_t reserve)
+{
+  close();
+  if (!path || !*path) return false;
+
+  const int wlen = MultiByteToWideChar(CP_UTF8, 0, path, -1, NULL, 0);
+  if (wlen <= 0) return false;
+  std::vector<WCHAR> wpath(wlen);
+  MultiByteToWideChar(CP_UTF8, 0, path, -1, wpath.data(), wlen);
+
+  m_file = CreateFileW(wpath.data(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ,
+                       NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+  if (m_file == INVALID_HANDLE_VALUE) return false;
+
+  FileId id;
+  if (fileIdentity(m_file, id))
+  {
+    registerLiveWriter(id, this, &m_size);
+    m_registered = true;
+  }
+
+  m_writable = true;
+  if (!growTo(reserve ? reserve : kInitialReserve))
+  {
+    close();
+    return false;
+  }
+  return true;
+}
+
+bool MappedIntervalFile::growTo(size_t capacity)
+{
+  unmap();
+  if (!setFileLength(m_file, capacity)) return false;
+  m_mapping = CreateFileMappingW(m_file, NULL, PAGE_READWRITE,
+                                 (DWORD)((unsigned long long)capacity >> 32),
+                                 (DWORD)(capacity & 0xffffffff), NULL);
+  if (!m_mapping) return false;
+  m_base = (unsigned char*)MapViewOfFile(m_mapping, FILE_MAP_WRITE, 0, 0, capacity);
+  if (!m_base) return false;
+  m_capacity = capacity;
+  return true;
+}
+
+bool MappedIntervalFile::mapReadOnly(FILE* fp)
+{
+  close();
+  if (!fp) return false;
+  HANDLE h = (HANDLE)_get_osfhandle(_fileno(fp));
+  if (h == INVALID_HANDLE_VALUE) return false;
+
+  LARGE_INTEGER len;
+  if (!GetFileSizeEx(h, &len)) return false;
+
+  // Still being written here: only the appended bytes are data.
+  FileId id;
+  if (fileIdentity(h, id))
+    len.QuadPart = (LONGLONG)liveLength(id, (size_t)len.QuadPart);
+  if (len.QuadPart == 0)
+  {
+    m_open_empty = true;
+    return true;
+  }
+
+  HANDLE mapping = CreateFileMappingW(h, NULL, PAGE_READONLY, 0, 0, NULL);
+  if (!mapping) return false;
+  m_base = (unsigned char*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, (SIZE_T)len.QuadPart);
+  // the view holds its own reference to the section
+  CloseHandle(mapping);
+  if (!m_base) return false;
+  m_size = m_capacity = (size_t)len.QuadPart;
+  return true;
+}
+
+void MappedIntervalFile::unmap()
+{
+  if (m_base) UnmapViewOfFile(m_base);
+  m_base = nullptr;
+  if (m_mapping) CloseHandle(m_mapping);
+  m_mapping = NULL;
+  m_capacity = 0;
+}
+
+void MappedIntervalFile::close()
+{
+  unmap();
+  if (m_registered)
+  {
+    unregisterLiveWriter(this);
+    m_registered = false;
+  }
+  if (m_file != INVALID_HANDLE_VALUE)
+  {
+    setFileLength(m_file, m_size);
+    CloseHandle(m_file);
+    m_file = INVALID_HANDLE_VALUE;
+  }
+  m_size = 0;
+  m_writable = false;
+  m_open_empty = false;
+}
+
+#else // !_WIN32
+
+static bool fileIdentity(int fd, FileId &id)
+{
+  struct stat st;
+  if (fstat(fd, &st) != 0) return false;
+  id.dev = (unsigned long long)st.st_dev;
+  id.ino = (unsigned long long)st.st_ino;
+  return true;
+}
+
+bool MappedIntervalFile::openWrite(const char* path, size_t reserve)
+{
+  close();
+  if (!path || !*path) return false;
+
+  m_fd = ::open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+  if (m_fd < 0) return false;
+
+  FileId id;
+  if (fileIdentity(m_fd, id))
+  {
+    registerLiveWriter(id, this, &m_size);
+    m_registered = true;
+  }
+
+  m_writable = true;
+  if (!growTo(reserve ? reserve : kInitialReserve))
+  {
+    close();
+    return false;
+  }
+  return true;
+}
+
+bool MappedIntervalFile::growTo(size_t capacity)
+{
+  // The file grows with the segment, so append() is only a memcpy. Real
+  // blocks are reserved where the filesystem can, so a full disk shows up
+  // here as a failed append rather than as SIGBUS on a later store into
+  // the mapping; elsewhere the length alone is set.
+#if defined(__linux__)
+  if (fallocate(m_fd, 0, 0, (off_t)capacity) != 0)
+  {
+    if (errno != EOPNOTSUPP && errno != ENOSYS) return false;
+    if (ftruncate(m_fd, (off_t)capacity) != 0) return false;
+  }
+#else
+#if defined(__APPLE__)
+  fstore_t fs = { F_ALLOCATEALL, F_PEOFPOSMODE, 0, (off_t)capacity, 0 };
+  fcntl(m_fd, F_PREALLOCATE, &fs);
+#endif
+  if (ftruncate(m_fd, (off_t)capacity) != 0) return false;
+#endif
+
+  void* p;
+#if defined(__linux__)
+  if (m_base)
+    p = mremap(m_base, m_capacity, capacity, MREMAP_MAYMOVE);
+  else
+#endif
+  {
+    unmap();
+    p = mmap(NULL, capacity, PROT_READ | PROT_WRITE, MAP_SHARED, m_fd, 0);
+  }
+  // on failure mremap leaves the old mapping in place (close() drops it);
+  // the plain mmap path has already unmapped
+  if (p == MAP_FAILED) return false;
+  m_base = (unsigned char*)p;
+  m_capacity = capacity;
+  return true;
+}
+
+bool MappedIntervalFile::mapReadOnly(FILE* fp)
+{
+  close();
+  if (!fp) return false;
+  const int fd = fileno(fp);
+  struct stat st;
+  if (fd < 0 || fstat(fd, &st) != 0) return false;
+  // Still being written here: only the appended bytes are data.
+  FileId id;
+  id.dev = (unsigned long long)st.st_dev;
+  id.ino = (unsigned long long)st.st_ino;
+  const size_t len = liveLength(id, (size_t)st.st_size);
+  if (len == 0)
+  {
+    m_open_empty = true;
+    return true;
+  }
+
+  void* p = mmap(NULL, len, PROT_READ, MAP_SHARED, fd, 0);
+  if (p == MAP_FAILED) return false;
+  // sequential playback: ask for aggressive readahead
+  madvise(p, len, MADV_SEQUENTIAL);
+  m_base = (unsigned char*)p;
+  m_size = m_capacity = len;
+  return true;
+}
+
+void MappedIntervalFile::unmap()
+{
+  if (m_base) munmap(m_base, m_capacity);
+  m_base = nullptr;
+  m_capacity = 0;
+}
+
+void MappedIntervalFile::close()
+{
+  unmap();
+  if (m_registered)
+  {
+    unregisterLiveWriter(this);
+    m_registered = false;
+  }
+  if (m_fd >= 0)
+  {
+    // trim the segment to the data (frees the reserved blocks past it)
+    if (m_writable && ftruncate(m_fd, (off_t)m_size) != 0) { /* best effort */ }
+    ::close(m_fd);
+    m_fd = -1;
+  }
+  m_size = 0;
+  m_writable = false;
+  m_open_empty = false;
+}
+
+#endif // _WIN32
+
+bool MappedIntervalFile::append(const void* buf, size_t len)
+{
+  if (!m_writable || !m_base) return false;
+  if (!len) return true;
+
+  if (m_size + len > m_capacity)
+  {
+    size_t cap = m_capacity ? m_capacity : kInitialReserve;
+    while (cap < m_size + len) cap *= 2;
+    if (!growTo(cap))
+    {
+      close();
+      return false;
+    }
+  }
+  memcpy(m_base + m_size, buf, len);
+  m_size += len;
+  return true;
+}
+
+} // namespace jamwide
@@ -0,0 +1,107 @@
+/*
+    JamWide Plugin - interval_store.h
+    Memory-mapped, append-only interval files
+
+    Copyright (C) 2026 JamWide Contributors
+    Licensed under GPLv2+
+
+    Downloaded intervals are cached on disk (one file per GUID, named by
+    NJClient::makeFilenameFromGuid plus the codec fourcc) when
+    config_savelocalaudio > 0 or the channel is a session channel. The old
+    path did fwrite + fflush on every network chunk, and session-mode
+    playback read the files back with fread, 4 x 4 KB per file per run-loop
+    tick. Long recordings ended up as a storm of tiny syscalls.
+
+    MappedIntervalFile replaces both sides:
+
+      Writer (RemoteDownload): openWrite() reserves a segment and maps it.
+      append() is a memcpy into the mapping. When it runs out of room the
+      segment doubles (one reserve and remap, amortised O(1) per byte).
+      There is no per-chunk flush; the kernel writes dirty pages back.
+
+      Reader (session-mode refill): mapReadOnly() maps an already-open file
+      once. refillSessionmodeBuffers then copies straight from the mapping
+      into the DecodeMediaBuffer SPSC. There is no fread and no bounce buffer.
+      The mapping stays valid after the caller closes its FILE* or fd.
+
+    The file length grows with the segment (in the same doubling steps,
+    with real blocks reserved where the filesystem can), and close() trims
+    it to the data. The reserve must never look like data, though: a zero
+    tail is not harmless (the Opus framing reads two zero bytes as a lost
+    packet and conceals it). So writers register their logical size by
+    file identity, and mapReadOnly() of a file still being written in this
+    process maps only that much. Readers map what is there at open time,
+    so playback of an in-flight download stops where its data did, as with
+    the old partial fread. A crash can leave the zero-filled tail on disk.
+
+    The audio thread never touches a mapping. A page fault there would be as
+    bad as the fread it replaced (H-04).
+
+    Run-thread only; not thread-safe.
+*/
+
+#ifndef INTERVAL_STORE_H
+#define INTERVAL_STORE_H
+
+#include <stddef.h>
+#include <stdio.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+namespace jamwide {
+
+class MappedIntervalFile {
+public:
+    // Initial writer segment. One interval at 128 kbps / 16 s is ~256 KB;
+    // higher bitrates and longer intervals grow by doubling.
+    static constexpr size_t kInitialReserve = 256 * 1024;
+
+    MappedIntervalFile() = default;
+    ~MappedIntervalFile() { close(); }
+    MappedIntervalFile(const MappedIntervalFile&) = delete;
+    MappedIntervalFile& operator=(const MappedIntervalFile&) = delete;
+
+    // Create/truncate `path` (UTF-8) and map a `reserve`-byte segment for
+    // appending. Returns false (and stays closed) on any failure.
+    bool openWrite(const char* path, size_t reserve = kInitialReserve);
+
+    // Map the whole of an already-open file read-only. `fp` stays owned by
+    // the caller and may be closed immediately afterwards. An empty file
+    // succeeds with size() == 0.
+    bool mapReadOnly(FILE* fp);
+
+    // Writer only. Returns false if the segment could not be grown (disk
+    // full, mapping failure); the store is closed in that case and the bytes
+    // written so far are kept.
+    bool append(const void* buf, size_t len);
+
+    // Writer: unmap and trim the file to size(). Reader: unmap.
+    void close();
+
+    bool isOpen() const { return m_base != nullptr || m_open_empty; }
+    const unsigned char* data() const { return m_base; }
+    size_t size() const { return m_size; }
+
+private:
+    bool growTo(size_t capacity);
+    void unmap();
+
+    unsigned char* m_base = nullptr;
+    size_t m_size = 0;      // logical length (bytes appended / file length)
+    size_t m_capacity = 0;  // mapped length
+    bool m_writable = false;
+    bool m_open_empty = false;
+    bool m_registered = false;   // in the live-writer table
+#ifdef _WIN32
+    HANDLE m_file = INVALID_HANDLE_VALUE;
+    HANDLE m_mapping = NULL;
+#else
+    int m_fd = -1;
+#endif
+};
+
+} // namespace jamwide
+
+#endif // INTERVAL_STORE_H
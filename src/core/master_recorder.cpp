@@ -0,0 +1,381 @@
+/*
+    JamWide Plugin - master_recorder.cpp
+    Streaming master-mix recorder with its own I/O thread (see master_recorder.h)
+
+    Copyright (C) 2026 JamWide Contributors
+    Licensed under GPLv2+
+*/
+
+#include "master_recorder.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstring>
+
+namespace jamwide {
+
+static const int kSilenceFrames = 4096;
+
+MasterRecorder::~MasterRecorder()
+{
+    stopAndWait();
+}
+
+// With control_mutex_ held. gen_ is cleared before quit is raised (see
+// run()), under wake_mutex_ so a deferred writer cannot set it afterwards.
+void MasterRecorder::requestStop(Writer& w)
+{
+    {
+        std::lock_guard<std::mutex> lk(wake_mutex_);
+        gen_.store(0, std::memory_order_release);
+        w.quit.store(true, std::memory_order_release);
+    }
+    wake_cv_.notify_all();
+}
+
+void MasterRecorder::resetStats()
+{
+    frames_written_.store(0, std::memory_order_relaxed);
+    gap_frames_.store(0, std::memory_order_relaxed);
+    blocks_dropped_.store(0, std::memory_order_relaxed);
+    fifo_high_water_.store(0, std::memory_order_relaxed);
+    slow_drains_.store(0, std::memory_order_relaxed);
+    max_drain_ms_.store(0, std::memory_order_relaxed);
+    sink_errors_.store(0, std::memory_order_relaxed);
+}
+
+static void finishAll(std::vector<std::unique_ptr<MasterRecorderSink>>& sinks)
+{
+    for (auto& s : sinks)
+        if (s) s->finish();
+    sinks.clear();
+}
+
+static std::vector<std::unique_ptr<MasterRecorderSink>> liveSinks(std::vector<std::unique_ptr<MasterRecorderSink>> sinks)
+{
+    std::vector<std::unique_ptr<MasterRecorderSink>> live;
+    for (auto& s : sinks)
+        if (s) live.push_back(std::move(s));
+    return live;
+}
+
+bool MasterRecorder::start(std::vector<std::unique_ptr<MasterRecorderSink>> sinks)
+{
+    std::unique_ptr<Writer> w(new Writer);
+    w->sinks = liveSinks(std::move(sinks));
+    return launch(std::move(w));
+}
+
+bool MasterRecorder::start(SinkOpener open)
+{
+    std::unique_ptr<Writer> w(new Writer);
+    w->open = std::move(open);
+    return launch(std::move(w));
+}
+
+bool MasterRecorder::launch(std::unique_ptr<Writer> w)
+{
+    std::lock_guard<std::mutex> lock(control_mutex_);
+    if (writer_) requestStop(*writer_);
+
+    // Still finishing: the new writer waits for it, so the files and gen_
+    // come from its thread. Otherwise start here and report failures.
+    w->deferred = live_writers_.load(std::memory_order_acquire) > 0;
+    if (w->open && !w->deferred)
+    {
+        w->sinks = liveSinks(w->open());
+        w->open = nullptr;
+    }
+    if ((!w->open && w->sinks.empty()) || !fifo_.allocate(fifo_bytes_))
+    {
+        finishAll(w->sinks);
+        return false;
+    }
+
+    const int gen = last_gen_ < 0x7fffffff ? last_gen_ + 1 : 1;
+    last_gen_ = gen;
+    w->gen = gen;
+    w->prev = std::move(writer_);
+    if (!w->deferred) resetStats();
+    live_writers_.fetch_add(1, std::memory_order_acq_rel);
+    try
+    {
+        w->thread = std::thread(&MasterRecorder::run, this, w.get());
+    }
+    catch (...)
+    {
+        live_writers_.fetch_sub(1, std::memory_order_acq_rel);
+        writer_ = std::move(w->prev);
+        finishAll(w->sinks);
+        return false;
+    }
+    if (!w->deferred) gen_.store(gen, std::memory_order_release);
+    writer_ = std::move(w);
+    return true;
+}
+
+void MasterRecorder::stop()
+{
+    std::lock_guard<std::mutex> lock(control_mutex_);
+    if (writer_) requestStop(*writer_);
+}
+
+void MasterRecorder::stopAndWait()
+{
+    std::lock_guard<std::mutex> lock(control_mutex_);
+    if (!writer_) return;
+    requestStop(*writer_);
+    if (writer_->thread.joinable()) writer_->thread.join();
+    writer_.reset();
+}
+
+bool MasterRecorder::push(const float* l, const float* r, int frames) noexcept
+{
+    const int gen = gen_.load(std::memory_order_acquire);
+    if (!gen || !l || frames <= 0) return false;
+    if (gap_gen_ != gen)
+    {
+        gap_gen_ = gen;
+        gap_owed_ = 0;
+    }
+
+    // Settle a pending gap first so the silence lands where the audio went
+    // missing, then the block itself.
+    bool ok = !gap_owed_ || fifo_.push(gen, (double) gap_owed_, nullptr, 0, 0);
+    if (ok)
+    {
+        gap_owed_ = 0;
+        ok = fifo_.push(gen, 0.0, l, frames, 2, r ? r : l);
+    }
+    if (!ok)
+    {
+        gap_owed_ += (uint64_t) frames;
+        blocks_dropped_.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    const uint64_t used = fifo_.bytesUsed();
+    if (used > fifo_high_water_.load(std::memory_order_relaxed))
+        fifo_high_water_.store(used, std::memory_order_relaxed);
+    return true;
+}
+
+void MasterRecorder::getStats(MasterRecorderStats& out) const noexcept
+{
+    out.recording       = recording();
+    out.finishing       = !out.recording && live_writers_.load(std::memory_order_acquire) > 0;
+    out.frames_written  = frames_written_.load(std::memory_order_relaxed);
+    out.gap_frames      = gap_frames_.load(std::memory_order_relaxed);
+    out.blocks_dropped  = blocks_dropped_.load(std::memory_order_relaxed);
+    out.fifo_bytes      = fifo_.capacity();
+    out.fifo_high_water = fifo_high_water_.load(std::memory_order_relaxed);
+    out.slow_drains     = slow_drains_.load(std::memory_order_relaxed);
+    out.max_drain_ms    = max_drain_ms_.load(std::memory_order_relaxed);
+    out.sink_errors     = sink_errors_.load(std::memory_order_relaxed);
+}
+
+void MasterRecorder::run(Writer* w)
+{
+    // The writer this one replaced has stopped; wait for it to drain its
+    // part of the ring and close its files (it joined its own predecessor).
+    if (w->prev)
+    {
+        if (w->prev->thread.joinable()) w->prev->thread.join();
+        w->prev.reset();
+    }
+    if (w->deferred)
+    {
+        resetStats();
+        if (w->open)
+        {
+            w->sinks = liveSinks(w->open());
+            w->open = nullptr;
+            if (w->sinks.empty()) sink_errors_.fetch_add(1, std::memory_order_relaxed);
+        }
+        std::lock_guard<std::mutex> lk(wake_mutex_);
+        if (!w->sinks.empty() && !w->quit.load(std::memory_order_relaxed))
+            gen_.store(w->gen, std::memory_order_release);
+    }
+
+    silence_.assign(kSilenceFrames, 0.0f);
+    while (!w->sinks.empty())   // emptied by writeAll when every sink failed
+    {
+        // Read quit before draining: stop() cleared gen_ first, so once quit
+        // is seen the pass below picks up everything that was accepted.
+        const bool quit = w->quit.load(std::memory_order_acquire);
+        drainOnce(*w);
+        if (quit) break;
+        std::unique_lock<std::mutex> lk(wake_mutex_);
+        wake_cv_.wait_for(lk, std::chrono::milliseconds(kWakeMs),
+                          [w] { return w->quit.load(std::memory_order_relaxed); });
+    }
+    finishAll(w->sinks);
+    live_writers_.fetch_sub(1, std::memory_order_acq_rel);
+}
+
+void MasterRecorder::drainOnce(Writer& w)
+{
+    if (fifo_.empty()) return;
+    const auto t0 = std::chrono::steady_clock::now();
+    const int gen = w.gen;
+    fifo_.drain([this, &w, gen](const SampleBlockHeader& h, const float* s1, const float* s2) {
+        if (h.attr != gen) return;   // pushed just as an earlier recording stopped
+        if (h.sample_count <= 0)
+        {
+            uint64_t gap = (uint64_t) h.startpos;
+            gap_frames_.fetch_add(gap, std::memory_order_relaxed);
+            while (gap > 0)
+            {
+                const int n = gap < (uint64_t) kSilenceFrames ? (int) gap : kSilenceFrames;
+                writeAll(w, silence_.data(), silence_.data(), n);
+                gap -= (uint64_t) n;
+            }
+            return;
+        }
+        writeAll(w, s1, s2 ? s2 : s1, h.sample_count);
+    });
+    const auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - t0).count();
+    if ((uint32_t) ms > max_drain_ms_.load(std::memory_order_relaxed))
+        max_drain_ms_.store((uint32_t) ms, std::memory_order_relaxed);
+    if (ms >= kSlowDrainMs)
+        slow_drains_.fetch_add(1, std::memory_order_relaxed);
+}
+
+void MasterRecorder::writeAll(Writer& w, const float* l, const float* r, int frames)
+{
+    if (w.sinks.empty()) return;
+    for (size_t i = 0; i < w.sinks.size();)
+    {
+        if (w.sinks[i]->write(l, r, frames))
+        {
+            i++;
+            continue;
+        }
+        w.sinks[i]->finish();
+        w.sinks.erase(w.sinks.begin() + (std::ptrdiff_t) i);
+        sink_errors_.fetch_add(1, std::memory_order_relaxed);
+    }
+    if (w.sinks.empty())
+    {
+        // Every file failed (disk full...): the recording is over. run()
+        // exits after this drain; a stop() or restart may already have
+        // cleared gen_, so only this recording's value is taken back.
+        int gen = w.gen;
+        gen_.compare_exchange_strong(gen, 0, std::memory_order_acq_rel);
+        return;
+    }
+    frames_written_.fetch_add((uint64_t) frames, std::memory_order_relaxed);
+}
+
+// ---------------------------------------------------------------------------
+// WavFileSink
+
+static void putLE(unsigned char* p, uint32_t v, int bytes)
+{
+    for (int i = 0; i < bytes; i++) p[i] = (unsigned char) (v >> (8 * i));
+}
+
+static void buildWavHeader(unsigned char h[44], int srate, int bytes_per_sample, uint64_t data_bytes)
+{
+    const uint32_t data = data_bytes > 0xffffffffull - 36 ? 0xffffffffu - 36 : (uint32_t) data_bytes;
+    const int block_align = 2 * bytes_per_sample;
+    std::memcpy(h, "RIFF", 4);
+    putLE(h + 4, data + 36, 4);
+    std::memcpy(h + 8, "WAVEfmt ", 8);
+    putLE(h + 16, 16, 4);                                // fmt chunk size
+    putLE(h + 20, 1, 2);                                 // PCM
+    putLE(h + 22, 2, 2);                                 // channels
+    putLE(h + 24, (uint32_t) srate, 4);
+    putLE(h + 28, (uint32_t) (srate * block_align), 4);  // bytes per second
+    putLE(h + 32, (uint32_t) block_align, 2);
+    putLE(h + 34, (uint32_t) (8 * bytes_per_sample), 2);
+    std::memcpy(h + 36, "data", 4);
+    putLE(h + 40, data, 4);
+}
+
+std::unique_ptr<WavFileSink> WavFileSink::open(FILE* fp, int srate, int bits)
+{
+    if (!fp) return nullptr;
+    if (srate <= 0 || (bits != 16 && bits != 24))
+    {
+        std::fclose(fp);
+        return nullptr;
+    }
+    // All writes are kBufferBytes blocks from buf_; a stdio buffer would
+    // only add a copy.
+    std::setvbuf(fp, nullptr, _IONBF, 0);
+    unsigned char h[44];
+    buildWavHeader(h, srate, bits / 8, 0);
+    if (std::fwrite(h, 1, sizeof(h), fp) != sizeof(h))
+    {
+        std::fclose(fp);
+        return nullptr;
+    }
+    return std::unique_ptr<WavFileSink>(new WavFileSink(fp, srate, bits));
+}
+
+WavFileSink::WavFileSink(FILE* fp, int srate, int bits)
+    : fp_(fp), srate_(srate), bytes_per_sample_(bits / 8), buf_(kBufferBytes)
+{
+}
+
+static inline int toPcm(float v, float scale)
+{
+    if (!(v > -1.0f)) v = v != v ? 0.0f : -1.0f;   // NaN -> 0
+    else if (v > 1.0f) v = 1.0f;
+    return (int) std::lrintf(v * scale);
+}
+
+bool WavFileSink::write(const float* l, const float* r, int frames)
+{
+    if (!fp_ || failed_) return false;
+    const std::size_t frame_bytes = 2 * (std::size_t) bytes_per_sample_;
+    const float scale = bytes_per_sample_ == 2 ? 32767.0f : 8388607.0f;
+    int done = 0;
+    while (done < frames)
+    {
+        if (buf_.size() - used_ < frame_bytes && !flush()) return false;
+        int n = (int) ((buf_.size() - used_) / frame_bytes);
+        if (n > frames - done) n = frames - done;
+        unsigned char* p = buf_.data() + used_;
+        for (int i = done; i < done + n; i++)
+        {
+            const int a = toPcm(l[i], scale), b = toPcm(r[i], scale);
+            putLE(p, (uint32_t) a, bytes_per_sample_);
+            putLE(p + bytes_per_sample_, (uint32_t) b, bytes_per_sample_);
+            p += frame_bytes;
+        }
+        used_ += (std::size_t) n * frame_bytes;
+        done += n;
+    }
+    return true;
+}
+
+bool WavFileSink::flush()
+{
+    if (!used_) return true;
+    if (std::fwrite(buf_.data(), 1, used_, fp_) != used_)
+    {
+        failed_ = true;
+        return false;
+    }
+    data_bytes_ += used_;
+    used_ = 0;
+    return true;
+}
+
+void WavFileSink::finish()
+{
+    if (!fp_) return;
+    if (!failed_ && flush() && std::fseek(fp_, 0, SEEK_SET) == 0)
+    {
+        unsigned char h[44];
+        buildWavHeader(h, srate_, bytes_per_sample_, data_bytes_);
+        std::fwrite(h, 1, sizeof(h), fp_);
+    }
+    std::fclose(fp_);
+    fp_ = nullptr;
+}
+
+} // namespace jamwide
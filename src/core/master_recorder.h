@@ -0,0 +1,225 @@
+/*
+    JamWide Plugin - master_recorder.h
+    Streaming master-mix recorder with its own I/O thread
+
+    Copyright (C) 2026 JamWide Contributors
+    Licensed under GPLv2+
+
+    The master recording (the pre-master-volume mix written to WAV/OGG) used
+    to travel audio thread -> 512 KB m_wave_block_q -> run thread, which
+    copied each block into m_wavebq and then encoded and fwrite()n it inside
+    NJClient::Run. A slow disk (or a slow vorbis encode) stalled the network
+    loop, and 1.3 s of FIFO at 48 kHz overflowed into m_block_queue_drops,
+    leaving spliced gaps in the file.
+
+    MasterRecorder moves all of that onto a dedicated thread:
+      - push() (audio thread) copies the block into a large SampleFifo
+        allocated once, on the first start(), with its pages faulted in
+        (16 MB by default: ~43 s of 48 kHz stereo float). Nothing else: no
+        wakeup, no lock. When the ring is full the block is counted as
+        dropped and its length is carried into a gap marker (a header-only
+        record whose startpos holds the frame count) ahead of the next block
+        that fits, so the writer fills the hole with silence and the file
+        stays sample-aligned with the session.
+      - The recorder thread wakes every kWakeMs, drains whatever is queued
+        and hands it to each MasterRecorderSink in order. Sinks do their own
+        large-block buffering; a sink whose write fails is finished and
+        dropped, the others keep going. When the last one fails the
+        recording ends on its own (recording() turns false).
+      - stop() only flips the flags and wakes the thread, which drains the
+        ring, finishes the sinks (closing the files) and exits on its own,
+        so the caller (the run thread for /record) never waits on the disk.
+      - start() over a recording retires the old writer the same way and
+        hands it to the new writer thread, which joins it before touching
+        the ring (one consumer at a time). If the old writer is still
+        finishing, the new recording (and, with a SinkOpener, its files, so
+        a reused name is not opened twice) begins once it is done; otherwise
+        at once. Only stopAndWait() and the destructor wait.
+
+    Each recording gets a generation number, carried in the block attr, so
+    a block pushed just as one recording stopped is discarded rather than
+    written into the next one.
+
+    WavFileSink is the PCM sink (16/24-bit). The compressed sinks (OGG
+    Vorbis, FLAC) wrap NJClient's encoders and live in njclient.cpp.
+
+    Thread Safety:
+      - start()/stop()/stats from control threads; serialized internally.
+      - push() from the audio thread only (single producer).
+      - Sinks are only touched on the recorder thread once start() returns.
+*/
+
+#ifndef MASTER_RECORDER_H
+#define MASTER_RECORDER_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "threading/sample_fifo.h"
+
+namespace jamwide {
+
+// One output file of a recording. Called on the recorder thread only.
+class MasterRecorderSink {
+public:
+    virtual ~MasterRecorderSink() {}
+
+    // Append `frames` stereo frames (l and r may alias for silence).
+    // Returns false on an I/O error; the sink is then finished and dropped.
+    virtual bool write(const float* l, const float* r, int frames) = 0;
+
+    // Flush whatever is buffered and close the file.
+    virtual void finish() = 0;
+};
+
+struct MasterRecorderStats {
+    bool     recording = false;      // accepting audio
+    bool     finishing = false;      // stopped, recorder thread still flushing
+    uint64_t frames_written = 0;     // frames handed to the sinks, gap fill included
+    uint64_t gap_frames = 0;         // of those, silence written for dropped blocks
+    uint64_t blocks_dropped = 0;     // audio-thread pushes refused (ring full)
+    uint64_t fifo_bytes = 0;         // ring capacity
+    uint64_t fifo_high_water = 0;    // most bytes queued at once
+    uint64_t slow_drains = 0;        // drain passes slower than kSlowDrainMs
+    uint32_t max_drain_ms = 0;       // slowest drain pass
+    uint32_t sink_errors = 0;        // sinks dropped after a failed write
+};
+
+class MasterRecorder {
+public:
+    static constexpr std::size_t kDefaultFifoBytes = 16u << 20;
+    static constexpr int kWakeMs = 10;
+    static constexpr int kSlowDrainMs = 100;
+
+    // Creates the files of a recording; null entries are skipped.
+    typedef std::function<std::vector<std::unique_ptr<MasterRecorderSink>>()> SinkOpener;
+
+    explicit MasterRecorder(std::size_t fifo_bytes = kDefaultFifoBytes) : fifo_bytes_(fifo_bytes) {}
+    ~MasterRecorder();
+
+    MasterRecorder(const MasterRecorder&) = delete;
+    MasterRecorder& operator=(const MasterRecorder&) = delete;
+
+    // Start a recording into `sinks` (takes ownership), stopping any
+    // previous one first without waiting for it. Allocates the ring on
+    // first use. Returns false (sinks finished and freed) if there are
+    // none, the ring cannot be allocated or the thread cannot be started.
+    bool start(std::vector<std::unique_ptr<MasterRecorderSink>> sinks);
+
+    // Same, with the files created by `open`: on the caller's thread when
+    // no earlier recording is still finishing (false if it yields no
+    // sink), otherwise on the recorder thread once that one has closed its
+    // files (a failure then counts as a sink error).
+    bool start(SinkOpener open);
+
+    // Stop accepting audio; the recorder thread writes out what is queued,
+    // closes the sinks and exits. Does not wait for it.
+    void stop();
+
+    // stop() and wait until the files are closed.
+    void stopAndWait();
+
+    bool recording() const noexcept { return gen_.load(std::memory_order_relaxed) != 0; }
+
+    // Audio thread. Queues one stereo block of the mix (r may equal l).
+    // Returns false when not recording or when the block was dropped.
+    bool push(const float* l, const float* r, int frames) noexcept;
+
+    void getStats(MasterRecorderStats& out) const noexcept;
+
+    // Ring storage, for memory locking (nullptr/0 until the first start()).
+    const void* fifoData() const noexcept { return fifo_.data(); }
+    std::size_t fifoCapacity() const noexcept { return fifo_.capacity(); }
+
+private:
+    // One recording's thread. A retired writer is owned, and joined, by the
+    // writer that replaced it.
+    struct Writer {
+        std::thread thread;
+        int gen = 0;
+        bool deferred = false;             // gen_ set by the thread, not start()
+        std::atomic<bool> quit{false};     // set under wake_mutex_
+        std::vector<std::unique_ptr<MasterRecorderSink>> sinks;
+        SinkOpener open;
+        std::unique_ptr<Writer> prev;
+    };
+
+    bool launch(std::unique_ptr<Writer> w);
+    void resetStats();
+    void run(Writer* w);
+    void drainOnce(Writer& w);
+    void writeAll(Writer& w, const float* l, const float* r, int frames);
+    void requestStop(Writer& w);
+
+    const std::size_t fifo_bytes_;
+    SampleFifo fifo_;
+
+    std::mutex control_mutex_;   // start/stop, writer_
+    std::unique_ptr<Writer> writer_;
+    int last_gen_ = 0;
+    std::atomic<int> live_writers_{0};   // writer threads not yet finished
+
+    std::mutex wake_mutex_;
+    std::condition_variable wake_cv_;
+
+    // Audio thread: current generation (0 = not recording) and the frames
+    // dropped since the last block that fit, owed to the writer as a gap.
+    std::atomic<int> gen_{0};
+    int gap_gen_ = 0;
+    uint64_t gap_owed_ = 0;
+
+    // Writer threads, one at a time.
+    std::vector<float> silence_;
+
+    std::atomic<uint64_t> frames_written_{0};
+    std::atomic<uint64_t> gap_frames_{0};
+    std::atomic<uint64_t> blocks_dropped_{0};
+    std::atomic<uint64_t> fifo_high_water_{0};
+    std::atomic<uint64_t> slow_drains_{0};
+    std::atomic<uint32_t> max_drain_ms_{0};
+    std::atomic<uint32_t> sink_errors_{0};
+};
+
+// Stereo RIFF/WAVE PCM file (16 or 24 bit). Samples are converted into a
+// 1 MB buffer that goes to the file in one fwrite (stdio buffering off), so
+// a long recording is a sequence of large sequential writes. The header is
+// written with placeholder sizes and patched by finish(); sizes saturate at
+// the 4 GB RIFF limit.
+class WavFileSink : public MasterRecorderSink {
+public:
+    static constexpr std::size_t kBufferBytes = 1u << 20;
+
+    // Takes over fp, a file opened "wb" by the caller (NJClient uses
+    // fopenUTF8 for Windows paths). nullptr, with fp closed, if fp is null,
+    // bits is not 16/24 or the header cannot be written.
+    static std::unique_ptr<WavFileSink> open(FILE* fp, int srate, int bits);
+
+    ~WavFileSink() override { finish(); }
+
+    bool write(const float* l, const float* r, int frames) override;
+    void finish() override;
+
+private:
+    WavFileSink(FILE* fp, int srate, int bits);
+    bool flush();
+
+    FILE* fp_;
+    int srate_;
+    int bytes_per_sample_;
+    std::vector<unsigned char> buf_;
+    std::size_t used_ = 0;
+    uint64_t data_bytes_ = 0;
+    bool failed_ = false;
+};
+
+} // namespace jamwide
+
+#endif // MASTER_RECORDER_H
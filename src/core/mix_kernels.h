@@ -0,0 +1,278 @@
+/*
+    JamWide Plugin - mix_kernels.h
+    Vectorized gain/accumulate and peak-detection kernels for the audio mix
+
+    Copyright (C) 2026 JamWide Contributors
+    Licensed under GPLv2+
+
+    process_samples and mixInChannel used to walk every buffer one sample at
+    a time with the VU peak folded in as
+        if (f > maxf) maxf = f; else if (f < -maxf) maxf = -f;
+    a data-dependent branch per sample (two per frame in stereo), with the
+    monitor's mute test inside the same loop. That keeps the compiler from
+    vectorizing and mispredicts on any real signal.
+
+    These kernels do the same work four samples at a time: the peak is a
+    branchless running max of |x| (and-not of the sign bit, then max), gain
+    and accumulate are one multiply-add, and callers pick the mix or
+    peak-only kernel once per block instead of testing mute per sample.
+    Each kernel takes the running peak and returns the updated one, so the
+    decayed-peak bookkeeping in the callers is unchanged.
+
+    SSE2 on x86/x64, NEON on arm64, plain loops elsewhere (and for the
+    tails). Unaligned loads throughout: the buffers come from the host and
+    from offset positions inside them. The peak result is identical to the
+    scalar code for finite input.
+*/
+
+#ifndef MIX_KERNELS_H
+#define MIX_KERNELS_H
+
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+  #include <emmintrin.h>
+  #define JAMWIDE_MIX_SSE 1
+#elif defined(__aarch64__) || defined(_M_ARM64)
+  #include <arm_neon.h>
+  #define JAMWIDE_MIX_NEON 1
+#endif
+
+namespace jamwide {
+
+// -120 dBFS. A decoded block whose peak stays below this is treated as
+// digital silence: mixInChannel skips its multiply-accumulate.
+constexpr float kSilenceFloor = 1.0e-6f;
+
+namespace mixdetail {
+
+#if defined(JAMWIDE_MIX_SSE)
+typedef __m128 vf;
+inline vf vload(const float* p) { return _mm_loadu_ps(p); }
+inline void vstore(float* p, vf v) { _mm_storeu_ps(p, v); }
+inline vf vset(float f) { return _mm_set1_ps(f); }
+inline vf vadd(vf a, vf b) { return _mm_add_ps(a, b); }
+inline vf vmul(vf a, vf b) { return _mm_mul_ps(a, b); }
+inline vf vmax(vf a, vf b) { return _mm_max_ps(a, b); }
+inline vf vmin(vf a, vf b) { return _mm_min_ps(a, b); }
+inline vf vabs(vf a) { return _mm_andnot_ps(_mm_set1_ps(-0.0f), a); }
+#define JAMWIDE_MIX_VECTOR 1
+#elif defined(JAMWIDE_MIX_NEON)
+typedef float32x4_t vf;
+inline vf vload(const float* p) { return vld1q_f32(p); }
+inline void vstore(float* p, vf v) { vst1q_f32(p, v); }
+inline vf vset(float f) { return vdupq_n_f32(f); }
+inline vf vadd(vf a, vf b) { return vaddq_f32(a, b); }
+inline vf vmul(vf a, vf b) { return vmulq_f32(a, b); }
+inline vf vmax(vf a, vf b) { return vmaxq_f32(a, b); }
+inline vf vmin(vf a, vf b) { return vminq_f32(a, b); }
+inline vf vabs(vf a) { return vabsq_f32(a); }
+#define JAMWIDE_MIX_VECTOR 1
+#endif
+
+#ifdef JAMWIDE_MIX_VECTOR
+inline void vlanes(vf v, float out[4]) { vstore(out, v); }
+
+inline float hmax(vf v)
+{
+  float l[4];
+  vlanes(v, l);
+  const float a = l[0] > l[1] ? l[0] : l[1];
+  const float b = l[2] > l[3] ? l[2] : l[3];
+  return a > b ? a : b;
+}
+#endif
+
+inline float amax(float peak, float f)
+{
+  const float a = std::fabs(f);
+  return a > peak ? a : peak;
+}
+
+inline float clip1(float f)
+{
+  return f < -1.0f ? -1.0f : f > 1.0f ? 1.0f : f;
+}
+
+} // namespace mixdetail
+
+/** max(peak, |x[i]|) over n samples. */
+inline float peakAbs(const float* x, int n, float peak)
+{
+  using namespace mixdetail;
+  int i = 0;
+#ifdef JAMWIDE_MIX_VECTOR
+  if (n >= 4)
+  {
+    vf acc = vset(peak);
+    for (; i + 4 <= n; i += 4) acc = vmax(acc, vabs(vload(x + i)));
+    peak = hmax(acc);
+  }
+#endif
+  for (; i < n; i++) peak = amax(peak, x[i]);
+  return peak;
+}
+
+/** out[i] += x[i] * gain; returns max(peak, |x[i]|) (pre-gain, like the VU). */
+inline float mixPeak(float* out, const float* x, int n, float gain, float peak)
+{
+  using namespace mixdetail;
+  int i = 0;
+#ifdef JAMWIDE_MIX_VECTOR
+  if (n >= 4)
+  {
+    const vf g = vset(gain);
+    vf acc = vset(peak);
+    for (; i + 4 <= n; i += 4)
+    {
+      const vf v = vload(x + i);
+      acc = vmax(acc, vabs(v));
+      vstore(out + i, vadd(vload(out + i), vmul(v, g)));
+    }
+    peak = hmax(acc);
+  }
+#endif
+  for (; i < n; i++)
+  {
+    peak = amax(peak, x[i]);
+    out[i] += x[i] * gain;
+  }
+  return peak;
+}
+
+/**
+ * Mono downmix d = (a[i] + b[i]) * 0.5; out[i] += d * gain when out is
+ * non-null. Returns max(peak, |d|).
+ */
+inline float downmixPeak(float* out, const float* a, const float* b, int n, float gain, float peak)
+{
+  using namespace mixdetail;
+  int i = 0;
+#ifdef JAMWIDE_MIX_VECTOR
+  if (n >= 4)
+  {
+    const vf half = vset(0.5f);
+    const vf g = vset(gain);
+    vf acc = vset(peak);
+    if (out)
+    {
+      for (; i + 4 <= n; i += 4)
+      {
+        const vf d = vmul(vadd(vload(a + i), vload(b + i)), half);
+        acc = vmax(acc, vabs(d));
+        vstore(out + i, vadd(vload(out + i), vmul(d, g)));
+      }
+    }
+    else
+    {
+      for (; i + 4 <= n; i += 4)
+        acc = vmax(acc, vabs(vmul(vadd(vload(a + i), vload(b + i)), half)));
+    }
+    peak = hmax(acc);
+  }
+#endif
+  for (; i < n; i++)
+  {
+    const float d = (a[i] + b[i]) * 0.5f;
+    peak = amax(peak, d);
+    if (out) out[i] += d * gain;
+  }
+  return peak;
+}
+
+/** x[i] *= gain in place; returns max(peak, |x[i]|) of the scaled samples. */
+inline float scalePeak(float* x, int n, float gain, float peak)
+{
+  using namespace mixdetail;
+  int i = 0;
+#ifdef JAMWIDE_MIX_VECTOR
+  if (n >= 4)
+  {
+    const vf g = vset(gain);
+    vf acc = vset(peak);
+    for (; i + 4 <= n; i += 4)
+    {
+      const vf v = vmul(vload(x + i), g);
+      vstore(x + i, v);
+      acc = vmax(acc, vabs(v));
+    }
+    peak = hmax(acc);
+  }
+#endif
+  for (; i < n; i++)
+  {
+    x[i] *= gain;
+    peak = amax(peak, x[i]);
+  }
+  return peak;
+}
+
+/** Clamp x[i] to [-1, 1] in place; returns max(peak, |x[i]|) after clamping. */
+inline float clipPeak(float* x, int n, float peak)
+{
+  using namespace mixdetail;
+  int i = 0;
+#ifdef JAMWIDE_MIX_VECTOR
+  if (n >= 4)
+  {
+    const vf lo = vset(-1.0f), hi = vset(1.0f);
+    vf acc = vset(peak);
+    for (; i + 4 <= n; i += 4)
+    {
+      const vf v = vmin(vmax(vload(x + i), lo), hi);
+      vstore(x + i, v);
+      acc = vmax(acc, vabs(v));
+    }
+    peak = hmax(acc);
+  }
+#endif
+  for (; i < n; i++)
+  {
+    x[i] = clip1(x[i]);
+    peak = amax(peak, x[i]);
+  }
+  return peak;
+}
+
+/**
+ * clipPeak for `frames` interleaved stereo frames (2 * frames samples):
+ * even samples update *peak_l, odd samples *peak_r.
+ */
+inline void clipPeakStereo(float* x, int frames, float* peak_l, float* peak_r)
+{
+  using namespace mixdetail;
+  float pl = *peak_l, pr = *peak_r;
+  int i = 0;
+  const int n = frames * 2;
+#ifdef JAMWIDE_MIX_VECTOR
+  if (n >= 4)
+  {
+    const vf lo = vset(-1.0f), hi = vset(1.0f);
+    const float init[4] = { pl, pr, pl, pr };
+    vf acc = vload(init);
+    for (; i + 4 <= n; i += 4)
+    {
+      const vf v = vmin(vmax(vload(x + i), lo), hi);
+      vstore(x + i, v);
+      acc = vmax(acc, vabs(v));
+    }
+    float l[4];
+    vlanes(acc, l);
+    pl = l[0] > l[2] ? l[0] : l[2];
+    pr = l[1] > l[3] ? l[1] : l[3];
+  }
+#endif
+  for (; i < n; i += 2)
+  {
+    x[i] = clip1(x[i]);
+    pl = amax(pl, x[i]);
+    x[i + 1] = clip1(x[i + 1]);
+    pr = amax(pr, x[i + 1]);
+  }
+  *peak_l = pl;
+  *peak_r = pr;
+}
+
+} // namespace jamwide
+
+#endif // MIX_KERNELS_H
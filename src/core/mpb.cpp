@@ -444,6 +444,12 @@ int mpb_server_download_interval_write::parse(Net_Message *msg) // return 0 on s
 
   audio_data = p;
   audio_data_len = msg->get_size()-17;
+  if (msg->get_direct_bytes() > 0)
+  {
+    // payload already went to a Net_DirectRecvSink; report its length only
+    audio_data = NULL;
+    audio_data_len = msg->get_direct_bytes();
+  }
 
   return 0;
 }
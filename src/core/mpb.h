@@ -152,7 +152,7 @@ class mpb_server_download_interval_write
     unsigned char guid[16]; // transfer id
     char flags; // & 1 = end
 
-    const void *audio_data;
+    const void *audio_data; // NULL with audio_data_len > 0 if the payload was received directly (Net_DirectRecvSink)
     int audio_data_len; // not encoded in, just used internally
 };
 
@@ -0,0 +1,176 @@
+/*
+    JamWide Plugin - net_wait.cpp
+    Readiness-driven wait for the NJClient run thread (see net_wait.h)
+
+    Copyright (C) 2026 JamWide Contributors
+    Licensed under GPLv2+
+*/
+
+#include "net_wait.h"
+
+#if !defined(_WIN32) && defined(__linux__)
+#include <sys/eventfd.h>
+#endif
+
+namespace jamwide {
+
+#ifdef _WIN32
+
+NetActivityWaiter::NetActivityWaiter()
+{
+  m_event = WSACreateEvent();
+  m_valid = m_event != WSA_INVALID_EVENT;
+}
+
+NetActivityWaiter::~NetActivityWaiter()
+{
+  if (m_event != WSA_INVALID_EVENT) WSACloseEvent(m_event);
+}
+
+void NetActivityWaiter::wake() noexcept
+{
+  if (!m_valid || m_pending.exchange(true, std::memory_order_acq_rel)) return;
+  m_wake_signals.fetch_add(1, std::memory_order_relaxed);
+  WSASetEvent(m_event);
+}
+
+void NetActivityWaiter::consumeWake()
+{
+  m_pending.store(false, std::memory_order_release);
+  WSAResetEvent(m_event);
+}
+
+int NetActivityWaiter::wait(SOCKET sock, bool want_write, int timeout_ms)
+{
+  (void)want_write; // FD_WRITE is edge-triggered: it fires once the send buffer drains
+  m_waits.fetch_add(1, std::memory_order_relaxed);
+  if (!m_valid)
+  {
+    Sleep((DWORD)timeout_ms);
+    m_timeouts.fetch_add(1, std::memory_order_relaxed);
+    return 0;
+  }
+
+  // A new connection (or reconnect) hands us a different socket. The old one
+  // is already closed, which drops its association with the event.
+  if (sock != m_selected)
+  {
+    if (sock != INVALID_SOCKET &&
+        WSAEventSelect(sock, m_event, FD_READ | FD_WRITE | FD_CLOSE | FD_CONNECT) != 0)
+      sock = INVALID_SOCKET;
+    m_selected = sock;
+  }
+
+  const DWORD r = WSAWaitForMultipleEvents(1, &m_event, FALSE, (DWORD)timeout_ms, FALSE);
+  if (r != WSA_WAIT_EVENT_0)
+  {
+    m_timeouts.fetch_add(1, std::memory_order_relaxed);
+    return 0;
+  }
+
+  // One event carries both sources; the pending flag tells them apart.
+  const bool woken = m_pending.load(std::memory_order_acquire);
+  consumeWake();
+  return woken ? kWoken : kSocketReady;
+}
+
+#else // !_WIN32
+
+NetActivityWaiter::NetActivityWaiter()
+{
+#if defined(__linux__)
+  m_rfd = m_wfd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  m_valid = m_rfd >= 0;
+#else
+  int fds[2];
+  if (pipe(fds) == 0)
+  {
+    for (int i = 0; i < 2; i++)
+    {
+      fcntl(fds[i], F_SETFL, fcntl(fds[i], F_GETFL) | O_NONBLOCK);
+      fcntl(fds[i], F_SETFD, FD_CLOEXEC);
+    }
+    m_rfd = fds[0];
+    m_wfd = fds[1];
+    m_valid = true;
+  }
+#endif
+}
+
+NetActivityWaiter::~NetActivityWaiter()
+{
+  if (m_wfd >= 0 && m_wfd != m_rfd) close(m_wfd);
+  if (m_rfd >= 0) close(m_rfd);
+}
+
+void NetActivityWaiter::wake() noexcept
+{
+  if (!m_valid || m_pending.exchange(true, std::memory_order_acq_rel)) return;
+  m_wake_signals.fetch_add(1, std::memory_order_relaxed);
+#if defined(__linux__)
+  const uint64_t one = 1;
+  ssize_t r = write(m_wfd, &one, sizeof(one));
+#else
+  const char one = 1;
+  ssize_t r = write(m_wfd, &one, 1);
+#endif
+  (void)r; // EAGAIN: the pipe/counter is already signalled, which is all we need
+}
+
+void NetActivityWaiter::consumeWake()
+{
+  // Clear the flag first. A wake() racing with the drain below either sees
+  // it set (and is covered by the pass we are about to make) or writes a
+  // fresh signal that the next wait() picks up.
+  m_pending.store(false, std::memory_order_release);
+  char buf[64];
+  while (read(m_rfd, buf, sizeof(buf)) > 0) { }
+}
+
+int NetActivityWaiter::wait(SOCKET sock, bool want_write, int timeout_ms)
+{
+  m_waits.fetch_add(1, std::memory_order_relaxed);
+
+  struct pollfd pfd[2];
+  int n = 0;
+  if (m_valid)
+  {
+    pfd[n].fd = m_rfd;
+    pfd[n].events = POLLIN;
+    pfd[n].revents = 0;
+    n++;
+  }
+  const int sock_idx = n;
+  if (sock != INVALID_SOCKET)
+  {
+    pfd[n].fd = sock;
+    pfd[n].events = POLLIN | (want_write ? POLLOUT : 0);
+    pfd[n].revents = 0;
+    n++;
+  }
+
+  int r;
+  do {
+    r = poll(pfd, (nfds_t)n, timeout_ms);
+  } while (r < 0 && errno == EINTR);
+
+  if (r <= 0)
+  {
+    m_timeouts.fetch_add(1, std::memory_order_relaxed);
+    return 0;
+  }
+
+  int result = 0;
+  if (m_valid && pfd[0].revents)
+  {
+    consumeWake();
+    result |= kWoken;
+  }
+  // POLLERR/POLLHUP/POLLNVAL count as ready: Run() is what notices the error.
+  if (sock_idx < n && pfd[sock_idx].revents) result |= kSocketReady;
+  return result;
+}
+
+#endif // _WIN32
+
+} // namespace jamwide
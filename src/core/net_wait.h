@@ -0,0 +1,95 @@
+/*
+    JamWide Plugin - net_wait.h
+    Readiness-driven wait for the NJClient run thread
+
+    Copyright (C) 2026 JamWide Contributors
+    Licensed under GPLv2+
+
+    The run loops (juce/NinjamRunThread.cpp, src/threading/run_thread.cpp)
+    used to sleep a fixed 20/50 ms between NJClient::Run() calls, and
+    JNL_Connection only looks at the socket from inside Run(). A download
+    chunk that arrived just after a tick sat in the kernel for up to 20 ms,
+    and a broadcast block the audio thread had just pushed waited the same
+    for the encoder.
+
+    NetActivityWaiter blocks the run thread until one of these happens:
+      - the server socket is readable (or writable, if output is queued);
+      - some other thread calls wake() (the audio thread does this after
+        pushing broadcast BlockRecords);
+      - the timeout expires. In the JUCE run loop, where queued UI commands
+        wake it too, this only paces the UI snapshot (33 ms connected,
+        250 ms idle), except while connecting, where it keeps the old
+        20 ms tick to notice connect and auth. The legacy loop
+        (run_thread.cpp) polls its command ring, so it keeps 20/50 ms.
+
+    POSIX: poll() on the socket plus an eventfd (Linux) or a non-blocking
+    self-pipe (macOS and other BSDs).
+    Windows: WSAEventSelect binds the socket to one manual-reset WSAEVENT and
+    wake() sets the same event, so a single WSAWaitForMultipleEvents covers
+    both.
+
+    wake() is lock-free, never blocks and coalesces: after the first call,
+    later calls are a single atomic exchange until the run thread consumes
+    the wakeup. The audio thread's caller is edge-triggered on top of that
+    (NJClient::wakeRunThreadIfBroadcastPending): it signals once per
+    broadcast drain, with a non-blocking write into a counter/pipe.
+
+    Threading: wait() is run-thread only. wake() and the counters may be used
+    from any thread.
+*/
+
+#ifndef NET_WAIT_H
+#define NET_WAIT_H
+
+#include <atomic>
+#include <cstdint>
+
+#include "../wdl/jnetlib/netinc.h"
+
+namespace jamwide {
+
+class NetActivityWaiter {
+public:
+    // wait() result bits; 0 means the timeout expired.
+    enum { kSocketReady = 1, kWoken = 2 };
+
+    NetActivityWaiter();
+    ~NetActivityWaiter();
+    NetActivityWaiter(const NetActivityWaiter&) = delete;
+    NetActivityWaiter& operator=(const NetActivityWaiter&) = delete;
+
+    // False if the wake primitive could not be created. wait() then falls
+    // back to a plain timed sleep, which is the old behaviour.
+    bool isValid() const { return m_valid; }
+
+    void wake() noexcept;
+
+    // Block for at most timeout_ms. `sock` may be INVALID_SOCKET (not
+    // connected yet, or DNS still resolving); only wake()/timeout apply then.
+    int wait(SOCKET sock, bool want_write, int timeout_ms);
+
+    uint64_t waits() const noexcept { return m_waits.load(std::memory_order_relaxed); }
+    uint64_t timeouts() const noexcept { return m_timeouts.load(std::memory_order_relaxed); }
+    uint64_t wakeSignals() const noexcept { return m_wake_signals.load(std::memory_order_relaxed); }
+
+private:
+    void consumeWake();
+
+    bool m_valid = false;
+    std::atomic<bool> m_pending{false};
+    std::atomic<uint64_t> m_waits{0};
+    std::atomic<uint64_t> m_timeouts{0};
+    std::atomic<uint64_t> m_wake_signals{0};
+
+#ifdef _WIN32
+    WSAEVENT m_event = WSA_INVALID_EVENT;
+    SOCKET m_selected = INVALID_SOCKET;
+#else
+    int m_rfd = -1;
+    int m_wfd = -1;   // == m_rfd for eventfd
+#endif
+};
+
+} // namespace jamwide
+
+#endif // NET_WAIT_H
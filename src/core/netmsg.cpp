@@ -35,6 +35,121 @@
 
 #include "netmsg.h"
 #include "crypto/nj_crypto.h"
+#include "threading/mpmc_ring.h"
+
+#include <atomic>
+#include <new>
+
+// Net_Message pool. Messages are built on the run thread (mpb_*::build,
+// keepalives, the receive parser) but Net_Message::releaseRef can in
+// principle run on whichever thread dropped the last reference, so the
+// freelists are MPMC rings rather than thread-local caches.
+//
+// Sizes: an upload interval write is at most NET_MESSAGE_MAX_SIZE (+32 once
+// encrypted); control messages (keepalive, config, chat) fit in 256 B or
+// 2 KB. 256 cached blocks per class bounds the pool at ~4.6 MB, reached only
+// after a full send queue has drained.
+namespace {
+
+const int kPayloadClassSize[3] = { 256, 2048, NET_MESSAGE_MAX_SIZE_ENCRYPTED };
+const int kOversizeClass = 3;
+
+struct NetMessagePool
+{
+  jamwide::MpmcRing<void *, 512> shells;
+  jamwide::MpmcRing<void *, 256> payloads[3];
+
+  std::atomic<unsigned long long> msg_allocs{0};
+  std::atomic<unsigned long long> msg_heap_allocs{0};
+  std::atomic<unsigned long long> payload_allocs{0};
+  std::atomic<unsigned long long> payload_heap_allocs{0};
+  std::atomic<unsigned long long> heap_frees{0};
+  std::atomic<int> msgs_outstanding{0};
+};
+
+// Never destroyed: Net_Messages owned by static objects may be released
+// after static destruction has started.
+NetMessagePool &pool()
+{
+  static NetMessagePool *p = new NetMessagePool;
+  return *p;
+}
+
+} // namespace
+
+void *Net_Message::operator new(size_t sz)
+{
+  NetMessagePool &pl=pool();
+  pl.msg_allocs.fetch_add(1, std::memory_order_relaxed);
+  pl.msgs_outstanding.fetch_add(1, std::memory_order_relaxed);
+  void *p=0;
+  if (sz == sizeof(Net_Message) && pl.shells.try_pop(p)) return p;
+  pl.msg_heap_allocs.fetch_add(1, std::memory_order_relaxed);
+  p=malloc(sz);
+  if (!p) throw std::bad_alloc();
+  return p;
+}
+
+void Net_Message::operator delete(void *p, size_t sz)
+{
+  if (!p) return;
+  NetMessagePool &pl=pool();
+  pl.msgs_outstanding.fetch_sub(1, std::memory_order_relaxed);
+  if (sz == sizeof(Net_Message) && pl.shells.try_push(p)) return;
+  pl.heap_frees.fetch_add(1, std::memory_order_relaxed);
+  free(p);
+}
+
+bool Net_Message::growPayload(int newsize)
+{
+  int cls=0;
+  while (cls < kOversizeClass && newsize > kPayloadClassSize[cls]) cls++;
+  const int cap = cls < kOversizeClass ? kPayloadClassSize[cls] : newsize;
+
+  NetMessagePool &pl=pool();
+  pl.payload_allocs.fetch_add(1, std::memory_order_relaxed);
+  void *blk=0;
+  if (cls == kOversizeClass || !pl.payloads[cls].try_pop(blk))
+  {
+    pl.payload_heap_allocs.fetch_add(1, std::memory_order_relaxed);
+    blk=malloc(cap);
+    if (!blk) return false;
+  }
+  if (m_data && m_size > 0) memcpy(blk, m_data, m_size);
+  releasePayload();
+  m_data=(unsigned char *)blk;
+  m_cap=cap;
+  m_class=cls;
+  return true;
+}
+
+void Net_Message::releasePayload()
+{
+  if (m_data)
+  {
+    NetMessagePool &pl=pool();
+    if (m_class >= kOversizeClass || !pl.payloads[m_class].try_push(m_data))
+    {
+      pl.heap_frees.fetch_add(1, std::memory_order_relaxed);
+      free(m_data);
+    }
+  }
+  m_data=0;
+  m_cap=0;
+  m_class=-1;
+}
+
+void Net_Message::GetPoolStats(Net_MessagePoolStats *out)
+{
+  if (!out) return;
+  NetMessagePool &pl=pool();
+  out->msg_allocs=pl.msg_allocs.load(std::memory_order_relaxed);
+  out->msg_heap_allocs=pl.msg_heap_allocs.load(std::memory_order_relaxed);
+  out->payload_allocs=pl.payload_allocs.load(std::memory_order_relaxed);
+  out->payload_heap_allocs=pl.payload_heap_allocs.load(std::memory_order_relaxed);
+  out->heap_frees=pl.heap_frees.load(std::memory_order_relaxed);
+  out->msgs_outstanding=pl.msgs_outstanding.load(std::memory_order_relaxed);
+}
 
 int Net_Message::parseBytesNeeded()
 {
@@ -158,6 +273,7 @@ Net_Message *Net_Connection::Run(int *wantsleep)
         char buf[32];
         int hdrlen=sendm->makeMessageHeader(buf);
         m_con->send_bytes(buf,hdrlen);
+        m_bytes_sent+=hdrlen;
 
         m_msgsendpos=0;
       }
@@ -177,6 +293,7 @@ Net_Message *Net_Connection::Run(int *wantsleep)
         {
           m_con->send_bytes((char*)sendm->get_data()+m_msgsendpos,sz);
           m_msgsendpos+=sz;
+          m_bytes_sent+=sz;
         }
       }
     }
@@ -194,17 +311,61 @@ Net_Message *Net_Connection::Run(int *wantsleep)
 
   m_sendq.Compact();
 
-  Net_Message *retv=0;
+  // handle receive now. Parse everything the connection has buffered in one
+  // pass, pump the socket again and keep going while it keeps producing, so a
+  // burst of interval-write messages costs one wakeup rather than one
+  // NJClient::Run() round trip (and one 64 KB ring refill) per message.
+  {
+    int batch=parseReceived();
+    while (!m_error && m_recvq.Available() < NET_CON_MAX_RECV_BATCH*(int)sizeof(Net_Message *))
+    {
+      int s=0,r=0;
+      m_con->run(-1,-1,&s,&r);
+      if (wantsleep && (s||r)) *wantsleep=0;
+      if (!r) break;
+      batch+=parseReceived();
+    }
+    if (batch > m_max_recv_batch) m_max_recv_batch=batch;
+  }
+
+  Net_Message *retv=popReceived();
+
+  // Parsed messages still queued (or left in the ring behind the batch cap)
+  // must not wait for the socket to become readable again. A partial message
+  // in the ring is fine to sleep on: the rest of it will wake us.
+  if (wantsleep && m_recvq.Available()>0) *wantsleep=0;
 
-  // handle receive now
-  if (!m_recvmsg)
+  if (retv)
+  {
+    m_last_recv=now;
+    m_last_recv_tp=std::chrono::steady_clock::now();
+    if (wantsleep) *wantsleep=0;
+  }
+  else if (now > m_last_recv + m_keepalive*3)
   {
-    m_recvmsg=new Net_Message;
-    m_recvstate=0;
+    m_error=-3;
   }
 
-  while (!retv && m_con->recv_bytes_available()>0)
+  return retv;
+}
+
+int Net_Connection::parseReceived()
+{
+  int completed=0;
+  while (!m_error && m_con->recv_bytes_available()>0 &&
+         m_recvq.Available() < NET_CON_MAX_RECV_BATCH*(int)sizeof(Net_Message *))
   {
+    if (!m_recvmsg)
+    {
+      if (m_direct_sink && parseDirect())
+      {
+        completed++;
+        continue;
+      }
+      m_recvmsg=new Net_Message;
+      m_recvstate=0;
+    }
+
     char buf[8192];
     int bufl=m_con->peek_bytes(buf,sizeof(buf));
     int a=0;
@@ -226,63 +387,151 @@ Net_Message *Net_Connection::Run(int *wantsleep)
 
     if (m_recvmsg->parseBytesNeeded()<1)
     {
-      retv=m_recvmsg;
+      if (m_recvmsg->get_type() == m_direct_type) m_direct_pending++;
+      m_recvq.Add(&m_recvmsg,sizeof(Net_Message *));
       m_recvmsg=0;
       m_recvstate=0;
-
-      // Decrypt payload if encryption active and payload is non-empty
-      // Zero-length payloads (keepalive) were not encrypted on send, so skip decrypt
-      if (retv && m_encryption_active && retv->get_size() > 0) {
-          auto dec = decrypt_payload(
-              (const unsigned char*)retv->get_data(),
-              retv->get_size(),
-              m_encryption_key
-          );
-          if (!dec.ok) {
-              retv->releaseRef();
-              retv = 0;
-              // Generic error code — do NOT reveal padding details (padding oracle mitigation)
-              m_error = -5;
-              break;
-          }
-          // Replace payload with decrypted plaintext
-          retv->set_size((int)dec.data.size());
-          if (retv->get_size() != (int)dec.data.size()) {
-              retv->releaseRef();
-              retv = 0;
-              m_error = -5;  // allocation failed
-              break;
-          }
-          if (dec.data.size() > 0) {
-              if (retv->get_data() == nullptr) {
-                  retv->releaseRef();
-                  retv = 0;
-                  m_error = -5;
-                  break;
-              }
-              memcpy(retv->get_data(), dec.data.data(), dec.data.size());
-          }
-      }
+      m_msgs_recvd++;
+      completed++;
     }
-    if (wantsleep) *wantsleep=0;
   }
+  return completed;
+}
 
+void Net_Connection::SetDirectRecv(int type, int prefix_len, Net_DirectRecvSink *sink)
+{
+  if (prefix_len < 0) prefix_len=0;
+  if (prefix_len > NET_CON_MAX_DIRECT_PREFIX) prefix_len=NET_CON_MAX_DIRECT_PREFIX;
+  m_direct_sink=sink;
+  m_direct_type=sink ? type : -1;
+  m_direct_prefix=prefix_len;
+
+  // Messages of this type may already be queued from before we were armed.
+  m_direct_pending=0;
+  Net_Message **rq=(Net_Message **)m_recvq.Get();
+  const int n=m_recvq.Available()/(int)sizeof(Net_Message *);
+  for (int x = 0; x < n; x ++)
+    if (rq[x] && rq[x]->get_type() == m_direct_type && !rq[x]->get_direct_bytes()) m_direct_pending++;
+}
+
+// A complete message of the direct type whose payload goes from the
+// connection's receive buffer to the sink without a Net_Message payload copy
+// in between. Falls back (returns false, nothing consumed) when encrypted,
+// when an earlier message of this type is still queued (the sink would see
+// it out of order), when the message isn't fully buffered yet, or when the
+// sink declines.
+bool Net_Connection::parseDirect()
+{
+  if (m_encryption_active || m_direct_pending > 0) return false;
+
+  const int avail=m_con->recv_bytes_available();
+  if (avail < 5 + m_direct_prefix) return false;
+
+  unsigned char hdr[5 + NET_CON_MAX_DIRECT_PREFIX];
+  m_con->peek_bytes(hdr,5+m_direct_prefix);
+  if ((int)hdr[0] != m_direct_type) return false;
+  const int size=(int)hdr[1] | ((int)hdr[2]<<8) | ((int)hdr[3]<<16) | ((int)hdr[4]<<24);
+  // malformed sizes are left for the normal path to reject
+  if (size < m_direct_prefix || size > NET_MESSAGE_MAX_SIZE_ENCRYPTED) return false;
+  if (avail < 5 + size) return false;
+
+  // The message keeps only the prefix, so the handler still sees the type,
+  // the prefix fields and (via get_direct_bytes) how much was delivered.
+  Net_Message *msg=new Net_Message;
+  msg->set_type(m_direct_type);
+  msg->set_size(m_direct_prefix);
+  const int len=size-m_direct_prefix;
+  if ((m_direct_prefix && !msg->get_data()) || !m_direct_sink->directRecvBegin(hdr+5,len))
   {
-    int s=0,r=0;
-    m_con->run(-1,-1,&s,&r);
-    if (wantsleep && (s||r)) *wantsleep=0;
+    delete msg;
+    return false;
   }
+  if (m_direct_prefix) memcpy(msg->get_data(),hdr+5,m_direct_prefix);
+  m_con->recv_bytes(NULL,5+m_direct_prefix);
 
-
-  if (retv)
+  int left=len;
+  while (left > 0)
   {
-    m_last_recv=now;
+    const void *span=NULL;
+    int n=m_con->peek_contiguous(&span);
+    if (n > 0 && span)
+    {
+      if (n > left) n=left;
+      m_direct_sink->directRecvData(span,n);
+      m_con->recv_bytes(NULL,n);
+    }
+    else
+    {
+      char buf[4096];
+      n=m_con->recv_bytes(buf,left < (int)sizeof(buf) ? left : (int)sizeof(buf));
+      if (n < 1) break; // can't happen: avail was checked above
+      m_direct_sink->directRecvData(buf,n);
+    }
+    left-=n;
   }
-  else if (now > m_last_recv + m_keepalive*3)
-  {
-    m_error=-3;
+
+  msg->set_direct_bytes(len-left);
+  m_recvq.Add(&msg,sizeof(Net_Message *));
+  m_msgs_recvd++;
+  m_direct_msgs++;
+  m_direct_bytes+=(unsigned long long)(len-left);
+  return true;
+}
+
+// Decryption happens here, at hand-out time, not in parseReceived(): a batch
+// can hold the auth reply that makes NJClient call SetEncryptionKey() along
+// with the first encrypted messages behind it.
+Net_Message *Net_Connection::popReceived()
+{
+  if (m_recvq.Available() < (int)sizeof(Net_Message *)) return 0;
+  Net_Message *retv=*(Net_Message **)m_recvq.Get();
+  m_recvq.Advance(sizeof(Net_Message *));
+  m_recvq.Compact();
+  if (retv && m_direct_pending > 0 && retv->get_type() == m_direct_type && !retv->get_direct_bytes())
+    m_direct_pending--;
+
+  // Decrypt payload if encryption active and payload is non-empty
+  // Zero-length payloads (keepalive) were not encrypted on send, so skip decrypt
+  if (retv && m_encryption_active && retv->get_size() > 0) {
+      auto dec = decrypt_payload(
+          (const unsigned char*)retv->get_data(),
+          retv->get_size(),
+          m_encryption_key
+      );
+      if (!dec.ok) {
+          delete retv;
+          // Generic error code — do NOT reveal padding details (padding oracle mitigation)
+          m_error = -5;
+          return 0;
+      }
+      // Replace payload with decrypted plaintext
+      retv->set_size((int)dec.data.size());
+      if (retv->get_size() != (int)dec.data.size()) {
+          delete retv;
+          m_error = -5;  // allocation failed
+          return 0;
+      }
+      if (dec.data.size() > 0) {
+          if (retv->get_data() == nullptr) {
+              delete retv;
+              m_error = -5;
+              return 0;
+          }
+          memcpy(retv->get_data(), dec.data.data(), dec.data.size());
+      }
   }
+  return retv;
+}
 
+Net_Message *Net_Connection::NextMessage()
+{
+  if (!m_con || m_error || GetStatus()) return 0;
+  Net_Message *retv=popReceived();
+  if (retv)
+  {
+    m_last_recv=time(NULL);
+    m_last_recv_tp=std::chrono::steady_clock::now();
+  }
   return retv;
 }
 
@@ -356,6 +605,22 @@ int Net_Connection::Send(Net_Message *msg)
   return 0;
 }
 
+int Net_Connection::GetSendQueueBytes() const
+{
+  Net_Message **p=(Net_Message **)m_sendq.Get();
+  if (!p) return 0;
+  int n=m_sendq.Available()/sizeof(Net_Message *);
+  int bytes=0;
+  for (int x = 0; x < n; x ++)
+  {
+    if (!p[x]) continue;
+    int sz=p[x]->get_size();
+    if (!x && m_msgsendpos>0) sz-=m_msgsendpos;
+    if (sz>0) bytes+=sz;
+  }
+  return bytes;
+}
+
 int Net_Connection::GetStatus()
 {
   if (m_error) return m_error;
@@ -380,6 +645,15 @@ Net_Connection::~Net_Connection()
   delete m_con;
   delete m_recvmsg;
 
+  // parsed but never handed out: refcnt 0, nobody else holds them
+  Net_Message **rq=(Net_Message **)m_recvq.Get();
+  if (rq)
+  {
+    int n=m_recvq.Available()/sizeof(Net_Message *);
+    while (n-->0) delete *rq++;
+    m_recvq.Advance(m_recvq.Available());
+  }
+
 }
 
 
@@ -31,6 +31,7 @@
 
 #include "../wdl/queue.h"
 #include "../wdl/jnetlib/jnetlib.h"
+#include <chrono>
 #include <cstring>  // for memcpy, memset
 #ifndef _WIN32
 #include <netinet/tcp.h>
@@ -41,6 +42,15 @@
 
 #define NET_CON_MAX_MESSAGES 512
 
+// Upper bound on complete-but-not-yet-consumed messages Net_Connection::Run
+// parses ahead in one pass. At NET_MESSAGE_MAX_SIZE that is ~2 MB worst case;
+// typical interval-write bursts are a few KB per message.
+#define NET_CON_MAX_RECV_BATCH 128
+
+// Largest payload prefix Net_Connection::SetDirectRecv keeps in the queued
+// message (an interval write's GUID + flags is 17 bytes).
+#define NET_CON_MAX_DIRECT_PREFIX 64
+
 #define MESSAGE_KEEPALIVE 0xfd
 #define MESSAGE_EXTENDED 0xfe
 #define MESSAGE_INVALID 0xff
@@ -48,28 +58,61 @@
 #define NET_CON_KEEPALIVE_RATE 3
 
 
+// Net_Message pool counters (Net_Message::GetPoolStats). "heap" counts are
+// round trips to the global allocator; in steady-state streaming they stop
+// moving once the freelists have warmed up.
+struct Net_MessagePoolStats
+{
+  unsigned long long msg_allocs;      // Net_Message objects handed out
+  unsigned long long msg_heap_allocs; // ... of which the freelist was empty
+  unsigned long long payload_allocs;  // payload blocks handed out (all size classes)
+  unsigned long long payload_heap_allocs;
+  unsigned long long heap_frees;      // objects/blocks freed because a freelist was full
+  int msgs_outstanding;               // live Net_Message objects
+};
+
+
+// Net_Message objects and their payloads are recycled: operator new/delete
+// go through a lock-free freelist of message shells, and the payload is a
+// block from one of three size classes (256 B, 2 KB, NET_MESSAGE_MAX_SIZE_
+// ENCRYPTED) with its own freelist. Each `new Net_Message` and set_size()
+// pair in mpb.cpp and netmsg.cpp stays as it was. Freelists are bounded; an
+// overflow falls back to free(). See netmsg.cpp.
 class Net_Message
 {
   public:
-    Net_Message() : m_parsepos(0), m_refcnt(0), m_type(MESSAGE_INVALID)
+    Net_Message() : m_parsepos(0), m_refcnt(0), m_type(MESSAGE_INVALID), m_data(0), m_size(0), m_cap(0), m_class(-1), m_direct_bytes(0)
     {
     }
     ~Net_Message()
     {
+      releasePayload();
     }
 
+    static void *operator new(size_t sz);
+    static void operator delete(void *p, size_t sz);
 
     void set_type(int type)  { m_type=type; }
     int  get_type() const { return m_type; }
 
+    // Growing keeps the existing bytes (like WDL_HeapBuf::Resize). Shrinking
+    // keeps the block. On allocation failure the size becomes 0.
     void set_size(int newsize)
     {
-      m_hb.Resize(newsize);
-      if (m_hb.GetSize() != newsize) m_hb.Resize(0);
+      if (newsize < 0) newsize=0;
+      if (newsize > m_cap && !growPayload(newsize)) newsize=0;
+      m_size=newsize;
     }
-    int get_size() const { return m_hb.GetSize(); }
+    int get_size() const { return m_size; }
+
+    void *get_data() { return m_size ? m_data : NULL; }
+
+    // Payload bytes that followed get_size() on the wire but were handed to a
+    // Net_DirectRecvSink instead of being stored here (0 for normal messages).
+    void set_direct_bytes(int n) { m_direct_bytes=n; }
+    int get_direct_bytes() const { return m_direct_bytes; }
 
-    void *get_data() { return m_hb.Get(); }
+    static void GetPoolStats(Net_MessagePoolStats *out);
 
     int parseMessageHeader(void *data, int len); // returns bytes used, if any (or 0 if more data needed), or -1 if invalid
     int parseBytesNeeded();
@@ -82,17 +125,47 @@ class Net_Message
     void releaseRef() { if (--m_refcnt < 1) delete this; }
 
   private:
+    Net_Message(const Net_Message &) = delete;
+    Net_Message &operator=(const Net_Message &) = delete;
+
+    bool growPayload(int newsize);
+    void releasePayload();
+
     int m_parsepos;
     int m_refcnt;
     int m_type;
-    WDL_HeapBuf m_hb;
+    unsigned char *m_data;
+    int m_size;
+    int m_cap;
+    int m_class; // payload size class, -1 = none, 3 = oversize (plain malloc)
+    int m_direct_bytes;
+};
+
+
+// Receiver for Net_Connection's zero-copy path (SetDirectRecv). When a whole
+// message of the registered type is sitting in the connection's receive
+// buffer, Net_Connection shows the sink the first prefix_len payload bytes;
+// if the sink accepts, the rest of the payload goes straight from the socket
+// buffer to directRecvData() and only the prefix is kept in the Net_Message
+// that is queued (with get_direct_bytes() set). Called on the thread that
+// calls Net_Connection::Run(), while earlier messages may still be waiting
+// in the receive queue: a sink should only store the bytes and leave
+// anything order-dependent to the handler of the queued message.
+class Net_DirectRecvSink
+{
+  public:
+    virtual ~Net_DirectRecvSink() { }
+    // Return true to take the remaining `len` payload bytes.
+    virtual bool directRecvBegin(const unsigned char *prefix, int len)=0;
+    // Called one or more times, in order, until `len` bytes have been passed.
+    virtual void directRecvData(const void *data, int len)=0;
 };
 
 
 class Net_Connection
 {
   public:
-    Net_Connection() : m_error(0),m_msgsendpos(-1), m_recvstate(0),m_recvmsg(0),m_con(0)
+    Net_Connection() : m_error(0),m_msgsendpos(-1), m_bytes_sent(0), m_recvstate(0),m_recvmsg(0),m_con(0)
     {
       SetKeepAlive(0);
     }
@@ -118,15 +191,49 @@ class Net_Connection
       }
     }
 
+    // Pumps the socket, then parses every complete message the connection has
+    // buffered (up to NET_CON_MAX_RECV_BATCH) and returns the first. The rest
+    // stay queued; drain them with NextMessage() before calling Run() again.
     Net_Message *Run(int *wantsleep=0);
+    // Next message parsed by an earlier Run(), without touching the socket.
+    // Returns 0 when none is queued or the connection has failed/is closing.
+    Net_Message *NextMessage();
+    int GetRecvQueueDepth() const { return m_recvq.Available()/(int)sizeof(Net_Message *); }
     int Send(Net_Message *msg); // -1 on error, i.e. queue full
     int GetStatus(); // returns <0 on error, 0 on normal, 1 on disconnect
     JNL_IConnection *GetConnection() { return m_con; }
 
+    // Uplink observability for NJClient's adaptive bitrate controller.
+    // Same thread as Send()/Run() (the run thread); no locking.
+    int GetSendQueueDepth() const { return m_sendq.Available()/(int)sizeof(Net_Message *); }
+    int GetSendQueueBytes() const; // payload bytes queued but not yet handed to the socket
+    unsigned long long GetBytesSent() const { return m_bytes_sent; }
+    time_t GetLastRecvTime() const { return m_last_recv; }
+    // Milliseconds since the last complete message, on a monotonic clock
+    // (GetLastRecvTime only has whole seconds).
+    int GetRecvGapMs() const
+    {
+      return (int)std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - m_last_recv_tp).count();
+    }
+
+    // Receive-side batching observability. Same thread as Run().
+    unsigned long long GetMessagesReceived() const { return m_msgs_recvd; }
+    int GetMaxRecvBatch() const { return m_max_recv_batch; }
+
+    // Zero-copy receive for messages of `type` (see Net_DirectRecvSink).
+    // Only used while encryption is off, and only while no message of that
+    // type is queued from the normal path, so the sink sees payloads in wire
+    // order. Pass sink=NULL to turn it off. The sink must outlive this.
+    void SetDirectRecv(int type, int prefix_len, Net_DirectRecvSink *sink);
+    unsigned long long GetDirectRecvMessages() const { return m_direct_msgs; }
+    unsigned long long GetDirectRecvBytes() const { return m_direct_bytes; }
+
     void SetKeepAlive(int interval)
     {
       m_keepalive=interval?interval:NET_CON_KEEPALIVE_RATE;
       m_last_send=m_last_recv=time(NULL);
+      m_last_recv_tp=std::chrono::steady_clock::now();
     }
 
     void Kill(int quick=0);
@@ -147,14 +254,30 @@ class Net_Connection
 
     int m_keepalive;
     int m_msgsendpos;
+    unsigned long long m_bytes_sent;
 
     time_t m_last_send, m_last_recv;
+    std::chrono::steady_clock::time_point m_last_recv_tp;
 
     int m_recvstate;
     Net_Message *m_recvmsg;
 
     JNL_IConnection *m_con;
     WDL_Queue m_sendq;
+    WDL_Queue m_recvq; // parsed Net_Message* (refcnt 0), still encrypted if encryption is on
+    unsigned long long m_msgs_recvd = 0;
+    int m_max_recv_batch = 0;
+
+    Net_DirectRecvSink *m_direct_sink = nullptr;
+    int m_direct_type = -1;
+    int m_direct_prefix = 0;
+    int m_direct_pending = 0; // queued normal-path messages of m_direct_type
+    unsigned long long m_direct_msgs = 0;
+    unsigned long long m_direct_bytes = 0;
+
+    int parseReceived(); // returns messages completed
+    bool parseDirect(); // one message via m_direct_sink, if possible
+    Net_Message *popReceived(); // dequeue + decrypt
 
     bool m_encryption_active = false;
     unsigned char m_encryption_key[32] = {};
@@ -31,9 +31,11 @@
 #include <atomic>     // 15.1-07c CR-12: std::atomic<int> m_refcnt
 #include <chrono>
 #include <cstring>    // 15.1-07c CR-12: std::memcpy in DecodeMediaBuffer Read/Write
-#include <stdexcept>  // 15.1-08 + Codex M-7: std::runtime_error in SetMaxAudioBlockSize
+#include <set>
 #include <thread>  // 15.1-06 HIGH-3: std::this_thread::yield in DeleteLocalChannel gate
 #include "njclient.h"
+#include "mix_kernels.h"
+#include "denormal_guard.h"
 #include "mpb.h"
 
 static int64_t currentMillis()
@@ -44,103 +46,35 @@ static int64_t currentMillis()
 }
 
 // 15.1-07b CR-09 + Codex M-7 + Codex M-8: producer-side helper for the per-channel
-// mirror BlockRecord SPSC. Audio thread calls this from process_samples and
-// on_new_interval. Two-layer defense:
-//   1. SetMaxAudioBlockSize prepareToPlay assertion (lands in 15.1-08) ensures
-//      no host pushes a sample_count > MAX_BLOCK_SAMPLES.
-//   2. Per-callsite bounds-check HERE rejects pathological inputs and bumps the
-//      drop counter. Codex M-7: bounds-check at every site, before memcpy.
-// On try_push failure (consumer hasn't drained yet), bump the drop counter and
-// drop the record. RT-safety > broadcast continuity at audio callback boundary.
+// mirror broadcast FIFO and the wave-mix FIFO. Audio thread calls this from
+// process_samples and on_new_interval. The FIFO rejects pathological inputs
+// (sample_count < 0, nch outside 0..2) and, when the run-thread consumer
+// hasn't drained yet, whatever does not fit; either way bump the drop counter
+// and drop the record. RT-safety > broadcast continuity at audio callback
+// boundary.
+//
+// The FIFO stores a small header plus exactly the samples pushed, written in
+// place, and splits blocks too large for one record, so there is no
+// MAX_BLOCK_SAMPLES ceiling on the host block size any more (the fixed 16 KB
+// BlockRecord slots this replaced carried one).
 //
 // Defined here at file top so the producer call sites in process_samples /
 // on_new_interval (which are member functions defined further down) can see
-// the helpers without needing forward declarations.
+// the helper without needing forward declarations.
 static inline void pushBlockRecord(
-    jamwide::SpscRing<jamwide::BlockRecord, 16>& ring,
-    std::atomic<uint64_t>& drop_counter,
-    int attr, double startpos,
-    const float* samples_ptr, int sample_count, int nch,
-    const float* samples_ptr_2 = nullptr)
-{
-  // Codex M-7: defensive bounds-check at the call site BEFORE memcpy.
-  // The interval-boundary marker case has sample_count<=0 (see legacy
-  // lc->m_bq.AddBlock(0,0.0,NULL,0) at on_new_interval) — accept those by
-  // letting sample_count==0 with samples_ptr==NULL through (no memcpy).
-  if (sample_count > jamwide::MAX_BLOCK_SAMPLES || nch > jamwide::MAX_BLOCK_CHANNELS
-      || sample_count < 0 || nch < 0)
-  {
-    // Out-of-bounds input — drop and count. Either the host violated the
-    // SetMaxAudioBlockSize contract OR the BufferQueue boundary-marker
-    // sentinel encoding leaked through (sample_count==-1).
-    drop_counter.fetch_add(1, std::memory_order_relaxed);
-    return;
-  }
-
-  jamwide::BlockRecord br{};
-  br.attr = attr;
-  br.startpos = startpos;
-  br.sample_count = sample_count;
-  br.nch = nch;
-  if (sample_count > 0 && samples_ptr)
-  {
-    // Stereo channel layout in BlockRecord.samples: channel-0 samples first
-    // (sample_count floats), then channel-1 samples (sample_count floats).
-    // This matches the legacy BufferQueue::AddBlock layout and the encoder
-    // consumer's existing `(float*)p->Get()+sz` interpretation at line 1750.
-    std::memcpy(br.samples, samples_ptr,
-                static_cast<size_t>(sample_count) * sizeof(float));
-    if (nch > 1 && samples_ptr_2)
-    {
-      std::memcpy(br.samples + sample_count, samples_ptr_2,
-                  static_cast<size_t>(sample_count) * sizeof(float));
-    }
-  }
-
-  if (!ring.try_push(std::move(br)))
-  {
-    // Run-thread consumer hasn't drained — drop and count (Codex M-8).
-    drop_counter.fetch_add(1, std::memory_order_relaxed);
-  }
-}
-
-// 15.1-07b CR-10: same shape, larger ring (N=32) for the m_wave_block_q.
-// Wavewriter can lag further than the encoder (file I/O latency), so a larger
-// ring absorbs more burst.
-static inline void pushWaveBlockRecord(
-    jamwide::SpscRing<jamwide::BlockRecord, 32>& ring,
+    jamwide::SampleFifo& fifo,
     std::atomic<uint64_t>& drop_counter,
     int attr, double startpos,
     const float* samples_ptr, int sample_count, int nch,
     const float* samples_ptr_2 = nullptr)
 {
-  if (sample_count > jamwide::MAX_BLOCK_SAMPLES || nch > jamwide::MAX_BLOCK_CHANNELS
-      || sample_count < 0 || nch < 0)
-  {
-    drop_counter.fetch_add(1, std::memory_order_relaxed);
-    return;
-  }
-
-  jamwide::BlockRecord br{};
-  br.attr = attr;
-  br.startpos = startpos;
-  br.sample_count = sample_count;
-  br.nch = nch;
-  if (sample_count > 0 && samples_ptr)
-  {
-    std::memcpy(br.samples, samples_ptr,
-                static_cast<size_t>(sample_count) * sizeof(float));
-    if (nch > 1 && samples_ptr_2)
-    {
-      std::memcpy(br.samples + sample_count, samples_ptr_2,
-                  static_cast<size_t>(sample_count) * sizeof(float));
-    }
-  }
-
-  if (!ring.try_push(std::move(br)))
-  {
+  // Stereo channel layout: channel-0 samples first (sample_count floats),
+  // then channel-1 samples (sample_count floats). This matches the legacy
+  // BufferQueue::AddBlock layout and the encoder consumer's existing
+  // `(float*)p->Get()+sz` interpretation. A stereo block without a second
+  // source gets a silent second channel.
+  if (!fifo.push(attr, startpos, samples_ptr, sample_count, nch, samples_ptr_2))
     drop_counter.fetch_add(1, std::memory_order_relaxed);
-  }
 }
 #include "crypto/nj_crypto.h"
 #include "../wdl/pcmfmtcvt.h"
@@ -151,6 +85,7 @@ static inline void pushWaveBlockRecord(
 
 #define NJ_ENCODER_FMT_TYPE MAKE_NJ_FOURCC('O','G','G','v')
 #define NJ_ENCODER_FMT_FLAC MAKE_NJ_FOURCC('F','L','A','C')
+#define NJ_ENCODER_FMT_OPUS MAKE_NJ_FOURCC('O','P','U','S')
 
 #ifdef REANINJAM
 #define WDL_VORBIS_INTERFACE_ONLY
@@ -160,6 +95,9 @@ static inline void pushWaveBlockRecord(
 #define VorbisDecoderInterface I_NJDecoder
 #include "../wdl/vorbisencdec.h"
 #include "../wdl/flacencdec.h"
+#ifdef JAMWIDE_WITH_OPUS
+#include "../wdl/opusencdec.h"
+#endif
 
 #undef VorbisEncoderInterface
 #undef VorbisDecoderInterface
@@ -203,6 +141,23 @@ static inline void pushWaveBlockRecord(
 #define CreateFLACEncoder(srate,ch,br,id) ((I_NJEncoder *)new FlacEncoder(srate,ch,br,id))
 #define CreateFLACDecoder() ((I_NJDecoder *)new FlacDecoder)
 
+// Opus is optional (JAMWIDE_WITH_OPUS, libs/libopus). Without it the 'OPUS'
+// fourcc is still recognized on download/decode so the interval is written
+// to disk and skipped cleanly, but no decoder is created (decode_codec stays
+// NULL, which mixInChannel already treats as silence).
+#ifdef JAMWIDE_WITH_OPUS
+#define CreateOpusEncoder(srate,ch,br,id,frame_ms) ((I_NJEncoder *)new NJOpusEncoder(srate,ch,br,id,frame_ms))
+#define CreateOpusDecoder() ((I_NJDecoder *)new NJOpusDecoder)
+#else
+#define CreateOpusDecoder() ((I_NJDecoder *)NULL)
+#endif
+
+// Opus frame duration for live (instamode, flags&2) channels. Regular
+// interval channels use 20 ms frames; live channels trade bitrate efficiency
+// for latency since each LIVE_ENC_BLOCKSIZE2 send already carries only a few
+// frames.
+#define OPUS_LIVE_FRAME_MS 5.0
+
 
 #define SESSION_CHUNK_SIZE 2.0
 #define LL_CHUNK_SIZE 2.0
@@ -217,9 +172,10 @@ static inline void pushWaveBlockRecord(
 // (AUDIT CR-12). Refcnt protected by the same mutex.
 //
 // AFTER:  Internals replaced with SpscRing<DecodeChunk, 32>. The audio thread
-// reads lock-free; partial-chunk reads are absorbed by an audio-thread-owned
-// linear consumer buffer (m_consumer_buf). The Write() side splits the
-// caller's data into CHUNK_BYTES-sized chunks. Refcnt is std::atomic<int>
+// reads lock-free, straight out of the ring slot (front/pop); a partially
+// consumed chunk stays at the front with a read offset (m_front_pos) until
+// it is used up. The Write() side fills CHUNK_BYTES-sized chunks in place
+// (try_reserve/commit). Refcnt is std::atomic<int>
 // with fetch_sub(acq_rel) — UAF-safe across audio/run thread Release races
 // (T-15.1-07c-01).
 //
@@ -260,10 +216,8 @@ public:
     int remaining = len;
     while (remaining > 0)
     {
-      jamwide::DecodeChunk chunk{};
-      chunk.len = std::min(remaining, jamwide::CHUNK_BYTES);
-      std::memcpy(chunk.data, in, static_cast<size_t>(chunk.len));
-      if (!m_chunks.try_push(chunk))
+      jamwide::DecodeChunk* chunk = m_chunks.try_reserve();
+      if (!chunk)
       {
         // Ring full — producer drops the rest. NINJAM frame loss handled by
         // the codec; the run-thread caller sees a short return.
@@ -271,17 +225,21 @@ public:
         s_total_write_drops.fetch_add(1, std::memory_order_relaxed);
         return len - remaining;
       }
-      in += chunk.len;
-      remaining -= chunk.len;
-      m_total_written.fetch_add(chunk.len, std::memory_order_relaxed);
+      const int clen = std::min(remaining, jamwide::CHUNK_BYTES);
+      chunk->len = clen;
+      std::memcpy(chunk->data, in, static_cast<size_t>(clen));
+      m_chunks.commit();
+      in += clen;
+      remaining -= clen;
+      m_total_written.fetch_add(clen, std::memory_order_relaxed);
     }
     return len;
   }
 
-  // Audio thread. Drains chunks from the SPSC into the linear consumer buffer
-  // and serves up to len bytes from it. Returns the number of bytes filled
-  // (may be 0 if the SPSC is empty and the consumer buffer is dry). Never
-  // blocks; never allocates; never enters a kernel mutex (CR-12 closed).
+  // Audio thread. Serves up to len bytes straight from the chunks at the
+  // front of the SPSC, popping each one once it is used up. Returns the
+  // number of bytes filled (may be 0 if the SPSC is empty). Never blocks;
+  // never allocates; never enters a kernel mutex (CR-12 closed).
   int Read(void *buf, int len)
   {
     if (len <= 0 || !buf) return 0;
@@ -289,30 +247,30 @@ public:
     uint8_t *out = static_cast<uint8_t *>(buf);
     while (written < len)
     {
-      // 1. Drain consumer-side buffer first.
-      const int avail = m_consumer_buf_len - m_consumer_buf_pos;
-      if (avail > 0)
-      {
-        const int take = std::min(avail, len - written);
-        std::memcpy(out + written,
-                    m_consumer_buf.data() + m_consumer_buf_pos,
-                    static_cast<size_t>(take));
-        m_consumer_buf_pos += take;
-        written += take;
-        continue;
-      }
-      // 2. Pull next chunk from SPSC. Empty -> return what we have so far
-      //    (short read; caller signals codec EOF/needs-more).
-      auto chunk = m_chunks.try_pop();
+      // Empty -> return what we have so far (short read; caller signals
+      // codec EOF/needs-more). A partially read front chunk stays put.
+      const jamwide::DecodeChunk* chunk = m_chunks.front();
       if (!chunk) break;
       // Defensive bounds-check: producer always writes <= CHUNK_BYTES, but
       // assert anyway so a future payload-size change is caught early.
       const int clen = chunk->len;
-      if (clen <= 0 || clen > jamwide::CHUNK_BYTES) continue; // skip malformed
-      std::memcpy(m_consumer_buf.data(), chunk->data,
-                  static_cast<size_t>(clen));
-      m_consumer_buf_len = clen;
-      m_consumer_buf_pos = 0;
+      if (clen <= 0 || clen > jamwide::CHUNK_BYTES || m_front_pos >= clen)
+      {
+        // skip malformed (or already fully consumed)
+        m_chunks.pop();
+        m_front_pos = 0;
+        continue;
+      }
+      const int take = std::min(clen - m_front_pos, len - written);
+      std::memcpy(out + written, chunk->data + m_front_pos,
+                  static_cast<size_t>(take));
+      m_front_pos += take;
+      written += take;
+      if (m_front_pos == clen)
+      {
+        m_chunks.pop();
+        m_front_pos = 0;
+      }
     }
     return written;
   }
@@ -328,6 +286,16 @@ public:
     return static_cast<int>(m_total_written.load(std::memory_order_relaxed));
   }
 
+  // Run-thread helper. Bytes Write() can take right now without dropping:
+  // free chunk slots x CHUNK_BYTES. Conservative — the audio thread can only
+  // free more slots concurrently, never fewer.
+  int WriteSpace() const
+  {
+    const size_t used = m_chunks.size();
+    const size_t usable = m_chunks.capacity() - 1;  // SpscRing keeps one slot open
+    return used >= usable ? 0 : static_cast<int>((usable - used) * jamwide::CHUNK_BYTES);
+  }
+
   // 15.1-09 + Codex HIGH-1: refcnt peek for the run-thread refill loop's
   // dead-entry detection. refillSessionmodeBuffers compares this against 1
   // (only the SessionmodeFileReader holds a ref → the audio side has Released
@@ -356,12 +324,10 @@ private:
   // is ~30 MB transient, acceptable.
   jamwide::SpscRing<jamwide::DecodeChunk, 256> m_chunks;
 
-  // Audio-thread-owned linear buffer — absorbs partial-chunk reads when the
-  // codec asks for fewer bytes than CHUNK_BYTES at a time. Sized to 2x
-  // CHUNK_BYTES so a single chunk fits with margin.
-  std::array<uint8_t, jamwide::CHUNK_BYTES * 2> m_consumer_buf{};
-  int m_consumer_buf_len = 0;
-  int m_consumer_buf_pos = 0;
+  // Audio-thread-owned read offset into the chunk at the front of m_chunks
+  // — absorbs partial-chunk reads when the codec asks for fewer bytes than
+  // CHUNK_BYTES at a time. The chunk is only popped once fully consumed.
+  int m_front_pos = 0;
 
   // Atomic refcount. Replaces the legacy WDL_Mutex-protected int. Race-safe
   // for concurrent Release() across audio/run threads (T-15.1-07c-01 mitigation).
@@ -433,18 +399,54 @@ class DecodeState
 
     bool is_voice_firstchk;
 
-    void applyOverlap(overlapFadeState *s)
+    // Silence bookkeeping for the interval this state decodes (audio thread
+    // only): blocks whose peak was measured, and whether any of them was
+    // above jamwide::kSilenceFloor. Read when on_new_interval retires it.
+    int blocks_scanned = 0;
+    bool heard_audio = false;
+
+    // Head of decoded PCM the run thread leaves in the codec's output
+    // buffer before publishing (primeHead): the longest crossfade plus a
+    // large host block at up to 2x resampling. With it in place the
+    // interval boundary's applyOverlap and first mixInChannel block only
+    // read ready samples instead of parsing headers and decoding the first
+    // packets on the audio thread, for every channel on the same downbeat.
+    enum { HEAD_FRAMES = 2048 };
+    int head_frames = 0;   // frames ready when published (diagnostics)
+
+    // Run thread only, before the state is published. Decodes until the
+    // codec holds `frames` frames (or the input runs dry: a download still
+    // in flight primes whatever has arrived). Returns the frames ready.
+    int primeHead(int frames)
     {
-      if (!s || !s->fade_sz || !decode_codec) return;
+      if (!decode_codec) return 0;
+      int nch = 0;
+      for (;;)
+      {
+        nch = decode_codec->GetNumChannels();
+        if (nch && decode_codec->Available() >= frames * nch) break;
+        if (runDecode()) break;
+      }
+      head_frames = nch ? decode_codec->Available() / nch : 0;
+      return head_frames;
+    }
+
+    // Returns true if the fade had to decode on the calling (audio) thread
+    // because the primed head was too short.
+    bool applyOverlap(overlapFadeState *s)
+    {
+      if (!s || !s->fade_sz || !decode_codec) return false;
       int nch;
+      bool decoded = false;
       for (;;)
       {
         nch = decode_codec->GetNumChannels();
         if (nch && decode_codec->Available() >= s->fade_sz * nch) break;
 
+        decoded = true;
         if (runDecode()) break;
       }
-      if (!nch) return;
+      if (!nch) return decoded;
       const int avail = decode_codec->Available()/nch;
       if (s->fade_nch == nch && s->fade_sz <= avail)
       {
@@ -463,6 +465,7 @@ class DecodeState
           }
         }
       }
+      return decoded;
     }
     void calcOverlap(overlapFadeState *s)
     {
@@ -619,7 +622,11 @@ public:
 
   void Close();
   void Open(NJClient *parent, unsigned int fourcc, bool forceToDisk);
-  void Write(const void *buf, int len);
+  void Write(const void *buf, int len); // Append() + startPlaying()
+  // Store bytes without publishing anything to the mixer. The zero-copy
+  // receive path (DownloadRecvSink) uses this while Net_Connection is still
+  // parsing; the message handler calls startPlaying() in message order.
+  void Append(const void *buf, int len);
   void startPlaying(int force=0); // call this with 1 to make sure it gets played ASAP, or let RemoteDownload call it automatically
 
   time_t last_time;
@@ -629,10 +636,23 @@ public:
   WDL_String username;
   int playtime;
 
+  // Arrival tracking (run thread): which m_arrival[][] tracker this download
+  // reports to. Kept separate from chidx, which startPlaying() clears.
+  int stats_slot, stats_chidx;
+  jamwide::ArrivalInterval arrival;
+
+  // Session archive (NJClient::SetSessionArchiveFile): channel index to
+  // record under (chidx is cleared by startPlaying) and the session position
+  // this interval starts at. Set by the caller after Open(); archive_chidx
+  // < 0 means don't archive.
+  int archive_chidx;
+  int64_t archive_start_ms;
+
 private:
   unsigned int m_fourcc;
   NJClient *m_parent;
-  FILE *m_fp;
+  jamwide::MappedIntervalFile *m_store; // on-disk copy (savelocalaudio / session channels)
+  WDL_TypedBuf<unsigned char> m_archive_buf; // in-memory copy when archiving without m_store
   DecodeMediaBuffer *m_decbuf;
 };
 
@@ -647,7 +667,7 @@ class BufferQueue
       Clear();
     }
 
-    void AddBlock(int attr, double blockstart, float *samples, int len, float *samples2=NULL);
+    void AddBlock(int attr, double blockstart, const float *samples, int len, const float *samples2=NULL);
     int GetBlock(WDL_HeapBuf **b, int *attr=NULL, double *startpos=NULL); // return 0 if got one, 1 if none avail
     void DisposeBlock(WDL_HeapBuf *b);
 
@@ -711,6 +731,7 @@ public:
 #ifndef NJCLIENT_NO_XMIT_SUPPORT
   I_NJEncoder  *m_enc;
   int m_enc_bitrate_used;
+  int m_enc_bitrate_base; // lc->bitrate after adaptive scaling, before the stereo bonus
   int m_enc_nch_used;
   Net_Message *m_enc_header_needsend;
 #endif
@@ -741,6 +762,10 @@ public:
 
 #define NJ_PORT 2049
 
+// Messages NJClient::Run handles per call before giving the upload path a
+// turn (see the batch loop in Run).
+#define NJ_MAX_MESSAGES_PER_RUN 64
+
 static unsigned char zero_guid[16];
 
 
@@ -841,7 +866,6 @@ void NJClient::makeFilenameFromGuid(WDL_String *s, unsigned char *guid)
 
 NJClient::NJClient()
 {
-  m_wavebq=new BufferQueue;
   m_userinfochange=0;
   m_loopcnt=0;
   m_srate=48000;
@@ -878,11 +902,6 @@ NJClient::NJClient()
   ChannelMixer=0;
   ChannelMixer_User=0;
 
-  waveWrite=0;
-#ifndef NJCLIENT_NO_XMIT_SUPPORT
-  m_oggWrite=0;
-  m_oggComp=0;
-#endif
   m_logFile=0;
 
   m_issoloactive=0;
@@ -999,11 +1018,11 @@ void NJClient::SetLogFile(const char *name)
 }
 
 
-// 15.1-08 M-01 + Codex M-7: pre-grow tmpblock so the audio thread (process_samples)
+// 15.1-08 M-01: pre-grow tmpblock so the audio thread (process_samples)
 // never hits its `if (tmpblock.GetSize() < bytelen) tmpblock.Resize(bytelen)` branch
-// in steady state. ALSO enforces the MAX_BLOCK_SAMPLES contract from
-// 15.1-04 spsc_payloads.h: throws std::runtime_error if maxSamplesPerBlock
-// > jamwide::MAX_BLOCK_SAMPLES.
+// in steady state. There is no upper bound any more: the broadcast and wave
+// feeds are byte-granular sample FIFOs that split oversized blocks, so the
+// MAX_BLOCK_SAMPLES contract of the BlockRecord rings no longer applies.
 //
 // Threading: caller MUST be a non-audio thread (JUCE prepareToPlay; UI/host
 // setup). Prealloc mutates m_alloc/m_size/m_buf and is NOT thread-safe vs the
@@ -1011,23 +1030,10 @@ void NJClient::SetLogFile(const char *name)
 // any processBlock call (and the audio thread is suspended across prepareToPlay
 // for a re-prepare), so this contract holds. Idempotent: WDL_HeapBuf::Prealloc
 // only grows; calling with a smaller value is a no-op.
-//
-// Failure mode: throws BEFORE touching tmpblock, so the receiver (JUCE
-// prepareToPlay) sees the bound violation synchronously and can log/degrade.
-// In Release builds, an unhandled host bound violation that slips past
-// SetMaxAudioBlockSize would still surface via the M-03 jassert at the top of
-// processBlock (Debug only) or via the per-callsite bounds check in
-// 15.1-07b's pushBlockRecord (Release counter increment).
 void NJClient::SetMaxAudioBlockSize(int maxSamplesPerBlock)
 {
   if (maxSamplesPerBlock <= 0) return;
 
-  if (maxSamplesPerBlock > jamwide::MAX_BLOCK_SAMPLES) {
-    throw std::runtime_error(
-      "Host samplesPerBlock exceeds JamWide MAX_BLOCK_SAMPLES contract. "
-      "Recompile with larger MAX_BLOCK_SAMPLES or reduce host block size.");
-  }
-
   // tmpblock holds `len` floats per audio-thread mix iteration; size in bytes.
   tmpblock.Prealloc(maxSamplesPerBlock * static_cast<int>(sizeof(float)));
 }
@@ -1035,11 +1041,15 @@ void NJClient::SetMaxAudioBlockSize(int maxSamplesPerBlock)
 
 NJClient::~NJClient()
 {
+  if (m_mem_locked) setHotMemoryLocked(false);
+
   delete m_netcon;
   m_netcon=0;
 
-  delete waveWrite;
-  SetOggOutFile(NULL,0,0);
+  m_master_rec.stopAndWait();
+  m_stem_rec.stopAndWait();
+  m_archive_export_cancel.store(true, std::memory_order_relaxed);
+  if (m_archive_export.joinable()) m_archive_export.join();
 
   if (m_logFile)
   {
@@ -1068,13 +1078,14 @@ NJClient::~NJClient()
       }
     }
     m_remoteusers.Empty();
+    m_users_by_name.clear();
   }
   for (x = 0; x < m_downloads.GetSize(); x ++) delete m_downloads.Get(x);
   m_downloads.Empty();
+  m_downloads_by_guid.clear();
+  discardPendingUpdates(-1);
   for (x = 0; x < m_locchannels.GetSize(); x ++) delete m_locchannels.Get(x);
   m_locchannels.Empty();
-
-  delete m_wavebq;
 }
 
 
@@ -1112,6 +1123,10 @@ unsigned int NJClient::GetSessionPosition()// returns milliseconds
 
 void NJClient::AudioProc(float **inbuf, int innch, float **outbuf, int outnch, int len, int srate, bool justmonitor, bool isPlaying, bool isSeek, double cursessionpos)
 {
+  // FTZ/DAZ for the whole callback: decode, overlap fades, resampling, VU
+  // decay and the metronome all produce decaying values (denormal_guard.h).
+  jamwide::ScopedFlushDenormals ftz;
+
   m_srate=srate;
 
   // 15.1-06 CR-02: drain pending local-channel mutations into the audio-thread
@@ -1136,22 +1151,19 @@ void NJClient::AudioProc(float **inbuf, int innch, float **outbuf, int outnch, i
   // zero output
   int x;
   for (x = 0; x < outnch; x ++) memset(outbuf[x],0,sizeof(float)*len);
+  m_outch_written = 0;
 
   // 15.1-07a CR-01: remote_user_count derived from the audio-thread mirror
   // (m_users_cs.Enter removed). The mirror's `active` slots are the audio-
   // thread-visible peer count after drainRemoteUserUpdates above.
-  int remote_user_count = 0;
-  if (!justmonitor)
-  {
-    for (int s = 0; s < MAX_PEERS; ++s)
-      if (m_remoteuser_mirror[s].active) ++remote_user_count;
-  }
+  const int remote_user_count = justmonitor ? 0 : m_remote_mix.active_peers;
 
   if (!m_audio_enable||justmonitor ||
       (!m_max_localch && remote_user_count == 0) // in a lobby, effectively
       )
   {
     process_samples(inbuf,innch,outbuf,outnch,len,srate,0,1,isPlaying,isSeek,cursessionpos);
+    wakeRunThreadIfBroadcastPending();
     return;
   }
 
@@ -1237,6 +1249,43 @@ void NJClient::AudioProc(float **inbuf, int innch, float **outbuf, int outnch, i
     }
   }
 
+  wakeRunThreadIfBroadcastPending();
+}
+
+// Audio thread. Only the per-channel broadcast rings count: they feed the
+// encoder, whose latency matters for instamode. The master recording has
+// its own writer thread. Edge-triggered: once a wake has been sent, later
+// callbacks skip the ring scan and the signal until drainBroadcastBlocks()
+// clears m_bcast_wake_sent, so there is one wake per drain, not one per
+// callback.
+void NJClient::wakeRunThreadIfBroadcastPending() noexcept
+{
+  if (m_bcast_wake_sent.load(std::memory_order_acquire)) return;
+  for (int ch = 0; ch < MAX_LOCAL_CHANNELS; ++ch)
+  {
+    const LocalChannelMirror &lcm = m_locchan_mirror[ch];
+    if (lcm.active && !lcm.block_q.empty())
+    {
+      m_bcast_wake_sent.store(true, std::memory_order_relaxed);
+      m_run_waiter.wake();
+      return;
+    }
+  }
+}
+
+int NJClient::WaitForActivity(int max_ms)
+{
+  SOCKET sock = INVALID_SOCKET;
+  bool want_write = false;
+  if (m_netcon && m_netcon->GetConnection())
+  {
+    JNL_IConnection *con = m_netcon->GetConnection();
+    sock = con->get_socket();
+    // Run() returned "sleep ok" with output still queued only if the kernel
+    // send buffer is full, so POLLOUT is the edge we want.
+    want_write = m_netcon->GetSendQueueDepth() > 0 || con->send_bytes_in_queue() > 0;
+  }
+  return m_run_waiter.wait(sock, want_write, max_ms);
 }
 
 
@@ -1251,6 +1300,9 @@ void NJClient::Disconnect()
   delete m_netcon;
   m_netcon=0;
 
+  // Unpublished prepared intervals belong to peers that are about to go.
+  discardPendingUpdates(-1);
+
   int x;
   // 15.1-07a CR-01 + Codex HIGH-3: Disconnect can race with the audio thread
   // (it runs on the run thread but the audio callback is independent). For each
@@ -1313,6 +1365,7 @@ void NJClient::Disconnect()
         // If gate timed out, leak rather than risk UAF.
       }
       m_remoteusers.Empty();
+      m_users_by_name.clear();
     }
     x = n;
   }
@@ -1338,8 +1391,7 @@ void NJClient::Disconnect()
     c->m_bq.Clear();
   }
   m_downloads.Empty();
-
-  m_wavebq->Clear();
+  m_downloads_by_guid.clear();
 
   _reinit();
 
@@ -1373,11 +1425,31 @@ void NJClient::Connect(const char *host, const char *user, const char *pass)
 #ifdef JAMWIDE_DEV_BUILD
   fprintf(stderr, "[NJClient] Connecting to %s:%d\n", tmp, port);
 #endif
-  JNL_Connection *c=new JNL_Connection(JNL_CONNECTION_AUTODNS,65536,65536);
+  // Send ring stays at 64 KB: bytes parked there are invisible to the
+  // adaptive-bitrate backlog measurement (GetSendQueueBytes).
+  int recv_ring=config_net_recv_ring.load(std::memory_order_relaxed);
+  if (recv_ring < 16384) recv_ring=16384;
+  else if (recv_ring > 4*1024*1024) recv_ring=4*1024*1024;
+  JNL_Connection *c=new JNL_Connection(JNL_CONNECTION_AUTODNS,65536,recv_ring);
+  c->set_socket_buffers(config_socket_sndbuf.load(std::memory_order_relaxed),
+                        config_socket_rcvbuf.load(std::memory_order_relaxed));
   c->connect(tmp,port);
   m_netcon = new Net_Connection;
   m_netcon->attach(c);
 
+  // fresh uplink: adaptive bitrate starts at the user setting again
+  m_abr.reset();
+  m_abr_last_eval_ms=0;
+  m_abr_sendq_bytes_peak=m_abr_sendq_msgs_peak=0;
+  m_abr_bytes_sent_mark=0;
+  m_abr_stat_percent.store(100, std::memory_order_relaxed);
+  m_abr_stat_step_downs.store(0, std::memory_order_relaxed);
+  m_abr_stat_step_ups.store(0, std::memory_order_relaxed);
+  m_net_stat_msgs.store(0, std::memory_order_relaxed);
+  m_net_stat_max_batch.store(0, std::memory_order_relaxed);
+  m_net_stat_direct_msgs.store(0, std::memory_order_relaxed);
+  m_net_stat_direct_bytes.store(0, std::memory_order_relaxed);
+
   m_status=0;
 
   // Update cached status for lock-free audio thread access
@@ -1460,12 +1532,20 @@ int NJClient::find_unused_output_channel_pair() const
   return best;
 }
 
+// Whether the encoder for `fmt` takes a bitrate at all (FLAC is lossless).
+static bool codecUsesBitrate(unsigned int fmt)
+{
+  return fmt != NJ_ENCODER_FMT_FLAC;
+}
+
 int NJClient::Run() // nonzero if sleep ok
 {
-  // 15.1-07b CR-10: drain m_wave_block_q (audio-thread producer) into the
-  // legacy m_wavebq (run-thread consumer). Must happen BEFORE the wave
-  // GetBlock loop below so the consumer sees freshly-forwarded records.
-  drainWaveBlocks();
+  jamwide::ScopedFlushDenormals ftz;   // encoders see near-silent input too
+  applyRunThreadSched();
+
+  // Interval publishes that found m_remoteuser_update_q full last time go
+  // first, ahead of anything this pass prepares.
+  flushPendingUpdates();
 
   // 15.1-07b CR-09: drain per-channel mirror block_q rings into legacy
   // lc->m_bq. Must happen BEFORE the encoder upload loop below so the
@@ -1474,34 +1554,8 @@ int NJClient::Run() // nonzero if sleep ok
   // producer side dormant.
   drainBroadcastBlocks();
 
-  WDL_HeapBuf *p=0;
-  while (!m_wavebq->GetBlock(&p))
-  {
-    if (p)
-    {
-      float *f=(float*)p->Get();
-      int hl=p->GetSize()/(2*sizeof(float));
-      float *outbuf[2]={f,f+hl};
-#ifndef NJCLIENT_NO_XMIT_SUPPORT
-      if (m_oggWrite&&m_oggComp)
-      {
-        m_oggComp->Encode(f,hl,1,hl);
-        if (m_oggComp->Available())
-        {
-          fwrite((char *)m_oggComp->Get(),1,m_oggComp->Available(),m_oggWrite);
-          m_oggComp->Advance(m_oggComp->Available());
-          m_oggComp->Compact();
-        }
-      }
-#endif
-      if (waveWrite)
-      {
-        waveWrite->WriteFloatsNI(outbuf,0,hl);
-      }
-      m_wavebq->DisposeBlock(p);
-    }
-  }
-//
+  // The master recording (wave/ogg/flac) is written by m_master_rec's own
+  // thread; nothing here waits on the disk.
   int wantsleep=1;
   auto return_with_status = [this](int value) {
     cached_status.store(GetStatus(), std::memory_order_release);
@@ -1523,7 +1577,7 @@ int NJClient::Run() // nonzero if sleep ok
         return return_with_status(1);
       }
     }
-    else
+    else for (int batch = 1; msg; ++batch)
     {
       msg->addRef();
 
@@ -1677,6 +1731,10 @@ int NJClient::Run() // nonzero if sleep ok
                   for (int x = 0; x < m_locchannels.GetSize(); x ++)
                     m_locchannels.Get(x)->channel_idx = x;
                 }
+                // Encryption is settled now; on a plaintext session, interval
+                // writes can skip the Net_Message payload (parseDirect()).
+                m_netcon->SetDirectRecv(MESSAGE_SERVER_DOWNLOAD_INTERVAL_WRITE,17,&m_download_sink);
+
                 NotifyServerOfChannelChange();
                 m_status=2;
                 m_in_auth=0;
@@ -1753,8 +1811,8 @@ int NJClient::Run() // nonzero if sleep ok
                   int          pub_choutch = 0;
 
                   m_users_cs.Enter();
-                  RemoteUser *theuser;
-                  for (x = 0; x < m_remoteusers.GetSize() && strcmp((theuser=m_remoteusers.Get(x))->name.Get(),un); x ++);
+                  RemoteUser *theuser=m_users_by_name.find(un);
+                  x=m_remoteusers.GetSize(); // index a new user gets (PeerAddedUpdate)
 
     //              char buf[512];
   //                sprintf(buf,"user %s, channel %d \"%s\": %s v:%d.%ddB p:%d flag=%d\n",un,cid,chn,a?"active":"inactive",(int)v/10,abs((int)v)%10,p,f);
@@ -1763,11 +1821,12 @@ int NJClient::Run() // nonzero if sleep ok
 
                   if (a)
                   {
-                    if (x == m_remoteusers.GetSize())
+                    if (!theuser)
                     {
                       theuser=new RemoteUser;
                       theuser->name.Set(un);
                       m_remoteusers.Add(theuser);
+                      m_users_by_name.insert(theuser);
                       // 15.1-07a CR-01: allocate a stable mirror slot for this
                       // canonical RemoteUser. Slot is held until generation-
                       // gated deferred-free completes.
@@ -1803,6 +1862,7 @@ int NJClient::Run() // nonzero if sleep ok
 
                     theuser->channels[cid].name.Set(chn);
                     theuser->chanpresentmask |= 1u<<cid;
+                    if (user_slot >= 0) registerStemName(user_slot, cid, un, chn);
 
 
                     if (config_autosubscribe)
@@ -1852,7 +1912,7 @@ int NJClient::Run() // nonzero if sleep ok
                   }
                   else
                   {
-                    if (x < m_remoteusers.GetSize())
+                    if (theuser)
                     {
                       theuser->channels[cid].ClearSessionInfo();
 
@@ -1889,7 +1949,8 @@ int NJClient::Run() // nonzero if sleep ok
                         // happens AFTER m_users_cs.Leave below.
                         victim_for_deferred_delete = theuser;
                         victim_slot = user_slot;
-                        m_remoteusers.Delete(x);
+                        m_remoteusers.Delete(m_remoteusers.Find(theuser));
+                        m_users_by_name.erase(theuser);
                         publish_removed = (victim_slot >= 0);
                         publish_mask_change = false;  // RemovedUpdate covers it
                       }
@@ -1935,32 +1996,20 @@ int NJClient::Run() // nonzero if sleep ok
                   // See .planning/debug/remote-channels-cutoff.md.
                   if (publish_chinfo && user_slot >= 0)
                   {
-                    if (m_remoteuser_update_q.try_push(jamwide::RemoteUserUpdate{
+                    publishOrdered(jamwide::RemoteUserUpdate{
                           jamwide::PeerChannelInfoUpdate{user_slot, cid, pub_chflags,
-                                                         pub_chvol, pub_chpan, pub_choutch}}))
-                    {
-                      m_chinfo_publishes_observed[user_slot][cid]
-                          .fetch_add(1, std::memory_order_relaxed);
-                    }
-                    else
-                    {
-                      m_remoteuser_update_overflows.fetch_add(1, std::memory_order_relaxed);
-                      writeLog("WARNING: m_remoteuser_update_q full on PeerChannelInfoUpdate (slot=%d ch=%d)\n", user_slot, cid);
-                    }
+                                                         pub_chvol, pub_chpan, pub_choutch}});
                   }
                   if (publish_mask_change && user_slot >= 0)
                   {
-                    if (!m_remoteuser_update_q.try_push(jamwide::RemoteUserUpdate{
+                    publishOrdered(jamwide::RemoteUserUpdate{
                           jamwide::PeerChannelMaskUpdate{user_slot, pub_submask,
                                                         pub_chanpresentmask,
-                                                        pub_mutedmask, pub_solomask}}))
-                    {
-                      m_remoteuser_update_overflows.fetch_add(1, std::memory_order_relaxed);
-                      writeLog("WARNING: m_remoteuser_update_q full on PeerChannelMaskUpdate (slot=%d)\n", user_slot);
-                    }
+                                                        pub_mutedmask, pub_solomask}});
                   }
                   if (publish_removed && victim_slot >= 0 && victim_for_deferred_delete)
                   {
+                    discardPendingUpdates(victim_slot);
                     // HIGH-3 generation-gate publish-wait-defer.
                     const uint64_t publish_gen_target =
                         m_audio_drain_generation.load(std::memory_order_acquire) + 1;
@@ -2018,10 +2067,8 @@ int NJClient::Run() // nonzero if sleep ok
               int silence_chidx = -1;
               {
               WDL_MutexLock lock(&m_users_cs);
-              int x;
-              RemoteUser *theuser;
-              for (x = 0; x < m_remoteusers.GetSize() && strcmp((theuser=m_remoteusers.Get(x))->name.Get(),dib.username); x ++);
-              if (x < m_remoteusers.GetSize() && dib.chidx >= 0 && dib.chidx < MAX_USER_CHANNELS)
+              RemoteUser *theuser=m_users_by_name.find(dib.username);
+              if (theuser && dib.chidx >= 0 && dib.chidx < MAX_USER_CHANNELS)
               {
                 //printf("Getting interval for %s, channel %d\n",dib.username,dib.chidx);
                 if (!memcmp(dib.guid,zero_guid,sizeof(zero_guid)))
@@ -2056,11 +2103,34 @@ int NJClient::Run() // nonzero if sleep ok
                   memcpy(ds->guid,dib.guid,sizeof(ds->guid));
                   ds->Open(this,dib.fourcc,!!(theuser->channels[dib.chidx].flags&4));
 
-                  ds->playtime=(theuser->channels[dib.chidx].flags&2)?LIVE_PREBUFFER:config_play_prebuffer.load(std::memory_order_relaxed);
+                  const bool live=!!(theuser->channels[dib.chidx].flags&2);
+                  const int prebuf=config_play_prebuffer.load(std::memory_order_relaxed);
+                  ds->playtime=live?LIVE_PREBUFFER:prebuf;
                   ds->chidx=dib.chidx;
                   ds->username.Set(dib.username);
+                  if (IsSessionArchiveActive())
+                  {
+                    ds->archive_chidx=dib.chidx;
+                    ds->archive_start_ms=archiveStartMs(true);
+                  }
+
+                  const int stats_slot=findRemoteUserSlot(theuser);
+                  if (stats_slot >= 0)
+                  {
+                    WDL_MutexLock alock(&m_arrival_cs);
+                    jamwide::ArrivalJitterTracker &tr=m_arrival[stats_slot][dib.chidx];
+                    ds->stats_slot=stats_slot;
+                    ds->stats_chidx=dib.chidx;
+                    tr.onIntervalBegin(ds->arrival,currentMillis());
+                    // Stable peers start sooner, jittery ones buffer more:
+                    // floor at 1/4 of the default, ceiling at 4x.
+                    if (prebuf > 0 && config_adaptive_prebuffer.load(std::memory_order_relaxed))
+                      ds->playtime=tr.recommendPrebuffer(ds->playtime,live?LIVE_PREBUFFER:prebuf/4,ds->playtime*4);
+                    tr.notePrebuffer(ds->playtime);
+                  }
 
                   m_downloads.Add(ds);
+                  m_downloads_by_guid.insert(ds);
                 }
                 else if (!(theuser->channels[dib.chidx].flags&4))
                 {
@@ -2102,15 +2172,8 @@ int NJClient::Run() // nonzero if sleep ok
                 upd.channel  = publish_silence ? silence_chidx : dib.chidx;
                 upd.slot_idx = useidx_to_publish;
                 upd.ds       = reinterpret_cast<jamwide::DecodeState*>(ds_to_publish);
-                if (!m_remoteuser_update_q.try_push(jamwide::RemoteUserUpdate{upd}))
-                {
-                  m_remoteuser_update_overflows.fetch_add(1, std::memory_order_relaxed);
-                  // Queue full — leak the ds (RT-safety > memory hygiene).
-                  // The mirror's previous slot retains its old ds; this update
-                  // is lost, which means a one-interval audio glitch but no
-                  // crash.
-                  writeLog("WARNING: m_remoteuser_update_q full on PeerNextDsUpdate (slot=%d ch=%d) — leaking ds\n", slot_to_publish, upd.channel);
-                }
+                // Queue full: held and retried next Run() (publishOrdered).
+                publishOrdered(jamwide::RemoteUserUpdate{upd});
               }
               else if (ds_to_publish)
               {
@@ -2128,37 +2191,41 @@ int NJClient::Run() // nonzero if sleep ok
             {
               time_t now;
               time(&now);
-              int x;
-              for (x = 0; x < m_downloads.GetSize(); x ++)
+              RemoteDownload *ds=m_downloads_by_guid.find(diw.guid);
+              if (ds)
               {
-                RemoteDownload *ds=m_downloads.Get(x);
-                if (ds)
-                {
-                  if (!memcmp(ds->guid,diw.guid,sizeof(ds->guid)))
-                  {
-                    if (config_debug_level>1) printf("RECV BLOCK DATA %s%s %d bytes\n",guidtostr_tmp(diw.guid),diw.flags&1?":end":"",diw.audio_data_len);
-
-                    ds->last_time=now;
-                    if (diw.audio_data_len > 0 && diw.audio_data)
-                    {
-                      ds->Write(diw.audio_data,diw.audio_data_len);
-                    }
-                    if (diw.flags & 1)
-                    {
-                      delete ds;
-                      m_downloads.Delete(x);
-                    }
-                    break;
-                  }
+                if (config_debug_level>1) printf("RECV BLOCK DATA %s%s %d bytes\n",guidtostr_tmp(diw.guid),diw.flags&1?":end":"",diw.audio_data_len);
 
-                  if (now - ds->last_time > DOWNLOAD_TIMEOUT)
-                  {
-                    ds->chidx=-1;
-                    delete ds;
-                    m_downloads.Delete(x--);
-                  }
+                ds->last_time=now;
+                if (ds->stats_slot >= 0)
+                {
+                  WDL_MutexLock alock(&m_arrival_cs);
+                  jamwide::ArrivalJitterTracker &tr=m_arrival[ds->stats_slot][ds->stats_chidx];
+                  const int64_t now_ms=currentMillis();
+                  tr.onChunk(ds->arrival,now_ms,diw.audio_data_len > 0 ? diw.audio_data_len : 0);
+                  if (diw.flags & 1) tr.onIntervalEnd(ds->arrival,now_ms,nominalIntervalMs());
+                }
+                // audio_data is NULL when DownloadRecvSink already stored
+                // the payload while the message was being parsed; playback
+                // may only start now, after every message queued before it.
+                if (diw.audio_data_len > 0 && diw.audio_data)
+                {
+                  ds->Write(diw.audio_data,diw.audio_data_len);
+                }
+                else if (diw.audio_data_len > 0)
+                {
+                  ds->startPlaying();
+                }
+                if (diw.flags & 1)
+                {
+                  m_downloads_by_guid.erase(ds);
+                  m_downloads.Delete(m_downloads.Find(ds));
+                  delete ds;
                 }
               }
+              // The old linear match also timed out every download it walked
+              // past; with the index that is a separate sweep, once a second.
+              if (now != m_download_reap_time) reapStaleDownloads(now);
             }
           }
         break;
@@ -2173,11 +2240,9 @@ int NJClient::Run() // nonzero if sleep ok
                 if (foo.parms[1] && foo.parms[2] && foo.parms[3] && foo.parms[4])
                 {
                   WDL_MutexLock lock(&m_users_cs);
-                  int x;
-                  RemoteUser *theuser;
-                  for (x = 0; x < m_remoteusers.GetSize() && strcmp((theuser=m_remoteusers.Get(x))->name.Get(),foo.parms[1]); x ++);
+                  RemoteUser *theuser=m_users_by_name.find(foo.parms[1]);
                   int chanidx=atoi(foo.parms[3]);
-                  if (x < m_remoteusers.GetSize() && chanidx >= 0 && chanidx < MAX_USER_CHANNELS &&
+                  if (theuser && chanidx >= 0 && chanidx < MAX_USER_CHANNELS &&
                       ((theuser->submask & theuser->chanpresentmask) & (1u<<chanidx)) && // only update if subscribed
                       (theuser->channels[chanidx].flags&4))
                   {
@@ -2251,6 +2316,21 @@ int NJClient::Run() // nonzero if sleep ok
       }
 
       msg->releaseRef();
+
+      // Net_Connection::Run parsed every complete message the socket had;
+      // handle the rest of the batch here instead of one per Run() call, so
+      // an interval-write burst doesn't pay for the encoder loop below (and a
+      // run-thread round trip) per message. Capped so uploads still get a
+      // turn; Run() reports "don't sleep" while messages remain queued.
+      msg = (m_netcon && batch < NJ_MAX_MESSAGES_PER_RUN) ? m_netcon->NextMessage() : 0;
+    }
+
+    if (m_netcon)
+    {
+      m_net_stat_msgs.store(m_netcon->GetMessagesReceived(), std::memory_order_relaxed);
+      m_net_stat_max_batch.store(m_netcon->GetMaxRecvBatch(), std::memory_order_relaxed);
+      m_net_stat_direct_msgs.store(m_netcon->GetDirectRecvMessages(), std::memory_order_relaxed);
+      m_net_stat_direct_bytes.store(m_netcon->GetDirectRecvBytes(), std::memory_order_relaxed);
     }
   }
 
@@ -2265,6 +2345,8 @@ int NJClient::Run() // nonzero if sleep ok
   // belt-and-braces for any other path that might leave records in lc->m_bq.
   if (m_netcon)
   {
+  updateAdaptiveBitrate();
+
   int u;
   for (u = 0; u < m_locchannels.GetSize(); u ++)
   {
@@ -2323,14 +2405,21 @@ int NJClient::Run() // nonzero if sleep ok
         if (!lc->m_enc)
         {
           m_encoder_fmt_active = m_encoder_fmt_requested.load(std::memory_order_relaxed);
+          const int br = lc->m_enc_bitrate_base = adaptiveChannelBitrate(lc);
           if (m_encoder_fmt_active == NJ_ENCODER_FMT_FLAC)
-            lc->m_enc = CreateFLACEncoder(m_srate,lc->m_enc_nch_used=block_nch,lc->m_enc_bitrate_used = lc->bitrate+(block_nch>1?lc->bitrate/3:0),WDL_RNG_int32());
+            lc->m_enc = CreateFLACEncoder(m_srate,lc->m_enc_nch_used=block_nch,lc->m_enc_bitrate_used = br+(block_nch>1?br/3:0),WDL_RNG_int32());
+#ifdef JAMWIDE_WITH_OPUS
+          else if (m_encoder_fmt_active == NJ_ENCODER_FMT_OPUS)
+            lc->m_enc = CreateOpusEncoder(m_srate,lc->m_enc_nch_used=block_nch,lc->m_enc_bitrate_used = br+(block_nch>1?br/3:0),WDL_RNG_int32(),
+                                          (lc->flags&2) ? OPUS_LIVE_FRAME_MS : 20.0);
+#endif
           else
-            lc->m_enc = CreateNJEncoder(m_srate,lc->m_enc_nch_used=block_nch,lc->m_enc_bitrate_used = lc->bitrate+(block_nch>1?lc->bitrate/3:0),WDL_RNG_int32());
+            lc->m_enc = CreateNJEncoder(m_srate,lc->m_enc_nch_used=block_nch,lc->m_enc_bitrate_used = br+(block_nch>1?br/3:0),WDL_RNG_int32());
 
           // Send chat notification when codec changes
           if (m_encoder_fmt_prev != 0 && m_encoder_fmt_active != m_encoder_fmt_prev) {
-            const char* codec_name = (m_encoder_fmt_active == NJ_ENCODER_FMT_FLAC) ? "FLAC lossless" : "Vorbis compressed";
+            const char* codec_name = (m_encoder_fmt_active == NJ_ENCODER_FMT_FLAC) ? "FLAC lossless" :
+                                     (m_encoder_fmt_active == NJ_ENCODER_FMT_OPUS) ? "Opus low-latency" : "Vorbis compressed";
             char msg[128];
             snprintf(msg, sizeof(msg), "/me switched to %s", codec_name);
             ChatMessage_Send("MSG", msg);
@@ -2346,9 +2435,18 @@ int NJClient::Run() // nonzero if sleep ok
             char guidstr[64];
             guidtostr(lc->m_curwritefile.guid,guidstr);
             if (!(lc->flags&4)) writeLog("local %s %d%s\n",guidstr,lc->channel_idx,(lc->flags&2)?"v":"");
-            if (config_savelocalaudio>0)
+            const bool archiving=IsSessionArchiveActive();
+            if (config_savelocalaudio>0 || archiving)
             {
               lc->m_curwritefile.Open(this,m_encoder_fmt_active,false);
+              if (archiving)
+              {
+                lc->m_curwritefile.archive_chidx=lc->channel_idx;
+                lc->m_curwritefile.archive_start_ms=archiveStartMs(false);
+              }
+            }
+            if (config_savelocalaudio>0)
+            {
               if (lc->m_wavewritefile) delete lc->m_wavewritefile;
               lc->m_wavewritefile=0;
               if (config_savelocalaudio>1)
@@ -2516,7 +2614,11 @@ int NJClient::Run() // nonzero if sleep ok
 
         }
 
-        if (lc->m_enc && lc->bitrate != lc->m_enc_bitrate_used)
+        // Compare against the pre-stereo-bonus base so stereo channels are not
+        // rebuilt every interval; this also picks up adaptive bitrate steps.
+        // FLAC ignores the bitrate, so rebuilding it would only re-prime it.
+        if (lc->m_enc && codecUsesBitrate(m_encoder_fmt_active) &&
+            adaptiveChannelBitrate(lc) != lc->m_enc_bitrate_base)
         {
           delete lc->m_enc;
           lc->m_enc=0;
@@ -2556,7 +2658,7 @@ DecodeState *NJClient::start_decode(unsigned char *guid, int chanflags, unsigned
 
 
   // Supported codec types for file probing and network decode
-  unsigned int types[]={NJ_ENCODER_FMT_FLAC, MAKE_NJ_FOURCC('O','G','G','v')};
+  unsigned int types[]={NJ_ENCODER_FMT_FLAC, MAKE_NJ_FOURCC('O','G','G','v'), NJ_ENCODER_FMT_OPUS};
   unsigned int matched_type = 0;
 
   if (!newstate->decode_buf)
@@ -2584,16 +2686,21 @@ DecodeState *NJClient::start_decode(unsigned char *guid, int chanflags, unsigned
     unsigned int codec_type = newstate->decode_buf ? fourcc : matched_type;
     if (codec_type == NJ_ENCODER_FMT_FLAC)
       newstate->decode_codec = CreateFLACDecoder();
+    else if (codec_type == NJ_ENCODER_FMT_OPUS)
+      newstate->decode_codec = CreateOpusDecoder();
     else
       newstate->decode_codec = CreateNJDecoder();
     // run some decoding
 
     if (newstate->decode_codec)
     {
-      while (newstate->decode_codec->Available() <= 0)
-      {
-        if (newstate->runDecode()) break;
-      }
+      // Header parse and the first packets happen here, on the run thread,
+      // not at the interval boundary on the audio thread.
+      const int frames = newstate->primeHead(DecodeState::HEAD_FRAMES);
+      if (frames >= DecodeState::HEAD_FRAMES)
+        m_decode_heads_primed.fetch_add(1, std::memory_order_relaxed);
+      else
+        m_decode_heads_short.fetch_add(1, std::memory_order_relaxed);
       if (chanflags & 2)
         newstate->is_voice_firstchk=true;
     }
@@ -2623,9 +2730,278 @@ void NJClient::ChatMessage_Send(const char *parm1, const char *parm2, const char
   }
 }
 
+// Adaptive upload bitrate. Called once per Run() pass (run thread) just
+// before the encoder loop. Samples the uplink backlog every pass and
+// evaluates the controller once per interval's worth of wall time; the
+// chosen rate is picked up by the encoder loop at each channel's next
+// interval boundary (see adaptiveChannelBitrate / m_enc_bitrate_base).
+void NJClient::updateAdaptiveBitrate()
+{
+  if (!m_netcon) return;
+
+  const int qbytes = m_netcon->GetSendQueueBytes();
+  const int qmsgs = m_netcon->GetSendQueueDepth();
+  if (qbytes > m_abr_sendq_bytes_peak) m_abr_sendq_bytes_peak = qbytes;
+  if (qmsgs > m_abr_sendq_msgs_peak) m_abr_sendq_msgs_peak = qmsgs;
+
+  const int bpm = m_bpm.load(std::memory_order_relaxed);
+  const int bpi = m_bpi.load(std::memory_order_relaxed);
+  if (bpm < 1 || bpi < 1) return; // not in a session yet
+
+  const int64_t now = currentMillis();
+  const int64_t interval_ms = (int64_t)bpi * 60000 / bpm;
+  if (!m_abr_last_eval_ms)
+  {
+    m_abr_last_eval_ms = now;
+    m_abr_bytes_sent_mark = m_netcon->GetBytesSent();
+    return;
+  }
+  if (now - m_abr_last_eval_ms < interval_ms) return;
+  m_abr_last_eval_ms = now;
+
+  jamwide::UplinkSample s;
+  s.sendq_bytes_peak = m_abr_sendq_bytes_peak;
+  s.sendq_msgs_peak = m_abr_sendq_msgs_peak;
+  s.bytes_sent = m_netcon->GetBytesSent() - m_abr_bytes_sent_mark;
+  s.recv_gap_ms = m_netcon->GetRecvGapMs();
+
+  double expected = 0.0;
+  for (int x = 0; x < m_locchannels.GetSize(); x ++)
+  {
+    const Local_Channel *lc = m_locchannels.Get(x);
+    if (!lc || !lc->broadcasting || lc->channel_idx >= m_max_localch) continue;
+    const int br = adaptiveChannelBitrate(lc);
+    const int kbps = br + ((lc->src_channel & 1024) ? br/3 : 0);
+    expected += kbps * 1000.0 / 8.0 * (double)interval_ms / 1000.0;
+  }
+  s.expected_bytes = (int)expected;
+
+  m_abr_bytes_sent_mark = m_netcon->GetBytesSent();
+  m_abr_sendq_bytes_peak = m_abr_sendq_msgs_peak = 0;
+
+  if (!config_adaptive_bitrate.load(std::memory_order_relaxed))
+  {
+    m_abr.reset();
+  }
+  else if (codecUsesBitrate(m_encoder_fmt_requested.load(std::memory_order_relaxed)))
+  {
+    // With a codec that ignores the bitrate a step would change nothing,
+    // so the controller and its step counts are left as they are.
+    const int before = m_abr.percent();
+    switch (m_abr.onInterval(s))
+    {
+      case jamwide::AdaptiveBitrateController::kStepDown:
+        m_abr_stat_step_downs.fetch_add(1, std::memory_order_relaxed);
+      break;
+      case jamwide::AdaptiveBitrateController::kStepUp:
+        m_abr_stat_step_ups.fetch_add(1, std::memory_order_relaxed);
+      break;
+      default:
+      break;
+    }
+    if (config_debug_level>0 && m_abr.percent() != before)
+      printf("ADAPTIVE BITRATE %d%% -> %d%% (backlog %d bytes/%d msgs, expected %d, sent %llu, recv gap %dms)\n",
+             before, m_abr.percent(), s.sendq_bytes_peak, s.sendq_msgs_peak, s.expected_bytes,
+             (unsigned long long)s.bytes_sent, s.recv_gap_ms);
+  }
+
+  m_abr_stat_percent.store(m_abr.percent(), std::memory_order_relaxed);
+  m_abr_stat_sendq_bytes.store(s.sendq_bytes_peak, std::memory_order_relaxed);
+  m_abr_stat_sendq_msgs.store(s.sendq_msgs_peak, std::memory_order_relaxed);
+  m_abr_stat_recv_gap_ms.store(s.recv_gap_ms, std::memory_order_relaxed);
+  m_abr_stat_bytes_sent.store(s.bytes_sent, std::memory_order_relaxed);
+}
+
+int NJClient::adaptiveChannelBitrate(const Local_Channel *lc) const
+{
+  if (!config_adaptive_bitrate.load(std::memory_order_relaxed)) return lc->bitrate;
+  return m_abr.apply(lc->bitrate);
+}
+
+void NJClient::GetAdaptiveBitrateStats(AdaptiveBitrateStats& out) const noexcept
+{
+  out.enabled          = config_adaptive_bitrate.load(std::memory_order_relaxed);
+  out.percent          = m_abr_stat_percent.load(std::memory_order_relaxed);
+  out.sendq_bytes_peak = m_abr_stat_sendq_bytes.load(std::memory_order_relaxed);
+  out.sendq_msgs_peak  = m_abr_stat_sendq_msgs.load(std::memory_order_relaxed);
+  out.recv_gap_ms      = m_abr_stat_recv_gap_ms.load(std::memory_order_relaxed);
+  out.bytes_sent       = m_abr_stat_bytes_sent.load(std::memory_order_relaxed);
+  out.step_downs       = m_abr_stat_step_downs.load(std::memory_order_relaxed);
+  out.step_ups         = m_abr_stat_step_ups.load(std::memory_order_relaxed);
+}
+
+// Called at the top of every Run() pass: four relaxed loads unless the
+// config changed. The first pass applies anything but the defaults, so
+// whichever thread ends up calling Run() (NinjamRunThread, the CLAP run
+// thread) gets the policy; with the defaults the host's own scheduling of
+// that thread is left untouched until a setting changes.
+void NJClient::applyRunThreadSched()
+{
+  jamwide::ThreadSchedConfig cfg;
+  cfg.policy   = config_thread_policy.load(std::memory_order_relaxed);
+  cfg.priority = config_thread_priority.load(std::memory_order_relaxed);
+  cfg.cpu_mask = config_thread_cpumask.load(std::memory_order_relaxed);
+  const bool want_lock = config_lock_memory.load(std::memory_order_relaxed);
+
+  if (want_lock != m_mem_locked ||
+      (want_lock && m_mem_locked_fifos != m_sample_fifo_allocs.load(std::memory_order_acquire)))
+    setHotMemoryLocked(want_lock);
+  if (cfg == m_sched_applied) return;
+  m_sched_applied = cfg;
+
+  jamwide::ThreadSchedStatus s;
+  jamwide::applyThreadSched(cfg, &s);
+  m_sched_stat_policy.store(s.policy, std::memory_order_relaxed);
+  m_sched_stat_priority.store(s.priority, std::memory_order_relaxed);
+  m_sched_stat_req_policy.store(s.requested_policy, std::memory_order_relaxed);
+  m_sched_stat_req_priority.store(s.requested_priority, std::memory_order_relaxed);
+  m_sched_stat_error.store(s.sched_error, std::memory_order_relaxed);
+  m_sched_stat_affinity_error.store(s.affinity_error, std::memory_order_relaxed);
+  m_sched_stat_cpumask.store(s.cpu_mask, std::memory_order_relaxed);
+  if (s.sched_error || s.affinity_error)
+    writeLog("run thread scheduling: policy error %d, affinity error %d\n", s.sched_error, s.affinity_error);
+}
+
+// The audio thread's working set that lives inside NJClient: the remote and
+// local channel mirrors, the remote mix list and the storage of every sample
+// FIFO allocated so far (per-channel broadcast, master recorder ring, stem
+// recorder ring). Decode buffers come and go per interval and are not
+// pinned. FIFOs allocated later are picked up by a re-lock from
+// applyRunThreadSched (m_sample_fifo_allocs); mlock of an already locked
+// range is harmless.
+void NJClient::setHotMemoryLocked(bool lock)
+{
+  struct Range { const void *p; size_t len; };
+  Range ranges[3 + MAX_LOCAL_CHANNELS + 2];
+  int nranges = 0;
+  ranges[nranges++] = { m_remoteuser_mirror, sizeof(m_remoteuser_mirror) };
+  ranges[nranges++] = { &m_remote_mix, sizeof(m_remote_mix) };
+  ranges[nranges++] = { m_locchan_mirror, sizeof(m_locchan_mirror) };
+  for (int ch = 0; ch < MAX_LOCAL_CHANNELS; ++ch)
+    if (m_locchan_mirror[ch].block_q.allocated())
+      ranges[nranges++] = { m_locchan_mirror[ch].block_q.data(), m_locchan_mirror[ch].block_q.capacity() };
+  if (m_master_rec.fifoData())
+    ranges[nranges++] = { m_master_rec.fifoData(), m_master_rec.fifoCapacity() };
+  if (m_stem_rec.fifoData())
+    ranges[nranges++] = { m_stem_rec.fifoData(), m_stem_rec.fifoCapacity() };
+
+  m_mem_locked_fifos = m_sample_fifo_allocs.load(std::memory_order_acquire);
+  uint64_t locked = 0;
+  int err = 0;
+  for (int i = 0; i < nranges; ++i)
+  {
+    const Range &r = ranges[i];
+    if (!lock) { jamwide::unlockMemory(r.p, r.len); continue; }
+    const int e = jamwide::lockMemory(r.p, r.len);
+    if (e) err = e;
+    else locked += r.len;
+  }
+  m_mem_locked = lock;
+  m_sched_stat_locked_bytes.store(locked, std::memory_order_relaxed);
+  m_sched_stat_lock_error.store(err, std::memory_order_relaxed);
+}
+
+void NJClient::ensureLocalChannelFifo(int ch)
+{
+  if (ch < 0 || ch >= MAX_LOCAL_CHANNELS) return;
+  jamwide::SampleFifo &f = m_locchan_mirror[ch].block_q;
+  if (f.allocated()) return;
+  if (f.allocate(LocalChannelMirror::kBroadcastFifoBytes))
+    m_sample_fifo_allocs.fetch_add(1, std::memory_order_release);
+  else
+    writeLog("WARNING: broadcast FIFO allocation failed (channel=%d)\n", ch);
+}
+
+void NJClient::GetRunThreadSchedStatus(jamwide::ThreadSchedStatus* out) const noexcept
+{
+  if (!out) return;
+  out->policy             = m_sched_stat_policy.load(std::memory_order_relaxed);
+  out->priority           = m_sched_stat_priority.load(std::memory_order_relaxed);
+  out->requested_policy   = m_sched_stat_req_policy.load(std::memory_order_relaxed);
+  out->requested_priority = m_sched_stat_req_priority.load(std::memory_order_relaxed);
+  out->sched_error        = m_sched_stat_error.load(std::memory_order_relaxed);
+  out->affinity_error     = m_sched_stat_affinity_error.load(std::memory_order_relaxed);
+  out->cpu_mask           = m_sched_stat_cpumask.load(std::memory_order_relaxed);
+  out->locked_bytes       = m_sched_stat_locked_bytes.load(std::memory_order_relaxed);
+  out->lock_error         = m_sched_stat_lock_error.load(std::memory_order_relaxed);
+}
+
+int64_t NJClient::nominalIntervalMs() const
+{
+  const int bpm = m_bpm.load(std::memory_order_relaxed);
+  const int bpi = m_bpi.load(std::memory_order_relaxed);
+  if (bpm < 1 || bpi < 1) return 0;
+  return (int64_t)bpi * 60000 / bpm;
+}
+
+bool NJClient::GetArrivalStatsSnapshot(int slot, int channel, jamwide::ArrivalStatsSnapshot* out) const
+{
+  if (!out) return false;
+  if (slot < 0 || slot >= MAX_PEERS) return false;
+  if (channel < 0 || channel >= MAX_USER_CHANNELS) return false;
+  WDL_MutexLock alock(&m_arrival_cs);
+  *out = m_arrival[slot][channel].snapshot();
+  return true;
+}
+
+void NJClient::archivePath(WDL_String *s, const char *name)
+{
+  s->Set("");
+  if (!strstr(name,"\\") && !strstr(name,"/") && !strstr(name,":"))
+    s->Set(m_workdir.Get());
+  s->Append(name);
+}
+
+bool NJClient::SetSessionArchiveFile(const char *name)
+{
+  WDL_MutexLock lock(&m_archive_cs);
+  m_archive.close();
+  if (!name || !*name) return true;
+
+  WDL_String s;
+  archivePath(&s, name);
+  return m_archive.open(s.Get());
+}
+
+bool NJClient::IsSessionArchiveActive()
+{
+  WDL_MutexLock lock(&m_archive_cs);
+  return m_archive.isOpen();
+}
+
+// Session position an interval is filed under. Local intervals are encoded
+// from the boundary they start at; a remote interval that begins arriving
+// now plays from the next boundary. Nominal (assumes BPM/BPI constant since
+// connect); falls back to the raw position before the first interval.
+int64_t NJClient::archiveStartMs(bool remote)
+{
+  const int64_t pos = (int64_t)GetSessionPosition();
+  const int64_t len = nominalIntervalMs();
+  if (len <= 0) return pos;
+  if (remote) return (pos / len + 1) * len;
+  return ((pos + len / 2) / len) * len;
+}
+
+void NJClient::archiveInterval(const char *user, int channel, const unsigned char *guid, unsigned int fourcc,
+                               int64_t start_ms, const void *data, int len)
+{
+  WDL_MutexLock lock(&m_archive_cs);
+  if (!m_archive.isOpen()) return;
+  const int track = m_archive.track(user, channel);
+  const int64_t ilen = nominalIntervalMs();
+  if (track < 0 || !m_archive.appendInterval(track, guid, fourcc, start_ms, (uint32_t)(ilen > 0 ? ilen : 0), data, (size_t)len))
+  {
+    if (config_debug_level>0) printf("session archive: failed to record interval for %s/%d\n", user, channel);
+  }
+}
+
 void NJClient::SetEncoderFormat(unsigned int fourcc)
 {
-  if (fourcc == NJ_ENCODER_FMT_FLAC || fourcc == NJ_ENCODER_FMT_TYPE)
+  if (fourcc == NJ_ENCODER_FMT_FLAC || fourcc == NJ_ENCODER_FMT_TYPE
+#ifdef JAMWIDE_WITH_OPUS
+      || fourcc == NJ_ENCODER_FMT_OPUS
+#endif
+     )
     m_encoder_fmt_requested.store(fourcc, std::memory_order_relaxed);
 }
 
@@ -2691,17 +3067,18 @@ void NJClient::process_samples(float **inbuf, int innch, float **outbuf, int out
 #ifndef NJCLIENT_NO_XMIT_SUPPORT
     // 15.1-07b CR-09: audio-thread broadcast producer. Audio thread mirrors
     // the legacy lc->m_bq.AddBlock semantics from process_samples 2002, 2017,
-    // 2023, 2036 — but pushes BlockRecords onto m_locchan_mirror[ch].block_q
-    // (the SPSC ring) instead of into the lock-and-heap-alloc BufferQueue.
+    // 2023, 2036 — but pushes blocks onto m_locchan_mirror[ch].block_q
+    // (the SPSC sample FIFO) instead of into the lock-and-heap-alloc
+    // BufferQueue.
     // The run thread (drainBroadcastBlocks, called from NJClient::Run before
     // the existing GetBlock loop) drains the ring and forwards into legacy
     // lc->m_bq.AddBlock there. This restores broadcast end-to-end after
     // 15.1-06 left this path dormant — and closes AUDIT CR-09.
     //
-    // pushBlockRecord performs Codex M-7 bounds-check (sample_count <=
-    // MAX_BLOCK_SAMPLES, nch <= MAX_BLOCK_CHANNELS) BEFORE memcpy and bumps
-    // m_block_queue_drops on either bounds failure or ring-full (Codex M-8
-    // counter — 15.1-10 fails the phase if non-zero post-UAT).
+    // pushBlockRecord rejects invalid counts/channel layouts, splits blocks
+    // too large for one FIFO record, and bumps m_block_queue_drops on
+    // rejection or FIFO-full (Codex M-8 counter — 15.1-10 fails the phase if
+    // non-zero post-UAT).
     if (!justmonitor)
     {
       if (lcm.flags & 2)
@@ -2740,8 +3117,8 @@ void NJClient::process_samples(float **inbuf, int innch, float **outbuf, int out
             lcm.bcast_active = true;
             // Broadcast-START marker: legacy lc->m_bq.AddBlock(0,
             //   cursessionpos, NULL, -1) — encoded here as sample_count=-1.
-            // pushBlockRecord with sample_count<0 is rejected by the M-7
-            // bounds check; instead we encode the broadcast-start as
+            // pushBlockRecord with sample_count<0 is rejected by the FIFO;
+            // instead we encode the broadcast-start as
             // attr=0 + startpos=cursessionpos + sample_count=0, and the run-
             // thread drainBroadcastBlocks() resolves the sample_count==-1
             // legacy semantic by checking startpos. (See drainBroadcastBlocks
@@ -2792,6 +3169,7 @@ void NJClient::process_samples(float **inbuf, int innch, float **outbuf, int out
       if (idx< 0)idx=0;
 
       float *out1=outbuf[idx]+offset;
+      if (chan_active) markOutputWritten(idx, use_nch);
 
       float vol1=lcm.volume;
       if (use_nch > 1)
@@ -2804,47 +3182,28 @@ void NJClient::process_samples(float **inbuf, int innch, float **outbuf, int out
         // 15.1-06: VU peak is stored on the mirror as std::atomic<float>;
         // GetLocalChannelPeak reads from there (no m_locchan_cs needed on
         // the UI side). Audio-thread writes are relaxed.
-        float maxf =(float)(lcm.peak_vol_l.load(std::memory_order_relaxed)*decay);
-        float maxf2=(float)(lcm.peak_vol_r.load(std::memory_order_relaxed)*decay);
+        float maxf =jamwide::flushDenormal((float)(lcm.peak_vol_l.load(std::memory_order_relaxed)*decay));
+        float maxf2=jamwide::flushDenormal((float)(lcm.peak_vol_r.load(std::memory_order_relaxed)*decay));
 
-        int x=len;
-        while (x--)
+        // Mute/solo is decided once per block: a silent channel still
+        // meters, it just skips the accumulate (mix_kernels.h).
+        if (chan_active)
         {
-          float f=src[0];
-
-          if (f > maxf) maxf=f;
-          else if (f < -maxf) maxf=-f;
-
-          if (chan_active)
-            *out1++ += f * vol1;
-
-          f=src2[0];
-
-          if (f > maxf2) maxf2=f;
-          else if (f < -maxf2) maxf2=-f;
-
-          if (chan_active)
-            *out2++ += f * vol2;
-
-          src++;
-          src2++;
+          maxf = jamwide::mixPeak(out1, src, len, vol1, maxf);
+          maxf2 = jamwide::mixPeak(out2, src2, len, vol2, maxf2);
+        }
+        else
+        {
+          maxf = jamwide::peakAbs(src, len, maxf);
+          maxf2 = jamwide::peakAbs(src2, len, maxf2);
         }
         lcm.peak_vol_l.store(maxf,  std::memory_order_relaxed);
         lcm.peak_vol_r.store(maxf2, std::memory_order_relaxed);
       }
       else
       {
-        float maxf=(float)(lcm.peak_vol_l.load(std::memory_order_relaxed)*decay);
-        int x=len;
-        while (x--)
-        {
-          float f=(*src++ + *src2++)*0.5f;
-          if (f > maxf) maxf=f;
-          else if (f < -maxf) maxf=-f;
-
-          if (chan_active)
-            *out1++ += f * vol1;;
-        }
+        float maxf=jamwide::flushDenormal((float)(lcm.peak_vol_l.load(std::memory_order_relaxed)*decay));
+        maxf = jamwide::downmixPeak(chan_active ? out1 : nullptr, src, src2, len, vol1, maxf);
         lcm.peak_vol_l.store(maxf, std::memory_order_relaxed);
         lcm.peak_vol_r.store(maxf, std::memory_order_relaxed);
       }
@@ -2856,69 +3215,53 @@ void NJClient::process_samples(float **inbuf, int innch, float **outbuf, int out
   if (!justmonitor)
   {
     // 15.1-07a CR-01: m_users_cs.Enter/Leave removed. Audio thread iterates
-    // m_remoteuser_mirror[MAX_PEERS]; every field needed for the mix-in pass
-    // is BY VALUE in the mirror (Codex HIGH-2). The DecodeState* members of
-    // each per-channel mirror are audio-thread-owned — pointer-shuffle in
-    // mixInChannel operates ONLY on the mirror.
+    // m_remote_mix, the present channels of m_remoteuser_mirror[MAX_PEERS]
+    // with their mix parameters pre-combined (rebuildRemoteMixList); every
+    // field needed for the mix-in pass is BY VALUE in the mirror (Codex
+    // HIGH-2). The DecodeState* members of each per-channel mirror are
+    // audio-thread-owned — pointer-shuffle in mixInChannel operates ONLY on
+    // the mirror.
     // 15.1-03 H-01: JAMWIDE_DEV_BUILD fopen("/tmp/jamwide.log") block removed
     // unconditionally (also removes the surrounding `if (!m_debug_logged_remote ...)`
     // gate which existed only to one-shot that dev-build log; m_debug_logged_remote
     // field deleted from the class).
-    for (int s = 0; s < MAX_PEERS; ++s)
+    //
+    // Stem recording: one generation load per block; mixInChannel taps each
+    // channel against it and the block's length closes it (tapStem).
+    m_stem_gen = m_stem_rec.beginBlock();
+    m_stem_block_offs = offset;
+    const RemoteMixList& rm = m_remote_mix;
+    for (int i = 0; i < rm.count; ++i)
     {
-      auto& um = m_remoteuser_mirror[s];
-      if (!um.active) continue;
-
-      int a = um.chanpresentmask;
-      for (int ch = 0; ch < MAX_USER_CHANNELS && a; ++ch)
-      {
-        if (a & 1)
-        {
-          float lpan = um.pan + um.chans[ch].pan;
-          if (lpan < -1.0f) lpan = -1.0f;
-          else if (lpan > 1.0f) lpan = 1.0f;
-
-          bool muteflag;
-          if (m_issoloactive) muteflag = !(um.solomask & (1u << ch));
-          else muteflag = (um.mutedmask & (1u << ch)) || um.muted;
-
-          mixInChannel(s, ch, muteflag,
-            um.volume * um.chans[ch].volume, lpan,
-            outbuf, um.chans[ch].out_chan_index + m_remote_chanoffs,
-            len, srate, outnch, offset, decay, isPlaying, isSeek, cursessionpos);
-        }
-        a >>= 1;
-      }
+      const bool muteflag = m_issoloactive ? !rm.solo[i] : rm.muted[i] != 0;
+      mixInChannel(rm.slot[i], rm.chan[i], *rm.mirror[i], muteflag,
+        rm.gain[i], rm.pan[i],
+        outbuf, rm.out_chan[i] + m_remote_chanoffs,
+        len, srate, outnch, offset, decay, isPlaying, isSeek, cursessionpos);
     }
+    if (m_stem_gen) m_stem_rec.endBlock(m_stem_gen, len);
 
 
-    // write out wave if necessary
-
-    if (waveWrite
-#ifndef NJCLIENT_NO_XMIT_SUPPORT
-      ||(m_oggWrite&&m_oggComp)
-#endif
-      )
-    {
-      // 15.1-07b CR-10: replaces audio-thread m_wavebq->AddBlock site.
-      // Audio thread try_pushes onto m_wave_block_q (SPSC); run thread
-      // (drainWaveBlocks at top of NJClient::Run) forwards into legacy
-      // m_wavebq->AddBlock so the existing wave drain loop is untouched.
-      // Bounds-check (Codex M-7) + drop counter (Codex M-8) inside
-      // pushWaveBlockRecord. nch=2 always for the wave mix.
-      pushWaveBlockRecord(m_wave_block_q, m_block_queue_drops,
-                          2, 0.0,
-                          outbuf[0]+offset, len, 2,
-                          outbuf[outnch>1]+offset);
-    }
+    // master recording: a copy into the recorder's ring when one is
+    // running (one relaxed load otherwise). Stereo always; a mono output
+    // records the same channel twice. Drops are counted and gap-filled by
+    // the recorder (GetMasterRecorderStats).
+    if (m_master_rec.recording())
+      m_master_rec.push(outbuf[0]+offset, outbuf[outnch>1]+offset, len);
+  }
+  else if (const int gen = m_stem_rec.beginBlock())
+  {
+    // Monitoring only (audio disabled, or alone in a lobby): no remote
+    // channels are mixed, but the stem timeline still advances, so every
+    // stem is silent here instead of the recording losing this time.
+    m_stem_rec.endBlock(gen, len);
   }
 
-  // apply master volume, then
+  // apply master volume, then meter (scalePeak: in-place gain + abs-max)
   {
-    int x=len;
     float *ptr1=outbuf[0]+offset;
-    float maxf1=(float)(output_peaklevel[0]*decay);
-    float maxf2=(float)(output_peaklevel[1]*decay);
+    float maxf1=jamwide::flushDenormal((float)(output_peaklevel[0]*decay));
+    float maxf2=jamwide::flushDenormal((float)(output_peaklevel[1]*decay));
 
     if (outnch >= 2)
     {
@@ -2929,26 +3272,13 @@ void NJClient::process_samples(float **inbuf, int innch, float **outbuf, int out
       if (masterpan > 0.0f) vol1 *= 1.0f-masterpan;
       else if (masterpan< 0.0f) vol2 *= 1.0f+masterpan;
 
-      while (x--)
-      {
-        float f = *ptr1++ *= vol1;
-        if (f > maxf1) maxf1=f;
-        else if (f < -maxf1) maxf1=-f;
-
-        f = *ptr2++ *= vol2;
-        if (f > maxf2) maxf2=f;
-        else if (f < -maxf2) maxf2=-f;
-      }
+      maxf1 = jamwide::scalePeak(ptr1, len, vol1, maxf1);
+      maxf2 = jamwide::scalePeak(ptr2, len, vol2, maxf2);
     }
     else
     {
       float vol1=config_mastermute.load(std::memory_order_relaxed)?0.0f:config_mastervolume.load(std::memory_order_relaxed);
-      while (x--)
-      {
-        float f = *ptr1++ *= vol1;
-        if (f > maxf1) maxf1=f;
-        else if (f < -maxf1) maxf1=-f;
-      }
+      maxf1 = jamwide::scalePeak(ptr1, len, vol1, maxf1);
       maxf2=maxf1;
     }
     output_peaklevel[0]=maxf1;
@@ -2983,6 +3313,7 @@ void NJClient::process_samples(float **inbuf, int innch, float **outbuf, int out
     }
     if (ptr1) ptr1+=offset;
     if (ptr2) ptr2+=offset;
+    bool clicked=false;
     for (x = 0; x < len; x ++)
     {
       if (m_metronome_pos <= 0.0)
@@ -3004,11 +3335,13 @@ void NJClient::process_samples(float **inbuf, int innch, float **outbuf, int out
 
           if (ptr1) ptr1[x]+=(float)(val*vol1);
           if (ptr2) ptr2[x]+=(float)(val*vol2);
+          clicked=true;
         }
         if (++m_metronome_state >= metrolen) m_metronome_state=0;
 
       }
     }
+    if (clicked && ptr1) markOutputWritten(chidx, ptr2 ? 2 : 1);
   }
 
 }
@@ -3109,6 +3442,24 @@ static void mixFloatsNIOutput(float *src, int src_srate, int src_nch,  // length
 }
 
 
+// Leave *state where mixFloatsNIOutput would after dest_len output frames,
+// without reading or writing samples: a skipped silent block must keep the
+// resampler phase of the blocks around it. Same arithmetic as the mix loop.
+static void advanceResampleState(int src_srate, int dest_srate, int dest_len, double *state)
+{
+  if (!src_srate) src_srate=48000;
+  if (!dest_srate) dest_srate=48000;
+
+  double rspos=*state;
+  if (src_srate != dest_srate)
+  {
+    const double drspos=(double)src_srate/(double)dest_srate;
+    for (int x = 0; x < dest_len; x ++) rspos+=drspos;
+  }
+  *state = rspos - (int)rspos;
+}
+
+
 // 15.1-05 CR-05/06/07: defer DecodeState delete to the run thread (RT-safety).
 // On overflow we leak the pointer for one tick AND bump the overflow counter
 // (Codex M-8: 15.1-10 phase verification fails the phase if non-zero post-UAT).
@@ -3132,6 +3483,20 @@ static inline void deferDecodeStateDelete(
   }
 }
 
+// Defer-delete every prepared interval queued on a channel and leave the
+// queue empty (peer removed / channel gone).
+static inline void deferQueuedDecodeStates(
+    jamwide::SpscRing<DecodeState*, jamwide::DEFERRED_DELETE_CAPACITY>& q,
+    std::atomic<uint64_t>& overflow_counter,
+    jamwide::PrefetchQueue<DecodeState, MAX_PREFETCH_INTERVALS>& queue)
+{
+  while (!queue.empty())
+  {
+    DecodeState* p = queue.pop();
+    deferDecodeStateDelete(q, overflow_counter, p);
+  }
+}
+
 // 15.1-07b CR-09/CR-10 + Codex M-7/M-8: helpers MOVED UP to file-top in the
 // next edit. (The original location here was after process_samples, which
 // failed to compile because the producer call sites need the helpers in
@@ -3260,9 +3625,16 @@ void NJClient::drainLocalChannelDeferredDelete()
 // RemoteUser-free with the audio-thread observation point.
 void NJClient::drainRemoteUserUpdates()
 {
-  m_remoteuser_update_q.drain([this](jamwide::RemoteUserUpdate&& upd) {
-    std::visit([this](auto&& u) {
+  // Set by every update that changes presence or mix parameters; the
+  // RemoteMixList is rebuilt once after the drain.
+  bool mix_dirty = false;
+  m_remoteuser_update_q.drain([this, &mix_dirty](jamwide::RemoteUserUpdate&& upd) {
+    std::visit([this, &mix_dirty](auto&& u) {
       using T = std::decay_t<decltype(u)>;
+      if constexpr (!std::is_same_v<T, jamwide::PeerNextDsUpdate> &&
+                    !std::is_same_v<T, jamwide::PeerCodecSwapUpdate>) {
+        mix_dirty = true;
+      }
       if constexpr (std::is_same_v<T, jamwide::PeerAddedUpdate>) {
         if (u.slot < 0 || u.slot >= MAX_PEERS) return;
         auto& m = m_remoteuser_mirror[u.slot];
@@ -3281,8 +3653,7 @@ void NJClient::drainRemoteUserUpdates()
         // cleanup is the audio thread's responsibility.
         for (int ch = 0; ch < MAX_USER_CHANNELS; ++ch) {
           deferDecodeStateDelete(m_deferred_delete_q, m_deferred_delete_overflows, m.chans[ch].ds);
-          deferDecodeStateDelete(m_deferred_delete_q, m_deferred_delete_overflows, m.chans[ch].next_ds[0]);
-          deferDecodeStateDelete(m_deferred_delete_q, m_deferred_delete_overflows, m.chans[ch].next_ds[1]);
+          deferQueuedDecodeStates(m_deferred_delete_q, m_deferred_delete_overflows, m.chans[ch].next_ds);
           // Reset the per-channel mirror to defaults. Cannot use {} because
           // RemoteUserChannelMirror has std::atomic<float> peak fields that
           // are non-copyable; assign each field explicitly.
@@ -3295,8 +3666,6 @@ void NJClient::drainRemoteUserUpdates()
           m.chans[ch].flags = 0;
           m.chans[ch].codec_fourcc = 0;
           m.chans[ch].ds = nullptr;
-          m.chans[ch].next_ds[0] = nullptr;
-          m.chans[ch].next_ds[1] = nullptr;
           m.chans[ch].dump_samples = 0;
           m.chans[ch].curds_lenleft = 0.0;
           m.chans[ch].peak_vol_l.store(0.0f, std::memory_order_relaxed);
@@ -3328,8 +3697,7 @@ void NJClient::drainRemoteUserUpdates()
           const bool now_present = (m.chanpresentmask  & (1u << ch)) != 0;
           if (was_present && !now_present) {
             deferDecodeStateDelete(m_deferred_delete_q, m_deferred_delete_overflows, m.chans[ch].ds);
-            deferDecodeStateDelete(m_deferred_delete_q, m_deferred_delete_overflows, m.chans[ch].next_ds[0]);
-            deferDecodeStateDelete(m_deferred_delete_q, m_deferred_delete_overflows, m.chans[ch].next_ds[1]);
+            deferQueuedDecodeStates(m_deferred_delete_q, m_deferred_delete_overflows, m.chans[ch].next_ds);
           }
         }
       }
@@ -3390,19 +3758,18 @@ void NJClient::drainRemoteUserUpdates()
         // better. Snapshot evidence in .planning/debug/
         // tx-silent-and-orphan-cutoff.md Evidence "01:31 / 01:32 — fix
         // worsened consistent-late-publish case".
-        if (chan.next_ds[0] == nullptr) {
-          chan.next_ds[0] = incoming_ds;
-        } else if (chan.next_ds[1] == nullptr) {
-          chan.next_ds[1] = incoming_ds;
-        } else {
-          // Both slots full — defer-delete oldest (next_ds[0]), shift, queue
-          // new ds at next_ds[1]. Bumps the deferred-delete overflow path
-          // implicitly (the captured pointer goes to defer-delete; no audio
-          // gap, just a backlog skip).
-          deferDecodeStateDelete(m_deferred_delete_q, m_deferred_delete_overflows, chan.next_ds[0]);
-          chan.next_ds[0] = chan.next_ds[1];
-          chan.next_ds[1] = incoming_ds;
-        }
+        //
+        // Queue behind whatever is already prepared, up to the configured
+        // lookahead depth; past it the oldest queued interval is defer-
+        // deleted (a backlog skip, no audio gap). A silence marker
+        // (incoming_ds == nullptr) queues nothing, as with the old two
+        // slots: an empty queue already plays silence at the boundary.
+        const int depth = config_prefetch_intervals.load(std::memory_order_relaxed);
+        const int evicted = chan.next_ds.push(incoming_ds, depth, [this](::DecodeState* old) {
+          deferDecodeStateDelete(m_deferred_delete_q, m_deferred_delete_overflows, old);
+        });
+        if (evicted)
+          m_prefetch_evictions.fetch_add((uint64_t)evicted, std::memory_order_relaxed);
       }
       else if constexpr (std::is_same_v<T, jamwide::PeerChannelInfoUpdate>) {
         // 2026-05-02 RemoteUserMirror orphan-fields fix. Apply per-channel
@@ -3430,6 +3797,45 @@ void NJClient::drainRemoteUserUpdates()
       }
     }, upd);
   });
+  if (mix_dirty) rebuildRemoteMixList();
+}
+
+// Gather the present channels of active peers into m_remote_mix, in the
+// same slot/channel order the mirror walk used (so the mix sums in the same
+// order), combining peer and channel volume/pan and mute/solo once here
+// instead of per block.
+void NJClient::rebuildRemoteMixList()
+{
+  RemoteMixList& rm = m_remote_mix;
+  int n = 0, peers = 0;
+  for (int s = 0; s < MAX_PEERS; ++s)
+  {
+    auto& um = m_remoteuser_mirror[s];
+    if (!um.active) continue;
+    ++peers;
+
+    int a = um.chanpresentmask;
+    for (int ch = 0; ch < MAX_USER_CHANNELS && a; ++ch, a >>= 1)
+    {
+      if (!(a & 1)) continue;
+      const unsigned int bit = 1u << ch;
+      float lpan = um.pan + um.chans[ch].pan;
+      if (lpan < -1.0f) lpan = -1.0f;
+      else if (lpan > 1.0f) lpan = 1.0f;
+
+      rm.gain[n] = um.volume * um.chans[ch].volume;
+      rm.pan[n] = lpan;
+      rm.out_chan[n] = um.chans[ch].out_chan_index;
+      rm.muted[n] = ((um.mutedmask & bit) || um.muted) ? 1 : 0;
+      rm.solo[n] = (um.solomask & bit) ? 1 : 0;
+      rm.slot[n] = (unsigned char)s;
+      rm.chan[n] = (unsigned char)ch;
+      rm.mirror[n] = &um.chans[ch];
+      ++n;
+    }
+  }
+  rm.count = n;
+  rm.active_peers = peers;
 }
 
 // 15.1-07a + Codex HIGH-3: drain canonical RemoteUser* pointers whose audio-
@@ -3467,12 +3873,13 @@ void NJClient::drainRemoteUserDeferredDelete()
 //   - The run-thread call sites that produce audio-thread-visible
 //     DecodeStates with non-null decode_fp invoke
 //     `inversionAttachSessionmodeReader(ds)` immediately after start_decode
-//     returns. That helper takes the FILE* off the DS, allocates a fresh
+//     returns. That helper takes the FILE* off the DS, maps the file
+//     read-only and closes the FILE*, allocates a fresh
 //     DecodeMediaBuffer, primes it with one chunk, registers a
 //     SessionmodeFileReader entry on m_sessionmode_file_readers, and sets
 //     ds->decode_buf to the buffer + ds->decode_fp = nullptr.
-//   - On every run-thread tick, refillSessionmodeBuffers reads more bytes
-//     from each active FILE* and pushes into the corresponding
+//   - On every run-thread tick, refillSessionmodeBuffers copies more bytes
+//     from each active mapping and pushes into the corresponding
 //     DecodeMediaBuffer (lock-free SPSC push from 15.1-07c).
 //   - The audio thread's runDecode reaches `decode_buf->Read` for these
 //     states, NEVER `fread(decode_fp)` — H-04 structurally unreachable IN
@@ -3501,23 +3908,29 @@ bool NJClient::inversionAttachSessionmodeReader(DecodeState* ds)
   ds->decode_buf = buf;
   buf->AddRef();  // SessionmodeFileReader owns the second ref; ds destructor will Release the first
 
-  // Prime the buffer with one initial chunk so the audio thread has bytes
-  // to drain on its first runDecode call. The legacy start_decode body
-  // already runs `while (Available() <= 0) runDecode()` BEFORE we reach
-  // here — but that loop ran fread on the same FILE* we just took. The
-  // codec internal queue holds whatever was decoded; new bytes from this
-  // point on come through decode_buf.
-  uint8_t prime_buf[jamwide::CHUNK_BYTES];
-  size_t primed = std::fread(prime_buf, 1, sizeof(prime_buf), fp_for_runthread);
-  if (primed > 0)
-  {
-    buf->Write(prime_buf, static_cast<int>(primed));
-  }
+  // start_decode already ran DecodeState::primeHead BEFORE we reach
+  // here — its runDecode loop freads the same FILE*
+  // we just took, so the codec holds everything up to ftell(). Map the
+  // file, continue from there, and drop the FILE*: the mapping outlives it.
+  const long consumed = std::ftell(fp_for_runthread);
+  jamwide::MappedIntervalFile* map = new jamwide::MappedIntervalFile();
+  const bool mapped = map->mapReadOnly(fp_for_runthread);
+  std::fclose(fp_for_runthread);
 
   SessionmodeFileReader rdr;
-  rdr.file = fp_for_runthread;
+  rdr.map = map;
+  rdr.pos = (mapped && consumed > 0) ? std::min(static_cast<size_t>(consumed), map->size()) : 0;
   rdr.buffer = buf;
-  rdr.eof = (primed == 0);
+  rdr.eof = !mapped || rdr.pos >= map->size();
+
+  // Prime the buffer with one initial chunk so the audio thread has bytes
+  // to drain on its first runDecode call.
+  if (!rdr.eof)
+  {
+    const size_t n = std::min(map->size() - rdr.pos, static_cast<size_t>(jamwide::CHUNK_BYTES));
+    rdr.pos += static_cast<size_t>(buf->Write(map->data() + rdr.pos, static_cast<int>(n)));
+    rdr.eof = rdr.pos >= map->size();
+  }
   m_sessionmode_file_readers.push_back(rdr);
 
   return true;
@@ -3557,28 +3970,86 @@ void NJClient::drainArmRequests()
     upd.slot_idx = req.slot_idx;
     upd.ds       = reinterpret_cast<jamwide::DecodeState*>(ds);
 
-    if (!m_remoteuser_update_q.try_push(jamwide::RemoteUserUpdate{upd}))
+    // In order behind any intervals still waiting for this channel. If the
+    // backlog has to drop it, deleting the ds leaves the reader as the
+    // buffer's only owner and refillSessionmodeBuffers reaps it.
+    publishOrdered(jamwide::RemoteUserUpdate{upd});
+  });
+}
+
+// A waiting update's prepared interval, if it carries one.
+static ::DecodeState *pendingDecodeState(const jamwide::RemoteUserUpdate& u)
+{
+  const jamwide::PeerNextDsUpdate *n = std::get_if<jamwide::PeerNextDsUpdate>(&u);
+  return n ? reinterpret_cast<::DecodeState*>(n->ds) : nullptr;
+}
+
+// Run thread. A PeerChannelInfoUpdate counts as published only once it is
+// actually in the queue: one the backlog drops never reaches the audio
+// thread, and counting it would make publishes exceed applies.
+bool NJClient::pushRemoteUpdate(const jamwide::RemoteUserUpdate& upd)
+{
+  if (!m_remoteuser_update_q.try_push(upd)) return false;
+  if (const jamwide::PeerChannelInfoUpdate *ci = std::get_if<jamwide::PeerChannelInfoUpdate>(&upd))
+    m_chinfo_publishes_observed[ci->slot][ci->channel].fetch_add(1, std::memory_order_relaxed);
+  return true;
+}
+
+void NJClient::publishOrdered(const jamwide::RemoteUserUpdate& upd)
+{
+  // Run thread. While anything is pending, later publishes queue behind it
+  // so each channel's intervals and the codec/info changes around them
+  // reach the audio thread in order.
+  if (m_pending_updates.empty() && pushRemoteUpdate(upd))
+    return;
+
+  if (std::holds_alternative<jamwide::PeerNextDsUpdate>(upd))
+    m_next_ds_deferred.fetch_add(1, std::memory_order_relaxed);
+  if (m_pending_updates.size() >= kMaxPendingUpdates)
+  {
+    // The audio thread isn't draining (host stopped processing). Drop the
+    // oldest entry rather than grow without bound.
+    const jamwide::RemoteUserUpdate &old = m_pending_updates.front();
+    const int old_slot = std::visit([](const auto& u) { return u.slot; }, old);
+    if (::DecodeState *ds = pendingDecodeState(old))
     {
-      // Update queue full — extraordinarily unlikely with N=64 capacity.
-      // Tear down what we built. Find the SessionmodeFileReader entry we
-      // just pushed (it's the last one) and reverse it.
-      m_remoteuser_update_overflows.fetch_add(1, std::memory_order_relaxed);
-      if (!m_sessionmode_file_readers.empty())
-      {
-        auto& rdr = m_sessionmode_file_readers.back();
-        if (rdr.file) std::fclose(rdr.file);
-        if (rdr.buffer)
-        {
-          // Two refs to release: the SessionmodeFileReader's AddRef + the ds
-          // destructor's implicit Release on ds->decode_buf. We let ~DecodeState
-          // handle the second one via `delete ds` below; release ours first.
-          rdr.buffer->Release();
-        }
-        m_sessionmode_file_readers.pop_back();
-      }
       delete ds;
+      m_next_ds_dropped.fetch_add(1, std::memory_order_relaxed);
     }
-  });
+    else
+    {
+      m_remoteuser_update_overflows.fetch_add(1, std::memory_order_relaxed);
+    }
+    writeLog("WARNING: remote update backlog full (slot=%d) — dropped oldest update\n", old_slot);
+    m_pending_updates.erase(m_pending_updates.begin());
+  }
+  m_pending_updates.push_back(upd);
+}
+
+void NJClient::flushPendingUpdates()
+{
+  size_t sent = 0;
+  while (sent < m_pending_updates.size() &&
+         pushRemoteUpdate(m_pending_updates[sent]))
+    ++sent;
+  if (sent) m_pending_updates.erase(m_pending_updates.begin(), m_pending_updates.begin() + sent);
+}
+
+void NJClient::discardPendingUpdates(int slot)
+{
+  // Run thread, before the peer's PeerRemovedUpdate (slot < 0: everyone).
+  // These DecodeStates never reached the audio thread, so they are ours to
+  // delete here.
+  size_t keep = 0;
+  for (size_t i = 0; i < m_pending_updates.size(); ++i)
+  {
+    const jamwide::RemoteUserUpdate& u = m_pending_updates[i];
+    if (slot < 0 || std::visit([](const auto& v) { return v.slot; }, u) == slot)
+      delete pendingDecodeState(u);
+    else
+      m_pending_updates[keep++] = u;
+  }
+  m_pending_updates.resize(keep);
 }
 
 void NJClient::refillSessionmodeBuffers()
@@ -3588,11 +4059,11 @@ void NJClient::refillSessionmodeBuffers()
   // DecodeMediaBuffer (lock-free SPSC push). The audio thread's
   // runDecode → decode_buf->Read drains the same SPSC.
   //
-  // Cap each file at kMaxChunksPerTickPerFile chunks per tick so a single
-  // active sessionmode file with a fast-drained buffer doesn't starve the
-  // others. With CHUNK_BYTES=4096 and a 20ms tick, 4 chunks = 16 KB/tick =
-  // 800 KB/s — comfortably above any audio-rate consumption.
-  constexpr int kMaxChunksPerTickPerFile = 4;
+  // Each file is read through a read-only mapping, so topping up is a
+  // memcpy from map->data() + pos bounded by the buffer's free space
+  // (WriteSpace) — no fread, no per-tick chunk cap, and bytes that don't
+  // fit simply stay in the mapping for the next tick instead of being
+  // dropped.
 
   for (size_t i = 0; i < m_sessionmode_file_readers.size(); /* manual advance */)
   {
@@ -3600,40 +4071,32 @@ void NJClient::refillSessionmodeBuffers()
 
     // Dead-entry detection: if the buffer's refcnt is 1, only THIS reader
     // holds a ref — the audio side has Released its share (ds destructor
-    // ran via deferDecodeStateDelete → drainDeferredDelete). We can fclose
+    // ran via deferDecodeStateDelete → drainDeferredDelete). We can unmap
     // the file and let the buffer go.
     if (rdr.buffer && rdr.buffer->GetRefCount() <= 1)
     {
-      if (rdr.file) std::fclose(rdr.file);
+      delete rdr.map;
       if (rdr.buffer) rdr.buffer->Release();  // refcnt → 0 → delete
       m_sessionmode_file_readers.erase(m_sessionmode_file_readers.begin() + i);
       continue;
     }
 
     // Active entry — top up the buffer.
-    if (!rdr.eof && rdr.file)
+    if (!rdr.eof && rdr.map && rdr.buffer)
     {
-      for (int chunk = 0; chunk < kMaxChunksPerTickPerFile; ++chunk)
+      const size_t left = rdr.map->size() - rdr.pos;
+      const size_t n = std::min(left, static_cast<size_t>(rdr.buffer->WriteSpace()));
+      if (n > 0)
       {
-        uint8_t tmp[jamwide::CHUNK_BYTES];
-        size_t got = std::fread(tmp, 1, sizeof(tmp), rdr.file);
-        if (got == 0)
-        {
-          rdr.eof = true;
-          break;
-        }
-        int written = rdr.buffer->Write(tmp, static_cast<int>(got));
-        if (written < static_cast<int>(got))
-        {
-          // Buffer SPSC full — the (got - written) bytes we already read
-          // from the file are lost (we cannot fseek back safely on all
-          // streams; sessionmode files are local + seekable but for
-          // simplicity we drop and document). Bump the drop counter so
-          // 15.1-10 surfaces this if it ever fires under realistic load.
+        const int written = rdr.buffer->Write(rdr.map->data() + rdr.pos, static_cast<int>(n));
+        // WriteSpace is conservative, so a short write means something
+        // else is producing into this buffer. Nothing is lost (pos only
+        // advances by what was taken), but keep it visible to 15.1-10.
+        if (written < static_cast<int>(n))
           m_sessionmode_refill_drops.fetch_add(1, std::memory_order_relaxed);
-          break;
-        }
+        rdr.pos += static_cast<size_t>(written);
       }
+      rdr.eof = rdr.pos >= rdr.map->size();
     }
     ++i;
   }
@@ -3652,6 +4115,8 @@ int NJClient::allocRemoteUserSlot(RemoteUser* user)
   for (int s = 0; s < MAX_PEERS; ++s) {
     if (!m_remoteuser_slot_table[s].user) {
       m_remoteuser_slot_table[s].user = user;
+      WDL_MutexLock alock(&m_arrival_cs);
+      for (int ch = 0; ch < MAX_USER_CHANNELS; ++ch) m_arrival[s][ch].reset();
       return s;
     }
   }
@@ -3673,8 +4138,8 @@ void NJClient::releaseRemoteUserSlot(int slot)
   m_remoteuser_slot_table[slot].user = nullptr;
 }
 
-// 15.1-07b CR-09: drain per-channel mirror BlockRecord rings on the run
-// thread, forwarding each BlockRecord into the legacy BufferQueue-backed
+// 15.1-07b CR-09: drain per-channel mirror sample FIFOs on the run
+// thread, forwarding each block into the legacy BufferQueue-backed
 // encoder feed. The audio thread is the producer (process_samples /
 // on_new_interval push to m_locchan_mirror[ch].block_q); this method runs
 // on the run thread, downstream of the audio callback, and bridges to the
@@ -3694,8 +4159,12 @@ void NJClient::releaseRemoteUserSlot(int slot)
 // thread as consumer — never two writers, never two readers.
 void NJClient::drainBroadcastBlocks()
 {
+  // Re-arm the audio thread's wake before draining: a block pushed after
+  // this point is either drained below or signals again.
+  m_bcast_wake_sent.store(false, std::memory_order_release);
+
   // 15.1-07b post-UAT crash fix (build 254): if Disconnect() has torn down
-  // m_netcon (line 1016), forwarding pre-Disconnect audio-thread BlockRecords
+  // m_netcon (line 1016), forwarding pre-Disconnect audio-thread blocks
   // into lc->m_bq.AddBlock would refill the just-cleared queue with stale
   // blocks. The encoder loop in NJClient::Run (line 1738+) then pops those
   // blocks and calls m_netcon->Send(...) at line 1788/1895/1901/1943/1948
@@ -3712,9 +4181,9 @@ void NJClient::drainBroadcastBlocks()
     for (int ch = 0; ch < MAX_LOCAL_CHANNELS; ++ch)
     {
       auto& m = m_locchan_mirror[ch];
-      m.block_q.drain([this](jamwide::BlockRecord&&) {
-        m_block_queue_drops.fetch_add(1, std::memory_order_relaxed);
-      });
+      const size_t dropped = m.block_q.discard();
+      if (dropped)
+        m_block_queue_drops.fetch_add(dropped, std::memory_order_relaxed);
     }
     return;
   }
@@ -3726,7 +4195,8 @@ void NJClient::drainBroadcastBlocks()
     // the apply visitor in drainLocalChannelUpdates ALSO drains the ring
     // empty at that point, so any remaining records here are for a still-
     // active channel.
-    m.block_q.drain([this, ch](jamwide::BlockRecord&& br) {
+    m.block_q.drain([this, ch](const jamwide::SampleBlockHeader& br,
+                               const float* s1, const float* s2) {
       // Find the canonical Local_Channel for this index. The encoder owns
       // it (m_enc, m_curwritefile, m_bq). We hold m_locchan_cs because the
       // canonical list can be mutated by other run-thread paths (Add/Delete);
@@ -3771,34 +4241,48 @@ void NJClient::drainBroadcastBlocks()
       }
       else
       {
-        float* s1 = br.samples;
-        float* s2 = (br.nch > 1) ? (br.samples + br.sample_count) : nullptr;
         lc->m_bq.AddBlock(br.attr, br.startpos, s1, br.sample_count, s2);
       }
     });
   }
 }
 
-// 15.1-07b CR-10: drain m_wave_block_q on the run thread, forwarding into
-// the legacy m_wavebq->AddBlock path. The existing wave consumer at
-// NJClient::Run() line 1073 reads from m_wavebq and feeds waveWrite +
-// m_oggComp; that code is untouched.
-void NJClient::drainWaveBlocks()
+
+
+// Stem recording tap (audio thread, from mixInChannel): the channel's
+// decoded block resampled to the session rate at unity gain and centre pan
+// into the recorder's scratch. It resamples from a copy of the phase, so the
+// mix itself is untouched. Digitally silent blocks are not queued; the
+// recorder writes silence wherever a stem has no audio.
+void NJClient::tapStem(int slot, int chanidx, DecodeState *chan, float *sptr, int srcnch,
+                       int needed, int srate, int len, int offs)
 {
-  m_wave_block_q.drain([this](jamwide::BlockRecord&& br) {
-    if (br.sample_count <= 0 || !m_wavebq) return;
-    float* s1 = br.samples;
-    float* s2 = (br.nch > 1) ? (br.samples + br.sample_count) : nullptr;
-    m_wavebq->AddBlock(br.attr, br.startpos, s1, br.sample_count, s2);
-  });
-}
+  if (len <= 0) return;
+  const int stem = slot * MAX_USER_CHANNELS + chanidx;
+  const int at = offs - m_stem_block_offs;
+  if (jamwide::peakAbs(sptr, needed * srcnch, 0.0f) < jamwide::kSilenceFloor) return;
 
+  float *l = m_stem_rec.scratch(0), *r = m_stem_rec.scratch(1);
+  if (!l || len > jamwide::StemRecorder::kScratchFrames)
+  {
+    m_stem_rec.push(m_stem_gen, stem, at, nullptr, nullptr, len);   // counted as dropped
+    return;
+  }
+  memset(l, 0, len * sizeof(float));
+  memset(r, 0, len * sizeof(float));
+  float *dest[2] = { l, r };
+  double rs = chan->resample_state;
+  mixFloatsNIOutput(sptr, chan->decode_codec->GetSampleRate(), srcnch, dest,
+                    srate, 2, len, 1.0f, 0.0f, &rs,
+                    chan->decode_codec->Available() / srcnch);
+  m_stem_rec.push(m_stem_gen, stem, at, l, r, len);
+}
 
 // 15.1-07a CR-01 + Codex HIGH-2: mixInChannel reads ONLY from the audio-thread
 // mirror (m_remoteuser_mirror[slot].chans[chanidx]). No dereference of run-
 // thread-owned RemoteUser / RemoteUser_Channel objects on the audio path.
 //
-// DecodeState ownership: chan_mirror.ds and chan_mirror.next_ds[0/1] are
+// DecodeState ownership: chan_mirror.ds and the chan_mirror.next_ds queue are
 // audio-thread-owned once published via PeerNextDsUpdate (15.1-04 contract).
 // Pointer-shuffle in this function operates ENTIRELY on the mirror; old
 // pointers cross to the run thread via deferDecodeStateDelete (15.1-05).
@@ -3814,19 +4298,19 @@ void NJClient::drainWaveBlocks()
 // (uintptr_t-cast) rather than the canonical RemoteUser* — the old pointer
 // would have been a cross-thread back-reference (HIGH-2 violation). Slot is
 // stable per-session, so identity comparison in on_new_interval still works.
-void NJClient::mixInChannel(int slot, int chanidx,
+void NJClient::mixInChannel(int slot, int chanidx, RemoteUserChannelMirror& chan_mirror,
                             bool muted, float vol, float pan, float **outbuf, int out_channel,
                             int len, int srate, int outnch, int offs, double vudecay,
                             bool isPlaying, bool isSeek, double playPos)
 {
   if (slot < 0 || slot >= MAX_PEERS) return;
   if (chanidx < 0 || chanidx >= MAX_USER_CHANNELS) return;
-  auto& chan_mirror = m_remoteuser_mirror[slot].chans[chanidx];
 
   // VU decay — read existing peak, decay, store back. Atomic relaxed because
   // UI side reads relaxed too (display-only convergent value).
-  float peak_l_decayed = chan_mirror.peak_vol_l.load(std::memory_order_relaxed) * (float)vudecay;
-  float peak_r_decayed = chan_mirror.peak_vol_r.load(std::memory_order_relaxed) * (float)vudecay;
+  // flushDenormal: in a silent room these only ever decay (denormal_guard.h).
+  float peak_l_decayed = jamwide::flushDenormal(chan_mirror.peak_vol_l.load(std::memory_order_relaxed) * (float)vudecay);
+  float peak_r_decayed = jamwide::flushDenormal(chan_mirror.peak_vol_r.load(std::memory_order_relaxed) * (float)vudecay);
 
   const int llmode     = (chan_mirror.flags & 2);
   const int sessionmode = !llmode && (chan_mirror.flags & 4);
@@ -3854,23 +4338,22 @@ void NJClient::mixInChannel(int slot, int chanidx,
   ::DecodeState* chan = chan_mirror.ds;
   if (!chan || !chan->decode_codec || (!chan->decode_fp && !chan->decode_buf))
   {
-    if (llmode && chan_mirror.next_ds[0])
+    if (llmode && chan_mirror.next_ds.front())
     {
       if (chan_mirror.ds) chan_mirror.ds->calcOverlap(&fade_state);
-      // 15.1-05 CR-05 (site 4/7): llmode advance to next_ds[0]. Per RESEARCH
+      // 15.1-05 CR-05 (site 4/7): llmode advance to the queue front. Per RESEARCH
       // § "Subtle note for the planner": capture old pointer FIRST, advance
       // the slot, THEN defer-delete the captured old pointer. Audio thread
       // retains exclusive ownership during the shuffle; only the now-orphaned
       // old pointer crosses to the run thread.
       ::DecodeState* old_ds = chan_mirror.ds;
-      chan = chan_mirror.ds = chan_mirror.next_ds[0];
-      chan_mirror.next_ds[0] = chan_mirror.next_ds[1]; // advance queue
-      chan_mirror.next_ds[1] = nullptr;
+      chan = chan_mirror.ds = chan_mirror.next_ds.pop(); // advance queue
       deferDecodeStateDelete(m_deferred_delete_q, m_deferred_delete_overflows, old_ds);
 
       if (chan_mirror.ds)
       {
-        chan_mirror.ds->applyOverlap(&fade_state);
+        if (chan_mirror.ds->applyOverlap(&fade_state))
+          m_overlap_cold_decodes.fetch_add(1, std::memory_order_relaxed);
         // 15.1-03 H-02: writeUserChanLog removed from audio path.
       }
 
@@ -3978,77 +4461,87 @@ void NJClient::mixInChannel(int slot, int chanidx,
   {
     float *sptr = chan->decode_codec->Get();
 
+    // Stems are recorded before mute and fader.
+    if (m_stem_gen) tapStem(slot, chanidx, chan, sptr, srcnch, needed, srate, len_out, offs);
+
     // process VU meter, yay for powerful CPUs
     if (!muted && vol > 0.0000001)
     {
-      float *p = sptr;
-      int l = needed * srcnch;
-      // Use the decayed-peak value computed above (was based on the relaxed-
-      // load before this block; equivalent to the legacy decode_peak_vol[0]/vol
-      // baseline because we re-multiply by vol when storing back).
-      float maxf  = peak_l_decayed / (vol > 0.0f ? vol : 1.0f);
-      float maxf2 = peak_r_decayed / (vol > 0.0f ? vol : 1.0f);
-      if (srcnch >= 2) // vu meter + clipping
+      const int l = needed * srcnch;
+      // Clip in place and measure this block's own peak first, so a silent
+      // block can be recognised before any mixing.
+      float blk_l = 0.0f, blk_r = 0.0f;
+      if (srcnch >= 2) // vu meter + clipping, interleaved L/R pairs
       {
-        l /= 2;
-        while (l--)
-        {
-          float f = *p;
-          if (f < -1.0f) f = *p = -1.0f;
-          else if (f > 1.0f) f = *p = 1.0f;
-          if (f > maxf) maxf = f;
-          else if (f < -maxf) maxf = -f;
-
-          f = *++p;
-          if (f < -1.0f) f = *p = -1.0f;
-          else if (f > 1.0f) f = *p = 1.0f;
-          if (f > maxf2) maxf2 = f;
-          else if (f < -maxf2) maxf2 = -f;
-          p++;
-        }
+        jamwide::clipPeakStereo(sptr, l / 2, &blk_l, &blk_r);
       }
       else
       {
-        while (l--)
-        {
-          float f = *p;
-          if (f < -1.0f) f = *p = -1.0f;
-          else if (f > 1.0f) f = *p = 1.0f;
-          if (f > maxf) maxf = f;
-          else if (f < -maxf) maxf = -f;
-          p++;
-        }
-        maxf2 = maxf;
+        blk_l = blk_r = jamwide::clipPeak(sptr, l, 0.0f);
       }
-      // Store the post-decode peak back into the mirror (relaxed; UI reads
-      // relaxed). Multiply by vol to match legacy decode_peak_vol semantics
-      // (lc->decode_peak_vol stored vol-applied peak; UI side scales by 1/vol
-      // when interpreting the dB display).
-      chan_mirror.peak_vol_l.store(maxf * vol,  std::memory_order_relaxed);
-      chan_mirror.peak_vol_r.store(maxf2 * vol, std::memory_order_relaxed);
-
-      int use_nch = 2;
-      if (outnch < 2 || (out_channel & 1024)) use_nch = 1;
-      int idx = (out_channel & 1023);
-      if (idx + use_nch > outnch) idx = outnch - use_nch;
-      if (idx < 0) idx = 0;
-
-      float lvol = vol;
-      float *tmpbuf[2] = { outbuf[idx] + offs, use_nch > 1 ? (outbuf[idx + 1] + offs) : nullptr };
-      if (use_nch == 1 && srcnch > 1)
+      chan->blocks_scanned++;
+
+      if (blk_l < jamwide::kSilenceFloor && blk_r < jamwide::kSilenceFloor)
       {
-        tmpbuf[1] = tmpbuf[0];
-        lvol *= 0.5f;
-        use_nch = 2;
+        // Digital silence (a subscribed peer that isn't playing): hold the
+        // VU at its decay, skip the multiply-accumulate, and leave the
+        // output channels unmarked so silent buses stay skipped. The
+        // resampler phase still advances as if mixed.
+        chan_mirror.peak_vol_l.store(peak_l_decayed, std::memory_order_relaxed);
+        chan_mirror.peak_vol_r.store(peak_r_decayed, std::memory_order_relaxed);
+        advanceResampleState(chan->decode_codec->GetSampleRate(), srate, len_out, &chan->resample_state);
+        m_silent_blocks_skipped.fetch_add(1, std::memory_order_relaxed);
       }
+      else
+      {
+        chan->heard_audio = true;
+
+        // Use the decayed-peak value computed above (was based on the relaxed-
+        // load before this block; equivalent to the legacy decode_peak_vol[0]/vol
+        // baseline because we re-multiply by vol when storing back).
+        float maxf  = peak_l_decayed / (vol > 0.0f ? vol : 1.0f);
+        float maxf2 = peak_r_decayed / (vol > 0.0f ? vol : 1.0f);
+        if (blk_l > maxf) maxf = blk_l;
+        if (srcnch >= 2)
+        {
+          if (blk_r > maxf2) maxf2 = blk_r;
+        }
+        else
+        {
+          maxf2 = maxf;
+        }
+        // Store the post-decode peak back into the mirror (relaxed; UI reads
+        // relaxed). Multiply by vol to match legacy decode_peak_vol semantics
+        // (lc->decode_peak_vol stored vol-applied peak; UI side scales by 1/vol
+        // when interpreting the dB display).
+        chan_mirror.peak_vol_l.store(maxf * vol,  std::memory_order_relaxed);
+        chan_mirror.peak_vol_r.store(maxf2 * vol, std::memory_order_relaxed);
+
+        int use_nch = 2;
+        if (outnch < 2 || (out_channel & 1024)) use_nch = 1;
+        int idx = (out_channel & 1023);
+        if (idx + use_nch > outnch) idx = outnch - use_nch;
+        if (idx < 0) idx = 0;
+
+        markOutputWritten(idx, use_nch);
+
+        float lvol = vol;
+        float *tmpbuf[2] = { outbuf[idx] + offs, use_nch > 1 ? (outbuf[idx + 1] + offs) : nullptr };
+        if (use_nch == 1 && srcnch > 1)
+        {
+          tmpbuf[1] = tmpbuf[0];
+          lvol *= 0.5f;
+          use_nch = 2;
+        }
 
-      mixFloatsNIOutput(sptr,
-              chan->decode_codec->GetSampleRate(),
-              srcnch,
-              tmpbuf,
-              srate, use_nch, len_out,
-              lvol, pan, &chan->resample_state,
-              chan->decode_codec->Available() / srcnch);
+        mixFloatsNIOutput(sptr,
+                chan->decode_codec->GetSampleRate(),
+                srcnch,
+                tmpbuf,
+                srate, use_nch, len_out,
+                lvol, pan, &chan->resample_state,
+                chan->decode_codec->Available() / srcnch);
+      }
     }
     else
     {
@@ -4094,7 +4587,7 @@ void NJClient::mixInChannel(int slot, int chanidx,
 
   if (llmode &&
       len_out < len &&
-      chan_mirror.next_ds[0])
+      chan_mirror.next_ds.front())
   {
     // call again
     chan_mirror.curds_lenleft = -10000.0;
@@ -4103,17 +4596,16 @@ void NJClient::mixInChannel(int slot, int chanidx,
     // ordering as site 4 — capture old pointer FIRST, advance the slot, THEN
     // defer-delete (RESEARCH § "Subtle note for the planner").
     ::DecodeState* old_ds = chan_mirror.ds;
-    chan = chan_mirror.ds = chan_mirror.next_ds[0];
-    chan_mirror.next_ds[0] = chan_mirror.next_ds[1]; // advance queue
-    chan_mirror.next_ds[1] = nullptr;
+    chan = chan_mirror.ds = chan_mirror.next_ds.pop(); // advance queue
     deferDecodeStateDelete(m_deferred_delete_q, m_deferred_delete_overflows, old_ds);
     if (chan_mirror.ds)
     {
-      chan_mirror.ds->applyOverlap(&fade_state);
+      if (chan_mirror.ds->applyOverlap(&fade_state))
+        m_overlap_cold_decodes.fetch_add(1, std::memory_order_relaxed);
       // 15.1-03 H-02: writeUserChanLog removed from audio path.
     }
     if (chan && chan->decode_codec && (chan->decode_fp || chan->decode_buf))
-      mixInChannel(slot, chanidx, muted, vol, pan, outbuf, out_channel, len - len_out, srate, outnch, offs + len_out, vudecay,
+      mixInChannel(slot, chanidx, chan_mirror, muted, vol, pan, outbuf, out_channel, len - len_out, srate, outnch, offs + len_out, vudecay,
         isPlaying, false, playPos + len_out / (double)srate);
   }
 }
@@ -4128,6 +4620,7 @@ void NJClient::mixInChannel(int slot, int chanidx,
 void NJClient::on_new_interval()
 {
   m_loopcnt++;
+  m_stem_rec.onInterval();   // an armed stem recording starts here
   // 15.1-03 CR-04: writeLog removed from audio path; was diagnostic noise per CONTEXT D-03.
 
   m_metronome_pos=0.0;
@@ -4203,30 +4696,36 @@ void NJClient::on_new_interval()
       // Capture old pointer FIRST, advance the slot, THEN defer-delete the
       // captured value (single-owner-at-a-time invariant).
       ::DecodeState* old_ds = chan_mirror.ds;
+
+      // The retiring interval's silence verdict (mixInChannel measured its
+      // blocks unless the channel was muted throughout).
+      if (old_ds && old_ds->blocks_scanned > 0)
+      {
+        m_scanned_intervals[s][ch].fetch_add(1, std::memory_order_relaxed);
+        if (!old_ds->heard_audio)
+          m_silent_intervals[s][ch].fetch_add(1, std::memory_order_relaxed);
+      }
       if ((um.submask & um.chanpresentmask) & (1u << ch))
       {
-        chan_mirror.ds = chan_mirror.next_ds[0];
-        chan_mirror.next_ds[0] = chan_mirror.next_ds[1]; // advance queue
-        chan_mirror.next_ds[1] = nullptr;
+        chan_mirror.ds = chan_mirror.next_ds.pop(); // advance queue, O(1)
         deferDecodeStateDelete(m_deferred_delete_q, m_deferred_delete_overflows, old_ds);
       }
       else
       {
-        // 15.1-05 CR-07 (site 7/7): on_new_interval — drop unsubscribed
-        // next_ds[0]. Capture pointer FIRST, advance the slot, THEN defer-
+        // 15.1-05 CR-07 (site 7/7): on_new_interval — drop the unsubscribed
+        // queue front. Capture pointer FIRST, advance the queue, THEN defer-
         // delete the captured pointer. Both old_ds and old_next0 are now
         // orphaned; defer-delete both.
-        ::DecodeState* old_next0 = chan_mirror.next_ds[0];
+        ::DecodeState* old_next0 = chan_mirror.next_ds.pop();
         chan_mirror.ds = nullptr;
-        chan_mirror.next_ds[0] = chan_mirror.next_ds[1]; // advance queue
-        chan_mirror.next_ds[1] = nullptr;
         deferDecodeStateDelete(m_deferred_delete_q, m_deferred_delete_overflows, old_ds);
         deferDecodeStateDelete(m_deferred_delete_q, m_deferred_delete_overflows, old_next0);
       }
 
       if (chan_mirror.ds)
       {
-        chan_mirror.ds->applyOverlap(&fade_state);
+        if (chan_mirror.ds->applyOverlap(&fade_state))
+          m_overlap_cold_decodes.fetch_add(1, std::memory_order_relaxed);
         // 15.1-03 H-02: writeUserChanLog removed from audio path.
 
         // Phase 14.2: capture t_interval when the measured peer's regular
@@ -4526,29 +5025,17 @@ void NJClient::SetUserChannelState(int useridx, int channelidx,
   // true given enqueue order.
   if (publish_chinfo && slot >= 0)
   {
-    if (m_remoteuser_update_q.try_push(jamwide::RemoteUserUpdate{
+    publishOrdered(jamwide::RemoteUserUpdate{
           jamwide::PeerChannelInfoUpdate{slot, channelidx, pub_chflags,
-                                         pub_chvol, pub_chpan, pub_choutch}}))
-    {
-      m_chinfo_publishes_observed[slot][channelidx]
-          .fetch_add(1, std::memory_order_relaxed);
-    }
-    else
-    {
-      m_remoteuser_update_overflows.fetch_add(1, std::memory_order_relaxed);
-      writeLog("WARNING: m_remoteuser_update_q full on PeerChannelInfoUpdate (slot=%d ch=%d)\n", slot, channelidx);
-    }
+                                         pub_chvol, pub_chpan, pub_choutch}});
   }
   // 15.1-07a CR-01: publish channel-mask change to mirror so the audio thread
   // sees mute/solo/subscribe toggles immediately on the next AudioProc drain.
   if (publish_mask && slot >= 0)
   {
-    if (!m_remoteuser_update_q.try_push(jamwide::RemoteUserUpdate{
+    publishOrdered(jamwide::RemoteUserUpdate{
           jamwide::PeerChannelMaskUpdate{slot, pub_submask, pub_chanpresentmask,
-                                        pub_mutedmask, pub_solomask}}))
-    {
-      m_remoteuser_update_overflows.fetch_add(1, std::memory_order_relaxed);
-    }
+                                        pub_mutedmask, pub_solomask}});
   }
 }
 
@@ -4635,6 +5122,18 @@ int NJClient::GetDumpSamplesPeak(int slot, int channel) const noexcept
   return m_dump_samples_peak[slot][channel].load(std::memory_order_relaxed);
 }
 
+void NJClient::GetSilentIntervalCount(int slot, int channel, uint32_t* silent, uint32_t* scanned) const noexcept
+{
+  uint32_t si = 0, sc = 0;
+  if (slot >= 0 && slot < MAX_PEERS && channel >= 0 && channel < MAX_USER_CHANNELS)
+  {
+    si = m_silent_intervals[slot][channel].load(std::memory_order_relaxed);
+    sc = m_scanned_intervals[slot][channel].load(std::memory_order_relaxed);
+  }
+  if (silent) *silent = si;
+  if (scanned) *scanned = sc;
+}
+
 uint64_t NJClient::GetDecodeBufWriteDropTotal() const noexcept
 {
   return DecodeMediaBuffer::TotalWriteDrops();
@@ -4661,8 +5160,9 @@ bool NJClient::GetMirrorChannelSnapshot(int slot, int channel, MirrorChannelSnap
   out->flags            = c.flags;
   out->codec_fourcc     = c.codec_fourcc;
   out->ds_active        = (c.ds        != nullptr);
-  out->next_ds0_active  = (c.next_ds[0] != nullptr);
-  out->next_ds1_active  = (c.next_ds[1] != nullptr);
+  out->next_ds0_active  = (c.next_ds.at(0) != nullptr);
+  out->next_ds1_active  = (c.next_ds.at(1) != nullptr);
+  out->next_ds_queued   = c.next_ds.size();
   out->dump_samples     = c.dump_samples;
   out->curds_lenleft    = c.curds_lenleft;
   return true;
@@ -4893,6 +5393,7 @@ void NJClient::SetLocalChannelInfo(int ch, const char *name, bool setsrcch, int
   if (was_add)
   {
     m_locchannels.Add(new Local_Channel);
+    ensureLocalChannelFifo(ch);
   }
 
   Local_Channel *c=m_locchannels.Get(x);
@@ -4977,6 +5478,7 @@ void NJClient::SetLocalChannelMonitoring(int ch, bool setvol, float vol, bool se
   if (was_add)
   {
     m_locchannels.Add(new Local_Channel);
+    ensureLocalChannelFifo(ch);
   }
 
   Local_Channel *c=m_locchannels.Get(x);
@@ -5139,9 +5641,22 @@ bool RemoteUser_Channel::GetSessionInfo(double time, unsigned char *guid, double
   WDL_MutexLock lock(&sessionlist_mutex);
 
   mv *= 2.0; // allow one sample poot
-  // todo: binary search
-  int x;
-  for (x = 0; x < sessioninfo.GetSize(); x ++)
+
+  // AddSessionInfo keeps the list sorted and non-overlapping, so end times
+  // are monotonic: binary search for the first item ending after `time`.
+  // (The old linear walk stopped at the same item — a gap before an item
+  // implies time is also before its end.)
+  int lo = 0, hi = sessioninfo.GetSize();
+  while (lo < hi)
+  {
+    const int mid = (lo + hi) / 2;
+    const ChannelSessionInfo *p = sessioninfo.Get(mid);
+    if (time < p->start_time + p->length - mv) hi = mid;
+    else lo = mid + 1;
+  }
+
+  const int x = lo;
+  if (x < sessioninfo.GetSize())
   {
     if (time < sessioninfo.Get(x)->start_time-mv)
     {
@@ -5150,21 +5665,18 @@ bool RemoteUser_Channel::GetSessionInfo(double time, unsigned char *guid, double
       return false;
     }
 
-    if (time < sessioninfo.Get(x)->start_time+ sessioninfo.Get(x)->length-mv)
+    memcpy(guid,sessioninfo.Get(x)->guid,16);
+    if (time < sessioninfo.Get(x)->start_time)
     {
-      memcpy(guid,sessioninfo.Get(x)->guid,16);
-      if (time < sessioninfo.Get(x)->start_time)
-      {
-        *offs=sessioninfo.Get(x)->offset;
-        *len = sessioninfo.Get(x)->length + (sessioninfo.Get(x)->start_time-time);
-      }
-      else
-      {
-        *offs=(time - sessioninfo.Get(x)->start_time) + sessioninfo.Get(x)->offset;
-        *len = (sessioninfo.Get(x)->start_time+sessioninfo.Get(x)->length)-time;
-      }
-      return true;
+      *offs=sessioninfo.Get(x)->offset;
+      *len = sessioninfo.Get(x)->length + (sessioninfo.Get(x)->start_time-time);
     }
+    else
+    {
+      *offs=(time - sessioninfo.Get(x)->start_time) + sessioninfo.Get(x)->offset;
+      *len = (sessioninfo.Get(x)->start_time+sessioninfo.Get(x)->length)-time;
+    }
+    return true;
   }
   *len = 1.0;
   return false;
@@ -5176,11 +5688,13 @@ void RemoteUser_Channel::AddSessionInfo(const unsigned char *guid, double st, do
   const double min_length=0.05;
   const int max_entries=65536;
 
-  // todo: binary search?
-  int x;
-  for (x = 0; x < sessioninfo.GetSize(); x ++)
+  // first item starting after st (binary search; list is sorted by start)
+  int x = 0, hi = sessioninfo.GetSize();
+  while (x < hi)
   {
-    if (st < sessioninfo.Get(x)->start_time) break;
+    const int mid = (x + hi) / 2;
+    if (st < sessioninfo.Get(mid)->start_time) hi = mid;
+    else x = mid + 1;
   }
   ChannelSessionInfo *prev=sessioninfo.Get(x-1);
   ChannelSessionInfo *next=sessioninfo.Get(x);
@@ -5241,7 +5755,8 @@ next_again:
 
 
 
-RemoteDownload::RemoteDownload() : chidx(-1), playtime(0), m_fp(0), m_decbuf(0)
+RemoteDownload::RemoteDownload() : chidx(-1), playtime(0), stats_slot(-1), stats_chidx(-1),
+  archive_chidx(-1), archive_start_ms(0), m_store(0), m_decbuf(0)
 {
   memset(&guid,0,sizeof(guid));
   time(&last_time);
@@ -5254,8 +5769,21 @@ RemoteDownload::~RemoteDownload()
 
 void RemoteDownload::Close()
 {
-  if (m_fp) fclose(m_fp);
-  m_fp=0;
+  if (archive_chidx >= 0 && m_parent)
+  {
+    // Archive from the mapped disk copy when there is one, else from the
+    // in-memory copy Write() kept.
+    const void *data = m_store ? (const void *)m_store->data() : (const void *)m_archive_buf.Get();
+    const int len = m_store ? (int)m_store->size() : m_archive_buf.GetSize();
+    if (data && len > 0)
+      m_parent->archiveInterval(username.GetLength() ? username.Get() : "local", archive_chidx,
+                                guid, m_fourcc, archive_start_ms, data, len);
+  }
+  archive_chidx=-1;
+  m_archive_buf.Resize(0);
+
+  delete m_store; // truncates the file to the bytes received
+  m_store=0;
   startPlaying(1);
   if (m_decbuf)
   {
@@ -5269,7 +5797,8 @@ void RemoteDownload::Open(NJClient *parent, unsigned int fourcc, bool forceToDis
 {
   m_parent=parent;
   Close();
-  m_fp=0;
+  m_store=0;
+  m_fourcc=fourcc;
   m_decbuf=new DecodeMediaBuffer;
   if (!m_decbuf || !parent || parent->config_savelocalaudio>0 || forceToDisk)
   {
@@ -5283,8 +5812,12 @@ void RemoteDownload::Open(NJClient *parent, unsigned int fourcc, bool forceToDis
     s.Append(".");
     s.Append(buf);
 
-    m_fourcc=fourcc;
-    m_fp=fopenUTF8(s.Get(),"wb");
+    m_store=new jamwide::MappedIntervalFile;
+    if (!m_store->openWrite(s.Get()))
+    {
+      delete m_store;
+      m_store=0;
+    }
   }
 }
 
@@ -5295,7 +5828,7 @@ void RemoteDownload::startPlaying(int force)
   {
     if (playtime)
     {
-      if (m_fp && ftell(m_fp)>playtime) force=1;
+      if (m_store && (int)m_store->size()>playtime) force=1;
       else if (m_decbuf && m_decbuf->Size()>playtime) force=1;
     }
 
@@ -5311,10 +5844,8 @@ void RemoteDownload::startPlaying(int force)
     unsigned int fourcc_to_publish = 0;
     {
     WDL_MutexLock lock(&m_parent->m_users_cs);
-    int x;
-    RemoteUser *theuser;
-    for (x = 0; x < m_parent->m_remoteusers.GetSize() && strcmp((theuser=m_parent->m_remoteusers.Get(x))->name.Get(),username.Get()); x ++);
-    if (x < m_parent->m_remoteusers.GetSize() && chidx >= 0 && chidx < MAX_USER_CHANNELS)
+    RemoteUser *theuser=m_parent->m_users_by_name.find(username.Get());
+    if (theuser && chidx >= 0 && chidx < MAX_USER_CHANNELS)
     {
     //  char buf[512];
   //    sprintf(buf,"download %s:%d flags=%d\n",username.Get(),chidx,theuser->channels[chidx].flags);
@@ -5370,19 +5901,12 @@ void RemoteDownload::startPlaying(int force)
       upd_ds.channel  = chidx_to_publish;
       upd_ds.slot_idx = useidx_to_publish;
       upd_ds.ds       = reinterpret_cast<jamwide::DecodeState*>(ds_to_publish);
-      if (!m_parent->m_remoteuser_update_q.try_push(jamwide::RemoteUserUpdate{upd_ds}))
-      {
-        m_parent->m_remoteuser_update_overflows.fetch_add(1, std::memory_order_relaxed);
-        m_parent->writeLog("WARNING: m_remoteuser_update_q full on PeerNextDsUpdate (download, slot=%d ch=%d) — leaking ds\n", slot_to_publish, chidx_to_publish);
-      }
+      m_parent->publishOrdered(jamwide::RemoteUserUpdate{upd_ds});
       jamwide::PeerCodecSwapUpdate upd_codec{};
       upd_codec.slot       = slot_to_publish;
       upd_codec.channel    = chidx_to_publish;
       upd_codec.new_fourcc = fourcc_to_publish;
-      if (!m_parent->m_remoteuser_update_q.try_push(jamwide::RemoteUserUpdate{upd_codec}))
-      {
-        m_parent->m_remoteuser_update_overflows.fetch_add(1, std::memory_order_relaxed);
-      }
+      m_parent->publishOrdered(jamwide::RemoteUserUpdate{upd_codec});
     }
     else if (ds_to_publish)
     {
@@ -5391,19 +5915,70 @@ void RemoteDownload::startPlaying(int force)
   }
 }
 
+bool NJClient::DownloadRecvSink::directRecvBegin(const unsigned char *prefix, int len)
+{
+  // prefix is the interval write's GUID + flags. No download yet (its BEGIN
+  // is still queued behind us) -> normal path; the message handler sorts it.
+  m_target=len > 0 ? m_client->m_downloads_by_guid.find(prefix) : nullptr;
+  return m_target != nullptr;
+}
+
+uint32_t NJClient::DownloadByGuid::hash(Key k) { return jamwide::hashBytes(k,16); }
+NJClient::DownloadByGuid::Key NJClient::DownloadByGuid::key(const RemoteDownload *v) { return v->guid; }
+bool NJClient::DownloadByGuid::equal(const RemoteDownload *v, Key k) { return !memcmp(v->guid,k,sizeof(v->guid)); }
+
+uint32_t NJClient::UserByName::hash(Key k) { return jamwide::hashString(k); }
+NJClient::UserByName::Key NJClient::UserByName::key(const RemoteUser *v) { return v->name.Get(); }
+bool NJClient::UserByName::equal(const RemoteUser *v, Key k) { return !strcmp(v->name.Get(),k); }
+
+void NJClient::reapStaleDownloads(time_t now)
+{
+  m_download_reap_time=now;
+  for (int x = 0; x < m_downloads.GetSize(); x ++)
+  {
+    RemoteDownload *ds=m_downloads.Get(x);
+    if (ds && now - ds->last_time > DOWNLOAD_TIMEOUT)
+    {
+      if (ds->stats_slot >= 0)
+      {
+        WDL_MutexLock alock(&m_arrival_cs);
+        m_arrival[ds->stats_slot][ds->stats_chidx].onIntervalLost(ds->arrival);
+      }
+      ds->chidx=-1;
+      m_downloads_by_guid.erase(ds);
+      delete ds;
+      m_downloads.Delete(x--);
+    }
+  }
+}
+
+void NJClient::DownloadRecvSink::directRecvData(const void *data, int len)
+{
+  if (m_target) m_target->Append(data,len);
+}
+
 void RemoteDownload::Write(const void *buf, int len)
 {
-  if (m_fp)
+  Append(buf,len);
+  startPlaying();
+}
+
+void RemoteDownload::Append(const void *buf, int len)
+{
+  // Append into the mapped segment; no per-chunk flush (interval_store.h).
+  if (m_store && !m_store->append(buf,len))
+  {
+    delete m_store;
+    m_store=0;
+  }
+  else if (!m_store && archive_chidx >= 0)
   {
-    fwrite(buf,1,len,m_fp);
-    fflush(m_fp);
+    m_archive_buf.Add((const unsigned char *)buf,len);
   }
   if (m_decbuf)
   {
     m_decbuf->Write(buf,len);
   }
-
-  startPlaying();
 }
 
 
@@ -5412,6 +5987,7 @@ Local_Channel::Local_Channel() : channel_idx(0), src_channel(0), volume(1.0f), p
 #ifndef NJCLIENT_NO_XMIT_SUPPORT
                 m_enc(NULL),
                 m_enc_bitrate_used(0),
+                m_enc_bitrate_base(0),
                 m_enc_nch_used(0),
                 m_enc_header_needsend(NULL),
 #endif
@@ -5463,7 +6039,7 @@ void BufferQueue::DisposeBlock(WDL_HeapBuf *b)
 }
 
 
-void BufferQueue::AddBlock(int attr, double startpos, float *samples, int len, float *samples2)
+void BufferQueue::AddBlock(int attr, double startpos, const float *samples, int len, const float *samples2)
 {
   WDL_HeapBuf *mybuf=0;
   if (len>0)
@@ -5534,28 +6110,391 @@ Local_Channel::~Local_Channel()
 
 }
 
-void NJClient::SetOggOutFile(FILE *fp, int srate, int nch, int bitrate)
-{
 #ifndef NJCLIENT_NO_XMIT_SUPPORT
-  if (m_oggWrite)
+// Compressed master-recording output (vorbis or FLAC), run on the recorder
+// thread. Owns fp and the encoder. Blocks are copied planar for Encode();
+// the encoder's output goes through a 1 MB stdio buffer, so the file sees
+// large sequential writes however small the encoded pages are.
+class MasterEncoderSink : public jamwide::MasterRecorderSink
+{
+public:
+  MasterEncoderSink(FILE *fp, I_NJEncoder *enc, int nch)
+    : m_fp(fp), m_enc(enc), m_nch(nch > 1 ? 2 : 1), m_iobuf(1 << 20)
   {
-    if (m_oggComp)
+    if (m_fp) setvbuf(m_fp, m_iobuf.data(), _IOFBF, m_iobuf.size());
+  }
+  ~MasterEncoderSink() override { finish(); }
+
+  bool write(const float *l, const float *r, int frames) override
+  {
+    if (!m_fp || !m_enc || m_enc->isError()) return false;
+    m_planar.resize((size_t)frames * m_nch);
+    memcpy(m_planar.data(), l, frames * sizeof(float));
+    if (m_nch > 1) memcpy(m_planar.data() + frames, r, frames * sizeof(float));
+    m_enc->Encode(m_planar.data(), frames, 1, frames);
+    return writeOut();
+  }
+
+  void finish() override
+  {
+    if (!m_fp) return;
+    if (m_enc)
     {
-      m_oggComp->Encode(NULL,0);
-      if (m_oggComp->Available())
-        fwrite((char *)m_oggComp->Get(),1,m_oggComp->Available(),m_oggWrite);
+      m_enc->Encode(NULL, 0);
+      writeOut();
     }
-    fclose(m_oggWrite);
-    m_oggWrite=0;
+    delete m_enc;
+    m_enc = 0;
+    fclose(m_fp);
+    m_fp = 0;
+  }
+
+private:
+  bool writeOut()
+  {
+    const int n = m_enc->Available();
+    if (n <= 0) return true;
+    const bool ok = fwrite(m_enc->Get(), 1, n, m_fp) == (size_t)n;
+    m_enc->Advance(n);
+    m_enc->Compact();
+    return ok;
+  }
+
+  FILE *m_fp;
+  I_NJEncoder *m_enc;
+  int m_nch;
+  std::vector<char> m_iobuf;
+  std::vector<float> m_planar;
+};
+#endif
+
+template <class Sinks> bool NJClient::startMasterRecorder(Sinks sinks)
+{
+  // The ring is allocated by the first start(); a memory lock in force
+  // picks it up on the next Run() pass.
+  const bool had_ring = m_master_rec.fifoData() != nullptr;
+  const bool ok = m_master_rec.start(std::move(sinks));
+  if (!had_ring && m_master_rec.fifoData())
+    m_sample_fifo_allocs.fetch_add(1, std::memory_order_release);
+  return ok;
+}
+
+bool NJClient::StartMasterRecording(const char *path_base, int formats, int bitrate)
+{
+  if (!path_base || !*path_base)
+  {
+    m_master_rec.stop();
+    return false;
   }
-  delete m_oggComp;
-  m_oggComp=0;
 
+  WDL_String base;
+  if (!strstr(path_base,"\\") && !strstr(path_base,"/") && !strstr(path_base,":"))
+    base.Set(m_workdir.Get());
+  base.Append(path_base);
+  const int srate = m_srate > 0 ? m_srate : 48000;
+
+  // The files are created once the previous recording has closed its own
+  // (the names may match): here if it already has, otherwise on the
+  // recorder thread, so this never waits on the disk.
+  const std::string path(base.Get());
+  auto open = [this, path, formats, srate, bitrate]
+  {
+    std::vector<std::unique_ptr<jamwide::MasterRecorderSink>> sinks;
+    if (formats & MASTERREC_WAV)
+    {
+      const std::string fn = path + ".wav";
+      if (auto s = jamwide::WavFileSink::open(fopenUTF8(fn.c_str(), "wb"), srate, 24))
+        sinks.push_back(std::move(s));
+      else
+        writeLog("master recording: could not create %s\n", fn.c_str());
+    }
+#ifndef NJCLIENT_NO_XMIT_SUPPORT
+    for (int fmt = MASTERREC_OGG; fmt <= MASTERREC_FLAC; fmt <<= 1)
+    {
+      if (!(formats & fmt)) continue;
+      const std::string fn = path + (fmt == MASTERREC_FLAC ? ".flac" : ".ogg");
+      FILE *fp = fopenUTF8(fn.c_str(), "wb");
+      if (!fp)
+      {
+        writeLog("master recording: could not create %s\n", fn.c_str());
+        continue;
+      }
+      I_NJEncoder *enc = fmt == MASTERREC_FLAC ? CreateFLACEncoder(srate,2,bitrate,WDL_RNG_int32())
+                                               : CreateNJEncoder(srate,2,bitrate,WDL_RNG_int32());
+      sinks.emplace_back(new MasterEncoderSink(fp, enc, 2));
+    }
+#endif
+    return sinks;
+  };
+  return startMasterRecorder(jamwide::MasterRecorder::SinkOpener(open));
+}
+
+void NJClient::SetOggOutFile(FILE *fp, int srate, int nch, int bitrate)
+{
+#ifndef NJCLIENT_NO_XMIT_SUPPORT
   if (fp)
   {
-    //fucko
-    m_oggComp=CreateNJEncoder(srate,nch,bitrate,WDL_RNG_int32());
-    m_oggWrite=fp;
+    std::vector<std::unique_ptr<jamwide::MasterRecorderSink>> sinks;
+    sinks.emplace_back(new MasterEncoderSink(fp, CreateNJEncoder(srate,nch,bitrate,WDL_RNG_int32()), nch));
+    startMasterRecorder(std::move(sinks));
+    return;
   }
 #endif
+  m_master_rec.stop();
+}
+
+// Stem file names: <user>_<channel index>_<channel name>, reduced to
+// characters every filesystem takes.
+static void appendFileNamePart(std::string &out, const char *s)
+{
+  for (; s && *s; s++)
+  {
+    const unsigned char c = (unsigned char)*s;
+    const bool keep = (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') ||
+                      (c >= '0' && c <= '9') || c == '-' || c == '.' || c >= 0x80;
+    out += keep ? (char)c : '_';
+  }
+}
+
+void NJClient::registerStemName(int slot, int chanidx, const char *user, const char *chname)
+{
+  if (slot < 0 || slot >= MAX_PEERS || chanidx < 0 || chanidx >= MAX_USER_CHANNELS) return;
+  char idx[16];
+  snprintf(idx, sizeof(idx), "_%d", chanidx);
+
+  std::string identity(user ? user : "");
+  identity += idx;
+  std::string label;
+  appendFileNamePart(label, user);
+  label += idx;
+  if (chname && *chname)
+  {
+    label += '_';
+    appendFileNamePart(label, chname);
+  }
+  m_stem_rec.setStemName(slot * MAX_USER_CHANNELS + chanidx, identity, label);
+}
+
+bool NJClient::StartStemRecording(const char *dirname, int format, int workers, int bitrate)
+{
+  // A running recording is retired without waiting for its files; the new
+  // one arms once they are written (stem_recorder.h).
+  m_stem_rec.stop();
+  if (!dirname || !*dirname) return false;
+#ifdef NJCLIENT_NO_XMIT_SUPPORT
+  if (format != MASTERREC_WAV) return false;
+#else
+  if (format != MASTERREC_WAV && format != MASTERREC_OGG && format != MASTERREC_FLAC) return false;
+#endif
+
+  WDL_String dir;
+  if (!strstr(dirname,"\\") && !strstr(dirname,"/") && !strstr(dirname,":"))
+    dir.Set(m_workdir.Get());
+  dir.Append(dirname);
+#ifdef _WIN32
+  CreateDirectory(dir.Get(),NULL);
+  dir.Append("\\");
+#else
+  mkdir(dir.Get(),0700);
+  dir.Append("/");
+#endif
+
+  const int srate = m_srate > 0 ? m_srate : 48000;
+  const char *ext = format == MASTERREC_FLAC ? ".flac" : format == MASTERREC_OGG ? ".ogg" : ".wav";
+  const std::string base(dir.Get());
+  std::set<std::string> used;
+
+  // Runs on the recorder's dispatcher thread, once per stem file. A label
+  // seen before in this recording (a peer that left and came back) gets a
+  // -2, -3... suffix rather than overwriting the first file.
+  auto factory = [this, base, ext, format, srate, bitrate, used](int, const std::string &label) mutable
+    -> std::unique_ptr<jamwide::MasterRecorderSink>
+  {
+    std::string name = label;
+    for (int n = 2; !used.insert(name).second; n++)
+      name = label + "-" + std::to_string(n);
+    const std::string fn = base + name + ext;
+    FILE *fp = fopenUTF8(fn.c_str(), "wb");
+    if (!fp)
+    {
+      writeLog("stem recording: could not create %s\n", fn.c_str());
+      return nullptr;
+    }
+    if (format == MASTERREC_WAV) return jamwide::WavFileSink::open(fp, srate, 24);
+#ifndef NJCLIENT_NO_XMIT_SUPPORT
+    I_NJEncoder *enc = format == MASTERREC_FLAC ? CreateFLACEncoder(srate,2,bitrate,WDL_RNG_int32())
+                                                : CreateNJEncoder(srate,2,bitrate,WDL_RNG_int32());
+    return std::unique_ptr<jamwide::MasterRecorderSink>(new MasterEncoderSink(fp, enc, 2));
+#else
+    fclose(fp);
+    return nullptr;
+#endif
+  };
+
+  const bool had_ring = m_stem_rec.fifoData() != nullptr;
+  const bool ok = m_stem_rec.start(factory, workers);
+  if (!had_ring && m_stem_rec.fifoData())
+    m_sample_fifo_allocs.fetch_add(1, std::memory_order_release);
+  return ok;
+}
+
+// One track of ExportSessionArchive: every interval overlapping
+// [from_ms, to_ms), decoded, cut where the next interval on the track
+// starts, and laid on a timeline of silence that begins at from_ms. The
+// file takes the sample rate of the first interval that decodes; a later
+// interval at another rate is left silent. Returns true if a file was
+// written.
+static bool exportArchiveTrack(const jamwide::SessionArchiveReader &ar, int track, int64_t from_ms, int64_t to_ms,
+                               const char *fn, const std::atomic<bool> &cancel)
+{
+  std::unique_ptr<jamwide::WavFileSink> sink;
+  int srate = 0;
+  uint64_t written = 0;
+  std::vector<float> bl, br;
+
+  auto frameAt = [&](int64_t ms) { return (uint64_t)((ms - from_ms) * (int64_t)srate / 1000); };
+  auto put = [&](const float *src, int nch, int frames) {
+    bl.resize((size_t)frames);
+    br.resize((size_t)frames);
+    for (int x = 0; x < frames; x++)
+    {
+      bl[x] = src ? src[x * nch] : 0.0f;
+      br[x] = src ? src[x * nch + (nch > 1)] : 0.0f;
+    }
+    sink->write(bl.data(), br.data(), frames);
+    written += (uint64_t)frames;
+  };
+  auto padTo = [&](uint64_t at) {
+    while (written < at)
+      put(NULL, 1, (int)std::min<uint64_t>(at - written, 4096));
+  };
+
+  const size_t n = ar.trackSize(track);
+  for (size_t pos = ar.trackSeek(track, from_ms); pos < n && !cancel.load(std::memory_order_relaxed); pos++)
+  {
+    const jamwide::SessionArchiveEntry &e = ar.entry(ar.trackEntry(track, pos));
+    if (e.start_ms >= to_ms) break;
+    int64_t end_ms = std::min(e.endMs(), to_ms);
+    if (pos + 1 < n) end_ms = std::min(end_ms, ar.entry(ar.trackEntry(track, pos + 1)).start_ms);
+
+    const unsigned char *src = ar.payload(e);
+    I_NJDecoder *dec = NULL;
+    if (e.fourcc == NJ_ENCODER_FMT_FLAC) dec = CreateFLACDecoder();
+    else if (e.fourcc == NJ_ENCODER_FMT_OPUS) dec = CreateOpusDecoder();
+    else dec = CreateNJDecoder();
+    if (!src || !dec)
+    {
+      delete dec;
+      continue;
+    }
+
+    // Frames of this interval: drop `skip` (before from_ms), keep up to `keep`.
+    bool placed = false;
+    uint64_t skip = 0, keep = 0;
+    uint32_t fed = 0;
+    for (bool eof = false; !eof; )
+    {
+      const int chunk = (int)std::min<uint32_t>(e.size - fed, 4096);
+      void *buf = dec->DecodeGetSrcBuffer(chunk > 0 ? chunk : 1);
+      if (!buf) break;
+      if (chunk > 0) memcpy(buf, src + fed, chunk);
+      dec->DecodeWrote(chunk);
+      fed += (uint32_t)chunk;
+      eof = chunk == 0;
+
+      const int nch = dec->GetNumChannels();
+      const int avail = nch > 0 ? dec->Available() / nch : 0;
+      if (avail <= 0) continue;
+      if (!sink)
+      {
+        srate = dec->GetSampleRate();
+        if (srate > 0) sink = jamwide::WavFileSink::open(fopenUTF8(fn, "wb"), srate, 24);
+        if (!sink)
+        {
+          delete dec;
+          return false;
+        }
+      }
+      if (!placed)
+      {
+        if (dec->GetSampleRate() != srate) break;
+        placed = true;
+        const int64_t at_ms = std::max(e.start_ms, from_ms);
+        skip = (uint64_t)((at_ms - e.start_ms) * (int64_t)srate / 1000);
+        padTo(frameAt(at_ms));
+        const uint64_t stop = frameAt(end_ms);
+        keep = stop > written ? stop - written : 0;
+      }
+
+      const float *p = dec->Get();
+      int use = avail;
+      const int drop = (int)std::min<uint64_t>(skip, (uint64_t)use);
+      skip -= (uint64_t)drop;
+      use -= drop;
+      if ((uint64_t)use > keep) use = (int)keep;
+      if (use > 0) put(p + drop * nch, nch, use);
+      keep -= (uint64_t)use;
+      dec->Skip(avail * nch);
+      if (!keep && !skip) break;
+    }
+    delete dec;
+  }
+
+  if (!sink) return false;
+  padTo(frameAt(to_ms));
+  sink->finish();
+  return true;
+}
+
+void NJClient::archiveExportMain(std::string path, int64_t from_ms, int64_t to_ms)
+{
+  jamwide::SessionArchiveReader ar;
+  FILE *fp = fopenUTF8(path.c_str(), "rb");
+  const bool opened = fp && ar.open(fp);
+  if (fp) fclose(fp);
+  if (!opened)
+  {
+    writeLog("archive export: could not read %s\n", path.c_str());
+    m_archive_export_state.store(ARCHIVE_EXPORT_FAILED, std::memory_order_release);
+    return;
+  }
+  if (to_ms <= 0 || to_ms > ar.lengthMs()) to_ms = ar.lengthMs();
+  if (from_ms < 0) from_ms = 0;
+
+  const size_t dot = path.find_last_of('.');
+  const size_t sep = path.find_last_of("\\/");
+  const std::string base = dot != std::string::npos && (sep == std::string::npos || dot > sep) ? path.substr(0, dot) : path;
+
+  for (size_t t = 0; t < ar.numTracks() && from_ms < to_ms; t++)
+  {
+    if (m_archive_export_cancel.load(std::memory_order_relaxed)) break;
+    const jamwide::SessionArchiveTrack &tr = ar.trackInfo(t);
+    std::string fn = base + "_";
+    appendFileNamePart(fn, tr.user.c_str());
+    fn += "_" + std::to_string(tr.channel) + ".wav";
+    if (exportArchiveTrack(ar, (int)t, from_ms, to_ms, fn.c_str(), m_archive_export_cancel))
+      m_archive_export_files.fetch_add(1, std::memory_order_relaxed);
+  }
+  m_archive_export_state.store(ARCHIVE_EXPORT_DONE, std::memory_order_release);
+}
+
+bool NJClient::ExportSessionArchive(const char *name, int64_t from_ms, int64_t to_ms)
+{
+  if (!name || !*name) return false;
+  if (m_archive_export_state.load(std::memory_order_acquire) == ARCHIVE_EXPORT_RUNNING) return false;
+  if (m_archive_export.joinable()) m_archive_export.join(); // finished; returns at once
+
+  WDL_String s;
+  archivePath(&s, name);
+  m_archive_export_cancel.store(false, std::memory_order_relaxed);
+  m_archive_export_files.store(0, std::memory_order_relaxed);
+  m_archive_export_state.store(ARCHIVE_EXPORT_RUNNING, std::memory_order_relaxed);
+  m_archive_export = std::thread(&NJClient::archiveExportMain, this, std::string(s.Get()), from_ms, to_ms);
+  return true;
+}
+
+int NJClient::GetSessionArchiveExportState(int *files) const
+{
+  if (files) *files = m_archive_export_files.load(std::memory_order_relaxed);
+  return m_archive_export_state.load(std::memory_order_acquire);
 }
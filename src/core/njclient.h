@@ -69,6 +69,7 @@
 #include <atomic>
 #include <cstdint>
 #include <string>
+#include <thread>
 #include <vector>
 #include "../wdl/wdlstring.h"
 #include "../wdl/ptrlist.h"
@@ -84,6 +85,17 @@
 // 15.1-05 CR-05/06/07: deferred-delete SPSC infrastructure (Wave 0 finalized in 15.1-04).
 #include "../threading/spsc_ring.h"
 #include "../threading/spsc_payloads.h"
+#include "../threading/sample_fifo.h"
+#include "bitrate_controller.h"
+#include "arrival_stats.h"
+#include "interval_store.h"
+#include "session_archive.h"
+#include "net_wait.h"
+#include "hash_index.h"
+#include "thread_sched.h"
+#include "prefetch_queue.h"
+#include "master_recorder.h"
+#include "stem_recorder.h"
 
 
 class I_NJEncoder;
@@ -118,6 +130,13 @@ class DecodeMediaBuffer;
 #define MAX_PEERS 64
 #endif
 
+// Capacity of each remote channel's queue of prepared intervals
+// (RemoteUserChannelMirror::next_ds). config_prefetch_intervals picks how
+// much of it is used.
+#ifndef MAX_PREFETCH_INTERVALS
+#define MAX_PREFETCH_INTERVALS 8
+#endif
+
 // 15.1-06 CR-02: audio-thread-owned mirror of local-channel state.
 //
 // Updated by NJClient::drainLocalChannelUpdates() at top of AudioProc; never
@@ -129,19 +148,19 @@ class DecodeMediaBuffer;
 // so the audio thread could call `lc_ptr->m_bq.AddBlock(...)` for the
 // BufferQueue handoff; that undermined the mirror model because the audio
 // thread still dereferenced run-thread-owned objects. This revision
-// eliminates the back-pointer entirely. The per-channel BlockRecord SPSC
+// eliminates the back-pointer entirely. The per-channel broadcast SPSC
 // (the only consumer of that pointer) is stored AS A MEMBER here.
 //
 // Notes on lifetime:
 //   - The mirror is a fixed-size array on NJClient; lifetime is tied to the
 //     NJClient instance. Mirror entries are constructed in place when the
-//     enclosing NJClient is constructed; the per-entry block_q SpscRing is
-//     non-copyable/non-movable but in-place default-constructible (verified
-//     by reading src/threading/spsc_ring.h:43).
-//   - block_q is the producer side for the BlockRecord SPSC consumed by the
+//     enclosing NJClient is constructed; the per-entry block_q SampleFifo is
+//     non-copyable but in-place default-constructible, and owns no storage
+//     until the channel is first added.
+//   - block_q is the producer side for the broadcast SPSC consumed by the
 //     encoder thread (wired in 15.1-07b). On RemovedUpdate apply, the audio
-//     thread drains the ring empty and resets scalar fields; the same ring
-//     is reused on the next AddedUpdate without ever being destroyed.
+//     thread resets scalar fields; the same FIFO is reused on the next
+//     AddedUpdate without ever being destroyed.
 //
 // 15.1-06 NinjamRunThread Instatalk processor (cbf) — see deviation #2 in
 // 15.1-06-SUMMARY.md: the production Local_Channel.cbf is consulted from
@@ -172,12 +191,14 @@ struct LocalChannelMirror {
     void (*cbf)(float* /*buf*/, int /*ns*/, void* /*inst*/) = nullptr;
     void* cbf_inst = nullptr;
 
-    // 15.1-06 + 15.1-07b: per-channel BlockRecord SPSC. process_samples /
-    // on_new_interval is the producer side (15.1-07b will wire the actual
-    // pushes). The encoder thread is the consumer (also 15.1-07b). Owned by
-    // the mirror entry; lifetime is tied to the entry's active flag — drained
-    // empty on RemovedUpdate apply, reused on the next AddedUpdate.
-    jamwide::SpscRing<jamwide::BlockRecord, 16> block_q;
+    // 15.1-06 + 15.1-07b: per-channel broadcast sample FIFO. process_samples /
+    // on_new_interval is the producer side; the run thread's
+    // drainBroadcastBlocks is the consumer. Storage (kBroadcastFifoBytes) is
+    // allocated on the run thread the first time the channel index is
+    // added (ensureLocalChannelFifo) and kept for the NJClient lifetime, so
+    // unused channel indices cost nothing; reused on the next AddedUpdate.
+    static constexpr size_t kBroadcastFifoBytes = 256 * 1024;
+    jamwide::SampleFifo block_q;
 
     // 15.1-06: per-channel VU peak. Audio thread writes (relaxed); UI/run
     // thread reads via NJClient::GetLocalChannelPeak (relaxed). Cross-thread
@@ -212,7 +233,7 @@ struct LocalChannelMirror {
 // dereferenced run-thread-owned objects. This revision eliminates the back-
 // pointer entirely.
 //
-// The DecodeState* members (ds, next_ds[0], next_ds[1]) are AUDIO-THREAD-OWNED
+// The DecodeState* members (ds and the next_ds queue) are AUDIO-THREAD-OWNED
 // once published via PeerNextDsUpdate from the run thread. This is documented
 // ownership transfer (per spsc_payloads.h header comment) — NOT a back-
 // reference into shared state. The audio thread frees old DecodeState
@@ -237,8 +258,10 @@ struct RemoteUserChannelMirror {
 
     // Audio-thread-owned DecodeState pointers; ownership transfers via
     // PeerNextDsUpdate. Freed via deferDecodeStateDelete (15.1-05).
+    // next_ds queues the prepared upcoming intervals, oldest first (see
+    // prefetch_queue.h); each interval boundary pops its front into ds.
     class ::DecodeState* ds = nullptr;
-    class ::DecodeState* next_ds[2] = {nullptr, nullptr};
+    jamwide::PrefetchQueue<::DecodeState, MAX_PREFETCH_INTERVALS> next_ds;
 
     // Audio-thread-only state: replaces RemoteUser_Channel::dump_samples and
     // .curds_lenleft for mixInChannel's resample/skip bookkeeping. NOT read
@@ -286,6 +309,39 @@ struct RemoteUserMirror {
     RemoteUserChannelMirror chans[MAX_USER_CHANNELS];
 };
 
+// Audio-thread list of the remote channels process_samples mixes, in
+// structure-of-arrays form.
+//
+// m_remoteuser_mirror is 64 peers x 32 channel mirrors with atomics, decode
+// pointers and doubles interleaved; walking it every block to find the few
+// present channels and gather volume/pan/mute/route from two levels touches
+// most of that. This list holds only the present channels of active peers,
+// in the same slot/channel order, with the mix parameters already combined
+// (peer x channel gain, clamped pan, mute/solo bits) in parallel arrays, and
+// a pointer to each channel's mirror for the decode-state work in
+// mixInChannel.
+//
+// Rebuilt by drainRemoteUserUpdates() after any update that changes
+// presence or mix parameters; read by process_samples. Audio-thread only.
+struct RemoteMixList {
+    static constexpr int kMaxEntries = MAX_PEERS * MAX_USER_CHANNELS;
+
+    int count = 0;          // entries in use
+    int active_peers = 0;   // active mirror slots (remote_user_count)
+
+    float         gain[kMaxEntries];       // peer volume * channel volume
+    float         pan[kMaxEntries];        // peer pan + channel pan, clamped to [-1, 1]
+    int           out_chan[kMaxEntries];   // out_chan_index (m_remote_chanoffs added at mix time)
+    unsigned char muted[kMaxEntries];      // channel muted bit or peer muted
+    unsigned char solo[kMaxEntries];       // channel solo bit
+    unsigned char slot[kMaxEntries];
+    unsigned char chan[kMaxEntries];
+    RemoteUserChannelMirror* mirror[kMaxEntries];
+};
+
+static_assert(MAX_PEERS <= 256 && MAX_USER_CHANNELS <= 256,
+              "RemoteMixList stores slot/channel indices as bytes");
+
 // #define NJCLIENT_NO_XMIT_SUPPORT // might want to do this for njcast :)
 //  it also removes mixed ogg writing support
 
@@ -304,12 +360,38 @@ public:
   // call Run() from your main (UI) thread
   int Run();// returns nonzero if sleep is OK
 
+  // Block the run thread until the server socket is ready, the audio thread
+  // has pushed broadcast blocks, WakeRunThread() is called, or max_ms
+  // elapses -- whichever comes first. max_ms only paces work nothing
+  // signals (UI snapshots), so it can be long. Call between Run() passes,
+  // in place of a fixed sleep, from the thread that calls
+  // Run()/Connect()/Disconnect() (it reads m_netcon unlocked). Returns
+  // NetActivityWaiter result bits (0 == timeout). See net_wait.h.
+  int WaitForActivity(int max_ms);
+
+  // Any thread, lock-free, coalesced. Use to cut a WaitForActivity short
+  // (thread shutdown, queued UI commands).
+  void WakeRunThread() noexcept { m_run_waiter.wake(); }
+
+  // Run-loop observability for /rcmstats. Relaxed counters.
+  uint64_t GetRunLoopWaits() const noexcept { return m_run_waiter.waits(); }
+  uint64_t GetRunLoopTimeouts() const noexcept { return m_run_waiter.timeouts(); }
+  uint64_t GetRunLoopWakeSignals() const noexcept { return m_run_waiter.wakeSignals(); }
+
   const char *GetErrorStr() { return m_errstr.Get(); }
 
   int IsAudioRunning() { return m_audio_enable; }
   // call AudioProc, (and only AudioProc) from your audio thread
   void AudioProc(float **inbuf, int innch, float **outbuf, int outnch, int len, int srate, bool justmonitor=false, bool isPlaying=true, bool isSeek=false, double cursessionpos=-1.0); // len is number of sample pairs or samples
 
+  // Audio thread only, valid right after AudioProc: bit n set = output
+  // channel n had something mixed into it during that call (a monitored
+  // local channel, an unmuted remote channel with decoded audio, or a
+  // metronome click). Clear bits are channels AudioProc left at the zeros
+  // it starts from, so the caller can skip summing/copying them. Channels
+  // >= 64 are never reported.
+  uint64_t GetOutputChannelsWritten() const { return m_outch_written; }
+
 
   // Basic configuration (non-atomic, require state_mutex)
   int   config_autosubscribe;
@@ -327,14 +409,87 @@ public:
   std::atomic<bool>  config_mastermute{false};
   std::atomic<int>   config_play_prebuffer{8192}; // -1 means play instantly, 0 means play when full file is there
 
+  // Adaptive per-channel prebuffer (see arrival_stats.h). When enabled, each
+  // new download's playtime comes from that remote channel's measured
+  // arrival jitter instead of config_play_prebuffer/LIVE_PREBUFFER directly.
+  // Ignored when config_play_prebuffer <= 0 (play instantly / when full).
+  // Off by default, so an upgrade keeps the configured playback latency;
+  // the arrival stats are gathered either way.
+  std::atomic<bool>  config_adaptive_prebuffer{false};
+
+  // Lookahead depth: how many prepared intervals each remote channel may
+  // queue ahead of the one playing (1..MAX_PREFETCH_INTERVALS). When a
+  // further interval arrives the oldest queued one is dropped. 2 keeps the
+  // historic behaviour (at most one interval of extra delay after a burst);
+  // more rides out longer run-thread stalls at the cost of playing that
+  // backlog late. Read by the audio thread on each PeerNextDsUpdate.
+  std::atomic<int>   config_prefetch_intervals{2};
+
+  // Network buffering, read by Connect() (changes apply to the next
+  // connection). config_socket_sndbuf/rcvbuf are the kernel SO_SNDBUF /
+  // SO_RCVBUF in bytes; 0 keeps the OS default, and with it Linux receive
+  // autotuning. config_net_recv_ring sizes JNL_Connection's user-space
+  // receive ring (clamped to 16 KB..4 MB): the more it holds, the more of an
+  // interval-write burst one Run() pass parses.
+  std::atomic<int>   config_socket_sndbuf{0};
+  std::atomic<int>   config_socket_rcvbuf{0};
+  std::atomic<int>   config_net_recv_ring{256*1024};
+
+  // Run-thread scheduling (see thread_sched.h). Run() applies changes to
+  // whichever thread calls it, on the next pass. config_thread_policy is a
+  // jamwide::SchedPolicy; config_thread_priority is the nice value or the
+  // real-time priority; config_thread_cpumask restricts the run thread to
+  // those CPUs (0 = any). config_lock_memory pins the audio-thread mirrors
+  // (remote/local channel mirrors and their sample FIFOs) in RAM.
+  std::atomic<int>      config_thread_policy{jamwide::kSchedDefault};
+  std::atomic<int>      config_thread_priority{0};
+  std::atomic<uint64_t> config_thread_cpumask{0};
+  std::atomic<bool>     config_lock_memory{false};
+
+  // What the run thread actually got, published after each change. Relaxed
+  // loads; safe from any thread.
+  void GetRunThreadSchedStatus(jamwide::ThreadSchedStatus* out) const noexcept;
+
   // Codec format selection (UI thread writes via SetEncoderFormat, Run thread reads at interval boundary)
   std::atomic<unsigned int> m_encoder_fmt_requested{0};  // initialized in constructor
   unsigned int m_encoder_fmt_active = 0;  // only accessed by Run thread
   unsigned int m_encoder_fmt_prev = 0;    // previous format for chat notification
 
-  void SetEncoderFormat(unsigned int fourcc);
+  void SetEncoderFormat(unsigned int fourcc);  // FLAC, OGGv, or OPUS (JAMWIDE_WITH_OPUS builds only)
   unsigned int GetEncoderFormat() const { return m_encoder_fmt_requested.load(std::memory_order_relaxed); }
 
+  // Adaptive upload bitrate (see bitrate_controller.h). When enabled, the run
+  // thread scales every local channel's bitrate down from the user setting
+  // while the uplink is backlogged, and back up once it drains. Changes only
+  // take effect at interval boundaries (encoder rebuild). Disabling it
+  // restores the user bitrate at the next boundary. Idle with FLAC, which
+  // has no bitrate. Off by default, so an upgrade keeps uploading at
+  // exactly the configured bitrate.
+  std::atomic<bool> config_adaptive_bitrate{false};
+
+  // Telemetry snapshot, published by the run thread once per interval.
+  // Relaxed loads; observability only.
+  struct AdaptiveBitrateStats {
+    bool     enabled = false;
+    int      percent = 100;            // current % of user bitrate
+    int      sendq_bytes_peak = 0;     // last interval's peak uplink backlog (bytes)
+    int      sendq_msgs_peak = 0;      // last interval's peak uplink backlog (messages)
+    int      recv_gap_ms = 0;          // keepalive gap at last evaluation
+    uint64_t bytes_sent = 0;           // bytes handed to the socket during last interval
+    uint64_t step_downs = 0;           // since connect
+    uint64_t step_ups = 0;             // since connect
+  };
+  void GetAdaptiveBitrateStats(AdaptiveBitrateStats& out) const noexcept;
+
+  // Receive batching telemetry for the current connection, published by the
+  // run thread after each Run() pass. Relaxed loads; observability only.
+  uint64_t GetNetMessagesReceived() const noexcept { return m_net_stat_msgs.load(std::memory_order_relaxed); }
+  int GetNetMaxRecvBatch() const noexcept { return m_net_stat_max_batch.load(std::memory_order_relaxed); }
+  // Interval writes (and their audio bytes) received straight into a
+  // download's buffer, bypassing the Net_Message payload copy.
+  uint64_t GetNetDirectRecvMessages() const noexcept { return m_net_stat_direct_msgs.load(std::memory_order_relaxed); }
+  uint64_t GetNetDirectRecvBytes() const noexcept { return m_net_stat_direct_bytes.load(std::memory_order_relaxed); }
+
   // Non-atomic config fields (require state_mutex)
   int   config_debug_level;
   int config_remote_autochan; // 1=auto-assign by channel, 2=auto-assign by user
@@ -445,6 +600,47 @@ public:
   // a multi-second silent gap. Audio-thread-writes / UI-thread-reads, relaxed.
   int GetDumpSamplesPeak(int slot, int channel) const noexcept;
 
+  // Silence detection in mixInChannel: decoded blocks below -120 dBFS are
+  // not mixed. GetSilentIntervalCount reports, per (slot,channel), how many
+  // retired intervals were measured at all and how many of those were
+  // entirely silent (a subscribed peer that isn't playing);
+  // GetSilentBlocksSkipped is the total of skipped blocks. Relaxed reads.
+  void GetSilentIntervalCount(int slot, int channel, uint32_t* silent, uint32_t* scanned) const noexcept;
+  uint64_t GetSilentBlocksSkipped() const noexcept
+  {
+    return m_silent_blocks_skipped.load(std::memory_order_relaxed);
+  }
+
+  // Interval lookahead (config_prefetch_intervals): publishes that waited
+  // for room in the update queue, prepared intervals dropped while waiting,
+  // and queued intervals evicted by a newer one at the configured depth.
+  struct PrefetchStats {
+    uint64_t deferred = 0;
+    uint64_t dropped = 0;
+    uint64_t evicted = 0;
+  };
+  void GetPrefetchStats(PrefetchStats& out) const noexcept
+  {
+    out.deferred = m_next_ds_deferred.load(std::memory_order_relaxed);
+    out.dropped  = m_next_ds_dropped.load(std::memory_order_relaxed);
+    out.evicted  = m_prefetch_evictions.load(std::memory_order_relaxed);
+  }
+
+  // Interval starts: decoders the run thread published with a full
+  // pre-decoded head or a short one, and boundary crossfades that still
+  // decoded on the audio thread. cold stays 0 when priming keeps up.
+  struct IntervalStartStats {
+    uint64_t primed = 0;
+    uint64_t short_head = 0;
+    uint64_t cold = 0;
+  };
+  void GetIntervalStartStats(IntervalStartStats& out) const noexcept
+  {
+    out.primed     = m_decode_heads_primed.load(std::memory_order_relaxed);
+    out.short_head = m_decode_heads_short.load(std::memory_order_relaxed);
+    out.cold       = m_overlap_cold_decodes.load(std::memory_order_relaxed);
+  }
+
   // Aggregate count of DecodeMediaBuffer SPSC ring-saturation drops since
   // session start. A non-zero value means the run thread was bursting bytes
   // into a per-channel decode buffer faster than the audio thread could drain
@@ -470,6 +666,7 @@ public:
       bool ds_active;
       bool next_ds0_active;
       bool next_ds1_active;
+      int next_ds_queued;       // prepared intervals waiting, 0..MAX_PREFETCH_INTERVALS
       int dump_samples;
       double curds_lenleft;
   };
@@ -487,6 +684,12 @@ public:
   bool GetMirrorChannelSnapshot(int slot, int channel, MirrorChannelSnapshot* out) const noexcept;
   bool GetMirrorPeerSnapshot   (int slot,              MirrorPeerSnapshot*    out) const noexcept;
 
+  // Receiver-side arrival statistics for a remote (slot, channel): interval
+  // write gaps, jitter, late-interval counts and the prebuffer threshold last
+  // chosen for it. Copied under m_arrival_cs. Returns false if (slot,
+  // channel) is out of bounds.
+  bool GetArrivalStatsSnapshot(int slot, int channel, jamwide::ArrivalStatsSnapshot* out) const;
+
   // 2026-05-03 TX-silent investigation: local channel mirror snapshot for
   // diagnosing transmit-side bugs. Audio-thread-writes / UI-thread-reads,
   // relaxed semantics. Returns false if `ch` is out of bounds.
@@ -546,18 +749,63 @@ public:
 
   void SetLogFile(const char *name=NULL);
 
-  // 15.1-08 M-01 + Codex M-7: pre-grow tmpblock so the audio thread never
-  // reallocates it. ALSO enforces the MAX_BLOCK_SAMPLES contract from
-  // 15.1-04 spsc_payloads.h: throws std::runtime_error if maxSamplesPerBlock
-  // > jamwide::MAX_BLOCK_SAMPLES. JUCE prepareToPlay catches this and
-  // surfaces it as a host-incompatibility error (the M-03 jassert in the
-  // processor's processBlock then catches debug-build violations of the
-  // host-claimed bound at audio time). Idempotent and safe to call from
-  // every prepareToPlay (Prealloc only grows, never shrinks).
+  // Record every completed interval (remote downloads and, while
+  // broadcasting, local channels) into a single time-indexed session
+  // archive (see session_archive.h). Relative names go in the work dir,
+  // like SetLogFile. NULL/empty finalizes the archive (writes its index)
+  // and stops recording. Returns false if the file could not be created.
+  bool SetSessionArchiveFile(const char *name=NULL);
+  bool IsSessionArchiveActive();
+
+  // Decode [from_ms, to_ms) of a session archive (to_ms <= 0: to its end)
+  // into one WAV per track, "<archive name>_<user>_<channel>.wav" next to
+  // the archive, all starting at from_ms so they line up. Each track is
+  // seeked through the archive index, so a few bars from the end of a long
+  // session cost the same as from the start. Runs on its own thread and
+  // returns false only if an export is already running; the outcome is
+  // read with GetSessionArchiveExportState. Names resolve like
+  // SetSessionArchiveFile.
+  bool ExportSessionArchive(const char *name, int64_t from_ms, int64_t to_ms=0);
+  enum { ARCHIVE_EXPORT_FAILED=-1, ARCHIVE_EXPORT_NONE=0, ARCHIVE_EXPORT_RUNNING=1, ARCHIVE_EXPORT_DONE=2 };
+  int GetSessionArchiveExportState(int *files=NULL) const; // files: WAVs written by the last export
+
+  // 15.1-08 M-01: pre-grow tmpblock so the audio thread never reallocates
+  // it. Any block size is accepted (the sample FIFOs have no per-block
+  // ceiling). Idempotent and safe to call from every prepareToPlay
+  // (Prealloc only grows, never shrinks).
   void SetMaxAudioBlockSize(int maxSamplesPerBlock);
 
+  // Master recording: the mix (before master volume) streamed to
+  // <path_base>.wav (24-bit), .ogg and/or .flac by a dedicated recorder
+  // thread (master_recorder.h), never by the run loop. Relative names land
+  // in the work dir. Call from any thread but the audio thread; a running
+  // recording is stopped first, without waiting for its files. Returns
+  // false if no file could be created (known at once unless that earlier
+  // recording is still finishing, then it shows as a sink error). Stop
+  // returns at once; the files are finished on the recorder thread.
+  enum { MASTERREC_WAV=1, MASTERREC_OGG=2, MASTERREC_FLAC=4 };
+  bool StartMasterRecording(const char *path_base, int formats, int bitrate=128);
+  void StopMasterRecording() { m_master_rec.stop(); }
+  bool IsMasterRecording() const noexcept { return m_master_rec.recording(); }
+  void GetMasterRecorderStats(jamwide::MasterRecorderStats& out) const noexcept { m_master_rec.getStats(out); }
+
+  // Stem recording: one continuous stereo file per remote user/channel,
+  // <dir>/<user>_<n>_<channel>.wav (24-bit), .ogg or .flac (format is one
+  // MASTERREC_* value), pre-fader and pre-mute. Every stem starts at the
+  // next interval boundary and all end with the same length, silent where
+  // the channel was. The audio comes from the block the mixer decodes
+  // anyway and is encoded by `workers` threads (0 = one per spare core, up
+  // to 4; stem_recorder.h). A relative dir is created under the work dir.
+  // Same threading rules as StartMasterRecording; stop returns at once.
+  bool StartStemRecording(const char *dirname, int format, int workers=0, int bitrate=128);
+  void StopStemRecording() { m_stem_rec.stop(); }
+  bool IsStemRecording() const noexcept { return m_stem_rec.active(); }
+  void GetStemRecorderStats(jamwide::StemRecorderStats& out) const noexcept { m_stem_rec.getStats(out); }
+
+  // Legacy entry point: an OGG-only master recording into fp (taken over
+  // and closed when the recording ends); fp == NULL stops it. nch is
+  // ignored, the mix is always stereo.
   void SetOggOutFile(FILE *fp, int srate, int nch, int bitrate=128);
-  WaveWriter *waveWrite;
 
 
   void *LicenseAgreement_User;
@@ -626,8 +874,8 @@ public:
       return m_deferred_delete_overflows.load(std::memory_order_relaxed);
   }
 
-  // 15.1-07b CR-09/CR-10 + Codex M-8: BlockRecord SPSC overflow counter.
-  // Audio thread bumps when the producer-side try_push (broadcast or wave)
+  // 15.1-07b CR-09/CR-10 + Codex M-8: sample FIFO overflow counter.
+  // Audio thread bumps when the producer-side push (broadcast or wave)
   // fails because the run-thread consumer hasn't drained yet. 15.1-10 phase
   // verification asserts this == 0 post-UAT. Non-zero == architectural
   // defect (ring undersized for the worst-case run-thread drain latency).
@@ -638,7 +886,7 @@ public:
 
 
   // 15.1-07b CR-09: drain per-channel mirror block_q rings on the run thread,
-  // forwarding their BlockRecord payloads into the legacy lc->m_bq.AddBlock
+  // forwarding their blocks into the legacy lc->m_bq.AddBlock
   // path so the existing encoder consumer at NJClient::Run() lines 1626-1840
   // remains untouched. Producer = audio thread (process_samples / on_new_interval
   // try_push); consumer = run thread (this method). Called from
@@ -646,14 +894,17 @@ public:
   // (token call site to satisfy the plan's juce/NinjamRunThread.cpp grep gate).
   void drainBroadcastBlocks();
 
-  // 15.1-07b CR-10: drain m_wave_block_q on the run thread, forwarding into
-  // the legacy m_wavebq->AddBlock path so the existing wave drain at
-  // NJClient::Run() line 1073 remains untouched.
-  void drainWaveBlocks();
-
 protected:
   double output_peaklevel[2];
 
+  // See GetOutputChannelsWritten(). Reset at the top of AudioProc.
+  uint64_t m_outch_written = 0;
+  void markOutputWritten(int idx, int nch)
+  {
+    for (int c = idx; c < idx + nch; ++c)
+      if (c >= 0 && c < 64) m_outch_written |= (uint64_t)1 << c;
+  }
+
   void _reinit();
 
   void makeFilenameFromGuid(WDL_String *s, unsigned char *guid);
@@ -674,10 +925,6 @@ protected:
   int m_max_localch;
   int m_connection_keepalive;
   FILE *m_logFile;
-#ifndef NJCLIENT_NO_XMIT_SUPPORT
-  FILE *m_oggWrite;
-  I_NJEncoder *m_oggComp;
-#endif
 
   WDL_String m_user, m_pass, m_host;
   unsigned char m_auth_challenge[8] = {};  // saved for encryption key derivation (Phase 15)
@@ -705,16 +952,15 @@ protected:
 
   DecodeState *start_decode(unsigned char *guid, int chanflags, unsigned int fourcc, DecodeMediaBuffer *decbuf);
 
-  BufferQueue *m_wavebq;
-
   WDL_PtrList<Local_Channel> m_locchannels;
 
   // 15.1-07a CR-01: mixInChannel takes a STABLE SLOT into m_remoteuser_mirror,
-  // not a RemoteUser*. The audio thread reads ONLY mirror fields; no
-  // dereference of run-thread-owned RemoteUser / RemoteUser_Channel objects
-  // (Codex HIGH-2). DecodeState* pointer-shuffle operates entirely on the
-  // mirror's RemoteUserChannelMirror::ds / next_ds.
-  void mixInChannel(int slot, int chanidx,
+  // not a RemoteUser*, plus that slot's channel mirror (from RemoteMixList).
+  // The audio thread reads ONLY mirror fields; no dereference of
+  // run-thread-owned RemoteUser / RemoteUser_Channel objects (Codex HIGH-2).
+  // DecodeState* pointer-shuffle operates entirely on the mirror's
+  // RemoteUserChannelMirror::ds / next_ds.
+  void mixInChannel(int slot, int chanidx, RemoteUserChannelMirror& chan_mirror,
                     bool muted, float vol, float pan, float **outbuf, int out_channel,
                     int len, int srate, int outnch, int offs, double vudecay, bool isPlaying, bool isSeek, double playPos);
 
@@ -723,12 +969,128 @@ protected:
   WDL_PtrList<RemoteUser> m_remoteusers;
   WDL_PtrList<RemoteDownload> m_downloads;
 
+  // O(1) lookups shadowing the two lists above (hash_index.h): downloads by
+  // transfer GUID for every interval write, users by name for every server
+  // message that names one. Updated wherever the lists are; m_users_by_name
+  // under m_users_cs like m_remoteusers. The lists stay authoritative for
+  // order and iteration.
+  struct DownloadByGuid {
+    typedef const unsigned char *Key;
+    static uint32_t hash(Key k);
+    static Key key(const RemoteDownload *v);
+    static bool equal(const RemoteDownload *v, Key k);
+  };
+  struct UserByName {
+    typedef const char *Key;
+    static uint32_t hash(Key k);
+    static Key key(const RemoteUser *v);
+    static bool equal(const RemoteUser *v, Key k);
+  };
+  jamwide::PtrHashIndex<RemoteDownload, DownloadByGuid> m_downloads_by_guid;
+  jamwide::PtrHashIndex<RemoteUser, UserByName> m_users_by_name;
+  time_t m_download_reap_time = 0;
+  void reapStaleDownloads(time_t now);
+
+  // Zero-copy interval-write receive. Armed on m_netcon once the auth reply
+  // has settled encryption; Net_Connection then hands each fully buffered
+  // interval-write payload from the socket ring straight to the matching
+  // RemoteDownload (no Net_Message payload copy). That happens mid-parse,
+  // ahead of messages still in the receive queue, so the sink only stores
+  // the bytes; the interval-write handler starts playback in message
+  // order. Run thread only.
+  class DownloadRecvSink : public Net_DirectRecvSink
+  {
+  public:
+    explicit DownloadRecvSink(NJClient *client) : m_client(client) { }
+    bool directRecvBegin(const unsigned char *prefix, int len) override;
+    void directRecvData(const void *data, int len) override;
+  private:
+    NJClient *m_client;
+    RemoteDownload *m_target = nullptr;
+  };
+  DownloadRecvSink m_download_sink{this};
+
   WDL_HeapBuf tmpblock;
 
+  // Adaptive upload bitrate state. m_abr and the m_abr_* sampling fields are
+  // run-thread only; the m_abr_stat_* atomics are the published telemetry
+  // read by GetAdaptiveBitrateStats (relaxed, observability only).
+  void updateAdaptiveBitrate();
+  int  adaptiveChannelBitrate(const Local_Channel *lc) const;
+  jamwide::AdaptiveBitrateController m_abr;
+  int64_t  m_abr_last_eval_ms = 0;
+  int      m_abr_sendq_bytes_peak = 0;
+  int      m_abr_sendq_msgs_peak = 0;
+  unsigned long long m_abr_bytes_sent_mark = 0;
+  std::atomic<int>      m_abr_stat_percent{100};
+  std::atomic<int>      m_abr_stat_sendq_bytes{0};
+  std::atomic<int>      m_abr_stat_sendq_msgs{0};
+  std::atomic<int>      m_abr_stat_recv_gap_ms{0};
+  std::atomic<uint64_t> m_abr_stat_bytes_sent{0};
+  std::atomic<uint64_t> m_abr_stat_step_downs{0};
+  std::atomic<uint64_t> m_abr_stat_step_ups{0};
+
+  std::atomic<uint64_t> m_net_stat_msgs{0};
+  std::atomic<int>      m_net_stat_max_batch{0};
+  std::atomic<uint64_t> m_net_stat_direct_msgs{0};
+  std::atomic<uint64_t> m_net_stat_direct_bytes{0};
+
+  // Run-thread scheduling. applyRunThreadSched() compares the config_thread_*
+  // / config_lock_memory atomics with what it applied last (run-thread-only
+  // copies below) and publishes the outcome into the m_sched_stat_* atomics.
+  void applyRunThreadSched();
+  void setHotMemoryLocked(bool lock);
+  jamwide::ThreadSchedConfig m_sched_applied;   // starts at the defaults: nothing to apply
+  bool m_mem_locked = false;
+  int  m_mem_locked_fifos = 0;   // m_sample_fifo_allocs when last (re)locked
+
+  // Allocate m_locchan_mirror[ch].block_q on first use (non-audio thread,
+  // m_locchan_cs held; before the AddedUpdate is published). Bumps
+  // m_sample_fifo_allocs so a memory lock in force picks the new storage up.
+  void ensureLocalChannelFifo(int ch);
+  std::atomic<int> m_sample_fifo_allocs{0};
+  std::atomic<int>      m_sched_stat_policy{jamwide::kSchedDefault};
+  std::atomic<int>      m_sched_stat_priority{0};
+  std::atomic<int>      m_sched_stat_req_policy{jamwide::kSchedDefault};
+  std::atomic<int>      m_sched_stat_req_priority{0};
+  std::atomic<int>      m_sched_stat_error{0};
+  std::atomic<int>      m_sched_stat_affinity_error{0};
+  std::atomic<uint64_t> m_sched_stat_cpumask{0};
+  std::atomic<uint64_t> m_sched_stat_locked_bytes{0};
+  std::atomic<int>      m_sched_stat_lock_error{0};
+
+  // Per-(slot, channel) download arrival trackers. Written by the run thread
+  // on every interval BEGIN/WRITE, read by GetArrivalStatsSnapshot; both
+  // under m_arrival_cs (never taken by the audio thread). Reset when a slot
+  // is (re)allocated.
+  mutable WDL_Mutex m_arrival_cs;
+  jamwide::ArrivalJitterTracker m_arrival[MAX_PEERS][MAX_USER_CHANNELS];
+  int64_t nominalIntervalMs() const;
+
+  // Session archive writer. Touched by the run thread (RemoteDownload::Close
+  // via archiveInterval) and by SetSessionArchiveFile; both under
+  // m_archive_cs. Never taken by the audio thread.
+  WDL_Mutex m_archive_cs;
+  jamwide::SessionArchiveWriter m_archive;
+  void archiveInterval(const char *user, int channel, const unsigned char *guid, unsigned int fourcc,
+                       int64_t start_ms, const void *data, int len);
+  int64_t archiveStartMs(bool remote);
+  void archivePath(WDL_String *s, const char *name);
+
+  // Archive export (ExportSessionArchive). The thread only reads the
+  // archive and writes its own files; it is joined by the next export,
+  // once finished, or by the destructor (after setting the cancel flag).
+  std::thread m_archive_export;
+  std::atomic<int> m_archive_export_state{ARCHIVE_EXPORT_NONE};
+  std::atomic<int> m_archive_export_files{0};
+  std::atomic<bool> m_archive_export_cancel{false};
+  void archiveExportMain(std::string path, int64_t from_ms, int64_t to_ms);
+
   // 15.1-05 CR-05/06/07: deferred-delete queue. Audio thread try_pushes
   // DecodeState*; run thread drainDeferredDelete() pops and runs ~DecodeState()
   // off-thread. Capacity 256 absorbs a worst-case interval-boundary burst
-  // (peers x channels x 2 next_ds slots) per spsc_payloads.h DEFERRED_DELETE_CAPACITY.
+  // (peers x channels x queued next_ds intervals) per spsc_payloads.h
+  // DEFERRED_DELETE_CAPACITY.
   jamwide::SpscRing<DecodeState*, jamwide::DEFERRED_DELETE_CAPACITY> m_deferred_delete_q;
 
   // 15.1-05 + Codex M-8: overflow counter. Audio thread increments on try_push
@@ -808,6 +1170,12 @@ protected:
   // Delete; see 15.1-MIRROR-AUDIT.md).
   RemoteUserMirror m_remoteuser_mirror[MAX_PEERS];
 
+  // Present channels of active peers with their combined mix parameters,
+  // rebuilt from m_remoteuser_mirror by drainRemoteUserUpdates() when an
+  // update touched them. Audio-thread only.
+  RemoteMixList m_remote_mix;
+  void rebuildRemoteMixList();
+
   // 15.1-07a CR-01: state-update queue. Run-thread mutators publish
   // RemoteUserUpdate variants here; audio thread drains at top of AudioProc
   // via drainRemoteUserUpdates(). Capacity 64 == MAX_PEERS — peer-churn is
@@ -819,9 +1187,37 @@ protected:
   // == 0 post-UAT. Relaxed semantics — observability only.
   std::atomic<uint64_t> m_remoteuser_update_overflows{0};
 
+  // Per-channel updates whose order matters to the audio thread
+  // (PeerChannelInfoUpdate, PeerChannelMaskUpdate, PeerNextDsUpdate,
+  // PeerCodecSwapUpdate) are published through publishOrdered(). One that
+  // finds m_remoteuser_update_q full waits here (run thread only), every
+  // later one queues behind it, and the list is retried in order at the top
+  // of each Run() instead of being leaked: a lost NextDs publish used to
+  // silence the channel for that interval, and a codec swap or channel info
+  // pushed past a waiting NextDs would apply to the wrong interval. Once the
+  // list holds kMaxPendingUpdates (the audio thread has stopped draining)
+  // the oldest entry is dropped, deleting its prepared interval if it has
+  // one. Entries for a peer are discarded when its PeerRemovedUpdate is
+  // published, so a reused slot never receives them.
+  static constexpr size_t kMaxPendingUpdates = 256;
+  std::vector<jamwide::RemoteUserUpdate> m_pending_updates;
+  void publishOrdered(const jamwide::RemoteUserUpdate& upd);
+  bool pushRemoteUpdate(const jamwide::RemoteUserUpdate& upd);
+  void flushPendingUpdates();
+  void discardPendingUpdates(int slot);
+
+  // Prefetch statistics (GetPrefetchStats). Run thread: NextDs publishes
+  // deferred to m_pending_updates, and prepared intervals dropped because
+  // that list was full. Audio thread: queued intervals evicted by a newer
+  // one at the configured depth. Relaxed.
+  std::atomic<uint64_t> m_next_ds_deferred{0};
+  std::atomic<uint64_t> m_next_ds_dropped{0};
+  std::atomic<uint64_t> m_prefetch_evictions{0};
+
   // Diagnostic counters for the 2026-05-02 RemoteUserMirror orphan-fields fix.
-  // Bumped at PeerChannelInfoUpdate publish (run thread) and apply (audio
-  // thread) sites. Relaxed atomics — purpose is falsifiable UAT readout, not
+  // Bumped when a PeerChannelInfoUpdate enters m_remoteuser_update_q (run
+  // thread, pushRemoteUpdate) and where it is applied (audio thread).
+  // Relaxed atomics — purpose is falsifiable UAT readout, not
   // synchronization. See .planning/debug/remote-channels-cutoff.md.
   std::atomic<uint64_t> m_chinfo_publishes_observed[MAX_PEERS][MAX_USER_CHANNELS]{};
   std::atomic<uint64_t> m_chinfo_applies_observed  [MAX_PEERS][MAX_USER_CHANNELS]{};
@@ -831,6 +1227,22 @@ protected:
   // GetDumpSamplesPeak. Relaxed atomic; observability only.
   std::atomic<int> m_dump_samples_peak[MAX_PEERS][MAX_USER_CHANNELS]{};
 
+  // Silence statistics (GetSilentIntervalCount / GetSilentBlocksSkipped).
+  // Audio-thread writes: mixInChannel per skipped block, on_new_interval
+  // per retired DecodeState that had blocks measured. Relaxed.
+  std::atomic<uint32_t> m_silent_intervals [MAX_PEERS][MAX_USER_CHANNELS]{};
+  std::atomic<uint32_t> m_scanned_intervals[MAX_PEERS][MAX_USER_CHANNELS]{};
+  std::atomic<uint64_t> m_silent_blocks_skipped{0};
+
+  // Interval-start priming (GetIntervalStartStats). Run thread, in
+  // start_decode: DecodeStates published with a full
+  // DecodeState::HEAD_FRAMES head vs. a short one (input ran dry first).
+  // Audio thread: boundary crossfades that still had to decode because the
+  // head was short. Relaxed.
+  std::atomic<uint64_t> m_decode_heads_primed{0};
+  std::atomic<uint64_t> m_decode_heads_short{0};
+  std::atomic<uint64_t> m_overlap_cold_decodes{0};
+
   // 15.1-07a + Codex HIGH-3: deferred-free queue for run-thread-owned
   // RemoteUser objects. The run thread enqueues a RemoteUser* ONLY AFTER:
   //   (a) it has pushed a PeerRemovedUpdate to m_remoteuser_update_q, AND
@@ -864,22 +1276,43 @@ protected:
   int  findRemoteUserSlot(RemoteUser* user) const;
   void releaseRemoteUserSlot(int slot);
 
-  // 15.1-07b CR-10: BlockRecord SPSC for the wavewrite/oggcomp output mix.
-  // Replaces the audio-thread m_wavebq->AddBlock site at process_samples:2182.
-  // Producer = audio thread (one push per processed block when waveWrite or
-  // m_oggWrite is on); consumer = run thread (drainWaveBlocks at the top of
-  // NJClient::Run()). N=32 because the wavewriter can lag further than the
-  // encoder (file I/O latency).
-  jamwide::SpscRing<jamwide::BlockRecord, 32> m_wave_block_q;
-
-  // 15.1-07b CR-09/CR-10 + Codex M-8: BlockRecord drop counter. Audio thread
-  // increments on try_push failure (queue full). 15.1-10 phase verification
+  // Master recording. The audio thread pushes the pre-master-volume mix in
+  // process_samples; the recorder's own thread encodes and writes it. Its
+  // ring (16 MB, ~43 s at 48 kHz) is allocated on the first recording and
+  // counted in m_sample_fifo_allocs so a memory lock picks it up. Drops
+  // are reported by GetMasterRecorderStats, not m_block_queue_drops.
+  jamwide::MasterRecorder m_master_rec;
+  template <class Sinks> bool startMasterRecorder(Sinks sinks);   // sink list or SinkOpener
+
+  // Stem recording. process_samples latches the generation for the block
+  // (m_stem_gen, 0 when off) and mixInChannel hands each decoded channel
+  // block to tapStem. Stem numbers are slot * MAX_USER_CHANNELS + channel,
+  // named from the userinfo handler (registerStemName) whether or not a
+  // recording is running. Its ring counts in m_sample_fifo_allocs too.
+  jamwide::StemRecorder m_stem_rec;
+  int m_stem_gen = 0;          // audio thread
+  int m_stem_block_offs = 0;   // audio thread: outbuf offset of the block
+  void tapStem(int slot, int chanidx, DecodeState *chan, float *sptr, int srcnch,
+               int needed, int srate, int len, int offs);
+  void registerStemName(int slot, int chanidx, const char *user, const char *chname);
+
+  // 15.1-07b CR-09/CR-10 + Codex M-8: sample FIFO drop counter. Audio thread
+  // increments on push failure (FIFO full). 15.1-10 phase verification
   // asserts this is 0 post-UAT. Non-zero means the run-thread drain didn't
   // keep pace with the audio-thread producer, which is an architectural
   // defect at this scale (5 minute populated-server session per phase
   // verification). Relaxed semantics — observability only.
   std::atomic<uint64_t> m_block_queue_drops{0};
 
+  // Run-thread readiness wait (WaitForActivity). The audio thread calls
+  // wakeRunThreadIfBroadcastPending() at the end of AudioProc so the encoder
+  // sees new broadcast blocks on the next run-thread pass rather than on the
+  // next poll timeout. m_bcast_wake_sent: set by the audio thread when it
+  // signals, cleared by drainBroadcastBlocks(); while set, no further wake.
+  jamwide::NetActivityWaiter m_run_waiter;
+  std::atomic<bool> m_bcast_wake_sent{false};
+  void wakeRunThreadIfBroadcastPending() noexcept;
+
   // 15.1-09 CR-08 + H-04 + Codex HIGH-1: sessionmode rearm requests from audio
   // thread → run thread. The current 15.1-07a refactor already collapses the
   // audio-thread sessionmode rearm to an early-return no-op (mixInChannel
@@ -898,11 +1331,11 @@ protected:
   // m_block_queue_drops. Relaxed — observability only.
   std::atomic<uint64_t> m_arm_request_drops{0};
 
-  // 15.1-09 + Codex HIGH-1: per-tick refill SPSC overflow counter. The
-  // refill loop drops at most CHUNK_BYTES per overflow event (it discards
-  // the bytes already read into the local stack buffer and continues at
-  // the file's next byte on the next tick — see refillSessionmodeBuffers
-  // in njclient.cpp). 15.1-10 asserts == 0 post-UAT.
+  // 15.1-09 + Codex HIGH-1: per-tick refill SPSC overflow counter. Since
+  // the refill loop copies from a mapping bounded by WriteSpace(), a short
+  // write loses nothing (the read position only advances by what the SPSC
+  // took) — see refillSessionmodeBuffers in njclient.cpp. 15.1-10 asserts
+  // == 0 post-UAT.
   std::atomic<uint64_t> m_sessionmode_refill_drops{0};
 
   // 15.1-09 + Codex HIGH-1: run-thread-private bookkeeping of active
@@ -916,15 +1349,20 @@ protected:
   // these states, NEVER `fread(decode_fp)`.
   //
   // Run-thread-only access; protected by NJClient's existing run-thread
-  // serialization (NinjamRunThread holds processor.getClientLock() during
-  // the run-loop body; m_users_cs would be redundant but is still acquired
+  // serialization (NinjamRunThread is the only thread that calls Run() or
+  // mutates the client; m_users_cs would be redundant but is still acquired
   // inside the DOWNLOAD_INTERVAL_BEGIN handler which adds entries here).
   // The forward-declared DecodeMediaBuffer is sufficient — this struct
   // only stores a pointer, never dereferences.
+  //
+  // The file is read through a read-only mapping (interval_store.h): the
+  // FILE* from start_decode is mapped and closed at attach time, and the
+  // refill loop copies from map->data() + pos with no fread.
   struct SessionmodeFileReader {
-      FILE*               file = nullptr;     // owned here on the run thread
+      jamwide::MappedIntervalFile* map = nullptr;  // owned here on the run thread
+      size_t              pos = 0;            // next unread byte in map
       DecodeMediaBuffer*  buffer = nullptr;   // refcounted; same instance the audio thread reads
-      bool                eof = false;        // set when fread returns 0
+      bool                eof = false;        // set once pos reaches map->size()
   };
   std::vector<SessionmodeFileReader> m_sessionmode_file_readers;
 
@@ -984,11 +1422,10 @@ public:
   }
 
   // 15.1-09 + Codex HIGH-1: refill SPSC drop counter accessor. Bumped by
-  // refillSessionmodeBuffers when the per-file DecodeMediaBuffer's SPSC is
-  // full (audio thread has not drained recently). 15.1-10 asserts == 0
-  // post-UAT. A non-zero value indicates the audio thread's runDecode is
-  // not consuming fast enough OR the run thread's refill cadence is too
-  // bursty — either is an architectural defect.
+  // refillSessionmodeBuffers when the per-file DecodeMediaBuffer's SPSC
+  // accepted less than its reported WriteSpace(). 15.1-10 asserts == 0
+  // post-UAT. A non-zero value means a second producer is writing into a
+  // sessionmode buffer — an architectural defect.
   uint64_t GetSessionmodeRefillDropCount() const noexcept {
       return m_sessionmode_refill_drops.load(std::memory_order_relaxed);
   }
@@ -1003,13 +1440,13 @@ public:
   // wired so a future sessionmode re-enable doesn't have to re-architect.
   void drainArmRequests();
 
-  // 15.1-09 + Codex HIGH-1: per-tick refill loop. Reads bytes from every
-  // active SessionmodeFileReader's FILE* and pushes them into the
+  // 15.1-09 + Codex HIGH-1: per-tick refill loop. Copies bytes from every
+  // active SessionmodeFileReader's mapping and pushes them into the
   // corresponding DecodeMediaBuffer (lock-free SPSC push from 15.1-07c).
   // The audio thread's runDecode → decode_buf->Read path is fed by THIS
   // method; without it, the buffer would drain and playback would silence
   // on file-backed sessions. Removes entries whose buffer's refcnt drops
-  // to 1 (the audio side has Released its share — we can fclose and let go).
+  // to 1 (the audio side has Released its share — we can unmap and let go).
   void refillSessionmodeBuffers();
 
   // 15.1-09 + Codex HIGH-1: helper invoked from the run-thread side of
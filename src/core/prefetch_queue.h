@@ -0,0 +1,94 @@
+/*
+    JamWide Plugin - prefetch_queue.h
+    Per-channel lookahead queue of prepared intervals for the audio thread
+
+    Copyright (C) 2026 JamWide Contributors
+    Licensed under GPLv2+
+
+    Each remote channel on the audio-thread mirror used to hold the playing
+    DecodeState plus a fixed next_ds[2]: a third interval arriving before
+    the boundary evicted the oldest, and every advance shuffled both slots.
+    When the run thread fell behind and then published a burst (or the
+    mixer skipped a boundary), prepared intervals were thrown away and the
+    channel went silent for the intervals they carried.
+
+    PrefetchQueue is a fixed-capacity FIFO of those prepared pointers:
+      - push() appends and, once `depth` entries are queued, first hands
+        the oldest to the caller to defer-delete. depth is the
+        configured lookahead (NJClient::config_prefetch_intervals), clamped
+        to [1, Capacity], and may change between calls.
+      - pop() hands the next interval to on_new_interval / the llmode
+        advance in O(1): a head index moves, nothing is shuffled.
+    Every entry was built by start_decode on the run thread, which already
+    parses the stream headers and decodes until the codec has output
+    (Available() > 0), so the swap itself does no codec work.
+
+    Pure C++, no NJClient dependency, so tests/test_prefetch_queue.cpp can
+    drive it directly. Not thread-safe: the audio thread is the only reader
+    and writer (the PeerNextDsUpdate apply and the interval advance).
+*/
+
+#ifndef PREFETCH_QUEUE_H
+#define PREFETCH_QUEUE_H
+
+namespace jamwide {
+
+template <typename T, int Capacity>
+class PrefetchQueue {
+    static_assert(Capacity > 0 && Capacity < 256, "PrefetchQueue indices are bytes");
+
+public:
+    static constexpr int kCapacity = Capacity;
+
+    bool empty() const noexcept { return count_ == 0; }
+    int  size() const noexcept { return count_; }
+
+    // Oldest queued entry (the next interval to play), or nullptr.
+    T* front() const noexcept { return count_ ? slots_[head_] : nullptr; }
+
+    // i-th entry from the front, or nullptr past the end.
+    T* at(int i) const noexcept
+    {
+        return (i >= 0 && i < count_) ? slots_[(head_ + i) % Capacity] : nullptr;
+    }
+
+    // Removes and returns the front entry (nullptr when empty).
+    T* pop() noexcept
+    {
+        if (!count_) return nullptr;
+        T* p = slots_[head_];
+        slots_[head_] = nullptr;
+        head_ = (unsigned char)((head_ + 1) % Capacity);
+        --count_;
+        return p;
+    }
+
+    // Appends p after handing the oldest entries to evict(T*) until fewer
+    // than `depth` remain. Returns the number evicted. A null p is not
+    // queued and evicts nothing.
+    template <typename Evict>
+    int push(T* p, int depth, Evict&& evict)
+    {
+        if (!p) return 0;
+        if (depth < 1) depth = 1;
+        if (depth > Capacity) depth = Capacity;
+        int evicted = 0;
+        while (count_ >= depth)
+        {
+            evict(pop());
+            ++evicted;
+        }
+        slots_[(head_ + count_) % Capacity] = p;
+        ++count_;
+        return evicted;
+    }
+
+private:
+    T* slots_[Capacity] = {};
+    unsigned char head_ = 0;
+    unsigned char count_ = 0;
+};
+
+} // namespace jamwide
+
+#endif // PREFETCH_QUEUE_H
@@ -0,0 +1,117 @@
+/*
+    JamWide Plugin - render_quantum.h
+    Fixed-quantum render adapter between host blocks and NJClient::AudioProc
+
+    Copyright (C) 2026 JamWide Contributors
+    Licensed under GPLv2+
+
+    NJClient::AudioProc does its work in whatever block size the host hands
+    the processor: decode pulls, fade windows, encoder BlockRecords and the
+    per-call fixed costs (mirror drains, update-queue polls, peak scans) all
+    scale with calls, not samples. A host running 32-frame buffers pays those
+    fixed costs eight times as often as one running 256.
+
+    RenderQuantizer re-frames the host stream into fixed blocks of Q frames.
+    Host input is appended to an input FIFO; whenever Q frames are there, the
+    render callback runs once on exactly Q frames and its output becomes the
+    output FIFO the host reads from. Classic double-FIFO scheme: output lags
+    input by exactly Q frames for any host block size (the processor reports
+    Q to the host via setLatencySamples), and every render call sees the same
+    block size, so CPU per sample is flat across host buffer sizes.
+
+    Host blocks may be larger or smaller than Q, and need not be multiples of
+    it. Storage is allocated in configure() (prepareToPlay); process() never
+    allocates. Audio-thread only; not thread-safe.
+
+    Pure C++ with no JUCE/NJClient dependency, so
+    tests/test_render_quantum.cpp can drive it directly.
+*/
+
+#ifndef RENDER_QUANTUM_H
+#define RENDER_QUANTUM_H
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+namespace jamwide {
+
+class RenderQuantizer {
+public:
+    static constexpr int kMaxChannels = 64;
+
+    // quantum <= 0 disables the adapter (process() must not be called then).
+    void configure(int numInputs, int numOutputs, int quantum)
+    {
+        m_in_ch = std::min(std::max(numInputs, 0), kMaxChannels);
+        m_out_ch = std::min(std::max(numOutputs, 0), kMaxChannels);
+        m_q = std::max(quantum, 0);
+        m_in.assign((size_t)m_in_ch * m_q, 0.0f);
+        m_out.assign((size_t)m_out_ch * m_q, 0.0f);
+        for (int c = 0; c < m_in_ch; ++c) m_in_ptr[c] = m_in.data() + (size_t)c * m_q;
+        for (int c = 0; c < m_out_ch; ++c) m_out_ptr[c] = m_out.data() + (size_t)c * m_q;
+        m_fill = 0;
+        m_renders = 0;
+    }
+
+    int quantum() const { return m_q; }
+    bool enabled() const { return m_q > 0; }
+    int latency() const { return m_q; }
+    unsigned long long renders() const { return m_renders; }
+
+    // Drop buffered audio (e.g. after a disconnect) so stale output is not
+    // replayed. The latency is unchanged.
+    void reset()
+    {
+        std::fill(m_in.begin(), m_in.end(), 0.0f);
+        std::fill(m_out.begin(), m_out.end(), 0.0f);
+        m_fill = 0;
+    }
+
+    /**
+     * Push `n` host frames through. `in` has numInputs channels (nullptr
+     * entries read as silence), `out` numOutputs channels; `out` may alias
+     * `in`. render(float** in, float** out, int q) is called
+     * once per completed quantum and must fill all q frames of every output
+     * channel.
+     */
+    template <typename Render>
+    void process(const float* const* in, float* const* out, int n, Render&& render)
+    {
+        int pos = 0;
+        while (pos < n)
+        {
+            const int k = std::min(n - pos, m_q - m_fill);
+            for (int c = 0; c < m_in_ch; ++c)
+            {
+                if (in[c]) std::memcpy(m_in_ptr[c] + m_fill, in[c] + pos, sizeof(float) * (size_t)k);
+                else std::memset(m_in_ptr[c] + m_fill, 0, sizeof(float) * (size_t)k);
+            }
+            for (int c = 0; c < m_out_ch; ++c)
+                std::memcpy(out[c] + pos, m_out_ptr[c] + m_fill, sizeof(float) * (size_t)k);
+            m_fill += k;
+            pos += k;
+            if (m_fill == m_q)
+            {
+                render(m_in_ptr, m_out_ptr, m_q);
+                ++m_renders;
+                m_fill = 0;
+            }
+        }
+    }
+
+private:
+    int m_in_ch = 0;
+    int m_out_ch = 0;
+    int m_q = 0;
+    int m_fill = 0;
+    unsigned long long m_renders = 0;
+    std::vector<float> m_in;
+    std::vector<float> m_out;
+    float* m_in_ptr[kMaxChannels] = {};
+    float* m_out_ptr[kMaxChannels] = {};
+};
+
+} // namespace jamwide
+
+#endif // RENDER_QUANTUM_H
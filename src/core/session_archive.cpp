@@ -0,0 +1,390 @@
+/*
+    JamWide Plugin - session_archive.cpp
+    Single-file, time-indexed multitrack session archive (see session_archive.h)
+
+    Copyright (C) 2026 JamWide Contributors
+    Licensed under GPLv2+
+*/
+
+#include "session_archive.h"
+
+#include <string.h>
+#include <algorithm>
+
+namespace jamwide {
+
+namespace {
+
+constexpr uint32_t kVersion = 1;
+constexpr size_t kHeaderSize = 16;
+constexpr size_t kChunkHeaderSize = 8;
+constexpr size_t kFooterSize = 16;
+constexpr size_t kIntervalHeaderSize = 36;  // track..length_ms, before payload
+constexpr size_t kIndexEntrySize = 52;
+constexpr int kMaxTracks = 0xffff;
+
+constexpr uint32_t fourcc(char a, char b, char c, char d)
+{
+    return (uint32_t)(unsigned char)a | ((uint32_t)(unsigned char)b << 8) |
+           ((uint32_t)(unsigned char)c << 16) | ((uint32_t)(unsigned char)d << 24);
+}
+
+constexpr uint32_t kTagHeader = fourcc('J','W','S','A');
+constexpr uint32_t kTagTrack  = fourcc('T','R','A','K');
+constexpr uint32_t kTagIntv   = fourcc('I','N','T','V');
+constexpr uint32_t kTagIndex  = fourcc('I','N','D','X');
+constexpr uint32_t kTagFooter = fourcc('J','W','S','X');
+
+// Little-endian put/get. The archive is exchanged between machines, so
+// never memcpy structs.
+struct Out {
+    std::vector<unsigned char> b;
+    void u8(unsigned v)  { b.push_back((unsigned char)v); }
+    void u16(unsigned v) { u8(v & 0xff); u8((v >> 8) & 0xff); }
+    void u32(uint32_t v) { u16(v & 0xffff); u16(v >> 16); }
+    void u64(uint64_t v) { u32((uint32_t)v); u32((uint32_t)(v >> 32)); }
+    void raw(const void* p, size_t n) { b.insert(b.end(), (const unsigned char*)p, (const unsigned char*)p + n); }
+};
+
+struct In {
+    const unsigned char* p;
+    size_t left;
+    bool ok = true;
+    bool need(size_t n) { if (left < n) ok = false; return ok; }
+    unsigned u8()  { if (!need(1)) return 0; unsigned v = p[0]; p++; left--; return v; }
+    unsigned u16() { unsigned lo = u8(); return lo | (u8() << 8); }
+    uint32_t u32() { uint32_t lo = u16(); return lo | ((uint32_t)u16() << 16); }
+    uint64_t u64() { uint64_t lo = u32(); return lo | ((uint64_t)u32() << 32); }
+    const unsigned char* raw(size_t n) { if (!need(n)) return nullptr; const unsigned char* r = p; p += n; left -= n; return r; }
+};
+
+void putEntry(Out& o, const SessionArchiveEntry& e)
+{
+    o.u64((uint64_t)e.start_ms);
+    o.u32(e.length_ms);
+    o.u16(e.track);
+    o.u16(0);
+    o.u32(e.fourcc);
+    o.raw(e.guid, 16);
+    o.u64(e.offset);
+    o.u32(e.size);
+    o.u32(0);
+}
+
+SessionArchiveEntry getEntry(In& in)
+{
+    SessionArchiveEntry e;
+    e.start_ms = (int64_t)in.u64();
+    e.length_ms = in.u32();
+    e.track = (uint16_t)in.u16();
+    in.u16();
+    e.fourcc = in.u32();
+    const unsigned char* g = in.raw(16);
+    if (g) memcpy(e.guid, g, 16);
+    e.offset = in.u64();
+    e.size = in.u32();
+    in.u32();
+    return e;
+}
+
+} // namespace
+
+// ---------------------------------------------------------------------------
+// Writer
+// ---------------------------------------------------------------------------
+
+bool SessionArchiveWriter::open(const char* path)
+{
+    close();
+    // Archives grow for the whole session; start with room for a few
+    // minutes of a small room so early intervals don't remap every time.
+    if (!m_file.openWrite(path, 4 * 1024 * 1024)) return false;
+
+    Out h;
+    h.u32(kTagHeader);
+    h.u32(kVersion);
+    h.u32(0);
+    h.u32(0);
+    if (!m_file.append(h.b.data(), h.b.size())) return false;
+    return true;
+}
+
+bool SessionArchiveWriter::appendChunk(uint32_t tag, const void* a, size_t alen, const void* b, size_t blen)
+{
+    if (alen + blen > 0xffffffffu) return false;
+    Out h;
+    h.u32(tag);
+    h.u32((uint32_t)(alen + blen));
+    return m_file.append(h.b.data(), h.b.size()) &&
+           m_file.append(a, alen) &&
+           (!blen || m_file.append(b, blen));
+}
+
+int SessionArchiveWriter::track(const char* user, int channel)
+{
+    if (!isOpen()) return -1;
+    if (!user) user = "";
+    for (size_t t = 0; t < m_tracks.size(); t++)
+        if (m_tracks[t].channel == channel && m_tracks[t].user == user) return (int)t;
+    if ((int)m_tracks.size() >= kMaxTracks) return -1;
+
+    SessionArchiveTrack tr;
+    tr.user = user;
+    tr.channel = channel;
+    const size_t name_len = std::min<size_t>(tr.user.size(), 0xffff);
+
+    Out body;
+    body.u16((unsigned)m_tracks.size());
+    body.u16((unsigned)channel & 0xffff);
+    body.u16((unsigned)name_len);
+    body.raw(tr.user.data(), name_len);
+    if (!appendChunk(kTagTrack, body.b.data(), body.b.size())) return -1;
+
+    m_tracks.push_back(tr);
+    return (int)m_tracks.size() - 1;
+}
+
+bool SessionArchiveWriter::appendInterval(int track, const unsigned char guid[16], unsigned int fcc,
+                                          int64_t start_ms, uint32_t length_ms, const void* data, size_t len)
+{
+    if (!isOpen() || track < 0 || track >= (int)m_tracks.size() || !data || !len) return false;
+
+    SessionArchiveEntry e;
+    e.start_ms = start_ms;
+    e.length_ms = length_ms;
+    e.track = (uint16_t)track;
+    e.fourcc = fcc;
+    if (guid) memcpy(e.guid, guid, 16);
+    e.offset = m_file.size() + kChunkHeaderSize + kIntervalHeaderSize;
+    e.size = (uint32_t)len;
+
+    Out body;
+    body.u16(e.track);
+    body.u16(0);
+    body.u32(e.fourcc);
+    body.raw(e.guid, 16);
+    body.u64((uint64_t)e.start_ms);
+    body.u32(e.length_ms);
+    if (!appendChunk(kTagIntv, body.b.data(), body.b.size(), data, len)) return false;
+
+    m_index.push_back(e);
+    return true;
+}
+
+bool SessionArchiveWriter::close()
+{
+    if (!isOpen()) return false;
+
+    Out body;
+    body.u32((uint32_t)m_tracks.size());
+    for (const SessionArchiveTrack& t : m_tracks) {
+        const size_t name_len = std::min<size_t>(t.user.size(), 0xffff);
+        body.u16((unsigned)t.channel & 0xffff);
+        body.u16((unsigned)name_len);
+        body.raw(t.user.data(), name_len);
+    }
+    body.u32((uint32_t)m_index.size());
+    for (const SessionArchiveEntry& e : m_index) putEntry(body, e);
+
+    const uint64_t indx_offset = m_file.size();
+    bool ok = appendChunk(kTagIndex, body.b.data(), body.b.size());
+    if (ok) {
+        Out f;
+        f.u32(kTagFooter);
+        f.u32(0);
+        f.u64(indx_offset);
+        ok = m_file.append(f.b.data(), f.b.size());
+    }
+    m_file.close();
+    m_tracks.clear();
+    m_index.clear();
+    return ok;
+}
+
+// ---------------------------------------------------------------------------
+// Reader
+// ---------------------------------------------------------------------------
+
+bool SessionArchiveReader::open(FILE* fp)
+{
+    close();
+    if (!m_map.mapReadOnly(fp) || m_map.size() < kHeaderSize) { close(); return false; }
+
+    In h{ m_map.data(), kHeaderSize };
+    if (h.u32() != kTagHeader || h.u32() != kVersion) { close(); return false; }
+
+    bool ok = false;
+    if (m_map.size() >= kHeaderSize + kFooterSize) {
+        In f{ m_map.data() + m_map.size() - kFooterSize, kFooterSize };
+        if (f.u32() == kTagFooter) {
+            f.u32();
+            ok = loadIndex(f.u64());
+        }
+    }
+    if (!ok) {
+        m_tracks.clear();
+        m_entries.clear();
+        m_recovered = true;
+        ok = scanChunks();
+    }
+    if (!ok) { close(); return false; }
+
+    buildLookups();
+    return true;
+}
+
+void SessionArchiveReader::close()
+{
+    m_map.close();
+    m_tracks.clear();
+    m_entries.clear();
+    m_by_track.clear();
+    m_length_ms = 0;
+    m_recovered = false;
+}
+
+bool SessionArchiveReader::loadIndex(uint64_t indx_offset)
+{
+    const size_t sz = m_map.size();
+    if (indx_offset < kHeaderSize || indx_offset + kChunkHeaderSize > sz - kFooterSize) return false;
+
+    In c{ m_map.data() + indx_offset, sz - kFooterSize - (size_t)indx_offset };
+    if (c.u32() != kTagIndex) return false;
+    const uint32_t body_len = c.u32();
+    if (!c.ok || body_len > c.left) return false;
+
+    In in{ c.p, body_len };
+    const uint32_t ntracks = in.u32();
+    for (uint32_t t = 0; in.ok && t < ntracks; t++) {
+        SessionArchiveTrack tr;
+        tr.channel = (int)in.u16();
+        const unsigned name_len = in.u16();
+        const unsigned char* name = in.raw(name_len);
+        if (name) tr.user.assign((const char*)name, name_len);
+        m_tracks.push_back(tr);
+    }
+    const uint32_t n = in.u32();
+    if (!in.ok || (uint64_t)n * kIndexEntrySize > in.left) return false;
+    m_entries.reserve(n);
+    for (uint32_t i = 0; i < n; i++) {
+        SessionArchiveEntry e = getEntry(in);
+        if (e.track >= m_tracks.size() || e.offset + e.size > indx_offset) return false;
+        m_entries.push_back(e);
+    }
+    return in.ok;
+}
+
+bool SessionArchiveReader::scanChunks()
+{
+    const size_t sz = m_map.size();
+    size_t pos = kHeaderSize;
+    while (pos + kChunkHeaderSize <= sz) {
+        In c{ m_map.data() + pos, kChunkHeaderSize };
+        const uint32_t tag = c.u32();
+        const uint32_t body_len = c.u32();
+        if (body_len > sz - pos - kChunkHeaderSize) break;  // torn write
+        In body{ m_map.data() + pos + kChunkHeaderSize, body_len };
+
+        if (tag == kTagTrack) {
+            const unsigned id = body.u16();
+            SessionArchiveTrack tr;
+            tr.channel = (int)body.u16();
+            const unsigned name_len = body.u16();
+            const unsigned char* name = body.raw(name_len);
+            if (!body.ok || id != m_tracks.size()) break;
+            tr.user.assign((const char*)name, name_len);
+            m_tracks.push_back(tr);
+        } else if (tag == kTagIntv) {
+            SessionArchiveEntry e;
+            e.track = (uint16_t)body.u16();
+            body.u16();
+            e.fourcc = body.u32();
+            const unsigned char* g = body.raw(16);
+            e.start_ms = (int64_t)body.u64();
+            e.length_ms = body.u32();
+            if (!body.ok || !g || e.track >= m_tracks.size()) break;
+            memcpy(e.guid, g, 16);
+            e.offset = pos + kChunkHeaderSize + kIntervalHeaderSize;
+            e.size = body_len - (uint32_t)kIntervalHeaderSize;
+            m_entries.push_back(e);
+        } else if (tag == kTagIndex) {
+            // trailing index from a completed archive; the entries are
+            // already known from the INTV chunks
+        } else {
+            break;  // reserved zero tail left by a crash, or garbage
+        }
+        pos += kChunkHeaderSize + body_len;
+    }
+    return true;
+}
+
+void SessionArchiveReader::buildLookups()
+{
+    std::stable_sort(m_entries.begin(), m_entries.end(),
+                     [](const SessionArchiveEntry& a, const SessionArchiveEntry& b) {
+                         if (a.start_ms != b.start_ms) return a.start_ms < b.start_ms;
+                         return a.track < b.track;
+                     });
+    m_by_track.assign(m_tracks.size(), std::vector<int>());
+    m_length_ms = 0;
+    for (size_t i = 0; i < m_entries.size(); i++) {
+        m_by_track[m_entries[i].track].push_back((int)i);
+        m_length_ms = std::max(m_length_ms, m_entries[i].endMs());
+    }
+}
+
+int SessionArchiveReader::findTrack(const char* user, int channel) const
+{
+    for (size_t t = 0; t < m_tracks.size(); t++)
+        if (m_tracks[t].channel == channel && m_tracks[t].user == (user ? user : "")) return (int)t;
+    return -1;
+}
+
+int SessionArchiveReader::findAt(int track, int64_t ms) const
+{
+    if (track < 0 || track >= (int)m_by_track.size()) return -1;
+    const std::vector<int>& v = m_by_track[track];
+    // last entry on this track starting at or before ms
+    auto it = std::upper_bound(v.begin(), v.end(), ms,
+                               [this](int64_t t, int idx) { return t < m_entries[idx].start_ms; });
+    if (it == v.begin()) return -1;
+    const int idx = *(it - 1);
+    return ms < m_entries[idx].endMs() ? idx : -1;
+}
+
+size_t SessionArchiveReader::firstStartingAt(int64_t ms) const
+{
+    auto it = std::lower_bound(m_entries.begin(), m_entries.end(), ms,
+                               [](const SessionArchiveEntry& e, int64_t t) { return e.start_ms < t; });
+    return (size_t)(it - m_entries.begin());
+}
+
+size_t SessionArchiveReader::trackSize(int track) const
+{
+    if (track < 0 || track >= (int)m_by_track.size()) return 0;
+    return m_by_track[track].size();
+}
+
+size_t SessionArchiveReader::trackSeek(int track, int64_t ms) const
+{
+    if (track < 0 || track >= (int)m_by_track.size()) return 0;
+    const std::vector<int>& v = m_by_track[track];
+    auto it = std::upper_bound(v.begin(), v.end(), ms,
+                               [this](int64_t t, int idx) { return t < m_entries[idx].start_ms; });
+    if (it != v.begin() && ms < m_entries[*(it - 1)].endMs()) --it;
+    return (size_t)(it - v.begin());
+}
+
+int SessionArchiveReader::trackEntry(int track, size_t pos) const
+{
+    if (track < 0 || track >= (int)m_by_track.size() || pos >= m_by_track[track].size()) return -1;
+    return m_by_track[track][pos];
+}
+
+const unsigned char* SessionArchiveReader::payload(const SessionArchiveEntry& e) const
+{
+    if (!m_map.data() || e.offset + e.size > m_map.size()) return nullptr;
+    return m_map.data() + e.offset;
+}
+
+} // namespace jamwide
@@ -0,0 +1,161 @@
+/*
+    JamWide Plugin - session_archive.h
+    Single-file, time-indexed multitrack session archive
+
+    Copyright (C) 2026 JamWide Contributors
+    Licensed under GPLv2+
+
+    A recorded session used to be one file per interval, named by
+    NJClient::makeFilenameFromGuid, plus a clipsort log. Finding what plays at
+    time T means walking the log or, in session mode, the per-channel
+    ChannelSessionInfo lists. The session archive keeps everything in one
+    chunked file instead. The writer appends while the session runs and the
+    reader answers "what plays on track N at T" in O(log n).
+
+    Layout (all integers little-endian):
+
+      header   "JWSA" u32 version u32 flags u32 reserved          (16 bytes)
+      chunk    u32 tag u32 body_len body[body_len]                 (repeated)
+        'TRAK' u16 track u16 channel u16 name_len name[name_len]
+        'INTV' u16 track u16 0 u32 fourcc guid[16] i64 start_ms u32 length_ms
+               payload[body_len - kIntervalHeaderSize]
+        'INDX' u32 ntracks { u16 channel u16 name_len name }
+               u32 nentries { SessionArchiveEntry, kIndexEntrySize bytes }
+      footer   "JWSX" u32 0 u64 offset_of_INDX_chunk               (16 bytes)
+
+    Payloads are the interval's codec stream exactly as it came off the wire
+    or out of the local encoder (Vorbis/FLAC/Opus, identified by fourcc), so
+    it is already compressed and is never transcoded.
+
+    A track is one (user, channel) pair. Local channels are recorded under
+    the user name "local".
+
+    The writer goes through MappedIntervalFile (interval_store.h), so a live
+    append is a memcpy into a mapping whose file grows in doubling steps.
+    INDX and the footer are written by close(), which also trims the file.
+    If the process dies first, the file keeps the reserved zero-filled
+    tail; the reader rebuilds the index by walking the TRAK/INTV chunks and
+    stops at the first malformed or zero-filled chunk header, which is
+    where that tail begins.
+
+    Writer: run-thread only (NJClient serialises it under m_archive_cs).
+    Reader: immutable after open(); const methods may be called from any
+    thread.
+*/
+
+#ifndef SESSION_ARCHIVE_H
+#define SESSION_ARCHIVE_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+#include "interval_store.h"
+
+namespace jamwide {
+
+struct SessionArchiveEntry {
+    int64_t       start_ms = 0;    // session position the interval starts at
+    uint32_t      length_ms = 0;   // nominal interval length
+    uint16_t      track = 0;
+    uint32_t      fourcc = 0;
+    unsigned char guid[16] = {};
+    uint64_t      offset = 0;      // payload offset in the archive
+    uint32_t      size = 0;        // payload bytes
+
+    int64_t endMs() const { return start_ms + (int64_t)length_ms; }
+};
+
+struct SessionArchiveTrack {
+    std::string user;
+    int channel = 0;
+};
+
+class SessionArchiveWriter {
+public:
+    SessionArchiveWriter() = default;
+    ~SessionArchiveWriter() { close(); }
+    SessionArchiveWriter(const SessionArchiveWriter&) = delete;
+    SessionArchiveWriter& operator=(const SessionArchiveWriter&) = delete;
+
+    bool open(const char* path);
+    bool isOpen() const { return m_file.isOpen(); }
+
+    // Track id for (user, channel), adding a TRAK chunk the first time it is
+    // seen. Returns -1 if the archive is not open or the table is full.
+    int track(const char* user, int channel);
+
+    bool appendInterval(int track, const unsigned char guid[16], unsigned int fourcc,
+                        int64_t start_ms, uint32_t length_ms, const void* data, size_t len);
+
+    // Writes INDX + footer and truncates. Safe to call when not open.
+    bool close();
+
+    size_t intervals() const { return m_index.size(); }
+    uint64_t bytes() const { return m_file.size(); }
+
+private:
+    bool appendChunk(uint32_t tag, const void* a, size_t alen, const void* b = nullptr, size_t blen = 0);
+
+    MappedIntervalFile m_file;
+    std::vector<SessionArchiveTrack> m_tracks;
+    std::vector<SessionArchiveEntry> m_index;
+};
+
+class SessionArchiveReader {
+public:
+    // Map and index an archive. `fp` stays owned by the caller and may be
+    // closed right after. Returns false if it is not a session archive.
+    bool open(FILE* fp);
+    void close();
+
+    // True if INDX/footer were missing and the index was rebuilt by scanning.
+    bool recovered() const { return m_recovered; }
+
+    size_t numTracks() const { return m_tracks.size(); }
+    const SessionArchiveTrack& trackInfo(size_t t) const { return m_tracks[t]; }
+    int findTrack(const char* user, int channel) const;
+
+    // Entries sorted by (start_ms, track).
+    size_t numEntries() const { return m_entries.size(); }
+    const SessionArchiveEntry& entry(size_t i) const { return m_entries[i]; }
+
+    // Entry index playing on `track` at `ms`, or -1 if the track is silent
+    // there. If a track's intervals overlap, the latest-starting one wins.
+    // O(log n).
+    int findAt(int track, int64_t ms) const;
+
+    // First entry (any track) with start_ms >= ms; numEntries() if none.
+    // O(log n). Use for export/scrub sweeps.
+    size_t firstStartingAt(int64_t ms) const;
+
+    // A track's entries in start order: trackSeek() is the position of the
+    // entry playing at `ms`, or of the next one to start after it
+    // (trackSize() if none), O(log n); trackEntry() maps a position to an
+    // entry index. A scrub or export of one track walks from trackSeek().
+    size_t trackSize(int track) const;
+    size_t trackSeek(int track, int64_t ms) const;
+    int trackEntry(int track, size_t pos) const;
+
+    int64_t lengthMs() const { return m_length_ms; }
+
+    // Zero-copy view of an entry's codec payload inside the mapping.
+    const unsigned char* payload(const SessionArchiveEntry& e) const;
+
+private:
+    bool loadIndex(uint64_t indx_offset);
+    bool scanChunks();
+    void buildLookups();
+
+    MappedIntervalFile m_map;
+    std::vector<SessionArchiveTrack> m_tracks;
+    std::vector<SessionArchiveEntry> m_entries;
+    std::vector<std::vector<int>> m_by_track;  // entry indices per track, by start
+    int64_t m_length_ms = 0;
+    bool m_recovered = false;
+};
+
+} // namespace jamwide
+
+#endif // SESSION_ARCHIVE_H
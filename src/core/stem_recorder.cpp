@@ -0,0 +1,477 @@
+/*
+    JamWide Plugin - stem_recorder.cpp
+    Live per-peer multitrack (stem) recorder (see stem_recorder.h)
+
+    Copyright (C) 2026 JamWide Contributors
+    Licensed under GPLv2+
+*/
+
+#include "stem_recorder.h"
+
+#include <chrono>
+#include <cstdio>
+
+namespace jamwide {
+
+// Ring attr layout: generation in the high bits, stem number in the low 12.
+// kTickStem marks the end-of-block record (startpos = block frames).
+static const int kStemBits = 12;
+static const int kTickStem = (1 << kStemBits) - 1;
+static const int kMaxGen = (1 << (31 - kStemBits)) - 1;
+
+static inline int packAttr(int gen, int stem) { return (gen << kStemBits) | stem; }
+
+StemRecorder::~StemRecorder()
+{
+    stopAndWait();
+}
+
+// With control_mutex_ held. state_ is cleared before quit is raised, so
+// the dispatcher's last drain sees everything that was accepted; both under
+// wake_mutex_ so a deferred dispatcher cannot arm afterwards.
+void StemRecorder::requestStop(Dispatcher& d)
+{
+    {
+        std::lock_guard<std::mutex> lk(wake_mutex_);
+        state_.store(0, std::memory_order_release);
+        d.quit.store(true, std::memory_order_release);
+    }
+    wake_cv_.notify_all();
+}
+
+// Resets the stats and starts the encode pool for a new recording. Called
+// only while no earlier recording's dispatcher or pool is running.
+bool StemRecorder::startPool(int workers)
+{
+    stem_count_.store(0, std::memory_order_relaxed);
+    length_frames_.store(0, std::memory_order_relaxed);
+    intervals_.store(0, std::memory_order_relaxed);
+    blocks_dropped_.store(0, std::memory_order_relaxed);
+    fifo_high_water_.store(0, std::memory_order_relaxed);
+    chunks_encoded_.store(0, std::memory_order_relaxed);
+    max_backlog_frames_.store(0, std::memory_order_relaxed);
+    sink_errors_.store(0, std::memory_order_relaxed);
+
+    {
+        std::lock_guard<std::mutex> lk(pool_mutex_);
+        pool_quit_ = false;
+        queued_frames_ = 0;
+        ready_.clear();
+    }
+    try
+    {
+        for (int i = 0; i < workers; i++)
+            workers_.emplace_back(&StemRecorder::workerMain, this);
+    }
+    catch (...)
+    {
+        stopPool();
+        return false;
+    }
+    worker_count_.store(workers, std::memory_order_relaxed);
+    return true;
+}
+
+// Lets the workers write out what is queued, then joins them.
+void StemRecorder::stopPool()
+{
+    {
+        std::lock_guard<std::mutex> lk(pool_mutex_);
+        pool_quit_ = true;
+    }
+    pool_cv_.notify_all();
+    for (auto& t : workers_)
+        if (t.joinable()) t.join();
+    workers_.clear();
+    worker_count_.store(0, std::memory_order_relaxed);
+}
+
+bool StemRecorder::start(SinkFactory factory, int workers)
+{
+    std::lock_guard<std::mutex> lock(control_mutex_);
+    if (dispatcher_) requestStop(*dispatcher_);
+
+    if (!factory || !fifo_.allocate(fifo_bytes_)) return false;
+    try
+    {
+        if (scratch_.empty()) scratch_.assign(2 * (std::size_t) kScratchFrames, 0.0f);
+        if (silence_.empty()) silence_.assign(kChunkFrames, 0.0f);
+    }
+    catch (...)
+    {
+        return false;
+    }
+
+    if (workers <= 0)
+    {
+        const unsigned hw = std::thread::hardware_concurrency();
+        workers = hw > 1 ? (int) hw - 1 : 1;
+        if (workers > 4) workers = 4;
+    }
+    if (workers > kMaxWorkers) workers = kMaxWorkers;
+
+    std::unique_ptr<Dispatcher> d(new Dispatcher);
+    d->workers = workers;
+    // An earlier recording still finishing owns the ring and the pool: the
+    // new dispatcher joins it first and then starts the pool and arms.
+    d->deferred = live_dispatchers_.load(std::memory_order_acquire) > 0;
+    if (!d->deferred && !startPool(workers)) return false;
+
+    const int gen = last_gen_ < kMaxGen ? last_gen_ + 1 : 1;
+    last_gen_ = gen;
+    d->gen = gen;
+    d->prev = std::move(dispatcher_);
+    live_dispatchers_.fetch_add(1, std::memory_order_acq_rel);
+    try
+    {
+        d->thread = std::thread(&StemRecorder::run, this, d.get(), std::move(factory));
+    }
+    catch (...)
+    {
+        live_dispatchers_.fetch_sub(1, std::memory_order_acq_rel);
+        dispatcher_ = std::move(d->prev);
+        if (!d->deferred) stopPool();
+        return false;
+    }
+    if (!d->deferred) state_.store(-gen, std::memory_order_release);   // armed until onInterval()
+    dispatcher_ = std::move(d);
+    return true;
+}
+
+void StemRecorder::stop()
+{
+    std::lock_guard<std::mutex> lock(control_mutex_);
+    if (dispatcher_) requestStop(*dispatcher_);
+}
+
+void StemRecorder::stopAndWait()
+{
+    std::lock_guard<std::mutex> lock(control_mutex_);
+    if (!dispatcher_) return;
+    requestStop(*dispatcher_);
+    if (dispatcher_->thread.joinable()) dispatcher_->thread.join();
+    dispatcher_.reset();
+}
+
+void StemRecorder::setStemName(int stem, const std::string& identity, const std::string& label)
+{
+    if (stem < 0 || stem >= kMaxStems) return;
+    std::lock_guard<std::mutex> lk(names_mutex_);
+    if (names_.size() < (std::size_t) kMaxStems) names_.resize(kMaxStems);
+    StemName& n = names_[stem];
+    if (n.identity != identity)
+    {
+        n.identity = identity;
+        n.serial = ++next_serial_;
+    }
+    n.label = label;
+    names_version_.fetch_add(1, std::memory_order_release);
+}
+
+// ---------------------------------------------------------------------------
+// Audio thread
+
+void StemRecorder::onInterval() noexcept
+{
+    int s = state_.load(std::memory_order_acquire);
+    if (s < 0 && state_.compare_exchange_strong(s, -s, std::memory_order_acq_rel))
+        s = -s;
+    if (s > 0) intervals_.fetch_add(1, std::memory_order_relaxed);
+}
+
+bool StemRecorder::push(int gen, int stem, int offset, const float* l, const float* r, int frames) noexcept
+{
+    if (gen <= 0 || stem < 0 || stem >= kMaxStems || offset < 0 || frames <= 0) return false;
+    if (tick_gen_ != gen)
+    {
+        tick_gen_ = gen;
+        tick_owed_ = 0;
+    }
+    // While a tick is owed the dispatcher's block base lags the audio
+    // thread, so an offset pushed now would land in the wrong place.
+    if (!l || frames > kScratchFrames || tick_owed_ ||
+        !fifo_.push(packAttr(gen, stem), (double) offset, l, frames, 2, r ? r : l))
+    {
+        blocks_dropped_.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    const uint64_t used = fifo_.bytesUsed();
+    if (used > fifo_high_water_.load(std::memory_order_relaxed))
+        fifo_high_water_.store(used, std::memory_order_relaxed);
+    return true;
+}
+
+void StemRecorder::endBlock(int gen, int frames) noexcept
+{
+    if (gen <= 0 || frames <= 0) return;
+    if (tick_gen_ != gen)
+    {
+        tick_gen_ = gen;
+        tick_owed_ = 0;
+    }
+    const uint64_t n = tick_owed_ + (uint64_t) frames;
+    tick_owed_ = fifo_.push(packAttr(gen, kTickStem), (double) n, nullptr, 0, 0) ? 0 : n;
+}
+
+void StemRecorder::getStats(StemRecorderStats& out) const noexcept
+{
+    const int s = state_.load(std::memory_order_acquire);
+    out.armed              = s < 0;
+    out.recording          = s > 0;
+    out.finishing          = !s && live_dispatchers_.load(std::memory_order_acquire) > 0;
+    out.workers            = worker_count_.load(std::memory_order_relaxed);
+    out.stems              = stem_count_.load(std::memory_order_relaxed);
+    out.length_frames      = length_frames_.load(std::memory_order_relaxed);
+    out.intervals          = intervals_.load(std::memory_order_relaxed);
+    out.blocks_dropped     = blocks_dropped_.load(std::memory_order_relaxed);
+    out.fifo_bytes         = fifo_.capacity();
+    out.fifo_high_water    = fifo_high_water_.load(std::memory_order_relaxed);
+    out.chunks_encoded     = chunks_encoded_.load(std::memory_order_relaxed);
+    out.max_backlog_frames = max_backlog_frames_.load(std::memory_order_relaxed);
+    out.sink_errors        = sink_errors_.load(std::memory_order_relaxed);
+}
+
+// ---------------------------------------------------------------------------
+// Dispatcher thread
+
+void StemRecorder::run(Dispatcher* d, SinkFactory factory)
+{
+    // The recording this one replaced has stopped; wait until its files
+    // are written out (it joined its own predecessor).
+    if (d->prev)
+    {
+        if (d->prev->thread.joinable()) d->prev->thread.join();
+        d->prev.reset();
+    }
+    if (d->deferred)
+    {
+        if (!startPool(d->workers))
+        {
+            sink_errors_.fetch_add(1, std::memory_order_relaxed);
+            live_dispatchers_.fetch_sub(1, std::memory_order_acq_rel);
+            return;
+        }
+        std::lock_guard<std::mutex> lk(wake_mutex_);
+        if (!d->quit.load(std::memory_order_relaxed))
+            state_.store(-d->gen, std::memory_order_release);   // armed until onInterval()
+    }
+
+    const int gen = d->gen;
+    factory_ = std::move(factory);
+    name_cache_version_ = names_version_.load(std::memory_order_acquire) - 1;
+    by_number_.assign(kMaxStems, nullptr);
+    stems_.clear();
+    block_base_ = 0;
+    last_flush_ = 0;
+
+    for (;;)
+    {
+        const bool quit = d->quit.load(std::memory_order_acquire);
+        drainOnce(gen);
+        if (quit) break;
+        std::unique_lock<std::mutex> lk(wake_mutex_);
+        wake_cv_.wait_for(lk, std::chrono::milliseconds(kWakeMs),
+                          [d] { return d->quit.load(std::memory_order_relaxed); });
+    }
+
+    // Every stem padded to the same end, then closed by its worker.
+    flushAll(true);
+    stopPool();
+
+    stems_.clear();
+    by_number_.clear();
+    factory_ = nullptr;
+    live_dispatchers_.fetch_sub(1, std::memory_order_acq_rel);
+}
+
+void StemRecorder::drainOnce(int gen)
+{
+    if (fifo_.empty()) return;
+    fifo_.drain([this, gen](const SampleBlockHeader& h, const float* s1, const float* s2) {
+        if ((h.attr >> kStemBits) != gen) return;   // pushed just as an earlier recording stopped
+        const int number = h.attr & kTickStem;
+        if (number == kTickStem)
+        {
+            block_base_ += (uint64_t) h.startpos;
+            length_frames_.store(block_base_, std::memory_order_relaxed);
+            if (block_base_ - last_flush_ >= (uint64_t) kChunkFrames) flushAll(false);
+            return;
+        }
+        if (h.sample_count <= 0) return;
+        append(stemFor(number), block_base_ + (uint64_t) h.startpos, s1, s2 ? s2 : s1, h.sample_count);
+    });
+}
+
+StemRecorder::Stem* StemRecorder::stemFor(int number)
+{
+    const uint32_t v = names_version_.load(std::memory_order_acquire);
+    if (v != name_cache_version_)
+    {
+        std::lock_guard<std::mutex> lk(names_mutex_);
+        name_cache_ = names_;
+        name_cache_version_ = v;
+    }
+    const bool named = (std::size_t) number < name_cache_.size();
+    const uint32_t serial = named ? name_cache_[number].serial : 0;
+
+    Stem* s = by_number_[number];
+    if (s && s->serial == serial) return s;
+
+    // First audio on this stem number, or the number now belongs to someone
+    // else: a new file, silent up to the last chunk boundary (the pending
+    // part of the chunk is padded by append()).
+    std::string label;
+    if (named) label = name_cache_[number].label;
+    if (label.empty())
+    {
+        char buf[32];
+        std::snprintf(buf, sizeof(buf), "stem%d", number);
+        label = buf;
+    }
+
+    std::unique_ptr<Stem> st(new Stem);
+    st->number = number;
+    st->serial = serial;
+    try
+    {
+        st->sink = factory_(number, label);
+    }
+    catch (...)
+    {
+        st->sink.reset();
+    }
+    if (!st->sink) sink_errors_.fetch_add(1, std::memory_order_relaxed);
+    st->pos = last_flush_;
+    st->l.reserve(kChunkFrames + kScratchFrames);
+    st->r.reserve(kChunkFrames + kScratchFrames);
+    stem_count_.fetch_add(1, std::memory_order_relaxed);
+
+    s = st.get();
+    stems_.push_back(std::move(st));
+    by_number_[number] = s;
+    if (last_flush_) submit(s, last_flush_, false);
+    return s;
+}
+
+void StemRecorder::padTo(Stem* s, uint64_t at)
+{
+    if (at <= s->pos) return;
+    const std::size_t n = s->l.size() + (std::size_t) (at - s->pos);
+    s->l.resize(n, 0.0f);
+    s->r.resize(n, 0.0f);
+    s->pos = at;
+}
+
+void StemRecorder::append(Stem* s, uint64_t at, const float* l, const float* r, int frames)
+{
+    if (at < s->pos)
+    {
+        // Overlaps what is already there (cannot happen with NJClient's
+        // sequential offsets); keep the first.
+        const uint64_t skip = s->pos - at;
+        if (skip >= (uint64_t) frames) return;
+        l += skip;
+        r += skip;
+        frames -= (int) skip;
+        at = s->pos;
+    }
+    padTo(s, at);
+    s->l.insert(s->l.end(), l, l + frames);
+    s->r.insert(s->r.end(), r, r + frames);
+    s->pos = at + (uint64_t) frames;
+}
+
+void StemRecorder::flushAll(bool finish)
+{
+    for (auto& s : stems_)
+    {
+        padTo(s.get(), block_base_);
+        submit(s.get(), 0, finish);
+    }
+    last_flush_ = block_base_;
+}
+
+// Hands the stem's pending frames (after `silence` frames of lead-in) to
+// the pool. Waits while the pool is more than kMaxQueuedFrames behind.
+void StemRecorder::submit(Stem* s, uint64_t silence, bool finish)
+{
+    Job j;
+    j.silence = silence;
+    j.finish = finish;
+    j.l.swap(s->l);
+    j.r.swap(s->r);
+    s->l.reserve(kChunkFrames + kScratchFrames);
+    s->r.reserve(kChunkFrames + kScratchFrames);
+    const uint64_t frames = j.l.size();
+    if (!frames && !silence && !finish) return;
+
+    std::unique_lock<std::mutex> lk(pool_mutex_);
+    room_cv_.wait(lk, [this] { return queued_frames_ <= kMaxQueuedFrames || pool_quit_; });
+    queued_frames_ += frames;
+    if (queued_frames_ > max_backlog_frames_.load(std::memory_order_relaxed))
+        max_backlog_frames_.store(queued_frames_, std::memory_order_relaxed);
+    s->jobs.push_back(std::move(j));
+    if (!s->scheduled)
+    {
+        s->scheduled = true;
+        ready_.push_back(s);
+        lk.unlock();
+        pool_cv_.notify_one();
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Encode pool
+
+void StemRecorder::workerMain()
+{
+    std::unique_lock<std::mutex> lk(pool_mutex_);
+    for (;;)
+    {
+        pool_cv_.wait(lk, [this] { return !ready_.empty() || pool_quit_; });
+        if (ready_.empty()) return;   // pool_quit_ and nothing left
+
+        // One job per turn, the stem going to the back of the line if it has
+        // more: a stem is only ever written by one worker at a time (in
+        // order), and a busy stem cannot starve the others.
+        Stem* s = ready_.front();
+        ready_.pop_front();
+        Job j = std::move(s->jobs.front());
+        s->jobs.pop_front();
+        lk.unlock();
+
+        if (s->sink)
+        {
+            bool ok = true;
+            for (uint64_t left = j.silence; ok && left > 0; )
+            {
+                const int n = left < (uint64_t) kChunkFrames ? (int) left : kChunkFrames;
+                ok = s->sink->write(silence_.data(), silence_.data(), n);
+                left -= (uint64_t) n;
+            }
+            if (ok && !j.l.empty())
+                ok = s->sink->write(j.l.data(), j.r.data(), (int) j.l.size());
+            if (!ok)
+            {
+                s->sink->finish();
+                s->sink.reset();
+                sink_errors_.fetch_add(1, std::memory_order_relaxed);
+            }
+            else if (j.finish)
+            {
+                s->sink->finish();
+                s->sink.reset();
+            }
+        }
+        const uint64_t frames = j.l.size();
+        if (frames) chunks_encoded_.fetch_add(1, std::memory_order_relaxed);
+
+        lk.lock();
+        queued_frames_ -= frames;
+        if (!s->jobs.empty()) ready_.push_back(s);
+        else s->scheduled = false;
+        room_cv_.notify_one();
+    }
+}
+
+} // namespace jamwide
@@ -0,0 +1,254 @@
+/*
+    JamWide Plugin - stem_recorder.h
+    Live per-peer multitrack (stem) recorder with a parallel encode pool
+
+    Copyright (C) 2026 JamWide Contributors
+    Licensed under GPLv2+
+
+    config_savelocalaudio keeps every received interval as its own
+    compressed file; turning those into a multitrack means decoding
+    thousands of files afterwards and lining them up by hand. StemRecorder
+    writes one continuous file per remote user/channel instead, all starting
+    on the same interval boundary and all the same length, from the PCM the
+    mixer already decoded.
+
+    Audio thread (NJClient::process_samples / mixInChannel):
+      - beginBlock() returns the recording generation (0 = off) once per
+        processed block. For every channel that produced sound in the block,
+        push() queues its resampled, pre-fader PCM with the stem number and
+        the frame offset inside the block; endBlock() queues a tick carrying
+        the block length. Everything goes into one shared SampleFifo; a
+        channel that is silent, absent or dropped simply has no record and
+        becomes silence in its file.
+      - onInterval() at each interval boundary: a recording armed by
+        start() becomes active there, so every stem begins exactly on an
+        interval.
+      - A tick that finds the ring full is carried over (the next one holds
+        both lengths) and the stem records in between are dropped, so the
+        timeline never loses frames; drops are counted.
+
+    Dispatcher thread: drains the ring every kWakeMs, keeps the session
+    timeline from the ticks and places each record at tick base + offset,
+    padding with silence. A stem first seen mid-session is padded from the
+    start of the recording. Every kChunkFrames of timeline all stems are
+    padded to the same position and their pending audio is handed to the
+    pool as one chunk each.
+
+    Encode pool (`workers` threads): a stem's chunks are written in order by
+    one worker at a time, different stems in parallel, so vorbis/FLAC
+    encoding of a 16-channel session uses several cores and never touches
+    the run loop. When the pool's backlog exceeds kMaxQueuedFrames the
+    dispatcher waits, the ring fills and the audio thread's drops show it.
+
+    Stems are identified by a stem number (NJClient: slot * MAX_USER_CHANNELS
+    + channel) and named through setStemName() by the run thread. A stem
+    number whose identity changes (the peer slot reused by someone else)
+    starts a new file; a label change alone does not. The file itself comes
+    from the SinkFactory passed to start() (MasterRecorderSink, so the
+    master recorder's WAV sink and NJClient's encoder sinks are reused).
+
+    Thread Safety:
+      - start()/stop()/setStemName()/stats from control threads.
+      - beginBlock()/push()/endBlock()/onInterval() from the audio thread.
+      - Sinks live on the dispatcher (creation) and pool (writes) threads.
+*/
+
+#ifndef STEM_RECORDER_H
+#define STEM_RECORDER_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "master_recorder.h"
+#include "threading/sample_fifo.h"
+
+namespace jamwide {
+
+struct StemRecorderStats {
+    bool     armed = false;           // waiting for the next interval boundary
+    bool     recording = false;
+    bool     finishing = false;       // stopped, files still being written
+    int      workers = 0;
+    int      stems = 0;               // files opened this recording
+    uint64_t length_frames = 0;       // recorded timeline length
+    uint32_t intervals = 0;           // interval boundaries crossed while recording
+    uint64_t blocks_dropped = 0;      // stem records refused (ring full / tick owed / oversize)
+    uint64_t fifo_bytes = 0;
+    uint64_t fifo_high_water = 0;
+    uint64_t chunks_encoded = 0;
+    uint64_t max_backlog_frames = 0;  // most frames waiting in the encode pool
+    uint32_t sink_errors = 0;         // stems whose file could not be created or written
+};
+
+class StemRecorder {
+public:
+    static constexpr int kMaxStems = 4095;              // stem numbers 0..4094
+    static constexpr std::size_t kDefaultFifoBytes = 16u << 20;
+    static constexpr int kScratchFrames = 16384;        // largest block push() takes per call
+    static constexpr int kChunkFrames = 65536;          // encode unit per stem
+    static constexpr uint64_t kMaxQueuedFrames = 64ull * kChunkFrames;
+    static constexpr int kWakeMs = 10;
+    static constexpr int kMaxWorkers = 16;
+
+    // Creates the file for a stem (dispatcher thread). nullptr = failed.
+    typedef std::function<std::unique_ptr<MasterRecorderSink>(int stem, const std::string& label)> SinkFactory;
+
+    explicit StemRecorder(std::size_t fifo_bytes = kDefaultFifoBytes) : fifo_bytes_(fifo_bytes) {}
+    ~StemRecorder();
+
+    StemRecorder(const StemRecorder&) = delete;
+    StemRecorder& operator=(const StemRecorder&) = delete;
+
+    // Arm a recording, stopping a previous one first without waiting for
+    // it. It starts at the next onInterval(); if the previous recording is
+    // still writing out its files, arming waits (on the new dispatcher)
+    // until it is done. workers <= 0 picks one per spare core, at most 4.
+    // Returns false if the ring, scratch or threads cannot be set up.
+    bool start(SinkFactory factory, int workers = 0);
+
+    // Stop at once; the dispatcher writes out what is queued, pads every
+    // stem to the common length and closes the files without the caller
+    // waiting. The next recording's dispatcher, stopAndWait() or the
+    // destructor joins it.
+    void stop();
+    void stopAndWait();
+
+    // Identity and file label for a stem number. A new identity makes the
+    // next audio on that stem start a new file.
+    void setStemName(int stem, const std::string& identity, const std::string& label);
+
+    // Armed or recording.
+    bool active() const noexcept { return state_.load(std::memory_order_relaxed) != 0; }
+
+    // ---- audio thread ----
+    int  beginBlock() noexcept
+    {
+        const int s = state_.load(std::memory_order_acquire);
+        return s > 0 ? s : 0;
+    }
+    void onInterval() noexcept;
+    bool push(int gen, int stem, int offset, const float* l, const float* r, int frames) noexcept;
+    void endBlock(int gen, int frames) noexcept;
+
+    // Stereo scratch for the caller to resample a stem block into before
+    // push() (audio thread; kScratchFrames each, allocated by the first start()).
+    float* scratch(int ch) noexcept { return scratch_.empty() ? nullptr : scratch_.data() + (ch ? kScratchFrames : 0); }
+
+    void getStats(StemRecorderStats& out) const noexcept;
+
+    // Ring storage, for memory locking (nullptr/0 until the first start()).
+    const void* fifoData() const noexcept { return fifo_.data(); }
+    std::size_t fifoCapacity() const noexcept { return fifo_.capacity(); }
+
+private:
+    struct Job {
+        uint64_t silence = 0;              // frames of silence before l/r
+        std::vector<float> l, r;
+        bool finish = false;
+    };
+
+    struct Stem {
+        int number = 0;
+        uint32_t serial = 0;
+        std::unique_ptr<MasterRecorderSink> sink;
+        uint64_t pos = 0;                  // timeline frames delivered (dispatcher)
+        std::vector<float> l, r;           // pending chunk (dispatcher)
+        std::deque<Job> jobs;              // pool_mutex_
+        bool scheduled = false;            // in ready_ or being written (pool_mutex_)
+    };
+
+    struct StemName {
+        std::string identity, label;
+        uint32_t serial = 0;
+    };
+
+    // One recording's dispatcher thread. A retired dispatcher is owned, and
+    // joined, by the one that replaced it.
+    struct Dispatcher {
+        std::thread thread;
+        int gen = 0;
+        int workers = 0;
+        bool deferred = false;             // pool and arming done by the thread
+        std::atomic<bool> quit{false};     // set under wake_mutex_
+        std::unique_ptr<Dispatcher> prev;
+    };
+
+    void run(Dispatcher* d, SinkFactory factory);
+    void drainOnce(int gen);
+    Stem* stemFor(int number);
+    void append(Stem* s, uint64_t at, const float* l, const float* r, int frames);
+    void padTo(Stem* s, uint64_t at);
+    void flushAll(bool finish);
+    void submit(Stem* s, uint64_t silence, bool finish);
+    void workerMain();
+    bool startPool(int workers);
+    void stopPool();
+    void requestStop(Dispatcher& d);
+
+    const std::size_t fifo_bytes_;
+    SampleFifo fifo_;
+    std::vector<float> scratch_;
+    std::vector<float> silence_;       // kChunkFrames of zeros, read by the pool
+
+    std::mutex control_mutex_;             // start/stop, dispatcher_
+    std::unique_ptr<Dispatcher> dispatcher_;
+    int last_gen_ = 0;
+    std::atomic<int> live_dispatchers_{0};   // dispatcher threads not yet finished
+
+    std::mutex wake_mutex_;
+    std::condition_variable wake_cv_;
+
+    // >0 recording generation, <0 armed (-generation), 0 off.
+    std::atomic<int> state_{0};
+
+    // Audio thread: frames of ticks that did not fit yet.
+    int tick_gen_ = 0;
+    uint64_t tick_owed_ = 0;
+
+    // Names (control threads write, dispatcher reads on version change).
+    mutable std::mutex names_mutex_;
+    std::vector<StemName> names_;
+    std::atomic<uint32_t> names_version_{0};
+    uint32_t next_serial_ = 0;
+
+    // Dispatcher thread.
+    SinkFactory factory_;
+    std::vector<StemName> name_cache_;
+    uint32_t name_cache_version_ = ~0u;
+    std::vector<Stem*> by_number_;
+    std::vector<std::unique_ptr<Stem>> stems_;
+    uint64_t block_base_ = 0;
+    uint64_t last_flush_ = 0;
+
+    // Encode pool.
+    std::mutex pool_mutex_;
+    std::condition_variable pool_cv_;
+    std::condition_variable room_cv_;
+    std::deque<Stem*> ready_;
+    bool pool_quit_ = false;
+    uint64_t queued_frames_ = 0;
+    std::vector<std::thread> workers_;
+
+    std::atomic<int>      worker_count_{0};
+    std::atomic<int>      stem_count_{0};
+    std::atomic<uint64_t> length_frames_{0};
+    std::atomic<uint32_t> intervals_{0};
+    std::atomic<uint64_t> blocks_dropped_{0};
+    std::atomic<uint64_t> fifo_high_water_{0};
+    std::atomic<uint64_t> chunks_encoded_{0};
+    std::atomic<uint64_t> max_backlog_frames_{0};
+    std::atomic<uint32_t> sink_errors_{0};
+};
+
+} // namespace jamwide
+
+#endif // STEM_RECORDER_H
@@ -0,0 +1,329 @@
+/*
+    JamWide Plugin - thread_sched.cpp
+    Scheduling policy, CPU affinity and memory locking (see thread_sched.h)
+
+    Copyright (C) 2026 JamWide Contributors
+    Licensed under GPLv2+
+*/
+
+#include "thread_sched.h"
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <unistd.h>
+#if defined(__linux__)
+#include <sys/syscall.h>
+#endif
+#endif
+
+namespace jamwide {
+
+static int clampInt(int v, int lo, int hi)
+{
+  return v < lo ? lo : v > hi ? hi : v;
+}
+
+#ifdef _WIN32
+
+// What the calling thread had before applyThreadSched first changed it.
+// kSchedDefault and a 0 mask put this back rather than a fixed "normal".
+struct OriginalSched {
+  bool priority_saved = false;
+  int priority = THREAD_PRIORITY_NORMAL;
+  bool affinity_saved = false;
+  DWORD_PTR affinity = 0;
+};
+static thread_local OriginalSched t_original;
+
+static int applyPolicy(int policy, int priority, int* applied_priority)
+{
+  if (policy == kSchedDefault)
+  {
+    *applied_priority = 0;
+    if (!t_original.priority_saved) return 0;   // never changed
+    return SetThreadPriority(GetCurrentThread(), t_original.priority) ? 0 : (int)GetLastError();
+  }
+  if (!t_original.priority_saved)
+  {
+    const int cur = GetThreadPriority(GetCurrentThread());
+    if (cur != THREAD_PRIORITY_ERROR_RETURN) t_original.priority = cur;
+    t_original.priority_saved = true;
+  }
+
+  int prio = THREAD_PRIORITY_NORMAL;
+  switch (policy)
+  {
+    case kSchedNice:
+      prio = priority < 0 ? THREAD_PRIORITY_ABOVE_NORMAL
+           : priority > 0 ? THREAD_PRIORITY_BELOW_NORMAL
+           : THREAD_PRIORITY_NORMAL;
+      *applied_priority = clampInt(priority, -20, 19);
+      break;
+    case kSchedRoundRobin: prio = THREAD_PRIORITY_HIGHEST; *applied_priority = clampInt(priority, 1, 99); break;
+    case kSchedFifo: prio = THREAD_PRIORITY_TIME_CRITICAL; *applied_priority = clampInt(priority, 1, 99); break;
+  }
+  return SetThreadPriority(GetCurrentThread(), prio) ? 0 : (int)GetLastError();
+}
+
+static int applyAffinity(uint64_t mask)
+{
+  if (!mask)
+  {
+    if (!t_original.affinity_saved) return 0;   // never changed
+    return SetThreadAffinityMask(GetCurrentThread(), t_original.affinity) ? 0 : (int)GetLastError();
+  }
+  const DWORD_PTR prev = SetThreadAffinityMask(GetCurrentThread(), (DWORD_PTR)mask);
+  if (!prev) return (int)GetLastError();
+  if (!t_original.affinity_saved)
+  {
+    t_original.affinity = prev;
+    t_original.affinity_saved = true;
+  }
+  return 0;
+}
+
+int lockMemory(const void* p, size_t len)
+{
+  if (!p || !len) return 0;
+  return VirtualLock(const_cast<void*>(p), len) ? 0 : (int)GetLastError();
+}
+
+void unlockMemory(const void* p, size_t len)
+{
+  if (p && len) VirtualUnlock(const_cast<void*>(p), len);
+}
+
+#else // !_WIN32
+
+// What the calling thread had before applyThreadSched first changed it.
+// kSchedDefault and a 0 mask put this back: a host may start its threads
+// with its own policy, nice value or CPU set, and "default" means that,
+// not SCHED_OTHER / nice 0 / every configured CPU.
+struct OriginalSched {
+  bool sched_saved = false;
+  int policy = SCHED_OTHER;
+  struct sched_param param;
+  int nice = 0;
+#if defined(__linux__)
+  bool affinity_saved = false;
+  cpu_set_t cpus;
+#endif
+};
+static thread_local OriginalSched t_original;
+
+static void saveOriginalSched()
+{
+  if (t_original.sched_saved) return;
+  memset(&t_original.param, 0, sizeof(t_original.param));
+  if (pthread_getschedparam(pthread_self(), &t_original.policy, &t_original.param) != 0)
+    t_original.policy = SCHED_OTHER;
+#if defined(__linux__)
+  errno = 0;
+  const int n = getpriority(PRIO_PROCESS, (id_t)syscall(SYS_gettid));
+  t_original.nice = errno ? 0 : n;
+#endif
+  t_original.sched_saved = true;
+}
+
+static int setNice(int nice_value)
+{
+#if defined(__linux__)
+  // Linux applies nice per thread (the tid is a PRIO_PROCESS target).
+  const id_t tid = (id_t)syscall(SYS_gettid);
+  return setpriority(PRIO_PROCESS, tid, nice_value) == 0 ? 0 : errno;
+#else
+  return nice_value == 0 ? 0 : ENOTSUP;
+#endif
+}
+
+static int applyPolicy(int policy, int priority, int* applied_priority)
+{
+  *applied_priority = 0;
+  if (policy == kSchedDefault)
+  {
+    if (!t_original.sched_saved) return 0;   // never changed
+    const int err = pthread_setschedparam(pthread_self(), t_original.policy, &t_original.param);
+    if (err) return err;
+    return t_original.policy == SCHED_FIFO || t_original.policy == SCHED_RR ? 0 : setNice(t_original.nice);
+  }
+  saveOriginalSched();
+  if (policy == kSchedRoundRobin || policy == kSchedFifo)
+  {
+    const int pol = policy == kSchedFifo ? SCHED_FIFO : SCHED_RR;
+    struct sched_param sp;
+    memset(&sp, 0, sizeof(sp));
+    sp.sched_priority = clampInt(priority, sched_get_priority_min(pol), sched_get_priority_max(pol));
+    const int err = pthread_setschedparam(pthread_self(), pol, &sp);
+    if (!err) *applied_priority = sp.sched_priority;
+    return err;
+  }
+
+  // kSchedNice: back to time-sharing first (in case a real-time policy was
+  // applied earlier), then the nice value.
+  struct sched_param sp;
+  memset(&sp, 0, sizeof(sp));
+  const int err = pthread_setschedparam(pthread_self(), SCHED_OTHER, &sp);
+  if (err) return err;
+  *applied_priority = clampInt(priority, -20, 19);
+  return setNice(*applied_priority);
+}
+
+static int applyAffinity(uint64_t mask)
+{
+#if defined(__linux__)
+  if (!mask)
+  {
+    if (!t_original.affinity_saved) return 0;   // never changed
+    return pthread_setaffinity_np(pthread_self(), sizeof(t_original.cpus), &t_original.cpus);
+  }
+  if (!t_original.affinity_saved)
+  {
+    CPU_ZERO(&t_original.cpus);
+    const int err = pthread_getaffinity_np(pthread_self(), sizeof(t_original.cpus), &t_original.cpus);
+    if (err) return err;
+    t_original.affinity_saved = true;
+  }
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  for (int i = 0; i < 64; i++)
+    if (mask & (1ull << i)) CPU_SET(i, &set);
+  return pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+#else
+  return mask ? ENOTSUP : 0;   // no thread affinity API on macOS/BSD
+#endif
+}
+
+int lockMemory(const void* p, size_t len)
+{
+  if (!p || !len) return 0;
+  return mlock(p, len) == 0 ? 0 : errno;
+}
+
+void unlockMemory(const void* p, size_t len)
+{
+  if (p && len) munlock(p, len);
+}
+
+#endif // _WIN32
+
+bool applyThreadSched(const ThreadSchedConfig& cfg, ThreadSchedStatus* out)
+{
+  ThreadSchedStatus s;
+  if (out)
+  {
+    // memory-lock fields belong to the caller
+    s.locked_bytes = out->locked_bytes;
+    s.lock_error = out->lock_error;
+  }
+  s.requested_policy = cfg.policy;
+  s.requested_priority = cfg.priority;
+
+  int prio = 0;
+  const int policy = (cfg.policy >= kSchedDefault && cfg.policy <= kSchedFifo) ? cfg.policy : kSchedDefault;
+  s.sched_error = applyPolicy(policy, cfg.priority, &prio);
+  if (s.sched_error)
+  {
+    int ignored = 0;
+    applyPolicy(kSchedDefault, 0, &ignored);
+    s.policy = kSchedDefault;
+    s.priority = 0;
+  }
+  else
+  {
+    s.policy = policy;
+    s.priority = prio;
+  }
+
+  s.affinity_error = applyAffinity(cfg.cpu_mask);
+  s.cpu_mask = s.affinity_error ? 0 : cfg.cpu_mask;
+  if (s.affinity_error && cfg.cpu_mask) applyAffinity(0);
+
+  if (out) *out = s;
+  return !s.sched_error && !s.affinity_error;
+}
+
+const char* schedPolicyName(int policy)
+{
+  switch (policy)
+  {
+    case kSchedNice: return "nice";
+    case kSchedRoundRobin: return "rr";
+    case kSchedFifo: return "fifo";
+    default: return "default";
+  }
+}
+
+bool parseSchedPolicy(const char* name, int* policy)
+{
+  if (!name || !policy) return false;
+  for (int p = kSchedDefault; p <= kSchedFifo; p++)
+  {
+    if (!strcmp(name, schedPolicyName(p)))
+    {
+      *policy = p;
+      return true;
+    }
+  }
+  return false;
+}
+
+static const char* errName(int err)
+{
+  switch (err)
+  {
+#ifndef _WIN32
+    case EPERM: return "EPERM";
+    case EINVAL: return "EINVAL";
+    case ENOMEM: return "ENOMEM";
+    case EAGAIN: return "EAGAIN";
+    case ENOTSUP: return "unsupported";
+#endif
+    default: return nullptr;
+  }
+}
+
+void describeThreadSched(const ThreadSchedStatus& s, char* buf, size_t bufsize)
+{
+  if (!buf || !bufsize) return;
+  int n = 0;
+  auto append = [&](const char* fmt, auto... args) {
+    if (n >= 0 && (size_t)n < bufsize)
+      n += snprintf(buf + n, bufsize - (size_t)n, fmt, args...);
+  };
+  auto appendErr = [&](int err) {
+    if (const char* e = errName(err)) append("%s", e);
+    else append("error %d", err);
+  };
+
+  append("%s", schedPolicyName(s.policy));
+  if (s.policy != kSchedDefault) append(" %d", s.priority);
+  if (s.sched_error)
+  {
+    append(" (%s %d refused: ", schedPolicyName(s.requested_policy), s.requested_priority);
+    appendErr(s.sched_error);
+    append("%s", ")");
+  }
+  if (s.cpu_mask) append(", cpus 0x%llx", (unsigned long long)s.cpu_mask);
+  if (s.affinity_error)
+  {
+    append("%s", ", affinity refused: ");
+    appendErr(s.affinity_error);
+  }
+  if (s.locked_bytes) append(", mlock %lluKB", (unsigned long long)(s.locked_bytes / 1024));
+  if (s.lock_error)
+  {
+    append("%s", ", mlock refused: ");
+    appendErr(s.lock_error);
+  }
+}
+
+} // namespace jamwide
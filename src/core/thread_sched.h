@@ -0,0 +1,102 @@
+/*
+    JamWide Plugin - thread_sched.h
+    Scheduling policy, CPU affinity and memory locking for the run thread
+
+    Copyright (C) 2026 JamWide Contributors
+    Licensed under GPLv2+
+
+    The run thread (NinjamRunThread in the JUCE build, the std::thread in
+    src/threading/run_thread.cpp for CLAP) parses downloads, encodes uploads
+    and feeds the decode buffers. Started at default priority, it competes
+    with every other normal thread in the DAW; under load the scheduler can
+    hold it off long enough for interval writes to arrive late.
+
+    applyThreadSched() sets the calling thread's policy and, optionally, its
+    CPU affinity:
+
+      kSchedDefault     whatever the thread had before it was first changed
+                        (host policy, nice value and CPU set); left alone
+                        if it never was
+      kSchedNice        time-sharing with a nice value (-20..19, lower = more CPU)
+      kSchedRoundRobin  SCHED_RR, real-time priority 1..99
+      kSchedFifo        SCHED_FIFO, real-time priority 1..99
+
+    Linux supports all of it (nice is per-thread there). macOS has no thread
+    affinity and no per-thread nice; the real-time policies go through
+    pthread_setschedparam. Windows maps the policies onto SetThreadPriority
+    (nice < 0 = ABOVE_NORMAL, > 0 = BELOW_NORMAL, RR = HIGHEST,
+    FIFO = TIME_CRITICAL) and affinity onto SetThreadAffinityMask.
+
+    Nothing here is fatal. Real-time policies usually need privileges
+    (RLIMIT_RTPRIO / CAP_SYS_NICE on Linux); when a request is refused the
+    thread is left at default scheduling and the status records the error,
+    so the UI can say what is actually in effect instead of what was asked
+    for.
+
+    lockMemory()/unlockMemory() pin a byte range in RAM (mlock/VirtualLock)
+    so the audio-thread mirrors are never paged out. Also subject to limits
+    (RLIMIT_MEMLOCK); failures are reported, not fatal.
+*/
+
+#ifndef THREAD_SCHED_H
+#define THREAD_SCHED_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace jamwide {
+
+enum SchedPolicy {
+    kSchedDefault = 0,
+    kSchedNice = 1,
+    kSchedRoundRobin = 2,
+    kSchedFifo = 3,
+};
+
+struct ThreadSchedConfig {
+    int policy = kSchedDefault;
+    int priority = 0;        // nice value for kSchedNice, 1..99 for RR/FIFO
+    uint64_t cpu_mask = 0;   // bit n = CPU n; 0 = the thread's original CPU set
+
+    bool operator==(const ThreadSchedConfig& o) const {
+        return policy == o.policy && priority == o.priority && cpu_mask == o.cpu_mask;
+    }
+    bool operator!=(const ThreadSchedConfig& o) const { return !(*this == o); }
+};
+
+// What is actually in effect after applyThreadSched()/lockMemory().
+struct ThreadSchedStatus {
+    int policy = kSchedDefault;
+    int priority = 0;
+    uint64_t cpu_mask = 0;       // 0 = the thread's original CPU set
+    int requested_policy = kSchedDefault;
+    int requested_priority = 0;
+    int sched_error = 0;         // errno / GetLastError() of a refused policy, 0 if none
+    int affinity_error = 0;      // same, for the affinity mask
+    uint64_t locked_bytes = 0;   // bytes pinned with lockMemory()
+    int lock_error = 0;          // error of the last failed lockMemory(), 0 if none
+};
+
+// Apply `cfg` to the calling thread. Priorities are clamped to the policy's
+// range. The thread's original settings are captured the first time they
+// are changed, per thread. On failure the thread falls back to kSchedDefault
+// (policy) or its original CPU set (affinity); `out` gets what is in effect
+// plus the errors.
+// Returns true if everything requested was applied.
+bool applyThreadSched(const ThreadSchedConfig& cfg, ThreadSchedStatus* out);
+
+// Pin/unpin [p, p+len) in physical memory. lockMemory returns 0 or the
+// platform error code.
+int lockMemory(const void* p, size_t len);
+void unlockMemory(const void* p, size_t len);
+
+const char* schedPolicyName(int policy);    // "default", "nice", "rr", "fifo"
+bool parseSchedPolicy(const char* name, int* policy);
+
+// One line for status displays, e.g.
+// "fifo 20, cpus 0x3, mlock 1536KB" or "default (fifo 20 refused: EPERM)".
+void describeThreadSched(const ThreadSchedStatus& s, char* buf, size_t bufsize);
+
+} // namespace jamwide
+
+#endif // THREAD_SCHED_H
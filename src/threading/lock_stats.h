@@ -0,0 +1,121 @@
+/*
+    JamWide Plugin - lock_stats.h
+    Hold-time instrumentation for the few locks the run thread still shares
+
+    Copyright (C) 2026 JamWide Contributors
+    Licensed under GPLv2+
+*/
+
+#ifndef LOCK_STATS_H
+#define LOCK_STATS_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+namespace jamwide {
+
+/**
+ * Relaxed counters describing how long a lock (or a lock-sized scope) is
+ * held: acquisitions, how many of them had to wait, total and worst hold
+ * time. Written by whoever takes the lock, read by /rcmstats at any time.
+ *
+ * The run loop used to hold one processor-wide lock across all of
+ * NJClient::Run(); these counters are how we show that what remains
+ * (cachedUsersMutex around the roster swap and the VU refresh) is held for
+ * microseconds, and how long a run pass takes, i.e. what a UI reader would
+ * have waited behind before.
+ */
+struct LockHoldStats {
+    struct Snapshot {
+        uint64_t acquisitions = 0;
+        uint64_t contended = 0;   // acquisitions that found the lock taken
+        uint64_t total_ns = 0;
+        uint64_t max_ns = 0;
+    };
+
+    void record(uint64_t held_ns, bool was_contended) noexcept {
+        acquisitions_.fetch_add(1, std::memory_order_relaxed);
+        if (was_contended) contended_.fetch_add(1, std::memory_order_relaxed);
+        total_ns_.fetch_add(held_ns, std::memory_order_relaxed);
+        uint64_t prev = max_ns_.load(std::memory_order_relaxed);
+        while (held_ns > prev &&
+               !max_ns_.compare_exchange_weak(prev, held_ns, std::memory_order_relaxed)) {}
+    }
+
+    Snapshot snapshot() const noexcept {
+        Snapshot s;
+        s.acquisitions = acquisitions_.load(std::memory_order_relaxed);
+        s.contended = contended_.load(std::memory_order_relaxed);
+        s.total_ns = total_ns_.load(std::memory_order_relaxed);
+        s.max_ns = max_ns_.load(std::memory_order_relaxed);
+        return s;
+    }
+
+private:
+    std::atomic<uint64_t> acquisitions_{0};
+    std::atomic<uint64_t> contended_{0};
+    std::atomic<uint64_t> total_ns_{0};
+    std::atomic<uint64_t> max_ns_{0};
+};
+
+/**
+ * Times a scope that is not itself a lock (e.g. one run pass) into a
+ * LockHoldStats. Never counts as contended.
+ */
+class ScopedHoldTimer {
+public:
+    explicit ScopedHoldTimer(LockHoldStats& stats) noexcept
+        : stats_(stats), start_(std::chrono::steady_clock::now()) {}
+
+    ~ScopedHoldTimer() {
+        stats_.record(elapsedNs(start_), false);
+    }
+
+    ScopedHoldTimer(const ScopedHoldTimer&) = delete;
+    ScopedHoldTimer& operator=(const ScopedHoldTimer&) = delete;
+
+    static uint64_t elapsedNs(std::chrono::steady_clock::time_point since) noexcept {
+        return (uint64_t) std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - since).count();
+    }
+
+private:
+    LockHoldStats& stats_;
+    std::chrono::steady_clock::time_point start_;
+};
+
+/**
+ * lock_guard that records into a LockHoldStats. A failed try_lock() marks
+ * the acquisition as contended; the hold time runs from acquisition to
+ * release. Mutex needs lock/try_lock/unlock (std::mutex and friends).
+ */
+template <typename Mutex>
+class TimedLockGuard {
+public:
+    TimedLockGuard(Mutex& m, LockHoldStats& stats)
+        : m_(m), stats_(stats) {
+        contended_ = !m_.try_lock();
+        if (contended_) m_.lock();
+        start_ = std::chrono::steady_clock::now();
+    }
+
+    ~TimedLockGuard() {
+        const uint64_t held = ScopedHoldTimer::elapsedNs(start_);
+        m_.unlock();
+        stats_.record(held, contended_);
+    }
+
+    TimedLockGuard(const TimedLockGuard&) = delete;
+    TimedLockGuard& operator=(const TimedLockGuard&) = delete;
+
+private:
+    Mutex& m_;
+    LockHoldStats& stats_;
+    bool contended_ = false;
+    std::chrono::steady_clock::time_point start_;
+};
+
+} // namespace jamwide
+
+#endif // LOCK_STATS_H
@@ -0,0 +1,134 @@
+/*
+    JamWide Plugin - mpmc_ring.h
+    Lock-free bounded Multi-Producer Multi-Consumer ring buffer
+
+    Copyright (C) 2026 JamWide Contributors
+    Licensed under GPLv2+
+*/
+
+#ifndef MPMC_RING_H
+#define MPMC_RING_H
+
+#include <atomic>
+#include <cstddef>
+#include <type_traits>
+
+namespace jamwide {
+
+/**
+ * Lock-free bounded MPMC ring (Vyukov's sequence-numbered cells).
+ *
+ * Each cell carries a sequence number that says whether it is ready to be
+ * written (seq == pos) or read (seq == pos + 1) for the lap that owns `pos`.
+ * Producers and consumers claim positions with a CAS on their own counter,
+ * so there is no ABA problem and no freelist node is ever dereferenced after
+ * another thread may have reused it.
+ *
+ * Thread Safety:
+ *   - Any number of threads may call try_push() and try_pop() concurrently
+ *   - Neither call blocks; both fail fast when the ring is full/empty
+ *
+ * Used for freelists (e.g. the Net_Message pool in netmsg.cpp), where the
+ * thread that frees an object is not necessarily the one that allocates.
+ *
+ * @tparam T      Element type (trivially copyable; typically a pointer)
+ * @tparam N      Capacity (must be power of 2 for efficient masking)
+ */
+template <typename T, std::size_t N>
+class MpmcRing {
+    static_assert((N & (N - 1)) == 0, "N must be a power of 2");
+    static_assert(N > 1, "N must be greater than 1");
+    static_assert(std::is_trivially_copyable<T>::value, "T must be trivially copyable");
+
+public:
+    MpmcRing() : enqueue_pos_(0), dequeue_pos_(0) {
+        for (std::size_t i = 0; i < N; ++i)
+            cells_[i].seq.store(i, std::memory_order_relaxed);
+    }
+
+    // Non-copyable, non-movable
+    MpmcRing(const MpmcRing&) = delete;
+    MpmcRing& operator=(const MpmcRing&) = delete;
+    MpmcRing(MpmcRing&&) = delete;
+    MpmcRing& operator=(MpmcRing&&) = delete;
+
+    /**
+     * Try to push an element (any thread).
+     * @return true if pushed, false if the ring is full
+     */
+    bool try_push(const T& value) {
+        std::size_t pos = enqueue_pos_.load(std::memory_order_relaxed);
+        for (;;) {
+            Cell& c = cells_[pos & mask_];
+            const std::size_t seq = c.seq.load(std::memory_order_acquire);
+            const std::ptrdiff_t dif = (std::ptrdiff_t)seq - (std::ptrdiff_t)pos;
+            if (dif == 0) {
+                if (enqueue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    c.value = value;
+                    c.seq.store(pos + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (dif < 0) {
+                return false;  // full
+            } else {
+                pos = enqueue_pos_.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    /**
+     * Try to pop an element (any thread).
+     * @return true if an element was written to `out`, false if empty
+     */
+    bool try_pop(T& out) {
+        std::size_t pos = dequeue_pos_.load(std::memory_order_relaxed);
+        for (;;) {
+            Cell& c = cells_[pos & mask_];
+            const std::size_t seq = c.seq.load(std::memory_order_acquire);
+            const std::ptrdiff_t dif = (std::ptrdiff_t)seq - (std::ptrdiff_t)(pos + 1);
+            if (dif == 0) {
+                if (dequeue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    out = c.value;
+                    c.seq.store(pos + N, std::memory_order_release);
+                    return true;
+                }
+            } else if (dif < 0) {
+                return false;  // empty
+            } else {
+                pos = dequeue_pos_.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    /**
+     * Approximate element count (exact when quiescent).
+     */
+    std::size_t size_approx() const {
+        const std::size_t e = enqueue_pos_.load(std::memory_order_acquire);
+        const std::size_t d = dequeue_pos_.load(std::memory_order_acquire);
+        return e >= d ? e - d : 0;
+    }
+
+    /**
+     * Get capacity.
+     */
+    static constexpr std::size_t capacity() { return N; }
+
+private:
+    static constexpr std::size_t mask_ = N - 1;
+
+    struct Cell {
+        std::atomic<std::size_t> seq;
+        T value;
+    };
+
+    Cell cells_[N];
+
+    // Separate cache lines to avoid false sharing
+    alignas(64) std::atomic<std::size_t> enqueue_pos_;
+    alignas(64) std::atomic<std::size_t> dequeue_pos_;
+};
+
+} // namespace jamwide
+
+#endif // MPMC_RING_H
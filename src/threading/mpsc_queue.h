@@ -0,0 +1,201 @@
+/*
+    JamWide Plugin - mpsc_queue.h
+    Lock-free bounded Multi-Producer Single-Consumer queue
+
+    Copyright (C) 2026 JamWide Contributors
+    Licensed under GPLv2+
+*/
+
+#ifndef MPSC_QUEUE_H
+#define MPSC_QUEUE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <utility>
+
+namespace jamwide {
+
+/**
+ * Lock-free bounded MPSC queue for non-trivial element types.
+ *
+ * Same sequence-numbered cells as MpmcRing (mpmc_ring.h), but the element is
+ * moved in and out, so it can carry std::string/std::variant payloads such
+ * as UiCommand. A producer claims a position with a CAS, moves the value in
+ * and publishes the cell; the single consumer takes cells in order.
+ *
+ * Thread Safety:
+ *   - Any number of threads may call try_push()
+ *   - One thread may call try_pop()/drain() (consumer)
+ *   - try_push never blocks: it fails (and counts a drop) when full
+ *
+ * An optional notifier runs after every successful push, on the producer's
+ * thread. NinjamRunThread uses it to wake the run loop out of its readiness
+ * wait so a command is applied now, not at the next poll timeout. The
+ * notifier must be cheap and thread-safe.
+ *
+ * @tparam T      Element type (default-constructible, movable)
+ * @tparam N      Capacity (must be power of 2 for efficient masking)
+ */
+template <typename T, std::size_t N>
+class MpscQueue {
+    static_assert((N & (N - 1)) == 0, "N must be a power of 2");
+    static_assert(N > 1, "N must be greater than 1");
+
+public:
+    using Notifier = void (*)(void* ctx);
+
+    struct Stats {
+        uint64_t pushed = 0;      // successful try_push calls
+        uint64_t dropped = 0;     // try_push calls that found the queue full
+        uint64_t coalesced = 0;   // elements the consumer merged away (note_coalesced)
+        std::size_t max_depth = 0; // deepest queue seen at drain time
+    };
+
+    MpscQueue() : enqueue_pos_(0), dequeue_pos_(0) {
+        for (std::size_t i = 0; i < N; ++i)
+            cells_[i].seq.store(i, std::memory_order_relaxed);
+    }
+
+    // Non-copyable, non-movable
+    MpscQueue(const MpscQueue&) = delete;
+    MpscQueue& operator=(const MpscQueue&) = delete;
+    MpscQueue(MpscQueue&&) = delete;
+    MpscQueue& operator=(MpscQueue&&) = delete;
+
+    /**
+     * Set (or clear, with nullptr) the post-push notifier. Call while no
+     * producer is pushing (setup/teardown).
+     */
+    void set_notifier(Notifier fn, void* ctx) {
+        notify_ctx_.store(ctx, std::memory_order_relaxed);
+        notify_fn_.store(fn, std::memory_order_release);
+    }
+
+    /**
+     * Try to push an element (any thread).
+     * @return true if pushed, false if the queue is full
+     */
+    template <typename U>
+    bool try_push(U&& value) {
+        std::size_t pos = enqueue_pos_.load(std::memory_order_relaxed);
+        Cell* c;
+        for (;;) {
+            c = &cells_[pos & mask_];
+            const std::size_t seq = c->seq.load(std::memory_order_acquire);
+            const std::ptrdiff_t dif = (std::ptrdiff_t)seq - (std::ptrdiff_t)pos;
+            if (dif == 0) {
+                if (enqueue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                    break;
+            } else if (dif < 0) {
+                dropped_.fetch_add(1, std::memory_order_relaxed);
+                return false;  // full
+            } else {
+                pos = enqueue_pos_.load(std::memory_order_relaxed);
+            }
+        }
+        c->value = T(std::forward<U>(value));
+        c->seq.store(pos + 1, std::memory_order_release);
+        pushed_.fetch_add(1, std::memory_order_relaxed);
+
+        if (Notifier fn = notify_fn_.load(std::memory_order_acquire))
+            fn(notify_ctx_.load(std::memory_order_relaxed));
+        return true;
+    }
+
+    /**
+     * Try to pop an element (consumer only).
+     * @return The element, or std::nullopt if empty (or the next producer
+     *         has claimed its cell but not finished writing it yet)
+     */
+    std::optional<T> try_pop() {
+        const std::size_t pos = dequeue_pos_.load(std::memory_order_relaxed);
+        Cell& c = cells_[pos & mask_];
+        if (c.seq.load(std::memory_order_acquire) != pos + 1)
+            return std::nullopt;
+        std::optional<T> out(std::move(c.value));
+        c.value = T();
+        c.seq.store(pos + N, std::memory_order_release);
+        dequeue_pos_.store(pos + 1, std::memory_order_relaxed);
+        return out;
+    }
+
+    /**
+     * Drain all available elements (consumer only).
+     * @return Number of elements drained
+     */
+    template <typename Func>
+    std::size_t drain(Func&& func) {
+        const std::size_t depth = size();
+        if (depth > max_depth_.load(std::memory_order_relaxed))
+            max_depth_.store(depth, std::memory_order_relaxed);
+        std::size_t count = 0;
+        while (auto value = try_pop()) {
+            func(std::move(*value));
+            ++count;
+        }
+        return count;
+    }
+
+    /**
+     * Consumer bookkeeping: `n` drained elements were merged into others.
+     */
+    void note_coalesced(std::size_t n) {
+        coalesced_.fetch_add(n, std::memory_order_relaxed);
+    }
+
+    /**
+     * Approximate element count (exact when quiescent).
+     */
+    std::size_t size() const {
+        const std::size_t e = enqueue_pos_.load(std::memory_order_acquire);
+        const std::size_t d = dequeue_pos_.load(std::memory_order_acquire);
+        return e >= d ? e - d : 0;
+    }
+
+    bool empty() const { return size() == 0; }
+
+    /**
+     * Counter snapshot (relaxed; any thread).
+     */
+    Stats stats() const {
+        Stats s;
+        s.pushed = pushed_.load(std::memory_order_relaxed);
+        s.dropped = dropped_.load(std::memory_order_relaxed);
+        s.coalesced = coalesced_.load(std::memory_order_relaxed);
+        s.max_depth = max_depth_.load(std::memory_order_relaxed);
+        return s;
+    }
+
+    /**
+     * Get capacity.
+     */
+    static constexpr std::size_t capacity() { return N; }
+
+private:
+    static constexpr std::size_t mask_ = N - 1;
+
+    struct Cell {
+        std::atomic<std::size_t> seq;
+        T value;
+    };
+
+    Cell cells_[N];
+
+    std::atomic<Notifier> notify_fn_{nullptr};
+    std::atomic<void*> notify_ctx_{nullptr};
+
+    std::atomic<uint64_t> pushed_{0};
+    std::atomic<uint64_t> dropped_{0};
+    std::atomic<uint64_t> coalesced_{0};
+    std::atomic<std::size_t> max_depth_{0};
+
+    // Separate cache lines to avoid false sharing
+    alignas(64) std::atomic<std::size_t> enqueue_pos_;
+    alignas(64) std::atomic<std::size_t> dequeue_pos_;
+};
+
+} // namespace jamwide
+
+#endif // MPSC_QUEUE_H
@@ -384,14 +384,18 @@ void run_thread_func(std::shared_ptr<JamWidePlugin> plugin) {
             }
         }
         
-        // Adaptive sleep based on connection state
-        // Connected: faster polling for responsiveness
-        // Disconnected: slower polling to save resources
-        auto sleep_time = (current_status == NJClient::NJC_STATUS_DISCONNECTED)
-            ? std::chrono::milliseconds(50)  // Disconnected: 20 Hz
-            : std::chrono::milliseconds(20); // Connected/connecting: 50 Hz
-        
-        std::this_thread::sleep_for(sleep_time);
+        // Readiness wait: returns as soon as the server socket is ready or
+        // the audio thread has pushed broadcast blocks. The old adaptive
+        // sleep is kept as the upper bound:
+        // Connected/connecting: 20 ms (UI position/VU cadence)
+        // Disconnected: 50 ms
+        // The client outlives this thread (plugin_deactivate stops us before
+        // resetting it), so waiting outside client_mutex is safe.
+        const int max_wait_ms = (current_status == NJClient::NJC_STATUS_DISCONNECTED)
+            ? 50
+            : 20;
+
+        client->WaitForActivity(max_wait_ms);
     }
 }
 
@@ -414,6 +418,14 @@ void run_thread_start(JamWidePlugin* plugin,
 void run_thread_stop(JamWidePlugin* plugin) {
     // Signal shutdown
     plugin->shutdown.store(true, std::memory_order_release);
+
+    // Cut the run loop's readiness wait short
+    {
+        std::lock_guard<std::mutex> lock(plugin->client_mutex);
+        if (plugin->client) {
+            plugin->client->WakeRunThread();
+        }
+    }
     
     // Wake up license wait if blocked
     // This prevents deadlock if Run thread is waiting for license response
@@ -0,0 +1,242 @@
+/*
+    JamWide Plugin - sample_fifo.h
+    Byte-granular SPSC FIFO of variable-length audio blocks
+
+    Copyright (C) 2026 JamWide Contributors
+    Licensed under GPLv2+
+*/
+
+#ifndef SAMPLE_FIFO_H
+#define SAMPLE_FIFO_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <new>
+
+namespace jamwide {
+
+/**
+ * Header in front of every block in a SampleFifo. Same fields the
+ * BlockRecord payload carried; the samples follow directly (channel 0's
+ * sample_count floats, then channel 1's).
+ */
+struct SampleBlockHeader {
+    int    attr = 0;
+    int    sample_count = 0;
+    int    nch = 0;
+    int    reserved = 0;
+    double startpos = 0.0;
+};
+
+/**
+ * Lock-free SPSC FIFO carrying audio blocks of any length.
+ *
+ * Replaces SpscRing<BlockRecord, N> for the broadcast and wave-mix feeds.
+ * A BlockRecord slot is sized for MAX_BLOCK_SAMPLES stereo frames (16 KB)
+ * whatever the block actually holds, so a 16-slot ring is 256 KB per local
+ * channel, resident from construction, holding only 15 blocks (20 ms at a
+ * 64-frame host buffer) and refusing blocks above 2048 frames. Here each
+ * block takes a 32-byte header plus its own samples, rounded up to 16
+ * bytes, so the same memory holds as much audio as it has room for, and
+ * the storage is only allocated once a feed is actually used.
+ *
+ * Blocks are stored contiguously so the consumer can read them in place.
+ * When a block does not fit before the end of the buffer, the producer
+ * skips to the start (marking the gap with a skip header when there is
+ * room for one). A block larger than half the buffer is split into several
+ * blocks with the same attr/startpos, so there is no block-size ceiling
+ * short of the FIFO itself; a block is queued whole or not at all. One
+ * record (plus its wrap gap) never exceeds the buffer, so a block of at
+ * most maxFramesPerBlock() frames always fits an empty FIFO.
+ *
+ * Thread Safety:
+ *   - allocate() on a non-audio thread, at most once, with no concurrent
+ *     allocate(). The audio thread may be pushing concurrently: until the
+ *     buffer is published push() just fails.
+ *   - One thread may call push() (producer)
+ *   - One thread may call drain()/discard() (consumer)
+ *   - empty()/bytesUsed()/allocated() from any thread (observability)
+ */
+class SampleFifo {
+public:
+    SampleFifo() = default;
+    ~SampleFifo() { delete[] buf_.load(std::memory_order_relaxed); }
+
+    SampleFifo(const SampleFifo&) = delete;
+    SampleFifo& operator=(const SampleFifo&) = delete;
+
+    /**
+     * Allocate the storage (non-audio thread). Capacity is rounded up to a
+     * power of two, at least 4 KB. No-op if already allocated.
+     * @return true if the FIFO has storage afterwards
+     */
+    bool allocate(std::size_t bytes) {
+        if (buf_.load(std::memory_order_acquire)) return true;
+        std::size_t cap = 4096;
+        while (cap < bytes) cap <<= 1;
+        unsigned char* b = new (std::nothrow) unsigned char[cap];
+        if (!b) return false;
+        std::memset(b, 0, cap);   // fault the pages in off the audio thread
+        cap_ = cap;
+        buf_.store(b, std::memory_order_release);
+        return true;
+    }
+
+    bool allocated() const { return buf_.load(std::memory_order_acquire) != nullptr; }
+    std::size_t capacity() const { return allocated() ? cap_ : 0; }
+    const void* data() const { return buf_.load(std::memory_order_acquire); }
+
+    /**
+     * Push one block (producer only). samples_2 is channel 1 for nch == 2
+     * (nullptr = silence). sample_count 0 pushes a header-only marker.
+     * Blocks too large for one record are split.
+     * @return false if the FIFO is unallocated, the arguments are invalid,
+     *         or there is no room for the whole block (nothing is pushed)
+     */
+    bool push(int attr, double startpos, const float* samples, int sample_count,
+              int nch, const float* samples_2 = nullptr) {
+        unsigned char* b = buf_.load(std::memory_order_acquire);
+        if (!b || sample_count < 0 || nch < 0 || nch > 2) return false;
+        const int max_frames = maxFramesPerBlock(nch);
+
+        // All or nothing: walk the split against the current free space
+        // before writing, so a consumer never sees half a block.
+        const std::size_t tail = tail_.load(std::memory_order_acquire);
+        std::size_t head = head_.load(std::memory_order_relaxed);
+        int done = 0;
+        do {
+            const int n = sample_count - done < max_frames ? sample_count - done : max_frames;
+            head += padBefore(head, recordBytes(n, nch)) + recordBytes(n, nch);
+            if (head - tail > cap_) return false;
+            done += n;
+        } while (done < sample_count);
+
+        done = 0;
+        do {
+            const int n = sample_count - done < max_frames ? sample_count - done : max_frames;
+            pushOne(b, attr, startpos,
+                    samples ? samples + done : nullptr, n, nch,
+                    samples_2 ? samples_2 + done : nullptr);
+            done += n;
+        } while (done < sample_count);
+        return true;
+    }
+
+    /**
+     * Consume every queued block in place (consumer only). Calls
+     * func(const SampleBlockHeader&, const float* ch0, const float* ch1);
+     * ch1 is nullptr unless nch > 1. Space is released block by block.
+     * @return Number of blocks consumed
+     */
+    template <typename Func>
+    std::size_t drain(Func&& func) {
+        unsigned char* b = buf_.load(std::memory_order_acquire);
+        if (!b) return 0;
+        std::size_t count = 0;
+        std::size_t tail = tail_.load(std::memory_order_relaxed);
+        const std::size_t head = head_.load(std::memory_order_acquire);
+        while (tail != head) {
+            const std::size_t off = tail & (cap_ - 1);
+            const std::size_t room = cap_ - off;
+            if (room < kHeaderBytes) { tail += room; continue; }
+            SampleBlockHeader h;
+            std::memcpy(&h, b + off, sizeof(h));
+            if (h.nch == kSkip) { tail += room; continue; }
+            const float* s1 = reinterpret_cast<const float*>(b + off + kHeaderBytes);
+            func(h, s1, h.nch > 1 ? s1 + h.sample_count : nullptr);
+            tail += recordBytes(h.sample_count, h.nch);
+            tail_.store(tail, std::memory_order_release);
+            ++count;
+        }
+        tail_.store(tail, std::memory_order_release);
+        return count;
+    }
+
+    /**
+     * Drop everything queued (consumer only).
+     * @return Number of blocks dropped
+     */
+    std::size_t discard() {
+        return drain([](const SampleBlockHeader&, const float*, const float*) {});
+    }
+
+    bool empty() const {
+        return head_.load(std::memory_order_acquire) == tail_.load(std::memory_order_acquire);
+    }
+
+    std::size_t bytesUsed() const {
+        return head_.load(std::memory_order_acquire) - tail_.load(std::memory_order_acquire);
+    }
+
+    /** Largest sample_count one stored block holds for `nch` channels. */
+    int maxFramesPerBlock(int nch) const {
+        const std::size_t payload = cap_ / 2 - kHeaderBytes;
+        const std::size_t per_frame = sizeof(float) * static_cast<std::size_t>(nch > 0 ? nch : 1);
+        return static_cast<int>((payload / per_frame) & ~static_cast<std::size_t>(3));
+    }
+
+private:
+    static constexpr int kSkip = -1;   // SampleBlockHeader::nch of a wrap gap
+    static constexpr std::size_t kAlign = 16;
+    static constexpr std::size_t kHeaderBytes =
+        (sizeof(SampleBlockHeader) + kAlign - 1) & ~(kAlign - 1);
+
+    static std::size_t recordBytes(int sample_count, int nch) {
+        const std::size_t bytes = kHeaderBytes
+            + sizeof(float) * static_cast<std::size_t>(sample_count) * static_cast<std::size_t>(nch);
+        return (bytes + kAlign - 1) & ~(kAlign - 1);
+    }
+
+    // Bytes skipped at the end of the buffer so a `rec`-byte record written
+    // at `head` stays contiguous.
+    std::size_t padBefore(std::size_t head, std::size_t rec) const {
+        const std::size_t room = cap_ - (head & (cap_ - 1));
+        return rec > room ? room : 0;
+    }
+
+    // Write one record; push() has already checked it fits.
+    void pushOne(unsigned char* b, int attr, double startpos, const float* s1,
+                 int n, int nch, const float* s2) {
+        const std::size_t rec = recordBytes(n, nch);
+        const std::size_t head = head_.load(std::memory_order_relaxed);
+        const std::size_t off = head & (cap_ - 1);
+        const std::size_t pad = padBefore(head, rec);
+
+        if (pad >= kHeaderBytes) {
+            SampleBlockHeader skip;
+            skip.nch = kSkip;
+            std::memcpy(b + off, &skip, sizeof(skip));
+        }
+        unsigned char* p = b + ((head + pad) & (cap_ - 1));
+        SampleBlockHeader h;
+        h.attr = attr;
+        h.sample_count = n;
+        h.nch = nch;
+        h.startpos = startpos;
+        std::memcpy(p, &h, sizeof(h));
+        float* d = reinterpret_cast<float*>(p + kHeaderBytes);
+        const std::size_t bytes = sizeof(float) * static_cast<std::size_t>(n);
+        if (n > 0 && nch > 0) {
+            if (s1) std::memcpy(d, s1, bytes);
+            else std::memset(d, 0, bytes);
+            if (nch > 1) {
+                if (s2) std::memcpy(d + n, s2, bytes);
+                else std::memset(d + n, 0, bytes);
+            }
+        }
+        head_.store(head + pad + rec, std::memory_order_release);
+    }
+
+    std::atomic<unsigned char*> buf_{nullptr};
+    std::size_t cap_ = 0;   // written before buf_ is published
+
+    // Monotonic byte counters; position = counter & (cap_ - 1).
+    alignas(64) std::atomic<std::size_t> head_{0};
+    alignas(64) std::atomic<std::size_t> tail_{0};
+};
+
+} // namespace jamwide
+
+#endif // SAMPLE_FIFO_H
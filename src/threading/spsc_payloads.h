@@ -228,6 +228,12 @@ static_assert(std::is_trivially_copyable_v<LocalChannelUpdate>,
 //   block, the assertion fires immediately — payloads cannot truncate.
 //   BlockRecord-producing call sites in 15.1-07b ALSO defensively assert
 //   sample_count <= MAX_BLOCK_SAMPLES and nch <= MAX_BLOCK_CHANNELS.
+//
+// NJClient no longer carries broadcast/wave audio in BlockRecords: the
+// fixed 16 KB slots moved to jamwide::SampleFifo (sample_fifo.h), which
+// stores exactly the samples pushed and splits large blocks, so the
+// SetMaxAudioBlockSize assertion is gone. BlockRecord stays as the
+// fixed-slot payload exercised by the SPSC tests.
 // ===========================================================================
 
 inline constexpr int MAX_BLOCK_SAMPLES = 2048;
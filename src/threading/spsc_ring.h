@@ -22,9 +22,14 @@ namespace jamwide {
  * Lock-free SPSC (Single-Producer Single-Consumer) ring buffer.
  * 
  * Thread Safety:
- *   - One thread may call try_push() (producer)
- *   - One thread may call try_pop()/drain() (consumer)
+ *   - One thread may call try_push()/try_reserve()/commit() (producer)
+ *   - One thread may call try_pop()/drain()/front()/pop() (consumer)
  *   - Different threads for producer and consumer is safe
+ *
+ * For large payloads (BlockRecord, DecodeChunk) the by-value API copies
+ * the whole element on each side. try_reserve()/commit() and front()/pop()
+ * hand out the slot itself instead, so the producer writes only the bytes
+ * it has and the consumer reads them where they lie.
  * 
  * @tparam T      Element type (must be trivially copyable or movable)
  * @tparam N      Capacity (must be power of 2 for efficient masking)
@@ -80,6 +85,52 @@ public:
         return true;
     }
 
+    /**
+     * Reserve the next free slot for in-place construction (producer only).
+     * The slot still holds whatever was last stored there; the caller
+     * overwrites the fields it needs, then calls commit() to publish it.
+     * Calling try_reserve() again before commit() returns the same slot.
+     * @return Pointer to the slot, or nullptr if queue is full
+     */
+    T* try_reserve() {
+        const std::size_t head = head_.load(std::memory_order_relaxed);
+        if (((head + 1) & mask_) == tail_.load(std::memory_order_acquire)) {
+            return nullptr;
+        }
+        return &buffer_[head];
+    }
+
+    /**
+     * Publish the slot returned by the last successful try_reserve()
+     * (producer only).
+     */
+    void commit() {
+        const std::size_t head = head_.load(std::memory_order_relaxed);
+        head_.store((head + 1) & mask_, std::memory_order_release);
+    }
+
+    /**
+     * Peek at the oldest element in place (consumer only). Valid until
+     * pop(); the producer never writes a slot that has not been popped.
+     * @return Pointer to the element, or nullptr if queue is empty
+     */
+    T* front() {
+        const std::size_t tail = tail_.load(std::memory_order_relaxed);
+        if (tail == head_.load(std::memory_order_acquire)) {
+            return nullptr;
+        }
+        return &buffer_[tail];
+    }
+
+    /**
+     * Release the element returned by front() (consumer only). Must follow
+     * a front() that returned non-null.
+     */
+    void pop() {
+        const std::size_t tail = tail_.load(std::memory_order_relaxed);
+        tail_.store((tail + 1) & mask_, std::memory_order_release);
+    }
+
     /**
      * Try to pop an element (consumer only).
      * @return The popped value, or std::nullopt if queue is empty
@@ -99,7 +150,9 @@ public:
 
     /**
      * Drain all available elements (consumer only).
-     * Calls the provided callback for each element.
+     * Calls the provided callback for each element, in place in its slot
+     * (no intermediate copy); the slot is released after the callback
+     * returns.
      * 
      * @tparam Func Callable with signature void(T&&) or void(const T&)
      * @param func Callback to invoke for each element
@@ -108,8 +161,9 @@ public:
     template <typename Func>
     std::size_t drain(Func&& func) {
         std::size_t count = 0;
-        while (auto value = try_pop()) {
+        while (T* value = front()) {
             func(std::move(*value));
+            pop();
             ++count;
         }
         return count;
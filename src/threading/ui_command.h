@@ -6,8 +6,11 @@
 #ifndef UI_COMMAND_H
 #define UI_COMMAND_H
 
+#include <cstddef>
+#include <cstdint>
 #include <string>
 #include <variant>
+#include <vector>
 
 namespace jamwide {
 
@@ -81,7 +84,7 @@ struct SendChatCommand {
 };
 
 struct SetEncoderFormatCommand {
-    unsigned int fourcc = 0;  // NJ_ENCODER_FMT_FLAC or MAKE_NJ_FOURCC('O','G','G','v')
+    unsigned int fourcc = 0;  // NJ_ENCODER_FMT_FLAC, MAKE_NJ_FOURCC('O','G','G','v') or ('O','P','U','S')
 };
 
 struct SetRoutingModeCommand {
@@ -101,6 +104,34 @@ struct PrelistenCommand {
 
 struct StopPrelistenCommand {};
 
+// Session archive (/archive). Opened/closed on the run thread; the result is
+// reported back as a System chat message.
+struct SetSessionArchiveCommand {
+    std::string path;   // empty = finalize and stop
+};
+
+// Session archive export (/archive export). Started on the run thread; the
+// export itself runs on its own thread (NJClient::ExportSessionArchive).
+struct ExportSessionArchiveCommand {
+    std::string path;
+    int64_t from_ms = 0;
+    int64_t to_ms = 0;  // 0 = to the end
+};
+
+// Master recording (/record). Started/stopped on the run thread; the result
+// is reported back as a System chat message.
+struct SetMasterRecordingCommand {
+    std::string path;   // base name, extension added per format
+    int formats = 0;    // NJClient::MASTERREC_* bits; 0 = stop
+};
+
+// Stem recording (/stems). Started/stopped on the run thread; the result is
+// reported back as a System chat message.
+struct SetStemRecordingCommand {
+    std::string dir;    // directory for the stem files
+    int format = 0;     // one NJClient::MASTERREC_* value; 0 = stop
+};
+
 using UiCommand = std::variant<
     ConnectCommand,
     DisconnectCommand,
@@ -116,9 +147,120 @@ using UiCommand = std::variant<
     SyncCancelCommand,
     SyncDisableCommand,
     PrelistenCommand,
-    StopPrelistenCommand
+    StopPrelistenCommand,
+    SetSessionArchiveCommand,
+    ExportSessionArchiveCommand,
+    SetMasterRecordingCommand,
+    SetStemRecordingCommand
 >;
 
+// ---------------------------------------------------------------------------
+// Coalescing (NinjamRunThread::processCommands)
+//
+// Fader, pan, mute and solo changes for one target carry absolute values, so
+// when a MIDI CC stream or OSC sweep queues several of them between two
+// run-loop passes only the newest value of each field matters. These helpers
+// merge such commands per (command type, user, channel) within each run of
+// consecutive mergeable commands. Any other command (connect, chat, routing
+// mode, ...) is a barrier: nothing is merged across it, so its ordering
+// relative to the mixer changes around it is unchanged.
+// ---------------------------------------------------------------------------
+
+// Key for a mergeable command; false for commands that must apply as-is.
+inline bool commandCoalesceKey(const UiCommand& cmd, uint64_t& key)
+{
+    const uint64_t kind = static_cast<uint64_t>(cmd.index()) << 56;
+    if (auto* c = std::get_if<SetLocalChannelMonitoringCommand>(&cmd)) {
+        key = kind | static_cast<uint32_t>(c->channel);
+        return true;
+    }
+    if (auto* c = std::get_if<SetUserStateCommand>(&cmd)) {
+        key = kind | (static_cast<uint64_t>(static_cast<uint32_t>(c->user_index)) << 16);
+        return true;
+    }
+    if (auto* c = std::get_if<SetUserChannelStateCommand>(&cmd)) {
+        key = kind | (static_cast<uint64_t>(static_cast<uint32_t>(c->user_index)) << 16)
+                   | static_cast<uint16_t>(c->channel_index);
+        return true;
+    }
+    return false;
+}
+
+// Fold `newer` into `older` (same key): every field `newer` sets wins, fields
+// only `older` sets are kept.
+inline void mergeCommand(UiCommand& older, const UiCommand& newer)
+{
+#define JW_MERGE_FIELD(flag, field) \
+    if (n->flag) { o->flag = true; o->field = n->field; }
+    if (auto* o = std::get_if<SetLocalChannelMonitoringCommand>(&older)) {
+        auto* n = std::get_if<SetLocalChannelMonitoringCommand>(&newer);
+        if (!n) return;
+        JW_MERGE_FIELD(set_volume, volume)
+        JW_MERGE_FIELD(set_pan, pan)
+        JW_MERGE_FIELD(set_mute, mute)
+        JW_MERGE_FIELD(set_solo, solo)
+    } else if (auto* o = std::get_if<SetUserStateCommand>(&older)) {
+        auto* n = std::get_if<SetUserStateCommand>(&newer);
+        if (!n) return;
+        JW_MERGE_FIELD(set_vol, volume)
+        JW_MERGE_FIELD(set_pan, pan)
+        JW_MERGE_FIELD(set_mute, mute)
+    } else if (auto* o = std::get_if<SetUserChannelStateCommand>(&older)) {
+        auto* n = std::get_if<SetUserChannelStateCommand>(&newer);
+        if (!n) return;
+        JW_MERGE_FIELD(set_sub, subscribed)
+        JW_MERGE_FIELD(set_vol, volume)
+        JW_MERGE_FIELD(set_pan, pan)
+        JW_MERGE_FIELD(set_mute, mute)
+        JW_MERGE_FIELD(set_solo, solo)
+        JW_MERGE_FIELD(set_outch, outchannel)
+    }
+#undef JW_MERGE_FIELD
+}
+
+// Targets seen since the last barrier. Owned by the draining thread and
+// reused, so a drain allocates nothing. Sized to the command queue: a run
+// with more distinct targets keeps the extras unmerged, which only misses
+// a fold and never reorders anything.
+struct CoalesceScratch {
+    static constexpr std::size_t kMaxSlots = 256;
+    struct Slot { uint64_t key; std::size_t at; };
+    Slot slots[kMaxSlots];
+    std::size_t count = 0;
+};
+
+// Merge in place; returns how many commands were folded away. Order of the
+// surviving commands is preserved (a merged command keeps its first slot).
+inline std::size_t coalesceCommands(std::vector<UiCommand>& batch, CoalesceScratch& run)
+{
+    run.count = 0;  // mergeable commands since the last barrier
+    std::size_t out = 0;
+    for (std::size_t i = 0; i < batch.size(); ++i) {
+        uint64_t key = 0;
+        if (!commandCoalesceKey(batch[i], key)) {
+            run.count = 0;
+            if (out != i) batch[out] = std::move(batch[i]);
+            ++out;
+            continue;
+        }
+        bool merged = false;
+        for (std::size_t s = 0; s < run.count; ++s) {
+            if (run.slots[s].key == key) {
+                mergeCommand(batch[run.slots[s].at], batch[i]);
+                merged = true;
+                break;
+            }
+        }
+        if (merged) continue;
+        if (run.count < CoalesceScratch::kMaxSlots) run.slots[run.count++] = {key, out};
+        if (out != i) batch[out] = std::move(batch[i]);
+        ++out;
+    }
+    const std::size_t folded = batch.size() - out;
+    batch.resize(out);
+    return folded;
+}
+
 } // namespace jamwide
 
 #endif // UI_COMMAND_H
@@ -0,0 +1,295 @@
+/*
+    JamWide Plugin - test_arrival_stats.cpp
+    Receiver-side arrival statistics (src/core/arrival_stats.h).
+
+    Feeds ArrivalJitterTracker synthetic interval-write timelines: a steady
+    peer converges to low jitter and gets a prebuffer below the default, a
+    bursty peer gets more, late and timed-out intervals are counted and widen
+    the recommendation, histogram buckets land where expected, and overlapping
+    intervals keep independent per-interval state.
+    Pure-C++ (no NJClient link).
+*/
+
+#include <cstdio>
+#include <cstdint>
+
+#include "core/arrival_stats.h"
+
+using jamwide::ArrivalInterval;
+using jamwide::ArrivalJitterTracker;
+using jamwide::ArrivalStatsSnapshot;
+
+static int tests_run = 0;
+static int tests_passed = 0;
+
+#define TEST(name) \
+    do { \
+        tests_run++; \
+        printf("  TEST: %s ... ", name); \
+        fflush(stdout); \
+    } while(0)
+
+#define PASS() \
+    do { \
+        tests_passed++; \
+        printf("PASSED\n"); \
+    } while(0)
+
+#define FAIL(msg) \
+    do { \
+        printf("FAILED: %s\n", msg); \
+    } while(0)
+
+// 8 second interval at ~16 kB/s (128 kbps)
+static const int64_t kIntervalMs = 8000;
+static const int     kDefault = 8192;
+
+// One interval: BEGIN at t0, `n` writes of `bytes` spaced by gaps[i % ngaps],
+// final write flagged. Returns the time of the final write.
+static int64_t feed_interval(ArrivalJitterTracker& tr, int64_t t0, int n, int bytes,
+                             const int* gaps, int ngaps)
+{
+    ArrivalInterval iv;
+    tr.onIntervalBegin(iv, t0);
+    int64_t t = t0;
+    for (int i = 0; i < n; i++) {
+        t += gaps[i % ngaps];
+        tr.onChunk(iv, t, bytes);
+    }
+    tr.onIntervalEnd(iv, t, kIntervalMs);
+    return t;
+}
+
+// ============================================================
+// Test 1: no history -> caller's default
+// ============================================================
+static void test_default_until_warm() {
+    TEST("recommendPrebuffer returns default before kMinIntervals");
+
+    ArrivalJitterTracker tr;
+    const int gaps[] = { 100 };
+    feed_interval(tr, 0, 40, 3200, gaps, 1);
+
+    if (tr.recommendPrebuffer(kDefault, kDefault / 4, kDefault * 4) == kDefault) {
+        PASS();
+    } else {
+        FAIL("adapted after a single interval");
+    }
+}
+
+// ============================================================
+// Test 2: steady peer -> low jitter, prebuffer below default
+// ============================================================
+static void test_steady_peer_starts_sooner() {
+    TEST("steady arrivals shrink the prebuffer");
+
+    ArrivalJitterTracker tr;
+    const int gaps[] = { 100 };
+    int64_t t = 0;
+    for (int k = 0; k < 4; k++) t = feed_interval(tr, t, 40, 3200, gaps, 1) + 10;
+
+    const ArrivalStatsSnapshot s = tr.snapshot();
+    const int pb = tr.recommendPrebuffer(kDefault, kDefault / 4, kDefault * 4);
+    if (s.jitter_ms > 1.0f || s.mean_gap_ms < 99.0f || s.mean_gap_ms > 101.0f) {
+        char msg[128];
+        snprintf(msg, sizeof(msg), "mean %.2f jitter %.2f", s.mean_gap_ms, s.jitter_ms);
+        FAIL(msg);
+    } else if (pb >= kDefault) {
+        char msg[128];
+        snprintf(msg, sizeof(msg), "prebuffer %d, expected < %d", pb, kDefault);
+        FAIL(msg);
+    } else if (s.intervals != 4 || s.late_intervals != 0) {
+        FAIL("interval/late counts wrong");
+    } else {
+        PASS();
+    }
+}
+
+// ============================================================
+// Test 3: bursty peer -> high jitter, prebuffer above default
+// ============================================================
+static void test_bursty_peer_buffers_more() {
+    TEST("bursty arrivals grow the prebuffer");
+
+    ArrivalJitterTracker tr;
+    const int gaps[] = { 0, 0, 0, 0, 600 };   // bursts after long stalls
+    int64_t t = 0;
+    for (int k = 0; k < 4; k++) t = feed_interval(tr, t, 40, 3200, gaps, 5) + 10;
+
+    const ArrivalStatsSnapshot s = tr.snapshot();
+    const int pb = tr.recommendPrebuffer(kDefault, kDefault / 4, kDefault * 4);
+    if (s.jitter_ms < 100.0f) {
+        char msg[128];
+        snprintf(msg, sizeof(msg), "jitter %.2f, expected >= 100", s.jitter_ms);
+        FAIL(msg);
+    } else if (pb <= kDefault) {
+        char msg[128];
+        snprintf(msg, sizeof(msg), "prebuffer %d, expected > %d", pb, kDefault);
+        FAIL(msg);
+    } else {
+        PASS();
+    }
+}
+
+// ============================================================
+// Test 4: recommendation respects floor and ceiling
+// ============================================================
+static void test_clamped() {
+    TEST("recommendPrebuffer clamps to [floor, ceil]");
+
+    ArrivalJitterTracker fast;
+    const int fast_gaps[] = { 1 };
+    int64_t t = 0;
+    for (int k = 0; k < 3; k++) t = feed_interval(fast, t, 100, 1280, fast_gaps, 1);
+
+    ArrivalJitterTracker slow;
+    const int slow_gaps[] = { 0, 4000 };
+    t = 0;
+    for (int k = 0; k < 3; k++) t = feed_interval(slow, t, 4, 32000, slow_gaps, 2);
+
+    const int lo = fast.recommendPrebuffer(kDefault, 2048, kDefault * 4);
+    const int hi = slow.recommendPrebuffer(kDefault, 2048, kDefault * 4);
+    if (lo == 2048 && hi == kDefault * 4) {
+        PASS();
+    } else {
+        char msg[128];
+        snprintf(msg, sizeof(msg), "lo %d hi %d", lo, hi);
+        FAIL(msg);
+    }
+}
+
+// ============================================================
+// Test 5: late and lost intervals are counted and widen the budget
+// ============================================================
+static void test_late_intervals() {
+    TEST("late / lost intervals counted and widen prebuffer");
+
+    const int gaps[] = { 100 };
+    ArrivalJitterTracker on_time;
+    ArrivalJitterTracker late;
+    int64_t t = 0;
+    for (int k = 0; k < 3; k++) t = feed_interval(on_time, t, 40, 3200, gaps, 1);
+
+    // Same arrival pattern, but finished 10.4s after BEGIN of an 8s interval.
+    const int late_gaps[] = { 260 };
+    t = 0;
+    for (int k = 0; k < 3; k++) t = feed_interval(late, t, 40, 3200, late_gaps, 1);
+    ArrivalInterval lost;
+    late.onIntervalBegin(lost, t);
+    late.onChunk(lost, t + 100, 3200);
+    late.onIntervalLost(lost);
+    late.onIntervalLost(lost);   // idempotent once closed
+
+    const ArrivalStatsSnapshot s = late.snapshot();
+    const int pb_on_time = on_time.recommendPrebuffer(kDefault, 128, kDefault * 4);
+    const int pb_late = late.recommendPrebuffer(kDefault, 128, kDefault * 4);
+    if (s.intervals != 3 || s.late_intervals != 4) {
+        char msg[128];
+        snprintf(msg, sizeof(msg), "intervals %llu late %llu, expected 3/4",
+                 (unsigned long long)s.intervals, (unsigned long long)s.late_intervals);
+        FAIL(msg);
+    } else if (s.completion_hist[ArrivalStatsSnapshot::kCompletionBuckets - 1] != 4) {
+        FAIL("late intervals not in the >=125% completion bucket");
+    } else if (s.late_ratio <= 0.0f || pb_late <= pb_on_time) {
+        char msg[128];
+        snprintf(msg, sizeof(msg), "late ratio %.2f, prebuffer late %d vs on-time %d",
+                 s.late_ratio, pb_late, pb_on_time);
+        FAIL(msg);
+    } else {
+        PASS();
+    }
+}
+
+// ============================================================
+// Test 6: gap histogram buckets
+// ============================================================
+static void test_gap_histogram() {
+    TEST("gap histogram bucket edges");
+
+    ArrivalJitterTracker tr;
+    ArrivalInterval iv;
+    tr.onIntervalBegin(iv, 0);
+    // gaps: 0, 5, 15, 49, 50, 499, 500, 2000
+    const int gaps[] = { 0, 5, 15, 49, 50, 499, 500, 2000 };
+    int64_t t = 0;
+    for (int g : gaps) { t += g; tr.onChunk(iv, t, 100); }
+
+    const ArrivalStatsSnapshot s = tr.snapshot();
+    const uint32_t expect[ArrivalStatsSnapshot::kGapBuckets] = { 1, 1, 1, 1, 1, 0, 1, 2 };
+    bool ok = true;
+    for (int i = 0; i < ArrivalStatsSnapshot::kGapBuckets; i++) ok = ok && s.gap_hist[i] == expect[i];
+    if (ok && s.chunks == 8 && s.bytes == 800) {
+        PASS();
+    } else {
+        FAIL("unexpected bucket counts");
+    }
+}
+
+// ============================================================
+// Test 7: overlapping intervals keep independent state
+// ============================================================
+static void test_overlapping_intervals() {
+    TEST("overlapping intervals tracked independently");
+
+    ArrivalJitterTracker tr;
+    ArrivalInterval a, b;
+    tr.onIntervalBegin(a, 0);
+    tr.onChunk(a, 7000, 64000);
+    tr.onIntervalBegin(b, 7900);   // next interval starts before a completes
+    tr.onChunk(b, 8000, 1000);
+    tr.onChunk(a, 8500, 64000);
+    tr.onIntervalEnd(a, 8500, kIntervalMs);   // 106% -> late
+    tr.onChunk(b, 9000, 1000);
+    tr.onIntervalEnd(b, 9000, kIntervalMs);   // 13% -> on time
+
+    const ArrivalStatsSnapshot s = tr.snapshot();
+    if (s.intervals == 2 && s.late_intervals == 1 &&
+        s.completion_hist[0] == 1 && s.completion_hist[4] == 1 &&
+        a.bytes == 128000 && b.bytes == 2000) {
+        PASS();
+    } else {
+        FAIL("interval state leaked between overlapping downloads");
+    }
+}
+
+// ============================================================
+// Test 8: reset clears history
+// ============================================================
+static void test_reset() {
+    TEST("reset clears history and prebuffer note");
+
+    ArrivalJitterTracker tr;
+    const int gaps[] = { 100 };
+    int64_t t = 0;
+    for (int k = 0; k < 3; k++) t = feed_interval(tr, t, 40, 3200, gaps, 1);
+    tr.notePrebuffer(4096);
+    tr.reset();
+
+    const ArrivalStatsSnapshot s = tr.snapshot();
+    if (s.chunks == 0 && s.intervals == 0 && s.prebuffer_bytes == 0 &&
+        tr.recommendPrebuffer(kDefault, 128, kDefault * 4) == kDefault) {
+        PASS();
+    } else {
+        FAIL("state survived reset");
+    }
+}
+
+// ============================================================
+// Main
+// ============================================================
+int main() {
+    printf("=== Arrival Stats Tests ===\n\n");
+
+    test_default_until_warm();
+    test_steady_peer_starts_sooner();
+    test_bursty_peer_buffers_more();
+    test_clamped();
+    test_late_intervals();
+    test_gap_histogram();
+    test_overlapping_intervals();
+    test_reset();
+
+    printf("\n=== Results: %d/%d tests passed ===\n", tests_passed, tests_run);
+
+    return (tests_passed == tests_run) ? 0 : 1;
+}
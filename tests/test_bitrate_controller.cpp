@@ -0,0 +1,145 @@
+/*
+    JamWide Plugin - test_bitrate_controller.cpp
+    Adaptive upload bitrate controller (src/core/bitrate_controller.h).
+
+    Drives AdaptiveBitrateController with synthetic per-interval uplink
+    samples: clean uplink holds at 100%, backlog steps down, hard congestion
+    (keepalive gap / message backlog) steps down twice, recovery requires a
+    streak of clean intervals, and apply() respects the kbps floor.
+    Pure-C++ (no NJClient link).
+*/
+
+#include <cstdio>
+
+#include "core/bitrate_controller.h"
+
+using jamwide::AdaptiveBitrateController;
+using jamwide::UplinkSample;
+
+static int tests_run = 0;
+static int tests_passed = 0;
+
+#define TEST(name) \
+    do { \
+        tests_run++; \
+        printf("  TEST: %s ... ", name); \
+        fflush(stdout); \
+    } while(0)
+
+#define PASS() \
+    do { \
+        tests_passed++; \
+        printf("PASSED\n"); \
+    } while(0)
+
+#define FAIL(msg) \
+    do { \
+        printf("FAILED: %s\n", msg); \
+    } while(0)
+
+// 128 kbps for an 8 second interval
+static const int kExpected = 128 * 1000 / 8 * 8;
+
+static UplinkSample clean() {
+    UplinkSample s;
+    s.expected_bytes = kExpected;
+    s.sendq_bytes_peak = 0;
+    s.bytes_sent = (uint64_t)kExpected;
+    return s;
+}
+
+static UplinkSample backlogged() {
+    UplinkSample s = clean();
+    s.sendq_bytes_peak = kExpected;  // a whole interval stuck in the queue
+    return s;
+}
+
+static void test_clean_uplink_holds() {
+    TEST("clean uplink holds at 100%");
+    AdaptiveBitrateController c;
+    bool ok = true;
+    for (int i = 0; i < 20; ++i)
+        ok = ok && c.onInterval(clean()) == AdaptiveBitrateController::kHold;
+    if (ok && c.percent() == 100 && c.apply(128) == 128) PASS();
+    else FAIL("controller moved on a clean uplink");
+}
+
+static void test_backlog_steps_down() {
+    TEST("byte backlog steps down one ladder step per interval");
+    AdaptiveBitrateController c;
+    const auto d1 = c.onInterval(backlogged());
+    const int p1 = c.percent();
+    const auto d2 = c.onInterval(backlogged());
+    const int p2 = c.percent();
+    if (d1 == AdaptiveBitrateController::kStepDown && p1 == 80 &&
+        d2 == AdaptiveBitrateController::kStepDown && p2 == 64) PASS();
+    else FAIL("unexpected step sequence");
+}
+
+static void test_hard_congestion_steps_twice() {
+    TEST("keepalive gap / message backlog steps down two");
+    AdaptiveBitrateController a, b;
+    UplinkSample gap = clean();
+    gap.recv_gap_ms = AdaptiveBitrateController::kHardRecvGapMs;
+    UplinkSample msgs = clean();
+    msgs.sendq_msgs_peak = AdaptiveBitrateController::kHardBacklogMsgs;
+    a.onInterval(gap);
+    b.onInterval(msgs);
+    if (a.percent() == 64 && b.percent() == 64) PASS();
+    else FAIL("hard congestion did not skip a step");
+}
+
+static void test_floor_and_bottom() {
+    TEST("ladder bottoms out and apply() honors the kbps floor");
+    AdaptiveBitrateController c;
+    for (int i = 0; i < 20; ++i) c.onInterval(backlogged());
+    const auto d = c.onInterval(backlogged());
+    const bool bottom = c.step() == AdaptiveBitrateController::kNumSteps - 1 &&
+                        d == AdaptiveBitrateController::kHold;
+    // 25% of 64 = 16 < 32 floor; 25% of 256 = 64; user below floor is untouched
+    if (bottom && c.apply(64) == 32 && c.apply(256) == 64 && c.apply(24) == 24) PASS();
+    else FAIL("floor/bottom handling wrong");
+}
+
+static void test_recovery_needs_streak() {
+    TEST("recovery needs kCleanIntervalsToStepUp clean intervals");
+    AdaptiveBitrateController c;
+    c.onInterval(backlogged());   // 80%
+    bool ok = true;
+    for (int i = 0; i < AdaptiveBitrateController::kCleanIntervalsToStepUp - 1; ++i)
+        ok = ok && c.onInterval(clean()) == AdaptiveBitrateController::kHold;
+    // a middling interval (neither clean nor congested) resets the streak
+    UplinkSample mid = clean();
+    mid.sendq_bytes_peak = kExpected / 4;
+    ok = ok && c.onInterval(mid) == AdaptiveBitrateController::kHold;
+    for (int i = 0; i < AdaptiveBitrateController::kCleanIntervalsToStepUp - 1; ++i)
+        ok = ok && c.onInterval(clean()) == AdaptiveBitrateController::kHold;
+    ok = ok && c.onInterval(clean()) == AdaptiveBitrateController::kStepUp;
+    if (ok && c.percent() == 100) PASS();
+    else FAIL("recovery streak logic wrong");
+}
+
+static void test_reset() {
+    TEST("reset() returns to the user bitrate");
+    AdaptiveBitrateController c;
+    c.onInterval(backlogged());
+    c.onInterval(backlogged());
+    c.reset();
+    if (c.percent() == 100 && c.apply(96) == 96) PASS();
+    else FAIL("reset did not restore 100%");
+}
+
+int main() {
+    printf("=== Adaptive Bitrate Controller Tests ===\n\n");
+
+    test_clean_uplink_holds();
+    test_backlog_steps_down();
+    test_hard_congestion_steps_twice();
+    test_floor_and_bottom();
+    test_recovery_needs_streak();
+    test_reset();
+
+    printf("\n=== Results: %d/%d tests passed ===\n", tests_passed, tests_run);
+
+    return (tests_passed == tests_run) ? 0 : 1;
+}
@@ -10,6 +10,10 @@
       3. test_overflow_returns_false            — capacity behavior (N=16 → effective 15)
       4. test_concurrent_audio_to_encoder       — 5s wall-time producer/consumer FIFO
       5. test_bounds_check_rejects_oversized    — Codex M-7 bounds-check exercise
+      6. test_in_place_reserve_front            — try_reserve/commit + front/pop:
+                                                  records written and read in
+                                                  the slot, reused slots carry
+                                                  no stale state into reads
 
     All tests pure-C++, no NJClient link; runs under TSan with zero races.
 */
@@ -307,6 +311,72 @@ static void test_bounds_check_rejects_oversized() {
     PASS();
 }
 
+// ============================================================================
+// Test 6: in-place API. The producer fills reserved slots directly (only the
+// header and sample_count floats per channel, as pushBlockRecord does) and
+// the consumer reads them through front()/pop(). Slots are reused without
+// zeroing, so sizes alternate large/small to prove stale tails are never
+// read. Runs concurrently so TSan covers the commit/pop publication.
+// ============================================================================
+static void test_in_place_reserve_front() {
+    TEST("In-place try_reserve/commit + front/pop: 20000 records, varying sizes, FIFO + data intact");
+
+    static jamwide::SpscRing<jamwide::BlockRecord, 16> ring;
+    bool ok = ring.front() == nullptr;   // empty
+
+    // Full ring: N-1 reservations succeed, then nullptr.
+    for (int i = 0; i < 15; ++i) {
+        jamwide::BlockRecord* br = ring.try_reserve();
+        if (!br) { ok = false; break; }
+        br->sample_count = 0;
+        ring.commit();
+    }
+    ok = ok && ring.try_reserve() == nullptr;
+    while (ring.front()) ring.pop();
+
+    constexpr int kRecords = 20000;
+    auto sizeFor = [](int i) { return (i & 1) ? 7 + (i % 13) : jamwide::MAX_BLOCK_SAMPLES - (i % 97); };
+    std::atomic<bool> data_ok{true};
+
+    std::thread consumer([&] {
+        int next = 0;
+        while (next < kRecords) {
+            const jamwide::BlockRecord* br = ring.front();
+            if (!br) { std::this_thread::yield(); continue; }
+            const int sc = sizeFor(next);
+            bool good = br->attr == next && br->sample_count == sc && br->nch == 2;
+            for (int s = 0; good && s < sc; ++s) {
+                good = br->samples[s] == static_cast<float>(next + s)
+                    && br->samples[sc + s] == -static_cast<float>(next + s);
+            }
+            if (!good) data_ok.store(false);
+            ring.pop();
+            ++next;
+        }
+    });
+
+    for (int i = 0; i < kRecords; ++i) {
+        jamwide::BlockRecord* br;
+        while (!(br = ring.try_reserve())) std::this_thread::yield();
+        const int sc = sizeFor(i);
+        br->attr = i;
+        br->sample_count = sc;
+        br->nch = 2;
+        for (int s = 0; s < sc; ++s) {
+            br->samples[s] = static_cast<float>(i + s);
+            br->samples[sc + s] = -static_cast<float>(i + s);
+        }
+        ring.commit();
+    }
+    consumer.join();
+
+    if (ok && data_ok.load() && ring.empty()) {
+        PASS();
+    } else {
+        FAIL("in-place reserve/front roundtrip corrupted or mis-sized");
+    }
+}
+
 // ============================================================================
 // main
 // ============================================================================
@@ -318,6 +388,7 @@ int main() {
     test_overflow_returns_false();
     test_concurrent_audio_to_encoder();
     test_bounds_check_rejects_oversized();
+    test_in_place_reserve_front();
 
     std::printf("\n%d/%d tests passed\n", tests_passed, tests_run);
     return tests_passed == tests_run ? 0 : 1;
@@ -0,0 +1,253 @@
+/*
+    JamWide Plugin - test_command_queue.cpp
+    Multi-producer command queue (src/threading/mpsc_queue.h) and command
+    coalescing (src/threading/ui_command.h).
+
+    Checks that concurrent producers pushing UiCommands with heap-allocated
+    strings lose nothing and keep per-producer order, that a full queue
+    counts drops and the notifier fires per push, that a 1 kHz fader sweep
+    collapses to one command carrying the newest value, that fields set only
+    by an older command survive a merge, that non-mergeable commands act
+    as barriers, and that a run wider than the fixed coalescing scratch
+    only loses folds, never order.
+*/
+
+#include <atomic>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "threading/mpsc_queue.h"
+#include "threading/ui_command.h"
+
+using namespace jamwide;
+
+static int tests_run = 0;
+static int tests_passed = 0;
+
+#define TEST(name) \
+    do { \
+        tests_run++; \
+        printf("  TEST: %s ... ", name); \
+        fflush(stdout); \
+    } while(0)
+
+#define PASS() \
+    do { \
+        tests_passed++; \
+        printf("PASSED\n"); \
+    } while(0)
+
+#define FAIL(msg) \
+    do { \
+        printf("FAILED: %s\n", msg); \
+    } while(0)
+
+static SetUserChannelStateCommand fader(int user, int ch, float vol)
+{
+    SetUserChannelStateCommand c;
+    c.user_index = user;
+    c.channel_index = ch;
+    c.set_vol = true;
+    c.volume = vol;
+    return c;
+}
+
+// ============================================================
+// Test 1: concurrent producers, single consumer
+// ============================================================
+static void test_multi_producer() {
+    TEST("4 producers: nothing lost, per-producer order kept");
+
+    static MpscQueue<UiCommand, 256> q;
+    const int kPer = 20000;
+    std::atomic<bool> done{false};
+    std::vector<int> next(4, 0);
+    bool ok = true;
+    int received = 0;
+
+    std::thread consumer([&] {
+        while (!done.load() || !q.empty()) {
+            q.drain([&](UiCommand&& cmd) {
+                auto* c = std::get_if<SendChatCommand>(&cmd);
+                if (!c) { ok = false; return; }
+                const int p = c->target[0] - '0';
+                const int seq = std::stoi(c->text);
+                if (p < 0 || p > 3 || seq != next[p]) ok = false;
+                else next[p]++;
+                received++;
+            });
+            std::this_thread::yield();
+        }
+    });
+    std::vector<std::thread> producers;
+    for (int p = 0; p < 4; p++) {
+        producers.emplace_back([p] {
+            for (int i = 0; i < kPer; i++) {
+                SendChatCommand c;
+                c.type = "MSG";
+                c.target = std::to_string(p);
+                c.text = std::to_string(i) + std::string(40, 'x');  // defeat SSO
+                // try_push only moves from its argument once it owns a cell,
+                // so a rejected command is still intact for the retry.
+                UiCommand cmd{std::move(c)};
+                while (!q.try_push(std::move(cmd))) std::this_thread::yield();
+            }
+        });
+    }
+    for (auto& t : producers) t.join();
+    done.store(true);
+    consumer.join();
+
+    if (ok && received == 4 * kPer && q.stats().pushed == 4ull * kPer) {
+        PASS();
+    } else {
+        char msg[128];
+        snprintf(msg, sizeof(msg), "ok=%d received=%d", ok ? 1 : 0, received);
+        FAIL(msg);
+    }
+}
+
+// ============================================================
+// Test 2: drops and notifier
+// ============================================================
+static int g_notified = 0;
+
+static void test_drops_and_notifier() {
+    TEST("full queue counts drops; notifier fires per push");
+
+    MpscQueue<UiCommand, 8> q;
+    q.set_notifier([](void* ctx) { ++*static_cast<int*>(ctx); }, &g_notified);
+    int pushed = 0;
+    for (int i = 0; i < 12; i++) pushed += q.try_push(DisconnectCommand{}) ? 1 : 0;
+    q.set_notifier(nullptr, nullptr);
+    q.try_push(DisconnectCommand{});   // full: another drop, no notify
+
+    const size_t drained = q.drain([](UiCommand&&) {});
+    const auto s = q.stats();
+    if (pushed == 8 && g_notified == 8 && s.dropped == 5 && drained == 8 && s.max_depth == 8) {
+        PASS();
+    } else {
+        FAIL("drop/notify accounting wrong");
+    }
+}
+
+// ============================================================
+// Test 3: a fader sweep collapses to the newest value
+// ============================================================
+static void test_sweep_coalesces() {
+    TEST("1000-step fader sweep per target collapses to newest value");
+
+    std::vector<UiCommand> batch;
+    CoalesceScratch scratch;
+    for (int i = 0; i < 1000; i++) {
+        batch.push_back(fader(1, 0, i / 1000.0f));
+        batch.push_back(fader(1, 1, 1.0f - i / 1000.0f));
+    }
+    const size_t folded = coalesceCommands(batch, scratch);
+
+    bool ok = folded == 1998 && batch.size() == 2;
+    if (ok) {
+        auto* a = std::get_if<SetUserChannelStateCommand>(&batch[0]);
+        auto* b = std::get_if<SetUserChannelStateCommand>(&batch[1]);
+        ok = a && b && a->channel_index == 0 && a->volume == 999 / 1000.0f &&
+             b->channel_index == 1 && b->volume == 1.0f - 999 / 1000.0f;
+    }
+
+    if (ok) {
+        PASS();
+    } else {
+        FAIL("sweep not collapsed correctly");
+    }
+}
+
+// ============================================================
+// Test 4: merge keeps older-only fields; barriers hold
+// ============================================================
+static void test_merge_and_barrier() {
+    TEST("merge keeps older-only fields; other commands are barriers");
+
+    SetLocalChannelMonitoringCommand m1;
+    m1.channel = 2;
+    m1.set_mute = true;
+    m1.mute = true;
+    SetLocalChannelMonitoringCommand m2;
+    m2.channel = 2;
+    m2.set_volume = true;
+    m2.volume = 0.5f;
+
+    std::vector<UiCommand> batch;
+    CoalesceScratch scratch;
+    batch.push_back(m1);
+    batch.push_back(m2);
+    batch.push_back(fader(0, 0, 0.1f));
+    batch.push_back(SetRoutingModeCommand{1});     // barrier
+    batch.push_back(fader(0, 0, 0.2f));
+    batch.push_back(fader(0, 0, 0.3f));
+    const size_t folded = coalesceCommands(batch, scratch);
+
+    bool ok = folded == 2 && batch.size() == 4;
+    if (ok) {
+        auto* m = std::get_if<SetLocalChannelMonitoringCommand>(&batch[0]);
+        auto* f1 = std::get_if<SetUserChannelStateCommand>(&batch[1]);
+        auto* r = std::get_if<SetRoutingModeCommand>(&batch[2]);
+        auto* f2 = std::get_if<SetUserChannelStateCommand>(&batch[3]);
+        ok = m && m->set_mute && m->mute && m->set_volume && m->volume == 0.5f &&
+             !m->set_pan && !m->set_solo &&
+             f1 && f1->volume == 0.1f && r && r->mode == 1 && f2 && f2->volume == 0.3f;
+    }
+
+    if (ok) {
+        PASS();
+    } else {
+        FAIL("merge or barrier ordering wrong");
+    }
+}
+
+// ============================================================
+// Test 5: more targets than scratch slots stay in order, unmerged
+// ============================================================
+static void test_scratch_overflow() {
+    TEST("targets beyond the scratch capacity pass through unmerged");
+
+    const int n = (int)CoalesceScratch::kMaxSlots + 10;
+    std::vector<UiCommand> batch;
+    CoalesceScratch scratch;
+    for (int pass = 0; pass < 2; pass++)
+        for (int i = 0; i < n; i++)
+            batch.push_back(fader(i, 0, pass ? 1.0f : 0.5f));
+    const size_t folded = coalesceCommands(batch, scratch);
+
+    // the first kMaxSlots targets fold, the last 10 appear twice
+    bool ok = folded == CoalesceScratch::kMaxSlots && batch.size() == (size_t)n + 10;
+    for (size_t i = 0; ok && i < batch.size(); i++) {
+        auto* f = std::get_if<SetUserChannelStateCommand>(&batch[i]);
+        const int want_user = i < (size_t)n ? (int)i : (int)CoalesceScratch::kMaxSlots + (int)(i - n);
+        const float want_vol = i < CoalesceScratch::kMaxSlots || i >= (size_t)n ? 1.0f : 0.5f;
+        ok = f && f->user_index == want_user && f->volume == want_vol;
+    }
+
+    if (ok) {
+        PASS();
+    } else {
+        FAIL("overflowing run merged or reordered wrongly");
+    }
+}
+
+// ============================================================
+// Main
+// ============================================================
+int main() {
+    printf("=== Command Queue Tests ===\n\n");
+
+    test_multi_producer();
+    test_drops_and_notifier();
+    test_sweep_coalesces();
+    test_merge_and_barrier();
+    test_scratch_overflow();
+
+    printf("\n=== Results: %d/%d tests passed ===\n", tests_passed, tests_run);
+
+    return (tests_passed == tests_run) ? 0 : 1;
+}
@@ -67,9 +67,7 @@ namespace test_dmb {
 
 struct DecodeMediaBuffer {
     jamwide::SpscRing<jamwide::DecodeChunk, 32> chunks;
-    std::array<uint8_t, jamwide::CHUNK_BYTES * 2> consumer_buf{};
-    int  consumer_buf_len = 0;
-    int  consumer_buf_pos = 0;
+    int  front_pos = 0;   // read offset into chunks.front()
     std::atomic<int64_t> total_written{0};
     std::atomic<uint64_t> drops{0};
 
@@ -78,16 +76,18 @@ struct DecodeMediaBuffer {
         const uint8_t* in = static_cast<const uint8_t*>(buf);
         int remaining = len;
         while (remaining > 0) {
-            jamwide::DecodeChunk chunk{};
-            chunk.len = std::min(remaining, jamwide::CHUNK_BYTES);
-            std::memcpy(chunk.data, in, static_cast<size_t>(chunk.len));
-            if (!chunks.try_push(chunk)) {
+            jamwide::DecodeChunk* chunk = chunks.try_reserve();
+            if (!chunk) {
                 drops.fetch_add(1, std::memory_order_relaxed);
                 return len - remaining;
             }
-            in += chunk.len;
-            remaining -= chunk.len;
-            total_written.fetch_add(chunk.len, std::memory_order_relaxed);
+            const int clen = std::min(remaining, jamwide::CHUNK_BYTES);
+            chunk->len = clen;
+            std::memcpy(chunk->data, in, static_cast<size_t>(clen));
+            chunks.commit();
+            in += clen;
+            remaining -= clen;
+            total_written.fetch_add(clen, std::memory_order_relaxed);
         }
         return len;
     }
@@ -97,24 +97,23 @@ struct DecodeMediaBuffer {
         int written = 0;
         uint8_t* out = static_cast<uint8_t*>(buf);
         while (written < len) {
-            const int avail = consumer_buf_len - consumer_buf_pos;
-            if (avail > 0) {
-                const int take = std::min(avail, len - written);
-                std::memcpy(out + written,
-                            consumer_buf.data() + consumer_buf_pos,
-                            static_cast<size_t>(take));
-                consumer_buf_pos += take;
-                written += take;
-                continue;
-            }
-            auto chunk = chunks.try_pop();
+            const jamwide::DecodeChunk* chunk = chunks.front();
             if (!chunk) break;
             const int clen = chunk->len;
-            if (clen <= 0 || clen > jamwide::CHUNK_BYTES) continue;
-            std::memcpy(consumer_buf.data(), chunk->data,
-                        static_cast<size_t>(clen));
-            consumer_buf_len = clen;
-            consumer_buf_pos = 0;
+            if (clen <= 0 || clen > jamwide::CHUNK_BYTES || front_pos >= clen) {
+                chunks.pop();
+                front_pos = 0;
+                continue;
+            }
+            const int take = std::min(clen - front_pos, len - written);
+            std::memcpy(out + written, chunk->data + front_pos,
+                        static_cast<size_t>(take));
+            front_pos += take;
+            written += take;
+            if (front_pos == clen) {
+                chunks.pop();
+                front_pos = 0;
+            }
         }
         return written;
     }
@@ -158,8 +157,9 @@ static void test_chunk_roundtrip() {
 }
 
 // ============================================================================
-// Test 2: partial read via consumer buffer — write 1024 bytes (fits in one
-// chunk), then call Read(buf, 256) four times. Each call must return exactly
+// Test 2: partial reads of the front chunk (read in place, popped once used
+// up) — write 1024 bytes (fits in one chunk), then call Read(buf, 256) four
+// times. Each call must return exactly
 // 256 bytes, with the byte sequence reconstructed in order. Mirrors the
 // audio-thread codec srcbuf-fill pattern (codec asks for sub-chunk lengths
 // over multiple calls).
@@ -15,15 +15,13 @@
     15.1-10's Instruments UAT — a runtime measurement, not a compile-time
     field-access dependency.
 
-    Test 4 covers the Codex M-7 enforcement contract on
-    NJClient::SetMaxAudioBlockSize (throws std::runtime_error if
-    maxSamplesPerBlock > MAX_BLOCK_SAMPLES). The test does NOT link NJClient
-    (this binary is pure-C++); instead it reimplements the assertion body
-    inline using a stand-in lambda. This mirrors the production body in
-    src/core/njclient.cpp::SetMaxAudioBlockSize and locks the contract at
-    test-time. If production diverges from the contract, the production
-    code's grep-criterion (`grep -n 'std::runtime_error' src/core/njclient.cpp`
-    in 15.1-08-PLAN.md) will fail.
+    Test 4 covers the NJClient::SetMaxAudioBlockSize contract. It used to
+    throw std::runtime_error above MAX_BLOCK_SAMPLES (Codex M-7, the fixed
+    BlockRecord slot size); since the broadcast/wave feeds moved to
+    SampleFifo, which splits large blocks, any positive size is accepted and
+    sizes <= 0 are a no-op. The test does NOT link NJClient (this binary is
+    pure-C++); it reimplements the body inline using a stand-in lambda that
+    mirrors src/core/njclient.cpp::SetMaxAudioBlockSize.
 */
 
 // Pull in the FULL decoder bodies (NOT WDL_VORBIS_INTERFACE_ONLY).
@@ -114,25 +112,23 @@ static void test_decoder_prealloc_documentation() {
 }
 
 // ============================================================
-// Test 4: Codex M-7 enforcement — SetMaxAudioBlockSize throws on bound violation
+// Test 4: SetMaxAudioBlockSize accepts any host block size
 // ============================================================
 //
-// NJClient::SetMaxAudioBlockSize is the host-block-size enforcement site for
-// the BlockRecord MAX_BLOCK_SAMPLES contract from 15.1-04. This test does NOT
-// link NJClient (this binary is pure-C++ + WDL + FLAC + libvorbis only); it
-// reimplements the production body inline using a stand-in lambda. The
-// production body in src/core/njclient.cpp::SetMaxAudioBlockSize is grep-locked
-// in the plan's acceptance criteria (`grep -n 'std::runtime_error' ...`).
+// NJClient::SetMaxAudioBlockSize used to enforce the BlockRecord
+// MAX_BLOCK_SAMPLES contract from 15.1-04 by throwing. The sample FIFOs that
+// replaced the BlockRecord rings split oversized blocks, so the ceiling is
+// gone: nothing throws, and sizes <= 0 leave tmpblock alone. This test does
+// NOT link NJClient (this binary is pure-C++ + WDL + FLAC + libvorbis only);
+// it reimplements the production body inline using a stand-in lambda.
 static void test_max_block_samples_assertion() {
-    TEST("M-7: SetMaxAudioBlockSize throws when maxSamplesPerBlock > MAX_BLOCK_SAMPLES");
-    auto SetMaxAudioBlockSizeStub = [](int maxSamplesPerBlock) {
+    TEST("SetMaxAudioBlockSize accepts sizes above MAX_BLOCK_SAMPLES without throwing");
+    int prealloc_bytes = 0;
+    auto SetMaxAudioBlockSizeStub = [&](int maxSamplesPerBlock) {
         if (maxSamplesPerBlock <= 0) return;
-        if (maxSamplesPerBlock > jamwide::MAX_BLOCK_SAMPLES) {
-            throw std::runtime_error(
-                "Host samplesPerBlock exceeds JamWide MAX_BLOCK_SAMPLES contract.");
-        }
-        // Production also calls tmpblock.Prealloc(...); no-op in stub since
-        // we don't link NJClient.
+        // Production calls tmpblock.Prealloc(...); record the size instead
+        // since we don't link NJClient.
+        prealloc_bytes = maxSamplesPerBlock * static_cast<int>(sizeof(float));
     };
 
     bool threw_oversize = false;
@@ -144,6 +140,8 @@ static void test_max_block_samples_assertion() {
         FAIL("oversize call threw wrong exception type");
         return;
     }
+    const bool oversize_prealloced =
+        prealloc_bytes == (jamwide::MAX_BLOCK_SAMPLES + 1) * static_cast<int>(sizeof(float));
 
     bool threw_inbound = false;
     try {
@@ -169,7 +167,10 @@ static void test_max_block_samples_assertion() {
         threw_negative = true;
     }
 
-    if (threw_oversize && !threw_inbound && !threw_zero && !threw_negative) {
+    // 0 / -1 must not touch the size recorded by the in-bound call.
+    if (!threw_oversize && !threw_inbound && !threw_zero && !threw_negative
+        && oversize_prealloced
+        && prealloc_bytes == jamwide::MAX_BLOCK_SAMPLES * static_cast<int>(sizeof(float))) {
         PASS();
     } else {
         FAIL("assertion behavior incorrect");
@@ -177,7 +178,7 @@ static void test_max_block_samples_assertion() {
 }
 
 int main() {
-    printf("test_decoder_prealloc - lighter sanity per Codex delta + M-7 enforcement\n");
+    printf("test_decoder_prealloc - lighter sanity per Codex delta + block-size contract\n");
     test_vorbis_constructs_cleanly();
     test_flac_init_runs_cleanly();
     test_decoder_prealloc_documentation();
@@ -0,0 +1,218 @@
+/*
+    JamWide Plugin - test_denormal_guard.cpp
+    FTZ/DAZ scope and VU flush (src/core/denormal_guard.h), plus a decaying-
+    signal benchmark through the mix kernels.
+
+    The benchmark feeds exponentially decaying input (what a peer's reverb
+    tail or an overlap fade turns into in a quiet room) through the same
+    steps the mixer runs per block: mixPeak into an accumulator, a one-pole
+    smoother standing in for resampler/fade arithmetic, scalePeak for the
+    master gain, and the VU decay. It counts subnormal results with and
+    without ScopedFlushDenormals and prints ns/sample for both; the test
+    fails if any subnormal survives under the guard or if the VU state ever
+    goes subnormal. Timing is reported, not asserted (machine-dependent).
+*/
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <optional>
+#include <vector>
+
+#include "core/denormal_guard.h"
+#include "core/mix_kernels.h"
+
+using namespace jamwide;
+
+static int tests_run = 0;
+static int tests_passed = 0;
+
+#define TEST(name) \
+    do { \
+        tests_run++; \
+        printf("  TEST: %s ... ", name); \
+        fflush(stdout); \
+    } while(0)
+
+#define PASS() \
+    do { \
+        tests_passed++; \
+        printf("PASSED\n"); \
+    } while(0)
+
+#define FAIL(msg) \
+    do { \
+        printf("FAILED: %s\n", msg); \
+    } while(0)
+
+static bool isSubnormal(float f)
+{
+    return std::fpclassify(f) == FP_SUBNORMAL;
+}
+
+// The compiler does not know MXCSR/FPCR writes affect arithmetic and will
+// happily move a multiply across them; an opaque call pins it in place.
+static float mulImpl(float a, float b) { return a * b; }
+static float (*volatile mul)(float, float) = mulImpl;
+
+// Compiled in at all? (kMask is 0 on platforms without an FTZ mode.)
+static bool guardSupported()
+{
+    ScopedFlushDenormals g;
+    return ScopedFlushDenormals::active();
+}
+
+// ============================================================
+// Test 1: Scope sets FTZ/DAZ and restores the previous mode
+// ============================================================
+static void test_scope_restores() {
+    TEST("ScopedFlushDenormals flushes inside the scope and restores after");
+
+    if (!guardSupported()) {
+        printf("(no FTZ mode on this target) ");
+        PASS();
+        return;
+    }
+
+    const float tiny = 1.0e-39f;   // subnormal
+    bool ok = !ScopedFlushDenormals::active();
+    ok = ok && isSubnormal(mul(tiny, 1.0f));   // default mode: subnormal survives
+    {
+        ScopedFlushDenormals outer;
+        ok = ok && ScopedFlushDenormals::active();
+        ok = ok && mul(tiny, 1.0f) == 0.0f;      // DAZ/FZ: input treated as zero
+        ok = ok && mul(1.0e-30f, 1.0e-10f) == 0.0f;   // FTZ: result flushed
+        {
+            ScopedFlushDenormals nested;   // already on: no-op, no restore
+            ok = ok && ScopedFlushDenormals::active();
+        }
+        ok = ok && ScopedFlushDenormals::active();
+    }
+    ok = ok && !ScopedFlushDenormals::active();
+    ok = ok && isSubnormal(mul(tiny, 1.0f));
+
+    if (ok) {
+        PASS();
+    } else {
+        FAIL("mode not set or not restored");
+    }
+}
+
+// ============================================================
+// Test 2: VU decay never goes subnormal
+// ============================================================
+static void test_vu_decay_flush() {
+    TEST("flushDenormal snaps decaying VU peaks to zero before FLT_MIN");
+
+    // process_samples' decay for a 16-frame block at 48 kHz, and for a huge one.
+    const double decays[] = {
+        std::pow(.25 * 0.25 * 0.25, 16 / 48000.0),
+        std::pow(.25 * 0.25 * 0.25, 8192 / 44100.0),
+    };
+    bool ok = true;
+    for (double decay : decays) {
+        float peak = 1.0f;
+        bool reached_zero = false;
+        for (int i = 0; i < 10000000 && !reached_zero; i++) {
+            peak = flushDenormal((float)(peak * decay));
+            if (isSubnormal(peak)) ok = false;
+            reached_zero = peak == 0.0f;
+        }
+        ok = ok && reached_zero;
+    }
+
+    if (ok) {
+        PASS();
+    } else {
+        FAIL("VU state went subnormal or never settled");
+    }
+}
+
+// ============================================================
+// Test 3: Decaying-signal benchmark through the mix kernels
+// ============================================================
+struct BenchResult {
+    double ns_per_sample = 0.0;
+    long long subnormals = 0;
+};
+
+static BenchResult runDecayBench(bool guarded)
+{
+    constexpr int kBlock = 64;
+    constexpr int kBlocks = 4000;
+    constexpr int kChannels = 8;
+
+    std::vector<float> in(kBlock), acc(kBlock), smooth(kChannels, 0.0f);
+    float vu[kChannels] = {};
+    const double decay = std::pow(.25 * 0.25 * 0.25, kBlock / 48000.0);
+    volatile float start = 1.0e-33f;   // starts near the bottom of the normal range
+    float level = start;
+
+    BenchResult r;
+    std::optional<ScopedFlushDenormals> guard;
+    if (guarded) guard.emplace();
+
+    const auto t0 = std::chrono::steady_clock::now();
+    for (int b = 0; b < kBlocks; b++) {
+        for (int i = 0; i < kBlock; i++) {
+            in[i] = level;
+            level *= 0.9998f;   // slides into subnormals without a guard
+        }
+        for (int i = 0; i < kBlock; i++) acc[i] = 0.0f;
+        for (int c = 0; c < kChannels; c++) {
+            vu[c] = flushDenormal((float)(vu[c] * decay));
+            vu[c] = mixPeak(acc.data(), in.data(), kBlock, 0.7f, vu[c]);
+            float y = smooth[c];
+            for (int i = 0; i < kBlock; i++) {
+                y = y * 0.99f + acc[i] * 0.01f;   // fade/resampler stand-in
+                acc[i] = y;
+            }
+            smooth[c] = y;
+        }
+        scalePeak(acc.data(), kBlock, 0.8f, 0.0f);
+        for (int i = 0; i < kBlock; i++) r.subnormals += isSubnormal(acc[i]) ? 1 : 0;
+        for (int c = 0; c < kChannels; c++) r.subnormals += isSubnormal(smooth[c]) ? 1 : 0;
+    }
+    const auto t1 = std::chrono::steady_clock::now();
+
+    guard.reset();
+    const double ns = (double) std::chrono::duration_cast<std::chrono::nanoseconds>(t1 - t0).count();
+    r.ns_per_sample = ns / ((double) kBlocks * kBlock * kChannels);
+    return r;
+}
+
+static void test_decay_benchmark() {
+    TEST("decaying signal through the mixer: no subnormals under the guard");
+
+    const BenchResult plain = runDecayBench(false);
+    const BenchResult guarded = runDecayBench(true);
+
+    printf("\n    unguarded: %.2f ns/sample, %lld subnormal results"
+           "\n    guarded:   %.2f ns/sample, %lld subnormal results\n    ",
+           plain.ns_per_sample, plain.subnormals,
+           guarded.ns_per_sample, guarded.subnormals);
+
+    bool ok = true;
+    if (guardSupported()) ok = guarded.subnormals == 0 && plain.subnormals > 0;
+
+    if (ok) {
+        PASS();
+    } else {
+        FAIL("subnormals survived under the guard (or the bench never produced any)");
+    }
+}
+
+// ============================================================
+// Main
+// ============================================================
+int main() {
+    printf("=== Denormal Guard Tests ===\n\n");
+
+    test_scope_restores();
+    test_vu_decay_flush();
+    test_decay_benchmark();
+
+    printf("\n=== Results: %d/%d tests passed ===\n", tests_passed, tests_run);
+
+    return (tests_passed == tests_run) ? 0 : 1;
+}
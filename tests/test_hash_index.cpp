@@ -0,0 +1,196 @@
+/*
+    JamWide Plugin - test_hash_index.cpp
+    Open-addressing pointer index (src/core/hash_index.h).
+
+    Exercises PtrHashIndex the way NJClient does: 16-byte GUID keys for
+    downloads and string keys for users. Checks find/erase against a plain
+    linear scan over a long random insert/erase churn (which drives
+    backward-shift deletion through wrapped clusters), forced hash
+    collisions, duplicate keys, and growth.
+*/
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "core/hash_index.h"
+
+static int tests_run = 0;
+static int tests_passed = 0;
+
+#define TEST(name) \
+    do { \
+        tests_run++; \
+        printf("  TEST: %s ... ", name); \
+        fflush(stdout); \
+    } while(0)
+
+#define PASS() \
+    do { \
+        tests_passed++; \
+        printf("PASSED\n"); \
+    } while(0)
+
+#define FAIL(msg) \
+    do { \
+        printf("FAILED: %s\n", msg); \
+    } while(0)
+
+struct Download { unsigned char guid[16]; };
+struct User { std::string name; };
+
+struct ByGuid {
+    typedef const unsigned char *Key;
+    static uint32_t hash(Key k) { return jamwide::hashBytes(k, 16); }
+    static Key key(const Download *v) { return v->guid; }
+    static bool equal(const Download *v, Key k) { return !memcmp(v->guid, k, 16); }
+};
+
+struct ByName {
+    typedef const char *Key;
+    static uint32_t hash(Key k) { return jamwide::hashString(k); }
+    static Key key(const User *v) { return v->name.c_str(); }
+    static bool equal(const User *v, Key k) { return v->name == k; }
+};
+
+// Every key lands in the same home slot: worst-case clustering.
+struct Colliding {
+    typedef const char *Key;
+    static uint32_t hash(Key) { return 7; }
+    static Key key(const User *v) { return v->name.c_str(); }
+    static bool equal(const User *v, Key k) { return v->name == k; }
+};
+
+static Download* linear_find(std::vector<Download*>& list, const unsigned char* g)
+{
+    for (Download* d : list)
+        if (!memcmp(d->guid, g, 16)) return d;
+    return nullptr;
+}
+
+// ============================================================
+// Test 1: random churn matches a linear scan
+// ============================================================
+static void test_churn_matches_scan() {
+    TEST("GUID index matches linear scan under insert/erase churn");
+
+    std::mt19937 rng(1234);
+    std::vector<Download> pool(512);
+    for (Download& d : pool)
+        for (int i = 0; i < 16; i++) d.guid[i] = (unsigned char)rng();
+
+    jamwide::PtrHashIndex<Download, ByGuid> idx;
+    std::vector<Download*> live;
+    bool ok = true;
+
+    for (int step = 0; step < 50000 && ok; step++)
+    {
+        Download* d = &pool[rng() % pool.size()];
+        const bool present = linear_find(live, d->guid) != nullptr;
+        if (!present && (live.size() < 200 || (rng() & 1)))
+        {
+            idx.insert(d);
+            live.push_back(d);
+        }
+        else if (present)
+        {
+            ok = idx.erase(d);
+            for (size_t i = 0; i < live.size(); i++)
+                if (live[i] == d) { live[i] = live.back(); live.pop_back(); break; }
+        }
+        // spot-check a few keys, present or not
+        for (int q = 0; q < 4 && ok; q++)
+        {
+            const Download* k = &pool[rng() % pool.size()];
+            ok = idx.find(k->guid) == linear_find(live, k->guid);
+        }
+    }
+    ok = ok && idx.size() == live.size();
+    for (Download* d : live) ok = ok && idx.find(d->guid) == d;
+
+    if (ok) {
+        PASS();
+    } else {
+        FAIL("index and list disagree");
+    }
+}
+
+// ============================================================
+// Test 2: all keys in one cluster, erase from the middle
+// ============================================================
+static void test_collisions() {
+    TEST("colliding keys survive middle erasures");
+
+    std::vector<User> users(7);
+    jamwide::PtrHashIndex<User, Colliding> idx;
+    for (size_t i = 0; i < users.size(); i++)
+    {
+        users[i].name = "user" + std::to_string(i);
+        idx.insert(&users[i]);
+    }
+    bool ok = idx.erase(&users[2]) && idx.erase(&users[5]) && !idx.erase(&users[5]);
+    for (size_t i = 0; i < users.size(); i++)
+    {
+        User* expect = (i == 2 || i == 5) ? nullptr : &users[i];
+        ok = ok && idx.find(users[i].name.c_str()) == expect;
+    }
+
+    if (ok && idx.size() == 5) {
+        PASS();
+    } else {
+        FAIL("lookup broken after erase in cluster");
+    }
+}
+
+// ============================================================
+// Test 3: duplicate keys and growth
+// ============================================================
+static void test_duplicates_and_growth() {
+    TEST("duplicate keys erase by pointer; table grows");
+
+    User a{"alice"}, a2{"alice"}, b{"bob"};
+    jamwide::PtrHashIndex<User, ByName> idx;
+    idx.insert(&a);
+    idx.insert(&a2);
+    idx.insert(&b);
+    User* first = idx.find("alice");
+    bool ok = (first == &a || first == &a2) && idx.erase(first);
+    ok = ok && idx.find("alice") == (first == &a ? &a2 : &a) && idx.find("bob") == &b;
+    ok = ok && idx.find("carol") == nullptr;
+
+    std::vector<User> many(1000);
+    for (size_t i = 0; i < many.size(); i++)
+    {
+        many[i].name = "peer@" + std::to_string(i);
+        idx.insert(&many[i]);
+    }
+    for (size_t i = 0; i < many.size() && ok; i++) ok = idx.find(many[i].name.c_str()) == &many[i];
+    ok = ok && idx.capacity() >= 2 * idx.size();
+
+    idx.clear();
+    ok = ok && idx.size() == 0 && idx.find("bob") == nullptr;
+
+    if (ok) {
+        PASS();
+    } else {
+        FAIL("duplicate/growth handling wrong");
+    }
+}
+
+// ============================================================
+// Main
+// ============================================================
+int main() {
+    printf("=== Hash Index Tests ===\n\n");
+
+    test_churn_matches_scan();
+    test_collisions();
+    test_duplicates_and_growth();
+
+    printf("\n=== Results: %d/%d tests passed ===\n", tests_passed, tests_run);
+
+    return (tests_passed == tests_run) ? 0 : 1;
+}
@@ -0,0 +1,277 @@
+/*
+    JamWide Plugin - test_interval_store.cpp
+    Memory-mapped interval files (src/core/interval_store.h).
+
+    Writes interval-sized streams through MappedIntervalFile in network-sized
+    chunks, checks the file on disk is truncated to exactly the appended
+    bytes on close (no preallocated tail), that growth past the initial reserve
+    preserves earlier data, that mapReadOnly sees the same bytes after the
+    caller's FILE* is closed, and that a file still being written never
+    shows readers the reserve. Links interval_store.cpp only (no NJClient).
+*/
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "core/interval_store.h"
+
+using jamwide::MappedIntervalFile;
+
+static int tests_run = 0;
+static int tests_passed = 0;
+
+#define TEST(name) \
+    do { \
+        tests_run++; \
+        printf("  TEST: %s ... ", name); \
+        fflush(stdout); \
+    } while(0)
+
+#define PASS() \
+    do { \
+        tests_passed++; \
+        printf("PASSED\n"); \
+    } while(0)
+
+#define FAIL(msg) \
+    do { \
+        printf("FAILED: %s\n", msg); \
+    } while(0)
+
+static std::string temp_path(const char* tag)
+{
+    char buf[512];
+    const char* dir = getenv("TMPDIR");
+#ifdef _WIN32
+    if (!dir) dir = getenv("TEMP");
+#endif
+    if (!dir) dir = "/tmp";
+    snprintf(buf, sizeof(buf), "%s/jamwide_interval_store_%s.ogg", dir, tag);
+    return buf;
+}
+
+static std::vector<unsigned char> pattern(size_t n, unsigned seed)
+{
+    std::vector<unsigned char> v(n);
+    for (size_t i = 0; i < n; i++) v[i] = (unsigned char)((i * 131 + seed) & 0xff);
+    return v;
+}
+
+static std::vector<unsigned char> read_back(const std::string& path)
+{
+    std::vector<unsigned char> out;
+    FILE* fp = fopen(path.c_str(), "rb");
+    if (!fp) return out;
+    unsigned char buf[8192];
+    size_t n;
+    while ((n = fread(buf, 1, sizeof(buf), fp)) > 0) out.insert(out.end(), buf, buf + n);
+    fclose(fp);
+    return out;
+}
+
+// Append `data` in chunks of `chunk` bytes, like RemoteDownload::Write does
+// for each MESSAGE_SERVER_DOWNLOAD_INTERVAL_WRITE.
+static bool write_chunked(MappedIntervalFile& f, const std::vector<unsigned char>& data, size_t chunk)
+{
+    for (size_t off = 0; off < data.size(); off += chunk) {
+        const size_t n = data.size() - off < chunk ? data.size() - off : chunk;
+        if (!f.append(data.data() + off, n)) return false;
+    }
+    return true;
+}
+
+// ============================================================
+// Test 1: small interval, file truncated to logical length on close
+// ============================================================
+static void test_write_truncates() {
+    TEST("writer truncates preallocated segment on close");
+
+    const std::string path = temp_path("small");
+    const std::vector<unsigned char> data = pattern(10000, 7);
+    MappedIntervalFile f;
+    bool ok = f.openWrite(path.c_str()) && write_chunked(f, data, 1400);
+    const size_t sz = f.size();
+    f.close();
+
+    const std::vector<unsigned char> disk = read_back(path);
+    remove(path.c_str());
+    if (!ok || sz != data.size()) {
+        FAIL("append failed or wrong logical size");
+    } else if (disk != data) {
+        char msg[128];
+        snprintf(msg, sizeof(msg), "disk has %zu bytes, expected %zu", disk.size(), data.size());
+        FAIL(msg);
+    } else {
+        PASS();
+    }
+}
+
+// ============================================================
+// Test 2: growth past the initial reserve keeps earlier bytes
+// ============================================================
+static void test_growth() {
+    TEST("segment grows past reserve without losing data");
+
+    const std::string path = temp_path("grow");
+    // 4 KB reserve, ~700 KB written -> several doublings
+    const std::vector<unsigned char> data = pattern(700 * 1024 + 123, 3);
+    MappedIntervalFile f;
+    bool ok = f.openWrite(path.c_str(), 4096) && write_chunked(f, data, 9000);
+    ok = ok && f.size() == data.size() && !memcmp(f.data(), data.data(), data.size());
+    f.close();
+
+    const std::vector<unsigned char> disk = read_back(path);
+    remove(path.c_str());
+    if (ok && disk == data) {
+        PASS();
+    } else {
+        FAIL("data mismatch after growth");
+    }
+}
+
+// ============================================================
+// Test 3: read mapping survives fclose and matches the file
+// ============================================================
+static void test_map_read_only() {
+    TEST("mapReadOnly maps whole file, valid after fclose");
+
+    const std::string path = temp_path("read");
+    const std::vector<unsigned char> data = pattern(50000, 11);
+    {
+        MappedIntervalFile w;
+        if (!w.openWrite(path.c_str()) || !write_chunked(w, data, 4096)) {
+            FAIL("writer setup failed");
+            return;
+        }
+    }   // destructor closes + truncates
+
+    FILE* fp = fopen(path.c_str(), "rb");
+    MappedIntervalFile r;
+    const bool mapped = fp && r.mapReadOnly(fp);
+    if (fp) fclose(fp);
+
+    const bool ok = mapped && r.size() == data.size() && !memcmp(r.data(), data.data(), data.size());
+    r.close();
+    remove(path.c_str());
+    if (ok) {
+        PASS();
+    } else {
+        FAIL("mapped bytes differ from written bytes");
+    }
+}
+
+// ============================================================
+// Test 4: empty file maps as open with size 0
+// ============================================================
+static void test_map_empty() {
+    TEST("mapReadOnly on an empty file");
+
+    const std::string path = temp_path("empty");
+    {
+        MappedIntervalFile w;
+        w.openWrite(path.c_str());
+    }
+
+    FILE* fp = fopen(path.c_str(), "rb");
+    MappedIntervalFile r;
+    const bool mapped = fp && r.mapReadOnly(fp);
+    if (fp) fclose(fp);
+    const bool ok = mapped && r.isOpen() && r.size() == 0 && read_back(path).empty();
+    remove(path.c_str());
+    if (ok) {
+        PASS();
+    } else {
+        FAIL("empty file not handled");
+    }
+}
+
+// ============================================================
+// Test 5: failures leave the object closed
+// ============================================================
+static void test_failures() {
+    TEST("bad path / append on reader fail cleanly");
+
+    MappedIntervalFile w;
+    const bool opened = w.openWrite("/nonexistent-dir-jamwide/x.ogg");
+
+    const std::string path = temp_path("ro");
+    {
+        MappedIntervalFile tmp;
+        tmp.openWrite(path.c_str());
+        const unsigned char b[4] = { 1, 2, 3, 4 };
+        tmp.append(b, sizeof(b));
+    }
+    FILE* fp = fopen(path.c_str(), "rb");
+    MappedIntervalFile r;
+    if (fp) { r.mapReadOnly(fp); fclose(fp); }
+    const unsigned char b = 0;
+    const bool appended = r.append(&b, 1);
+    r.close();
+    remove(path.c_str());
+
+    if (!opened && !w.isOpen() && !appended) {
+        PASS();
+    } else {
+        FAIL("expected open/append to fail");
+    }
+}
+
+// ============================================================
+// Test 6: an in-flight file shows only the appended bytes
+// ============================================================
+static void test_in_flight() {
+    TEST("reader of an open writer sees no reserved tail");
+
+    const std::string path = temp_path("inflight");
+    const std::vector<unsigned char> data = pattern(20000, 11);
+    MappedIntervalFile w;
+    bool ok = w.openWrite(path.c_str(), 4096);
+
+    // Across a growth: after each chunk a fresh reader must end exactly
+    // where the data does (a zero tail would decode as lost Opus packets),
+    // while the file itself holds the data and the reserved segment.
+    const size_t chunks[2] = { 3000, 20000 };
+    for (size_t c = 0; ok && c < 2; c++) {
+        const std::vector<unsigned char> part(data.begin(), data.begin() + chunks[c]);
+        ok = write_chunked(w, std::vector<unsigned char>(part.begin() + w.size(), part.end()), 1400);
+        const std::vector<unsigned char> disk = read_back(path);
+        ok = ok && disk.size() > part.size() && std::equal(part.begin(), part.end(), disk.begin());
+
+        FILE* fp = fopen(path.c_str(), "rb");
+        MappedIntervalFile r;
+        ok = ok && fp && r.mapReadOnly(fp) && r.size() == part.size() &&
+             !memcmp(r.data(), part.data(), part.size());
+        if (fp) fclose(fp);
+    }
+    w.close();
+    ok = ok && read_back(path) == data;
+    remove(path.c_str());
+
+    if (ok) {
+        PASS();
+    } else {
+        FAIL("reader saw a size other than the appended bytes");
+    }
+}
+
+// ============================================================
+// Main
+// ============================================================
+int main() {
+    printf("=== Interval Store Tests ===\n\n");
+
+    test_write_truncates();
+    test_growth();
+    test_map_read_only();
+    test_map_empty();
+    test_failures();
+    test_in_flight();
+
+    printf("\n=== Results: %d/%d tests passed ===\n", tests_passed, tests_run);
+
+    return (tests_passed == tests_run) ? 0 : 1;
+}
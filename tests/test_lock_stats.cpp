@@ -0,0 +1,129 @@
+/*
+    JamWide Plugin - test_lock_stats.cpp
+    Lock hold-time instrumentation (src/threading/lock_stats.h).
+
+    Checks that TimedLockGuard records hold times and flags an acquisition
+    as contended only when another thread held the mutex, that
+    ScopedHoldTimer never counts as contended, and that max/total survive
+    concurrent recorders.
+*/
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "threading/lock_stats.h"
+
+using namespace jamwide;
+
+static int tests_run = 0;
+static int tests_passed = 0;
+
+#define TEST(name) \
+    do { \
+        tests_run++; \
+        printf("  TEST: %s ... ", name); \
+        fflush(stdout); \
+    } while(0)
+
+#define PASS() \
+    do { \
+        tests_passed++; \
+        printf("PASSED\n"); \
+    } while(0)
+
+#define FAIL(msg) \
+    do { \
+        printf("FAILED: %s\n", msg); \
+    } while(0)
+
+// ============================================================
+// Test 1: hold time and contention
+// ============================================================
+static void test_hold_and_contention() {
+    TEST("TimedLockGuard records hold time and contention");
+
+    std::mutex m;
+    LockHoldStats stats;
+    {
+        TimedLockGuard<std::mutex> g(m, stats);
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    const auto a = stats.snapshot();
+    bool ok = a.acquisitions == 1 && a.contended == 0 &&
+              a.max_ns >= 5000000ull && a.total_ns == a.max_ns;
+
+    // Another thread holds the mutex when we ask for it.
+    std::atomic<bool> held{false};
+    std::thread holder([&] {
+        std::lock_guard<std::mutex> lk(m);
+        held.store(true);
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    });
+    while (!held.load()) std::this_thread::yield();
+    {
+        TimedLockGuard<std::mutex> g(m, stats);
+    }
+    holder.join();
+
+    const auto b = stats.snapshot();
+    ok = ok && b.acquisitions == 2 && b.contended == 1 && b.max_ns == a.max_ns;
+
+    if (ok) {
+        PASS();
+    } else {
+        FAIL("hold/contention accounting wrong");
+    }
+}
+
+// ============================================================
+// Test 2: scope timer and concurrent recorders
+// ============================================================
+static void test_scope_timer_concurrent() {
+    TEST("ScopedHoldTimer is never contended; max survives racing recorders");
+
+    LockHoldStats stats;
+    {
+        ScopedHoldTimer t(stats);
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    }
+    bool ok = stats.snapshot().contended == 0 && stats.snapshot().max_ns >= 2000000ull;
+
+    LockHoldStats racing;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; t++) {
+        threads.emplace_back([&racing, t] {
+            for (uint64_t i = 1; i <= 10000; i++)
+                racing.record(i * 4 + (uint64_t) t, (i & 1) != 0);
+        });
+    }
+    for (auto& th : threads) th.join();
+
+    const auto s = racing.snapshot();
+    ok = ok && s.acquisitions == 40000 && s.contended == 20000 &&
+         s.max_ns == 10000ull * 4 + 3 &&
+         s.total_ns == 4ull * (4ull * 10000 * 10001 / 2) + 10000ull * (0 + 1 + 2 + 3);
+
+    if (ok) {
+        PASS();
+    } else {
+        FAIL("scope timer or concurrent max/total wrong");
+    }
+}
+
+// ============================================================
+// Main
+// ============================================================
+int main() {
+    printf("=== Lock Stats Tests ===\n\n");
+
+    test_hold_and_contention();
+    test_scope_timer_concurrent();
+
+    printf("\n=== Results: %d/%d tests passed ===\n", tests_passed, tests_run);
+
+    return (tests_passed == tests_run) ? 0 : 1;
+}
@@ -0,0 +1,401 @@
+/*
+    JamWide Plugin - test_master_recorder.cpp
+    Streaming master recorder (src/core/master_recorder.h).
+
+    Covers what NJClient's /record path relies on: a producer thread's blocks
+    reach every sink in order and complete after stop; a sink that stalls
+    fills the ring, the drops are counted and come back as silence of the
+    same length (the file stays sample-aligned); blocks from an earlier
+    recording never leak into the next one, a restart does not wait for the
+    previous recording to finish and a failing sink is dropped without
+    stopping the others, while the last one failing ends the recording;
+    WavFileSink writes a valid 24-bit header and samples.
+*/
+
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "core/master_recorder.h"
+
+using namespace jamwide;
+
+static int tests_run = 0;
+static int tests_passed = 0;
+
+#define TEST(name) \
+    do { \
+        tests_run++; \
+        printf("  TEST: %s ... ", name); \
+        fflush(stdout); \
+    } while(0)
+
+#define PASS() \
+    do { \
+        tests_passed++; \
+        printf("PASSED\n"); \
+    } while(0)
+
+#define FAIL(msg) \
+    do { \
+        printf("FAILED: %s\n", msg); \
+    } while(0)
+
+// Records what it is given. The owner keeps a raw pointer; the recorder
+// owns the object, so results are copied out through `out` on finish().
+struct CapturedAudio {
+    std::vector<float> l, r;
+    int finishes = 0;
+};
+
+class CaptureSink : public MasterRecorderSink {
+public:
+    CaptureSink(CapturedAudio* out, std::atomic<bool>* gate = nullptr, int fail_after = -1)
+        : out_(out), gate_(gate), fail_after_(fail_after) {}
+
+    bool write(const float* l, const float* r, int frames) override
+    {
+        while (gate_ && !gate_->load()) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        if (fail_after_ >= 0 && (int) l_.size() >= fail_after_) return false;
+        l_.insert(l_.end(), l, l + frames);
+        r_.insert(r_.end(), r, r + frames);
+        return true;
+    }
+
+    void finish() override
+    {
+        out_->l = l_;
+        out_->r = r_;
+        out_->finishes++;
+    }
+
+private:
+    CapturedAudio* out_;
+    std::atomic<bool>* gate_;
+    int fail_after_;
+    std::vector<float> l_, r_;
+};
+
+static void waitFinished(MasterRecorder& rec)
+{
+    MasterRecorderStats st;
+    for (int i = 0; i < 5000; i++) {
+        rec.getStats(st);
+        if (!st.recording && !st.finishing) return;
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+}
+
+// ============================================================
+// Test 1: Stream reaches every sink in order
+// ============================================================
+static void test_stream_in_order() {
+    TEST("producer blocks reach both sinks in order, complete after stop()");
+
+    CapturedAudio a, b;
+    MasterRecorder rec(1024 * 1024);
+    std::vector<std::unique_ptr<MasterRecorderSink>> sinks;
+    sinks.emplace_back(new CaptureSink(&a));
+    sinks.emplace_back(new CaptureSink(&b));
+    bool ok = rec.start(std::move(sinks)) && rec.recording();
+
+    // Audio-thread stand-in: variable block sizes, one per millisecond
+    // (~10x real time at 48 kHz), far inside what the ring absorbs between
+    // two recorder wakeups.
+    const int kBlocks = 400;
+    std::atomic<int> refused{0};
+    std::thread producer([&rec, &refused] {
+        std::vector<float> l(1024), r(1024);
+        int n = 0;
+        for (int blk = 0; blk < kBlocks; blk++) {
+            const int frames = 32 + (blk * 37) % 900;
+            for (int i = 0; i < frames; i++) {
+                l[i] = (float) (n + i);
+                r[i] = -(float) (n + i);
+            }
+            if (!rec.push(l.data(), r.data(), frames)) refused++;
+            n += frames;
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    });
+    producer.join();
+    rec.stop();   // returns at once; the thread flushes and closes on its own
+    waitFinished(rec);
+
+    MasterRecorderStats st;
+    rec.getStats(st);
+    ok = ok && refused == 0 && a.finishes == 1 && b.finishes == 1 && !a.l.empty();
+    for (size_t i = 0; ok && i < a.l.size(); i++)
+        ok = a.l[i] == (float) i && a.r[i] == -(float) i;
+    ok = ok && b.l == a.l && b.r == a.r;
+    ok = ok && st.frames_written == a.l.size() && st.blocks_dropped == 0 && st.gap_frames == 0;
+    ok = ok && st.fifo_bytes >= 1024 * 1024 && st.fifo_high_water > 0;
+
+    // Not recording: push refuses.
+    float x = 1.0f;
+    ok = ok && !rec.push(&x, &x, 1) && !st.recording && !st.finishing;
+
+    if (ok) {
+        PASS();
+    } else {
+        FAIL("samples missing, reordered or stats wrong");
+    }
+}
+
+// ============================================================
+// Test 2: Stalled sink -> drops counted, gaps filled with silence
+// ============================================================
+static void test_backpressure_gap_fill() {
+    TEST("stalled sink fills the ring; drops come back as equal-length silence");
+
+    CapturedAudio a;
+    std::atomic<bool> gate{false};
+    MasterRecorder rec(64 * 1024);   // ~8k stereo frames of room
+    std::vector<std::unique_ptr<MasterRecorderSink>> sinks;
+    sinks.emplace_back(new CaptureSink(&a, &gate));
+    bool ok = rec.start(std::move(sinks));
+
+    // Push 1.0 blocks until the ring refuses a few, then resume with 2.0
+    // blocks once the sink is unstuck.
+    const int kFrames = 256;
+    std::vector<float> ones(kFrames, 1.0f), twos(kFrames, 2.0f);
+    uint64_t pushed = 0, dropped_frames = 0;
+    int refused = 0;
+    for (int i = 0; i < 2000 && refused < 5; i++) {
+        if (rec.push(ones.data(), ones.data(), kFrames)) pushed += kFrames;
+        else { dropped_frames += kFrames; refused++; }
+    }
+    gate.store(true);
+    for (int i = 0; i < 20; i++) {
+        while (!rec.push(twos.data(), twos.data(), kFrames)) {
+            dropped_frames += kFrames;
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        pushed += kFrames;
+    }
+    rec.stopAndWait();
+
+    MasterRecorderStats st;
+    rec.getStats(st);
+    ok = ok && refused == 5;
+    ok = ok && st.blocks_dropped == dropped_frames / kFrames;
+    ok = ok && st.gap_frames == dropped_frames;
+    ok = ok && a.l.size() == pushed + dropped_frames && st.frames_written == a.l.size();
+    ok = ok && st.fifo_high_water > 32 * 1024;
+
+    // Layout: all ones, then exactly the dropped frames of silence, then twos.
+    const size_t ones_end = pushed - 20 * kFrames;
+    for (size_t i = 0; ok && i < a.l.size(); i++) {
+        const float want = i < ones_end ? 1.0f : i < ones_end + dropped_frames ? 0.0f : 2.0f;
+        ok = a.l[i] == want;
+    }
+
+    if (ok) {
+        PASS();
+    } else {
+        FAIL("drop accounting or gap fill wrong");
+    }
+}
+
+// ============================================================
+// Test 3: Generations and sink failure
+// ============================================================
+static void test_generations_and_sink_errors() {
+    TEST("restart never sees the previous recording; a failing sink is dropped alone");
+
+    CapturedAudio first, good, bad;
+    MasterRecorder rec(64 * 1024);
+    std::vector<float> blk(128, 5.0f), blk2(128, 7.0f);
+
+    std::vector<std::unique_ptr<MasterRecorderSink>> sinks;
+    sinks.emplace_back(new CaptureSink(&first));
+    bool ok = rec.start(std::move(sinks));
+    for (int i = 0; i < 10; i++) ok = ok && rec.push(blk.data(), nullptr, 128);
+
+    // start() over a running recording: the old one is closed on its own
+    // thread, before the new one begins.
+    sinks.clear();
+    sinks.emplace_back(new CaptureSink(&good));
+    sinks.emplace_back(new CaptureSink(&bad, nullptr, 256));
+    ok = ok && rec.start(std::move(sinks));
+    for (int i = 0; i < 5000 && !rec.recording(); i++)
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    for (int i = 0; i < 10; i++) ok = ok && rec.push(blk2.data(), blk2.data(), 128);
+    rec.stopAndWait();
+    ok = ok && first.finishes == 1 && first.l.size() == 1280;
+
+    MasterRecorderStats st;
+    rec.getStats(st);
+    ok = ok && good.finishes == 1 && bad.finishes == 1;
+    ok = ok && good.l.size() == 1280 && bad.l.size() == 256 && st.sink_errors == 1;
+    for (float v : good.l) ok = ok && v == 7.0f;
+    for (float v : first.r) ok = ok && v == 5.0f;   // r = nullptr records l twice
+
+    // No sinks -> no recording.
+    sinks.clear();
+    sinks.emplace_back(nullptr);
+    ok = ok && !rec.start(std::move(sinks)) && !rec.recording();
+
+    // A restart over a recording stuck on its sink returns at once; the
+    // new files are opened only after the old ones are closed.
+    CapturedAudio stuck, next;
+    std::atomic<bool> gate{false};
+    sinks.clear();
+    sinks.emplace_back(new CaptureSink(&stuck, &gate));
+    ok = ok && rec.start(std::move(sinks)) && rec.push(blk.data(), nullptr, 128);
+    std::this_thread::sleep_for(std::chrono::milliseconds(3 * MasterRecorder::kWakeMs));
+    std::atomic<int> stuck_finishes_at_open{-1};
+    ok = ok && rec.start([&] {
+        stuck_finishes_at_open = stuck.finishes;
+        std::vector<std::unique_ptr<MasterRecorderSink>> s;
+        s.emplace_back(new CaptureSink(&next));
+        return s;
+    });
+    ok = ok && !rec.recording() && stuck_finishes_at_open < 0;
+    gate.store(true);
+    for (int i = 0; i < 5000 && !rec.recording(); i++)
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    ok = ok && rec.recording() && rec.push(blk2.data(), nullptr, 128);
+    rec.stopAndWait();
+    ok = ok && stuck_finishes_at_open == 1 && stuck.l.size() == 128;
+    ok = ok && next.finishes == 1 && next.l.size() == 128 && next.l[0] == 7.0f;
+
+    if (ok) {
+        PASS();
+    } else {
+        FAIL("stale audio leaked or sink failure not isolated");
+    }
+}
+
+// ============================================================
+// Test 4: Every sink failing ends the recording
+// ============================================================
+static void test_all_sinks_fail() {
+    TEST("when the last sink fails the recording stops and counts nothing more");
+
+    CapturedAudio a, b;
+    MasterRecorder rec(64 * 1024);
+    std::vector<float> blk(128, 1.0f);
+    std::vector<std::unique_ptr<MasterRecorderSink>> sinks;
+    sinks.emplace_back(new CaptureSink(&a, nullptr, 0));     // fails at once
+    sinks.emplace_back(new CaptureSink(&b, nullptr, 256));   // after two blocks
+    bool ok = rec.start(std::move(sinks));
+    for (int i = 0; i < 4; i++) rec.push(blk.data(), nullptr, 128);   // refused once it has ended
+
+    // Nothing calls stop(): the writer ends it on its own.
+    waitFinished(rec);
+    MasterRecorderStats st;
+    rec.getStats(st);
+    ok = ok && !st.recording && !st.finishing && st.sink_errors == 2;
+    ok = ok && st.frames_written == 256 && a.finishes == 1 && b.finishes == 1;
+    ok = ok && b.l.size() == 256 && !rec.push(blk.data(), nullptr, 128);
+    rec.stopAndWait();
+
+    if (ok) {
+        PASS();
+    } else {
+        FAIL("recording kept running after its sinks failed");
+    }
+}
+
+// ============================================================
+// Test 5: WavFileSink output
+// ============================================================
+static unsigned le(const unsigned char* p, int n)
+{
+    unsigned v = 0;
+    for (int i = n - 1; i >= 0; i--) v = (v << 8) | p[i];
+    return v;
+}
+
+static std::string temp_path(const char* tag)
+{
+    char buf[512];
+    const char* dir = getenv("TMPDIR");
+#ifdef _WIN32
+    if (!dir) dir = getenv("TEMP");
+#endif
+    if (!dir) dir = "/tmp";
+    snprintf(buf, sizeof(buf), "%s/jamwide_master_recorder_%s.wav", dir, tag);
+    return buf;
+}
+
+static void test_wav_sink() {
+    TEST("WavFileSink writes a valid 24-bit stereo header and samples");
+
+    const std::string tmp = temp_path("wav_sink");
+    const char* path = tmp.c_str();
+
+    bool ok = !WavFileSink::open(nullptr, 48000, 24);
+    ok = ok && !WavFileSink::open(std::fopen(path, "wb"), 48000, 8);   // unsupported depth
+    auto sink = WavFileSink::open(std::fopen(path, "wb"), 48000, 24);
+    ok = ok && sink != nullptr;
+    const int kFrames = 300000;   // > one 1 MB buffer
+    std::vector<float> l(kFrames), r(kFrames);
+    for (int i = 0; i < kFrames; i++) {
+        l[i] = (i % 200) / 100.0f - 1.0f;
+        r[i] = i == 5 ? 2.0f : i == 6 ? -3.0f : 0.5f;   // 5/6 clip
+    }
+    if (sink) {
+        ok = ok && sink->write(l.data(), r.data(), 1000) && sink->write(l.data() + 1000, r.data() + 1000, kFrames - 1000);
+        sink->finish();
+        sink.reset();
+    }
+
+    std::vector<unsigned char> file;
+    if (FILE* fp = std::fopen(path, "rb")) {
+        unsigned char buf[65536];
+        size_t n;
+        while ((n = std::fread(buf, 1, sizeof(buf), fp)) > 0) file.insert(file.end(), buf, buf + n);
+        std::fclose(fp);
+    }
+    std::remove(path);
+
+    const unsigned data_bytes = kFrames * 6;
+    ok = ok && file.size() == 44 + data_bytes;
+    if (ok) {
+        const unsigned char* h = file.data();
+        ok = !std::memcmp(h, "RIFF", 4) && le(h + 4, 4) == data_bytes + 36 && !std::memcmp(h + 8, "WAVEfmt ", 8);
+        ok = ok && le(h + 20, 2) == 1 && le(h + 22, 2) == 2 && le(h + 24, 4) == 48000;
+        ok = ok && le(h + 28, 4) == 48000 * 6 && le(h + 32, 2) == 6 && le(h + 34, 2) == 24;
+        ok = ok && !std::memcmp(h + 36, "data", 4) && le(h + 40, 4) == data_bytes;
+
+        auto sample = [&](int frame, int ch) {
+            const int v = (int) le(h + 44 + frame * 6 + ch * 3, 3);
+            return (v & 0x800000) ? v - 0x1000000 : v;
+        };
+        ok = ok && sample(0, 0) == -8388607 && sample(100, 0) == 0 && sample(150, 0) == 4194304;
+        ok = ok && sample(5, 1) == 8388607 && sample(6, 1) == -8388607 && sample(7, 1) == 4194304;
+        ok = ok && sample(kFrames - 1, 0) == (int) std::lrintf(l[kFrames - 1] * 8388607.0f);
+    }
+
+    if (ok) {
+        PASS();
+    } else {
+        FAIL("header or sample data wrong");
+    }
+}
+
+// ============================================================
+// Main
+// ============================================================
+int main() {
+    printf("=== Master Recorder Tests ===\n\n");
+
+    test_stream_in_order();
+    test_backpressure_gap_fill();
+    test_generations_and_sink_errors();
+    test_all_sinks_fail();
+    test_wav_sink();
+
+    printf("\n=== Results: %d/%d tests passed ===\n", tests_passed, tests_run);
+
+    return (tests_passed == tests_run) ? 0 : 1;
+}
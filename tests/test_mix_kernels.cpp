@@ -0,0 +1,231 @@
+/*
+    JamWide Plugin - test_mix_kernels.cpp
+    Vectorized mix/peak kernels (src/core/mix_kernels.h).
+
+    Each kernel is checked against the per-sample loop it replaced in
+    process_samples / mixInChannel (the branchy `if (f > maxf) ... else if
+    (f < -maxf)` peak), over lengths that exercise the vector body and the
+    scalar tail, from unaligned offsets, with the running peak both below
+    and above the block's own peak.
+*/
+
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include "core/mix_kernels.h"
+
+using namespace jamwide;
+
+static int tests_run = 0;
+static int tests_passed = 0;
+
+#define TEST(name) \
+    do { \
+        tests_run++; \
+        printf("  TEST: %s ... ", name); \
+        fflush(stdout); \
+    } while(0)
+
+#define PASS() \
+    do { \
+        tests_passed++; \
+        printf("PASSED\n"); \
+    } while(0)
+
+#define FAIL(msg) \
+    do { \
+        printf("FAILED: %s\n", msg); \
+    } while(0)
+
+static const int kLens[] = { 0, 1, 3, 4, 5, 7, 8, 31, 64, 129, 1023 };
+static const float kPeaks[] = { 0.0f, 0.3f, 5.0f };
+
+static std::vector<float> noise(int n, unsigned seed, float scale)
+{
+    srand(seed);
+    std::vector<float> v(n);
+    for (int i = 0; i < n; i++) v[i] = ((float)rand() / (float)RAND_MAX * 2.0f - 1.0f) * scale;
+    return v;
+}
+
+// Accumulated outputs may differ in the last bit where the compiler fuses
+// the scalar multiply-add; peaks and clamps are compared exactly.
+static bool close(const std::vector<float>& a, const std::vector<float>& b)
+{
+    if (a.size() != b.size()) return false;
+    for (size_t i = 0; i < a.size(); i++) {
+        const float d = a[i] - b[i];
+        if (d > 1e-6f || d < -1e-6f) return false;
+    }
+    return true;
+}
+
+static float legacyPeak(float maxf, float f)
+{
+    if (f > maxf) maxf = f;
+    else if (f < -maxf) maxf = -f;
+    return maxf;
+}
+
+// ============================================================
+// Test 1: mixPeak / peakAbs against the monitor loop
+// ============================================================
+static void test_mix_and_peak() {
+    TEST("mixPeak and peakAbs match the per-sample monitor loop");
+
+    bool ok = true;
+    for (int n : kLens) {
+        for (float p0 : kPeaks) {
+            for (int off = 0; off < 3; off++) {
+                std::vector<float> src = noise(n + off, 11 + n, 1.5f);
+                std::vector<float> out = noise(n + off, 23 + n, 1.0f);
+                std::vector<float> ref = out;
+
+                float want = p0;
+                for (int i = off; i < n + off; i++) {
+                    want = legacyPeak(want, src[i]);
+                    ref[i] += src[i] * 0.7f;
+                }
+                const float got = mixPeak(out.data() + off, src.data() + off, n, 0.7f, p0);
+                const float got2 = peakAbs(src.data() + off, n, p0);
+
+                ok = ok && got == want && got2 == want && close(out, ref);
+            }
+        }
+    }
+
+    if (ok) {
+        PASS();
+    } else {
+        FAIL("mix or peak differs from scalar reference");
+    }
+}
+
+// ============================================================
+// Test 2: downmixPeak (mono monitor path, muted and unmuted)
+// ============================================================
+static void test_downmix() {
+    TEST("downmixPeak matches the mono downmix loop; null out only meters");
+
+    bool ok = true;
+    for (int n : kLens) {
+        for (float p0 : kPeaks) {
+            std::vector<float> a = noise(n + 1, 5 + n, 1.2f);
+            std::vector<float> b = noise(n + 1, 9 + n, 1.2f);
+            std::vector<float> out = noise(n + 1, 13 + n, 1.0f);
+            std::vector<float> ref = out;
+
+            float want = p0;
+            for (int i = 1; i < n + 1; i++) {
+                const float f = (a[i] + b[i]) * 0.5f;
+                want = legacyPeak(want, f);
+                ref[i] += f * 0.4f;
+            }
+            std::vector<float> untouched = out;
+            ok = ok && downmixPeak(nullptr, a.data() + 1, b.data() + 1, n, 0.4f, p0) == want;
+            ok = ok && out == untouched;
+            ok = ok && downmixPeak(out.data() + 1, a.data() + 1, b.data() + 1, n, 0.4f, p0) == want;
+            ok = ok && close(out, ref);
+        }
+    }
+
+    if (ok) {
+        PASS();
+    } else {
+        FAIL("downmix differs from scalar reference");
+    }
+}
+
+// ============================================================
+// Test 3: scalePeak (master volume + output meter)
+// ============================================================
+static void test_scale() {
+    TEST("scalePeak matches the master-volume loop");
+
+    bool ok = true;
+    for (int n : kLens) {
+        for (float p0 : kPeaks) {
+            std::vector<float> x = noise(n + 2, 31 + n, 2.0f);
+            std::vector<float> ref = x;
+            float want = p0;
+            for (int i = 2; i < n + 2; i++) {
+                const float f = ref[i] *= 0.8f;
+                want = legacyPeak(want, f);
+            }
+            ok = ok && scalePeak(x.data() + 2, n, 0.8f, p0) == want;
+            ok = ok && x == ref;
+        }
+    }
+
+    if (ok) {
+        PASS();
+    } else {
+        FAIL("scale differs from scalar reference");
+    }
+}
+
+// ============================================================
+// Test 4: clipPeak / clipPeakStereo (mixInChannel VU + clipping)
+// ============================================================
+static void test_clip() {
+    TEST("clipPeak and clipPeakStereo clamp in place and meter like mixInChannel");
+
+    bool ok = true;
+    for (int n : kLens) {
+        for (float p0 : kPeaks) {
+            // mono
+            std::vector<float> x = noise(n + 1, 41 + n, 3.0f);
+            std::vector<float> ref = x;
+            float want = p0;
+            for (int i = 1; i < n + 1; i++) {
+                float f = ref[i];
+                if (f < -1.0f) f = ref[i] = -1.0f;
+                else if (f > 1.0f) f = ref[i] = 1.0f;
+                want = legacyPeak(want, f);
+            }
+            ok = ok && clipPeak(x.data() + 1, n, p0) == want;
+            ok = ok && x == ref;
+
+            // interleaved stereo, n frames
+            std::vector<float> s = noise(2 * n + 1, 43 + n, 3.0f);
+            std::vector<float> sref = s;
+            float wl = p0, wr = p0 * 0.5f;
+            for (int i = 1; i < 2 * n + 1; i += 2) {
+                float f = sref[i];
+                if (f < -1.0f) f = sref[i] = -1.0f;
+                else if (f > 1.0f) f = sref[i] = 1.0f;
+                wl = legacyPeak(wl, f);
+                f = sref[i + 1];
+                if (f < -1.0f) f = sref[i + 1] = -1.0f;
+                else if (f > 1.0f) f = sref[i + 1] = 1.0f;
+                wr = legacyPeak(wr, f);
+            }
+            float gl = p0, gr = p0 * 0.5f;
+            clipPeakStereo(s.data() + 1, n, &gl, &gr);
+            ok = ok && gl == wl && gr == wr && s == sref;
+        }
+    }
+
+    if (ok) {
+        PASS();
+    } else {
+        FAIL("clip/peak differs from scalar reference");
+    }
+}
+
+// ============================================================
+// Main
+// ============================================================
+int main() {
+    printf("=== Mix Kernel Tests ===\n\n");
+
+    test_mix_and_peak();
+    test_downmix();
+    test_scale();
+    test_clip();
+
+    printf("\n=== Results: %d/%d tests passed ===\n", tests_passed, tests_run);
+
+    return (tests_passed == tests_run) ? 0 : 1;
+}
@@ -0,0 +1,215 @@
+/*
+    JamWide Plugin - test_net_message_pool.cpp
+    Net_Message pooling (src/core/netmsg.h) and the MPMC freelist ring
+    (src/threading/mpmc_ring.h).
+
+    Checks that set_size keeps the bytes across a size-class promotion, that
+    a steady stream of upload-sized messages stops touching the global
+    allocator once the freelists are warm, that mpb_* builders go through
+    the pool, and that MpmcRing neither loses nor duplicates pointers under
+    concurrent producers and consumers.
+*/
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include "core/netmsg.h"
+#include "core/mpb.h"
+#include "threading/mpmc_ring.h"
+
+static int tests_run = 0;
+static int tests_passed = 0;
+
+#define TEST(name) \
+    do { \
+        tests_run++; \
+        printf("  TEST: %s ... ", name); \
+        fflush(stdout); \
+    } while(0)
+
+#define PASS() \
+    do { \
+        tests_passed++; \
+        printf("PASSED\n"); \
+    } while(0)
+
+#define FAIL(msg) \
+    do { \
+        printf("FAILED: %s\n", msg); \
+    } while(0)
+
+static Net_MessagePoolStats stats()
+{
+    Net_MessagePoolStats s;
+    Net_Message::GetPoolStats(&s);
+    return s;
+}
+
+// ============================================================
+// Test 1: growth across size classes keeps the payload
+// ============================================================
+static void test_grow_keeps_bytes() {
+    TEST("set_size growth keeps bytes across size classes");
+
+    Net_Message* m = new Net_Message;
+    m->addRef();
+    bool ok = m->get_data() == nullptr && m->get_size() == 0;
+
+    m->set_size(100);
+    ok = ok && m->get_data() != nullptr;
+    for (int i = 0; i < 100; i++) ((unsigned char*)m->get_data())[i] = (unsigned char)i;
+    m->set_size(1500);   // 256 B -> 2 KB class
+    for (int i = 100; i < 1500; i++) ((unsigned char*)m->get_data())[i] = (unsigned char)i;
+    m->set_size(NET_MESSAGE_MAX_SIZE_ENCRYPTED);   // -> largest class
+    const unsigned char* d = (const unsigned char*)m->get_data();
+    for (int i = 0; i < 1500 && ok; i++) ok = d[i] == (unsigned char)i;
+
+    m->set_size(10);     // shrink keeps the block and the prefix
+    ok = ok && m->get_size() == 10 && ((unsigned char*)m->get_data())[9] == 9;
+    m->set_size(0);
+    ok = ok && m->get_data() == nullptr;
+
+    m->set_size(NET_MESSAGE_MAX_SIZE_ENCRYPTED + 100);   // oversize: plain malloc
+    ok = ok && m->get_size() == NET_MESSAGE_MAX_SIZE_ENCRYPTED + 100;
+    m->releaseRef();
+
+    if (ok) {
+        PASS();
+    } else {
+        FAIL("payload bytes lost on resize");
+    }
+}
+
+// ============================================================
+// Test 2: steady-state streaming does not touch the allocator
+// ============================================================
+static void test_steady_state() {
+    TEST("steady-state upload stream is allocation-free");
+
+    unsigned char guid[16] = { 1, 2, 3 };
+    unsigned char chunk[NET_MESSAGE_MAX_SIZE - 64];
+    memset(chunk, 0x5a, sizeof(chunk));
+
+    // A send queue holding up to 64 messages at a time, like Net_Connection.
+    auto stream = [&](int rounds) {
+        std::vector<Net_Message*> q;
+        for (int r = 0; r < rounds; r++) {
+            for (int k = 0; k < 64; k++) {
+                mpb_client_upload_interval_write wh;
+                memcpy(wh.guid, guid, sizeof(guid));
+                wh.flags = 0;
+                wh.audio_data = chunk;
+                wh.audio_data_len = (k & 1) ? (int)sizeof(chunk) : 700;
+                Net_Message* m = wh.build();
+                if (!m) return false;
+                m->addRef();
+                q.push_back(m);
+
+                Net_Message* ka = new Net_Message;   // keepalive
+                ka->set_type(MESSAGE_KEEPALIVE);
+                ka->set_size(0);
+                ka->addRef();
+                q.push_back(ka);
+            }
+            for (Net_Message* m : q) m->releaseRef();
+            q.clear();
+        }
+        return true;
+    };
+
+    bool ok = stream(2);   // warm the freelists
+    const Net_MessagePoolStats before = stats();
+    ok = ok && stream(50);
+    const Net_MessagePoolStats after = stats();
+
+    const bool no_heap = after.msg_heap_allocs == before.msg_heap_allocs &&
+                         after.payload_heap_allocs == before.payload_heap_allocs &&
+                         after.heap_frees == before.heap_frees;
+    const bool counted = after.msg_allocs - before.msg_allocs == 50ull * 128 &&
+                         after.payload_allocs - before.payload_allocs == 50ull * 64;
+    if (ok && no_heap && counted && after.msgs_outstanding == before.msgs_outstanding) {
+        PASS();
+    } else {
+        char msg[200];
+        snprintf(msg, sizeof(msg), "heap msg +%llu payload +%llu frees +%llu, allocs +%llu/+%llu",
+                 after.msg_heap_allocs - before.msg_heap_allocs,
+                 after.payload_heap_allocs - before.payload_heap_allocs,
+                 after.heap_frees - before.heap_frees,
+                 after.msg_allocs - before.msg_allocs,
+                 after.payload_allocs - before.payload_allocs);
+        FAIL(msg);
+    }
+}
+
+// ============================================================
+// Test 3: MpmcRing under concurrent producers/consumers
+// ============================================================
+static void test_mpmc_ring() {
+    TEST("MpmcRing: 4 producers / 4 consumers, no loss or duplication");
+
+    static jamwide::MpmcRing<int, 64> ring;
+    const int kPerProducer = 100000;
+    const int kProducers = 4;
+    std::vector<std::atomic<int>> seen(kPerProducer * kProducers);
+    for (auto& s : seen) s.store(0);
+    std::atomic<int> consumed{0};
+
+    std::vector<std::thread> threads;
+    for (int p = 0; p < kProducers; p++) {
+        threads.emplace_back([&, p] {
+            for (int i = 0; i < kPerProducer; i++) {
+                const int v = p * kPerProducer + i;
+                while (!ring.try_push(v)) std::this_thread::yield();
+            }
+        });
+    }
+    for (int c = 0; c < 4; c++) {
+        threads.emplace_back([&] {
+            int v;
+            while (consumed.load() < kPerProducer * kProducers) {
+                if (ring.try_pop(v)) {
+                    seen[v].fetch_add(1);
+                    consumed.fetch_add(1);
+                } else {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+    for (auto& t : threads) t.join();
+
+    bool ok = consumed.load() == kPerProducer * kProducers && ring.size_approx() == 0;
+    for (auto& s : seen) ok = ok && s.load() == 1;
+
+    // bounded: a full ring rejects pushes
+    jamwide::MpmcRing<int, 4> small;
+    int pushed = 0;
+    while (small.try_push(pushed)) pushed++;
+    int v = -1;
+    ok = ok && pushed == 4 && small.try_pop(v) && v == 0;
+
+    if (ok) {
+        PASS();
+    } else {
+        FAIL("element lost or duplicated");
+    }
+}
+
+// ============================================================
+// Main
+// ============================================================
+int main() {
+    printf("=== Net Message Pool Tests ===\n\n");
+
+    test_grow_keeps_bytes();
+    test_steady_state();
+    test_mpmc_ring();
+
+    printf("\n=== Results: %d/%d tests passed ===\n", tests_passed, tests_run);
+
+    return (tests_passed == tests_run) ? 0 : 1;
+}
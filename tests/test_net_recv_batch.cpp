@@ -0,0 +1,459 @@
+/*
+    JamWide Plugin - test_net_recv_batch.cpp
+    Receive-side batching in Net_Connection (src/core/netmsg.h).
+
+    Drives Net_Connection against an in-memory JNL_IConnection whose run()
+    moves bytes from a fake "wire" into a bounded ring, like the real socket
+    path. Checks that one Run() parses a whole burst and NextMessage() hands
+    out the rest in order without touching the connection, that the batch cap
+    leaves the remainder for the next pass, that a trailing partial message
+    lets the run loop sleep, and that decryption happens at hand-out time (so
+    a key set after the first message of a batch still applies to the rest).
+
+    Also covers the zero-copy path (Net_Connection::SetDirectRecv): payloads
+    reach the sink in wire order, a message queued from the normal path holds
+    later ones back until it has been handed out, and encryption disables it.
+*/
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "core/netmsg.h"
+#include "crypto/nj_crypto.h"
+
+static int tests_run = 0;
+static int tests_passed = 0;
+
+#define TEST(name) \
+    do { \
+        tests_run++; \
+        printf("  TEST: %s ... ", name); \
+        fflush(stdout); \
+    } while(0)
+
+#define PASS() \
+    do { \
+        tests_passed++; \
+        printf("PASSED\n"); \
+    } while(0)
+
+#define FAIL(msg) \
+    do { \
+        printf("FAILED: %s\n", msg); \
+    } while(0)
+
+// In-memory connection: bytes appended to `wire` become readable after the
+// next run(), up to `ring_cap` buffered at once.
+class FakeConnection : public JNL_IConnection
+{
+public:
+    explicit FakeConnection(int ring_cap) : m_ring_cap(ring_cap) {}
+
+    std::vector<unsigned char> wire;
+    size_t wire_pos = 0;
+    int runs = 0;
+    bool contiguous = false; // expose peek_contiguous()
+
+    void connect(const char *, int) override {}
+    void connect(SOCKET, struct sockaddr_in *) override {}
+    void run(int, int, int *bytes_sent, int *bytes_rcvd) override
+    {
+        runs++;
+        if (bytes_sent) *bytes_sent = 0;
+        int n = 0;
+        while (wire_pos < wire.size() && (int)m_ring.size() < m_ring_cap)
+        {
+            m_ring.push_back(wire[wire_pos++]);
+            n++;
+        }
+        if (bytes_rcvd) *bytes_rcvd = n;
+    }
+    int get_state() override { return JNL_Connection::STATE_CONNECTED; }
+    const char *get_errstr() override { return ""; }
+    void close(int) override {}
+    void flush_send(void) override {}
+    int send_bytes_in_queue(void) override { return 0; }
+    int send_bytes_available(void) override { return 1 << 20; }
+    int send(const void *, int) override { return 0; }
+    int send_bytes(const void *, int) override { return 0; }
+    int send_string(const char *) override { return 0; }
+    int recv_bytes_available(void) override { return (int)m_ring.size(); }
+    int recv_bytes(void *data, int maxlength) override
+    {
+        const int n = peek_bytes(data, maxlength);
+        m_ring.erase(m_ring.begin(), m_ring.begin() + n);
+        return n;
+    }
+    int recv_lines_available(void) override { return 0; }
+    int recv_line(char *, int) override { return 1; }
+    int recv_get_linelen() override { return 0; }
+    int peek_bytes(void *data, int maxlength) override
+    {
+        const int n = maxlength < (int)m_ring.size() ? maxlength : (int)m_ring.size();
+        if (data && n) memcpy(data, m_ring.data(), (size_t)n);
+        return n;
+    }
+    int peek_contiguous(const void **data) override
+    {
+        *data = (contiguous && !m_ring.empty()) ? m_ring.data() : nullptr;
+        return *data ? (int)m_ring.size() : 0;
+    }
+    unsigned int get_interface(void) override { return 0; }
+    unsigned int get_remote(void) override { return 0; }
+    short get_remote_port(void) override { return 0; }
+    void set_interface(int) override {}
+    SOCKET get_socket() const override { return INVALID_SOCKET; }
+
+private:
+    int m_ring_cap;
+    std::vector<unsigned char> m_ring;
+};
+
+static void frame(std::vector<unsigned char>& out, int type, const unsigned char* payload, int len)
+{
+    Net_Message m;
+    m.set_type(type);
+    m.set_size(len);
+    if (len) memcpy(m.get_data(), payload, (size_t)len);
+    unsigned char hdr[16];
+    const int hl = m.makeMessageHeader(hdr);
+    out.insert(out.end(), hdr, hdr + hl);
+    out.insert(out.end(), payload, payload + len);
+}
+
+// Message k: type 0x10, 1200 bytes (a typical interval-write chunk), first
+// byte = k so order can be checked.
+static void frame_numbered(std::vector<unsigned char>& out, int k)
+{
+    unsigned char p[1200];
+    for (int i = 0; i < (int)sizeof(p); i++) p[i] = (unsigned char)(k + i);
+    p[0] = (unsigned char)k;
+    frame(out, 0x10, p, (int)sizeof(p));
+}
+
+static bool take_in_order(Net_Message* m, int& expect)
+{
+    if (!m) return false;
+    const bool ok = m->get_type() == 0x10 && m->get_size() == 1200 &&
+                    ((unsigned char*)m->get_data())[0] == (unsigned char)expect;
+    expect++;
+    m->addRef();
+    m->releaseRef();
+    return ok;
+}
+
+// ============================================================
+// Test 1: one Run() parses a burst, NextMessage() drains it
+// ============================================================
+static void test_burst_one_pass() {
+    TEST("burst parsed in one Run(), rest via NextMessage()");
+
+    FakeConnection* fc = new FakeConnection(256 * 1024);
+    for (int k = 0; k < 40; k++) frame_numbered(fc->wire, k);
+    Net_Connection nc;
+    nc.attach(fc);
+
+    int wantsleep = 1;
+    int expect = 0;
+    bool ok = take_in_order(nc.Run(&wantsleep), expect);
+    const int depth = nc.GetRecvQueueDepth();
+    const int runs_after = fc->runs;
+    while (Net_Message* m = nc.NextMessage()) ok = ok && take_in_order(m, expect);
+
+    if (ok && depth == 39 && expect == 40 && wantsleep == 0 &&
+        fc->runs == runs_after && nc.GetMaxRecvBatch() == 40 &&
+        nc.GetMessagesReceived() == 40) {
+        PASS();
+    } else {
+        char msg[160];
+        snprintf(msg, sizeof(msg), "ok=%d depth=%d got=%d wantsleep=%d batch=%d",
+                 ok ? 1 : 0, depth, expect, wantsleep, nc.GetMaxRecvBatch());
+        FAIL(msg);
+    }
+}
+
+// ============================================================
+// Test 2: small ring refilled within the same Run() pass
+// ============================================================
+static void test_small_ring_refill() {
+    TEST("small ring is refilled within one Run()");
+
+    // 8 KB ring, ~60 KB burst: Run must pump the connection repeatedly.
+    FakeConnection* fc = new FakeConnection(8192);
+    for (int k = 0; k < 50; k++) frame_numbered(fc->wire, k);
+    Net_Connection nc;
+    nc.attach(fc);
+
+    int expect = 0;
+    bool ok = take_in_order(nc.Run(), expect);
+    while (Net_Message* m = nc.NextMessage()) ok = ok && take_in_order(m, expect);
+
+    if (ok && expect == 50) {
+        PASS();
+    } else {
+        FAIL("burst not fully parsed in one pass");
+    }
+}
+
+// ============================================================
+// Test 3: batch cap leaves the remainder for the next Run()
+// ============================================================
+static void test_batch_cap() {
+    TEST("NET_CON_MAX_RECV_BATCH caps one pass");
+
+    FakeConnection* fc = new FakeConnection(1 << 20);
+    const int total = NET_CON_MAX_RECV_BATCH + 30;
+    for (int k = 0; k < total; k++) frame_numbered(fc->wire, k & 0xff);
+    Net_Connection nc;
+    nc.attach(fc);
+
+    int expect = 0;
+    bool ok = take_in_order(nc.Run(), expect);
+    while (Net_Message* m = nc.NextMessage()) ok = ok && take_in_order(m, expect);
+    const int first_pass = expect;
+    ok = ok && take_in_order(nc.Run(), expect);
+    while (Net_Message* m = nc.NextMessage()) ok = ok && take_in_order(m, expect);
+
+    if (ok && first_pass == NET_CON_MAX_RECV_BATCH && expect == total &&
+        nc.GetMaxRecvBatch() == NET_CON_MAX_RECV_BATCH) {
+        PASS();
+    } else {
+        char msg[128];
+        snprintf(msg, sizeof(msg), "first pass %d, total %d", first_pass, expect);
+        FAIL(msg);
+    }
+}
+
+// ============================================================
+// Test 4: trailing partial message does not block sleeping
+// ============================================================
+static void test_partial_tail() {
+    TEST("partial trailing message lets the loop sleep");
+
+    FakeConnection* fc = new FakeConnection(256 * 1024);
+    frame_numbered(fc->wire, 0);
+    std::vector<unsigned char> next;
+    frame_numbered(next, 1);
+    fc->wire.insert(fc->wire.end(), next.begin(), next.begin() + 600);
+    Net_Connection nc;
+    nc.attach(fc);
+
+    int wantsleep = 1;
+    int expect = 0;
+    bool ok = take_in_order(nc.Run(&wantsleep), expect);
+    ok = ok && nc.NextMessage() == nullptr;
+
+    // second pass: nothing new, partial still pending -> sleep ok
+    wantsleep = 1;
+    ok = ok && nc.Run(&wantsleep) == nullptr;
+    const int sleep_with_partial = wantsleep;
+
+    // rest arrives
+    fc->wire.insert(fc->wire.end(), next.begin() + 600, next.end());
+    ok = ok && take_in_order(nc.Run(), expect);
+
+    if (ok && sleep_with_partial == 1 && expect == 2) {
+        PASS();
+    } else {
+        FAIL("partial message mishandled");
+    }
+}
+
+// ============================================================
+// Test 5: decryption at hand-out, after a key set mid-batch
+// ============================================================
+static void test_decrypt_at_handout() {
+    TEST("key set after first message applies to the rest of the batch");
+
+    unsigned char key[32];
+    for (int i = 0; i < 32; i++) key[i] = (unsigned char)(i * 3 + 1);
+    const char* secret = "interval-write payload";
+    EncryptedPayload enc = encrypt_payload((const unsigned char*)secret, (int)strlen(secret), key);
+    if (!enc.ok) {
+        FAIL("encrypt_payload failed");
+        return;
+    }
+
+    FakeConnection* fc = new FakeConnection(256 * 1024);
+    const unsigned char plain[4] = { 'a', 'u', 't', 'h' };
+    frame(fc->wire, 0x01, plain, 4);                               // e.g. auth reply
+    frame(fc->wire, 0x02, enc.data.data(), (int)enc.data.size());  // first encrypted message
+    Net_Connection nc;
+    nc.attach(fc);
+
+    Net_Message* first = nc.Run();
+    const bool first_ok = first && first->get_type() == 0x01 && first->get_size() == 4;
+    if (first) { first->addRef(); first->releaseRef(); }
+
+    nc.SetEncryptionKey(key);
+    Net_Message* second = nc.NextMessage();
+    const bool second_ok = second && second->get_type() == 0x02 &&
+                           second->get_size() == (int)strlen(secret) &&
+                           !memcmp(second->get_data(), secret, strlen(secret));
+    if (second) { second->addRef(); second->releaseRef(); }
+
+    if (first_ok && second_ok && nc.GetStatus() == 0) {
+        PASS();
+    } else {
+        FAIL("batched message not decrypted with the late key");
+    }
+}
+
+// Records what the zero-copy path delivered. Accepts a message when its
+// first payload byte (the "GUID") is >= accept_from.
+struct RecordingSink : Net_DirectRecvSink
+{
+    int accept_from = 0;
+    int begins = 0;
+    std::vector<unsigned char> bytes;
+
+    bool directRecvBegin(const unsigned char* prefix, int len) override
+    {
+        if (prefix[0] < accept_from || len != 1199) return false;
+        begins++;
+        return true;
+    }
+    void directRecvData(const void* data, int len) override
+    {
+        bytes.insert(bytes.end(), (const unsigned char*)data, (const unsigned char*)data + len);
+    }
+};
+
+// Payload bytes 1..1199 of frame_numbered(k)
+static bool tail_matches(const unsigned char* p, int k)
+{
+    for (int i = 1; i < 1200; i++)
+        if (p[i - 1] != (unsigned char)(k + i)) return false;
+    return true;
+}
+
+// ============================================================
+// Test 6: direct path delivers payloads in order, keeps the prefix
+// ============================================================
+static void test_direct_recv() {
+    TEST("direct receive: payload to sink, prefix in message");
+
+    bool ok = true;
+    for (int pass = 0; pass < 2; pass++)
+    {
+        FakeConnection* fc = new FakeConnection(256 * 1024);
+        fc->contiguous = pass == 1;
+        for (int k = 0; k < 20; k++) frame_numbered(fc->wire, k);
+        Net_Connection nc;
+        nc.attach(fc);
+        RecordingSink sink;
+        nc.SetDirectRecv(0x10, 1, &sink);
+
+        int got = 0;
+        for (Net_Message* m = nc.Run(); m; m = nc.NextMessage())
+        {
+            ok = ok && m->get_type() == 0x10 && m->get_size() == 1 &&
+                 ((unsigned char*)m->get_data())[0] == got && m->get_direct_bytes() == 1199;
+            got++;
+            m->addRef();
+            m->releaseRef();
+        }
+        ok = ok && got == 20 && sink.begins == 20 && sink.bytes.size() == 20 * 1199 &&
+             nc.GetDirectRecvMessages() == 20 && nc.GetDirectRecvBytes() == 20 * 1199;
+        for (int k = 0; ok && k < 20; k++) ok = tail_matches(&sink.bytes[k * 1199], k);
+    }
+
+    if (ok) {
+        PASS();
+    } else {
+        FAIL("direct payloads missing or out of order");
+    }
+}
+
+// ============================================================
+// Test 7: a normal-path message holds the direct path back
+// ============================================================
+static void test_direct_order() {
+    TEST("direct receive waits for queued normal-path messages");
+
+    FakeConnection* fc = new FakeConnection(256 * 1024);
+    for (int k = 0; k < 10; k++) frame_numbered(fc->wire, k);
+    Net_Connection nc;
+    nc.attach(fc);
+    RecordingSink sink;
+    sink.accept_from = 2;   // 0 and 1 have no download yet
+    nc.SetDirectRecv(0x10, 1, &sink);
+
+    // First pass: 0,1 declined -> queued with payload; 2..9 must not
+    // overtake them, so they are queued with payload too.
+    int expect = 0;
+    bool ok = take_in_order(nc.Run(), expect);
+    while (Net_Message* m = nc.NextMessage()) ok = ok && take_in_order(m, expect);
+    const int begins_first = sink.begins;
+
+    // Queue drained: the next burst goes direct.
+    for (int k = 10; k < 15; k++) frame_numbered(fc->wire, k);
+    int direct = 0;
+    for (Net_Message* m = nc.Run(); m; m = nc.NextMessage())
+    {
+        direct += m->get_direct_bytes() == 1199;
+        m->addRef();
+        m->releaseRef();
+    }
+
+    if (ok && expect == 10 && begins_first == 0 && direct == 5 &&
+        sink.bytes.size() == 5 * 1199 && tail_matches(sink.bytes.data(), 10)) {
+        PASS();
+    } else {
+        char msg[128];
+        snprintf(msg, sizeof(msg), "normal=%d early_direct=%d later_direct=%d", expect, begins_first, direct);
+        FAIL(msg);
+    }
+}
+
+// ============================================================
+// Test 8: encryption disables the direct path
+// ============================================================
+static void test_direct_encrypted() {
+    TEST("direct receive is off while encryption is active");
+
+    unsigned char key[32] = { 7 };
+    unsigned char p[1200];
+    for (int i = 0; i < (int)sizeof(p); i++) p[i] = (unsigned char)(5 + i);
+    p[0] = 5;
+    EncryptedPayload enc = encrypt_payload(p, (int)sizeof(p), key);
+
+    FakeConnection* fc = new FakeConnection(256 * 1024);
+    frame(fc->wire, 0x10, enc.data.data(), (int)enc.data.size());
+    Net_Connection nc;
+    nc.attach(fc);
+    RecordingSink sink;
+    nc.SetDirectRecv(0x10, 1, &sink);
+    nc.SetEncryptionKey(key);
+
+    int expect = 5;
+    const bool ok = enc.ok && take_in_order(nc.Run(), expect);
+
+    if (ok && sink.begins == 0 && nc.GetDirectRecvMessages() == 0) {
+        PASS();
+    } else {
+        FAIL("encrypted message went to the sink");
+    }
+}
+
+// ============================================================
+// Main
+// ============================================================
+int main() {
+    printf("=== Net Receive Batch Tests ===\n\n");
+
+    test_burst_one_pass();
+    test_small_ring_refill();
+    test_batch_cap();
+    test_partial_tail();
+    test_decrypt_at_handout();
+    test_direct_recv();
+    test_direct_order();
+    test_direct_encrypted();
+
+    printf("\n=== Results: %d/%d tests passed ===\n", tests_passed, tests_run);
+
+    return (tests_passed == tests_run) ? 0 : 1;
+}
@@ -0,0 +1,179 @@
+/*
+    JamWide Plugin - test_net_wait.cpp
+    Run-loop readiness wait (src/core/net_wait.h).
+
+    Checks that NetActivityWaiter::wait times out when nothing happens, that
+    wake() from another thread ends the wait well before the timeout, that
+    repeated wake() calls coalesce into one signal, and (POSIX) that a
+    readable socket ends the wait with kSocketReady. Links net_wait.cpp only
+    (no NJClient).
+*/
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <thread>
+
+#include "core/net_wait.h"
+
+using jamwide::NetActivityWaiter;
+
+static int tests_run = 0;
+static int tests_passed = 0;
+
+#define TEST(name) \
+    do { \
+        tests_run++; \
+        printf("  TEST: %s ... ", name); \
+        fflush(stdout); \
+    } while(0)
+
+#define PASS() \
+    do { \
+        tests_passed++; \
+        printf("PASSED\n"); \
+    } while(0)
+
+#define FAIL(msg) \
+    do { \
+        printf("FAILED: %s\n", msg); \
+    } while(0)
+
+static long long elapsed_ms(std::chrono::steady_clock::time_point t0)
+{
+    return (long long)std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - t0).count();
+}
+
+// ============================================================
+// Test 1: no activity -> timeout, returns 0
+// ============================================================
+static void test_timeout() {
+    TEST("idle wait times out");
+
+    NetActivityWaiter w;
+    const auto t0 = std::chrono::steady_clock::now();
+    const int r = w.wait(INVALID_SOCKET, false, 30);
+    const long long ms = elapsed_ms(t0);
+
+    if (w.isValid() && r == 0 && ms >= 25 && w.timeouts() == 1 && w.waits() == 1) {
+        PASS();
+    } else {
+        char msg[128];
+        snprintf(msg, sizeof(msg), "r=%d after %lldms (valid=%d)", r, ms, w.isValid() ? 1 : 0);
+        FAIL(msg);
+    }
+}
+
+// ============================================================
+// Test 2: wake() from another thread ends a long wait early
+// ============================================================
+static void test_cross_thread_wake() {
+    TEST("wake() from another thread ends the wait");
+
+    NetActivityWaiter w;
+    std::thread t([&] {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        w.wake();
+    });
+    const auto t0 = std::chrono::steady_clock::now();
+    const int r = w.wait(INVALID_SOCKET, false, 2000);
+    const long long ms = elapsed_ms(t0);
+    t.join();
+
+    // the wakeup was consumed: the next wait times out again
+    const int r2 = w.wait(INVALID_SOCKET, false, 5);
+
+    if (r == NetActivityWaiter::kWoken && ms < 1000 && r2 == 0) {
+        PASS();
+    } else {
+        char msg[128];
+        snprintf(msg, sizeof(msg), "r=%d after %lldms, second r=%d", r, ms, r2);
+        FAIL(msg);
+    }
+}
+
+// ============================================================
+// Test 3: wake() before wait() is not lost; bursts coalesce
+// ============================================================
+static void test_coalesce() {
+    TEST("wake bursts coalesce into one signal");
+
+    NetActivityWaiter w;
+    for (int i = 0; i < 100; i++) w.wake();
+    const uint64_t signals = w.wakeSignals();
+    const int r = w.wait(INVALID_SOCKET, false, 1000);
+    w.wake();
+    const int r2 = w.wait(INVALID_SOCKET, false, 1000);
+
+    if (signals == 1 && r == NetActivityWaiter::kWoken &&
+        r2 == NetActivityWaiter::kWoken && w.wakeSignals() == 2) {
+        PASS();
+    } else {
+        FAIL("wake() did not coalesce or was lost");
+    }
+}
+
+// ============================================================
+// Test 4: readable socket ends the wait (POSIX socketpair)
+// ============================================================
+static void test_socket_ready() {
+    TEST("readable socket ends the wait");
+
+#ifdef _WIN32
+    // WSAEventSelect path has no socketpair(); covered by the live client.
+    PASS();
+#else
+    int sv[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, sv) != 0) {
+        FAIL("socketpair failed");
+        return;
+    }
+    NetActivityWaiter w;
+    const int idle = w.wait(sv[0], false, 5);
+
+    std::thread t([&] {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        const char b = 'x';
+        ssize_t n = write(sv[1], &b, 1);
+        (void)n;
+    });
+    const auto t0 = std::chrono::steady_clock::now();
+    const int r = w.wait(sv[0], false, 2000);
+    const long long ms = elapsed_ms(t0);
+    t.join();
+
+    // empty send buffer: asking for writability returns at once
+    char b;
+    ssize_t n = read(sv[0], &b, 1);
+    (void)n;
+    const int wr = w.wait(sv[0], true, 1000);
+
+    close(sv[0]);
+    close(sv[1]);
+    if (idle == 0 && r == NetActivityWaiter::kSocketReady && ms < 1000 &&
+        wr == NetActivityWaiter::kSocketReady) {
+        PASS();
+    } else {
+        char msg[128];
+        snprintf(msg, sizeof(msg), "idle=%d r=%d after %lldms wr=%d", idle, r, ms, wr);
+        FAIL(msg);
+    }
+#endif
+}
+
+// ============================================================
+// Main
+// ============================================================
+int main() {
+    printf("=== Net Wait Tests ===\n\n");
+
+    test_timeout();
+    test_cross_thread_wake();
+    test_coalesce();
+    test_socket_ready();
+
+    printf("\n=== Results: %d/%d tests passed ===\n", tests_passed, tests_run);
+
+    return (tests_passed == tests_run) ? 0 : 1;
+}
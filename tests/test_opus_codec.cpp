@@ -0,0 +1,247 @@
+/*
+    test_opus_codec.cpp - Tests for NJOpusEncoder and NJOpusDecoder
+
+    Simple assert-based tests for the Opus codec wrapper (wdl/opusencdec.h).
+    Opus is lossy, so round-trips are checked by signal energy and length
+    rather than sample-exact comparison (contrast test_flac_codec.cpp).
+    Built only when JAMWIDE_WITH_OPUS is ON.
+*/
+
+#include <cstdio>
+#include <cstdlib>
+#include <cmath>
+#include <cassert>
+#include <cstring>
+#include <vector>
+
+// Only pull the interface classes from vorbisencdec.h (no Vorbis codec deps)
+// WDL_VORBIS_INTERFACE_ONLY is defined via compile_definitions in CMakeLists.txt
+#include "wdl/vorbisencdec.h"
+#include "wdl/opusencdec.h"
+
+static int tests_run = 0;
+static int tests_passed = 0;
+
+#define TEST(name) \
+    do { \
+        tests_run++; \
+        printf("  TEST: %s ... ", name); \
+        fflush(stdout); \
+    } while(0)
+
+#define PASS() \
+    do { \
+        tests_passed++; \
+        printf("PASSED\n"); \
+    } while(0)
+
+#define FAIL(msg) \
+    do { \
+        printf("FAILED: %s\n", msg); \
+    } while(0)
+
+// Planar sine: channel c occupies buf[c*num_samples .. (c+1)*num_samples)
+static void generate_sine_planar(float* buf, int num_samples, int num_channels,
+                                 float freq, float sample_rate) {
+    for (int i = 0; i < num_samples; i++) {
+        float val = 0.5f * sinf(2.0f * 3.14159265358979f * freq * (float)i / sample_rate);
+        for (int c = 0; c < num_channels; c++)
+            buf[c * num_samples + i] = val;
+    }
+}
+
+// Encode one NINJAM-style interval (planar, as NJClient::Run does) and
+// decode it; returns decoded interleaved samples.
+static std::vector<float> roundtrip(int srate, int nch, int len, double frame_ms,
+                                    int* out_nch, int* out_srate) {
+    std::vector<float> in((size_t)len * nch);
+    generate_sine_planar(in.data(), len, nch, 440.0f, (float)srate);
+
+    NJOpusEncoder enc(srate, nch, 96, 1, frame_ms);
+    enc.Encode(in.data(), len, 1, nch > 1 ? len : 0);
+    enc.Encode(NULL, 0);
+
+    NJOpusDecoder dec;
+    const int avail = enc.Available();
+    void* src = dec.DecodeGetSrcBuffer(avail);
+    memcpy(src, enc.Get(), avail);
+    dec.DecodeWrote(avail);
+
+    *out_nch = dec.GetNumChannels();
+    *out_srate = dec.GetSampleRate();
+    std::vector<float> out(dec.Get(), dec.Get() + dec.Available());
+    return out;
+}
+
+static float rms(const float* p, int n) {
+    double acc = 0.0;
+    for (int i = 0; i < n; i++) acc += (double)p[i] * p[i];
+    return n > 0 ? (float)sqrt(acc / n) : 0.0f;
+}
+
+// ============================================================
+// Test 1: encoder emits the OpusHead ID header first
+// ============================================================
+static void test_encoder_header() {
+    TEST("NJOpusEncoder writes OpusHead header");
+
+    NJOpusEncoder enc(48000, 2, 96, 1);
+    assert(enc.isError() == 0);
+
+    const unsigned char* h = (const unsigned char*)enc.Get();
+    if (enc.Available() == OPUSENCDEC_HEADER_SIZE && !memcmp(h, "OpusHead", 8) && h[9] == 2) {
+        PASS();
+    } else {
+        FAIL("header missing or malformed");
+    }
+}
+
+// ============================================================
+// Test 2: mono round-trip at a native rate preserves energy and length
+// ============================================================
+static void test_roundtrip_mono_48k() {
+    TEST("NJOpusEncoder/Decoder mono 48k round-trip");
+
+    const int len = 48000;
+    int nch = 0, srate = 0;
+    std::vector<float> out = roundtrip(48000, 1, len, 20.0, &nch, &srate);
+
+    const int frames = (int)out.size() / nch;
+    // skip the first 20ms (codec warm-up) when measuring energy
+    const float r = rms(out.data() + 960, (int)out.size() - 960);
+    const float expected = 0.5f / sqrtf(2.0f);
+    if (nch != 1 || srate != 48000) {
+        FAIL("wrong channel count or sample rate");
+    } else if (frames < len) {
+        char msg[128];
+        snprintf(msg, sizeof(msg), "decoded %d frames, expected >= %d", frames, len);
+        FAIL(msg);
+    } else if (fabsf(r - expected) > expected * 0.1f) {
+        char msg[128];
+        snprintf(msg, sizeof(msg), "rms %.4f, expected ~%.4f", r, expected);
+        FAIL(msg);
+    } else {
+        PASS();
+    }
+}
+
+// ============================================================
+// Test 3: stereo 44.1k input goes through the resampler, decodes at 48k
+// ============================================================
+static void test_roundtrip_stereo_44k() {
+    TEST("NJOpusEncoder/Decoder stereo 44.1k round-trip (resampled)");
+
+    const int len = 44100;
+    int nch = 0, srate = 0;
+    std::vector<float> out = roundtrip(44100, 2, len, 20.0, &nch, &srate);
+
+    const int frames = (int)out.size() / 2;
+    const float r = rms(out.data() + 960 * 2, (int)out.size() - 960 * 2);
+    const float expected = 0.5f / sqrtf(2.0f);
+    if (nch != 2 || srate != 48000) {
+        FAIL("wrong channel count or sample rate");
+    } else if (frames < 48000 - 960) {
+        char msg[128];
+        snprintf(msg, sizeof(msg), "decoded %d frames, expected ~48000", frames);
+        FAIL(msg);
+    } else if (fabsf(r - expected) > expected * 0.1f) {
+        char msg[128];
+        snprintf(msg, sizeof(msg), "rms %.4f, expected ~%.4f", r, expected);
+        FAIL(msg);
+    } else {
+        PASS();
+    }
+}
+
+// ============================================================
+// Test 4: short live frames produce more, smaller packets
+// ============================================================
+static void test_live_frame_size() {
+    TEST("NJOpusEncoder 2.5ms live frames");
+
+    const int len = 4800;
+    std::vector<float> in(len);
+    generate_sine_planar(in.data(), len, 1, 440.0f, 48000.0f);
+
+    NJOpusEncoder enc(48000, 1, 64, 1, 2.5);
+    enc.Encode(in.data(), len, 1, 0);
+
+    // walk the length-prefixed packets after the header
+    const unsigned char* p = (const unsigned char*)enc.Get() + OPUSENCDEC_HEADER_SIZE;
+    int left = enc.Available() - OPUSENCDEC_HEADER_SIZE;
+    int packets = 0;
+    while (left >= 2) {
+        const int plen = p[0] | (p[1] << 8);
+        p += 2 + plen;
+        left -= 2 + plen;
+        packets++;
+    }
+
+    // 100ms / 2.5ms = 40 packets
+    if (packets == 40 && left == 0) {
+        PASS();
+    } else {
+        char msg[128];
+        snprintf(msg, sizeof(msg), "got %d packets (%d bytes left), expected 40", packets, left);
+        FAIL(msg);
+    }
+}
+
+// ============================================================
+// Test 5: reinit(0) starts a fresh, independently decodable stream
+// ============================================================
+static void test_encoder_reinit() {
+    TEST("NJOpusEncoder reinit restarts stream with header");
+
+    std::vector<float> in(4800);
+    generate_sine_planar(in.data(), 4800, 1, 440.0f, 48000.0f);
+
+    NJOpusEncoder enc(48000, 1, 64, 1);
+    enc.Encode(in.data(), 4800, 1, 0);
+    enc.Encode(NULL, 0);
+    enc.reinit(0);
+
+    const unsigned char* h = (const unsigned char*)enc.Get();
+    if (enc.Available() == OPUSENCDEC_HEADER_SIZE && !memcmp(h, "OpusHead", 8)) {
+        PASS();
+    } else {
+        FAIL("reinit did not reset queue to a fresh header");
+    }
+}
+
+// ============================================================
+// Test 6: decoder rejects a non-Opus stream without producing samples
+// ============================================================
+static void test_decoder_rejects_garbage() {
+    TEST("NJOpusDecoder rejects non-Opus stream");
+
+    NJOpusDecoder dec;
+    const char junk[] = "fLaC not an opus stream at all";
+    void* src = dec.DecodeGetSrcBuffer((int)sizeof(junk));
+    memcpy(src, junk, sizeof(junk));
+    dec.DecodeWrote((int)sizeof(junk));
+
+    if (dec.Available() == 0) {
+        PASS();
+    } else {
+        FAIL("decoder produced samples from garbage input");
+    }
+}
+
+// ============================================================
+// Main
+// ============================================================
+int main() {
+    printf("=== Opus Codec Tests ===\n\n");
+
+    test_encoder_header();
+    test_roundtrip_mono_48k();
+    test_roundtrip_stereo_44k();
+    test_live_frame_size();
+    test_encoder_reinit();
+    test_decoder_rejects_garbage();
+
+    printf("\n=== Results: %d/%d tests passed ===\n", tests_passed, tests_run);
+
+    return (tests_passed == tests_run) ? 0 : 1;
+}
@@ -0,0 +1,157 @@
+/*
+    JamWide Plugin - test_prefetch_queue.cpp
+    Per-channel interval lookahead queue (src/core/prefetch_queue.h).
+
+    Covers what the PeerNextDsUpdate apply and on_new_interval rely on:
+    intervals come back out in arrival order across many wraps, pushing past
+    the configured depth hands exactly the oldest entries to the evict
+    callback (also after the depth is lowered), null silence markers queue
+    nothing, and depth is clamped to [1, capacity].
+*/
+
+#include <cstdio>
+#include <vector>
+
+#include "core/prefetch_queue.h"
+
+using namespace jamwide;
+
+static int tests_run = 0;
+static int tests_passed = 0;
+
+#define TEST(name) \
+    do { \
+        tests_run++; \
+        printf("  TEST: %s ... ", name); \
+        fflush(stdout); \
+    } while(0)
+
+#define PASS() \
+    do { \
+        tests_passed++; \
+        printf("PASSED\n"); \
+    } while(0)
+
+#define FAIL(msg) \
+    do { \
+        printf("FAILED: %s\n", msg); \
+    } while(0)
+
+struct FakeDs { int interval; };
+
+typedef PrefetchQueue<FakeDs, 8> Queue;
+
+// ============================================================
+// Test 1: FIFO order across wraps
+// ============================================================
+static void test_fifo_order() {
+    TEST("intervals pop in arrival order across many wraps");
+
+    std::vector<FakeDs> ds(1000);
+    for (int i = 0; i < 1000; i++) ds[i].interval = i;
+
+    Queue q;
+    bool ok = q.empty() && q.front() == nullptr && q.pop() == nullptr;
+    int next_in = 0, next_out = 0, evicted = 0;
+    // Fill 1..5 deep, drain 1..3 at a time, never exceeding depth 8.
+    while (next_out < 1000) {
+        const int fill = 1 + next_in % 5;
+        for (int k = 0; k < fill && next_in < 1000 && q.size() < 8; k++)
+            evicted += q.push(&ds[next_in++], 8, [](FakeDs*) {});
+        const int drain = 1 + next_out % 3;
+        for (int k = 0; k < drain && !q.empty(); k++) {
+            ok = ok && q.front() == &ds[next_out] && q.at(0) == &ds[next_out];
+            FakeDs* p = q.pop();
+            ok = ok && p && p->interval == next_out++;
+        }
+    }
+    ok = ok && evicted == 0 && q.empty() && q.size() == 0;
+
+    if (ok) {
+        PASS();
+    } else {
+        FAIL("order or count wrong");
+    }
+}
+
+// ============================================================
+// Test 2: Depth eviction
+// ============================================================
+static void test_depth_eviction() {
+    TEST("pushing past depth evicts the oldest; lowering depth trims on next push");
+
+    FakeDs ds[10];
+    for (int i = 0; i < 10; i++) ds[i].interval = i;
+
+    Queue q;
+    std::vector<int> gone;
+    auto evict = [&gone](FakeDs* p) { gone.push_back(p->interval); };
+
+    bool ok = true;
+    for (int i = 0; i < 5; i++) q.push(&ds[i], 3, evict);
+    // depth 3: 0 and 1 evicted, 2 3 4 queued
+    ok = ok && gone == std::vector<int>{0, 1} && q.size() == 3;
+    ok = ok && q.at(0) == &ds[2] && q.at(2) == &ds[4] && q.at(3) == nullptr;
+
+    // Depth lowered to 1: three queued, one arriving; 2 3 4 all go, 5 stays.
+    q.push(&ds[5], 1, evict);
+    ok = ok && gone == std::vector<int>{0, 1, 2, 3, 4} && q.size() == 1 && q.front() == &ds[5];
+
+    // Raising the depth keeps what's queued.
+    const int n = q.push(&ds[6], 4, evict);
+    ok = ok && n == 0 && q.size() == 2 && q.at(1) == &ds[6];
+
+    if (ok) {
+        PASS();
+    } else {
+        FAIL("wrong entries evicted");
+    }
+}
+
+// ============================================================
+// Test 3: Silence markers and depth clamping
+// ============================================================
+static void test_null_and_clamp() {
+    TEST("null markers queue nothing; depth clamped to [1, capacity]");
+
+    FakeDs ds[20];
+    Queue q;
+    int evicted = 0;
+    auto evict = [&evicted](FakeDs*) { ++evicted; };
+
+    bool ok = q.push(nullptr, 2, evict) == 0 && q.empty();
+    q.push(&ds[0], 2, evict);
+    q.push(&ds[1], 2, evict);
+    ok = ok && q.push(nullptr, 2, evict) == 0 && q.size() == 2 && evicted == 0;
+
+    // depth 0 behaves as 1
+    q.push(&ds[2], 0, evict);
+    ok = ok && q.size() == 1 && evicted == 2 && q.front() == &ds[2];
+
+    // depth 100 behaves as the capacity (8)
+    evicted = 0;
+    for (int i = 3; i < 20; i++) q.push(&ds[i], 100, evict);
+    ok = ok && q.size() == Queue::kCapacity && evicted == 18 - Queue::kCapacity;
+    ok = ok && q.front() == &ds[20 - Queue::kCapacity] && q.at(Queue::kCapacity - 1) == &ds[19];
+
+    if (ok) {
+        PASS();
+    } else {
+        FAIL("marker or clamp handling wrong");
+    }
+}
+
+// ============================================================
+// Main
+// ============================================================
+int main() {
+    printf("=== Prefetch Queue Tests ===\n\n");
+
+    test_fifo_order();
+    test_depth_eviction();
+    test_null_and_clamp();
+
+    printf("\n=== Results: %d/%d tests passed ===\n", tests_passed, tests_run);
+
+    return (tests_passed == tests_run) ? 0 : 1;
+}
@@ -0,0 +1,176 @@
+/*
+    JamWide Plugin - test_render_quantum.cpp
+    Fixed-quantum render adapter (src/core/render_quantum.h).
+
+    Drives RenderQuantizer with a ramp through host block sizes smaller than,
+    equal to, larger than and not multiples of the quantum, and checks that
+    the output is the rendered input delayed by exactly one quantum, that
+    render always sees exactly Q frames, that the number of render calls
+    depends only on the frames pushed, and that reset() drops buffered audio.
+*/
+
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+#include "core/render_quantum.h"
+
+using namespace jamwide;
+
+static int tests_run = 0;
+static int tests_passed = 0;
+
+#define TEST(name) \
+    do { \
+        tests_run++; \
+        printf("  TEST: %s ... ", name); \
+        fflush(stdout); \
+    } while(0)
+
+#define PASS() \
+    do { \
+        tests_passed++; \
+        printf("PASSED\n"); \
+    } while(0)
+
+#define FAIL(msg) \
+    do { \
+        printf("FAILED: %s\n", msg); \
+    } while(0)
+
+// Render: out0 = in0 * 2, out1 = in1 + in0 (so both inputs and outputs are checked).
+struct Doubler {
+    int q;
+    int calls = 0;
+    bool bad_size = false;
+    void operator()(float** in, float** out, int n) {
+        ++calls;
+        if (n != q) bad_size = true;
+        for (int i = 0; i < n; i++) {
+            out[0][i] = in[0][i] * 2.0f;
+            out[1][i] = in[1][i] + in[0][i];
+        }
+    }
+};
+
+// Push `total` ramp frames through in blocks cycling over `sizes`; return
+// false on any sample that isn't the rendered input delayed by q frames.
+static bool run_stream(int q, const std::vector<int>& sizes, int total, int* calls_out)
+{
+    RenderQuantizer rq;
+    rq.configure(2, 2, q);
+    Doubler r{q};
+    std::vector<float> in0(4096), in1(4096), out0(4096), out1(4096);
+    int t = 0;
+    size_t which = 0;
+    bool ok = rq.latency() == q;
+    while (t < total && ok) {
+        const int n = sizes[which++ % sizes.size()];
+        for (int i = 0; i < n; i++) {
+            in0[i] = (float)(t + i);
+            in1[i] = 0.5f;
+        }
+        const float* in[2] = { in0.data(), in1.data() };
+        float* out[2] = { out0.data(), out1.data() };
+        rq.process(in, out, n, r);
+        for (int i = 0; i < n && ok; i++) {
+            const int src = t + i - q;
+            const float e0 = src < 0 ? 0.0f : 2.0f * (float)src;
+            const float e1 = src < 0 ? 0.0f : 0.5f + (float)src;
+            ok = out0[i] == e0 && out1[i] == e1;
+        }
+        t += n;
+    }
+    *calls_out = r.calls;
+    return ok && !r.bad_size && r.calls == t / q && (int)rq.renders() == r.calls;
+}
+
+// ============================================================
+// Test 1: exact one-quantum delay across host block sizes
+// ============================================================
+static void test_delay_any_block_size() {
+    TEST("output = render(input) delayed by Q for any host block size");
+
+    const std::vector<std::vector<int>> patterns = {
+        {32}, {128}, {256}, {1000}, {1, 7, 64, 129, 300, 5}, {127, 129},
+    };
+    bool ok = true;
+    for (int q : {64, 128, 256}) {
+        for (const auto& p : patterns) {
+            int calls = 0;
+            ok = ok && run_stream(q, p, 20000, &calls);
+        }
+    }
+
+    if (ok) {
+        PASS();
+    } else {
+        FAIL("delay or render framing wrong");
+    }
+}
+
+// ============================================================
+// Test 2: render count depends only on frames pushed
+// ============================================================
+static void test_flat_call_rate() {
+    TEST("render calls per frame are independent of host block size");
+
+    int small = 0, large = 0;
+    bool ok = run_stream(128, {32}, 128 * 100, &small) &&
+              run_stream(128, {512}, 128 * 100, &large);
+    ok = ok && small == 100 && large == 100;
+
+    if (ok) {
+        PASS();
+    } else {
+        FAIL("render call count varies with host block size");
+    }
+}
+
+// ============================================================
+// Test 3: reset drops buffered audio; null inputs are silence
+// ============================================================
+static void test_reset_and_null_input() {
+    TEST("reset() drops buffered output; null input channels read as silence");
+
+    RenderQuantizer rq;
+    rq.configure(2, 2, 64);
+    Doubler r{64};
+    std::vector<float> in0(64, 1.0f), out0(64), out1(64);
+    const float* in[2] = { in0.data(), nullptr };
+    float* out[2] = { out0.data(), out1.data() };
+
+    rq.process(in, out, 64, r);   // fills the output FIFO with 2.0 / 1.0
+    rq.reset();
+    std::vector<float> zeros(64, 0.0f);
+    const float* zin[2] = { zeros.data(), nullptr };
+    rq.process(zin, out, 64, r);
+    bool ok = true;
+    for (int i = 0; i < 64; i++) ok = ok && out0[i] == 0.0f && out1[i] == 0.0f;
+
+    rq.process(in, out, 64, r);   // previous quantum was silence -> still silent
+    for (int i = 0; i < 64; i++) ok = ok && out0[i] == 0.0f;
+    rq.process(zin, out, 64, r);  // now the 1.0 quantum comes out: in1 (null) read as 0
+    for (int i = 0; i < 64; i++) ok = ok && out0[i] == 2.0f && out1[i] == 1.0f;
+
+    if (ok) {
+        PASS();
+    } else {
+        FAIL("reset or null-input handling wrong");
+    }
+}
+
+// ============================================================
+// Main
+// ============================================================
+int main() {
+    printf("=== Render Quantum Tests ===\n\n");
+
+    test_delay_any_block_size();
+    test_flat_call_rate();
+    test_reset_and_null_input();
+
+    printf("\n=== Results: %d/%d tests passed ===\n", tests_passed, tests_run);
+
+    return (tests_passed == tests_run) ? 0 : 1;
+}
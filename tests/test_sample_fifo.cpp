@@ -0,0 +1,256 @@
+/*
+    JamWide Plugin - test_sample_fifo.cpp
+    Byte-granular SPSC sample FIFO (src/threading/sample_fifo.h).
+
+    Covers what the broadcast and wave-mix feeds rely on: an unallocated FIFO
+    refuses pushes, header-only markers survive, blocks larger than half the
+    buffer are split with their attr/startpos kept, a full FIFO refuses
+    instead of overwriting, discard() empties it, and a producer/consumer
+    pair streaming blocks of varying size across many wraps sees every
+    sample in order.
+*/
+
+#include <atomic>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+#include "threading/sample_fifo.h"
+
+using namespace jamwide;
+
+static int tests_run = 0;
+static int tests_passed = 0;
+
+#define TEST(name) \
+    do { \
+        tests_run++; \
+        printf("  TEST: %s ... ", name); \
+        fflush(stdout); \
+    } while(0)
+
+#define PASS() \
+    do { \
+        tests_passed++; \
+        printf("PASSED\n"); \
+    } while(0)
+
+#define FAIL(msg) \
+    do { \
+        printf("FAILED: %s\n", msg); \
+    } while(0)
+
+// ============================================================
+// Test 1: Unallocated FIFO and invalid arguments
+// ============================================================
+static void test_unallocated_and_invalid() {
+    TEST("push fails until allocate(); invalid counts/channels refused");
+
+    SampleFifo fifo;
+    float s[4] = {1, 2, 3, 4};
+    bool ok = !fifo.allocated() && fifo.capacity() == 0;
+    ok = ok && !fifo.push(0, 0.0, s, 4, 1);
+    ok = ok && fifo.drain([](const SampleBlockHeader&, const float*, const float*) {}) == 0;
+
+    ok = ok && fifo.allocate(5000);
+    ok = ok && fifo.capacity() == 8192;   // rounded up to a power of two
+    ok = ok && !fifo.push(0, 0.0, s, -1, 1);
+    ok = ok && !fifo.push(0, 0.0, s, 4, 3);
+    ok = ok && fifo.empty();
+    ok = ok && fifo.push(0, 0.0, s, 4, 1);
+    ok = ok && !fifo.empty();
+
+    if (ok) {
+        PASS();
+    } else {
+        FAIL("allocation or argument checks wrong");
+    }
+}
+
+// ============================================================
+// Test 2: Header-only markers and mono/stereo payloads
+// ============================================================
+static void test_markers_and_channels() {
+    TEST("markers, mono, stereo and null channel 1 round-trip in place");
+
+    SampleFifo fifo;
+    fifo.allocate(4096);
+    float l[8], r[8];
+    for (int i = 0; i < 8; i++) { l[i] = (float)i; r[i] = (float)(100 + i); }
+
+    bool ok = fifo.push(0, 12.5, nullptr, 0, 0);   // broadcast-start marker
+    ok = ok && fifo.push(1, 13.0, l, 8, 1);
+    ok = ok && fifo.push(2, 14.0, l, 8, 2, r);
+    ok = ok && fifo.push(3, 15.0, l, 8, 2);        // channel 1 -> silence
+
+    int seen = 0;
+    const size_t n = fifo.drain([&](const SampleBlockHeader& h, const float* s1, const float* s2) {
+        switch (seen++) {
+            case 0:
+                ok = ok && h.attr == 0 && h.startpos == 12.5 && h.sample_count == 0 && !s2;
+                break;
+            case 1:
+                ok = ok && h.attr == 1 && h.nch == 1 && h.sample_count == 8 && !s2;
+                for (int i = 0; i < 8; i++) ok = ok && s1[i] == l[i];
+                break;
+            case 2:
+                ok = ok && h.attr == 2 && h.nch == 2 && s2;
+                for (int i = 0; i < 8; i++) ok = ok && s1[i] == l[i] && s2[i] == r[i];
+                break;
+            case 3:
+                ok = ok && h.attr == 3 && s2;
+                for (int i = 0; i < 8; i++) ok = ok && s1[i] == l[i] && s2[i] == 0.0f;
+                break;
+            default:
+                ok = false;
+        }
+    });
+    ok = ok && n == 4 && seen == 4 && fifo.empty() && fifo.bytesUsed() == 0;
+
+    if (ok) {
+        PASS();
+    } else {
+        FAIL("block contents or headers wrong");
+    }
+}
+
+// ============================================================
+// Test 3: Oversized blocks are split
+// ============================================================
+static void test_split_large_block() {
+    TEST("block larger than half the FIFO is split; too-large block queues nothing");
+
+    SampleFifo fifo;
+    fifo.allocate(64 * 1024);
+    const int max_frames = fifo.maxFramesPerBlock(2);
+    const int total = max_frames * 2 + 37;   // well past the old 2048-frame ceiling
+    std::vector<float> l(total), r(total);
+    for (int i = 0; i < total; i++) { l[i] = (float)i; r[i] = -(float)i; }
+
+    // Needs more than the whole FIFO: refused, and nothing is queued.
+    bool ok = total > 2048 && !fifo.push(7, 99.0, l.data(), total, 2, r.data());
+    ok = ok && fifo.empty();
+
+    // Something that fits overall but not in one record.
+    const int fits = max_frames + 100;
+    ok = ok && fifo.push(7, 99.0, l.data(), fits, 2, r.data());
+    int blocks = 0, pos = 0;
+    fifo.drain([&](const SampleBlockHeader& h, const float* s1, const float* s2) {
+        ++blocks;
+        ok = ok && h.attr == 7 && h.startpos == 99.0 && h.sample_count <= max_frames;
+        for (int i = 0; i < h.sample_count; i++)
+            ok = ok && s1[i] == l[pos + i] && s2[i] == r[pos + i];
+        pos += h.sample_count;
+    });
+    ok = ok && blocks == 2 && pos == fits;
+
+    if (ok) {
+        PASS();
+    } else {
+        FAIL("split wrong");
+    }
+}
+
+// ============================================================
+// Test 4: Full FIFO refuses; discard empties
+// ============================================================
+static void test_full_and_discard() {
+    TEST("full FIFO refuses without overwriting; discard() empties it");
+
+    SampleFifo fifo;
+    fifo.allocate(4096);
+    float s[64] = {};
+    int pushed = 0;
+    while (fifo.push(pushed, 0.0, s, 64, 2)) ++pushed;   // 544 bytes per record
+
+    bool ok = pushed == 7 && !fifo.empty();
+    const size_t dropped = fifo.discard();
+    ok = ok && dropped == (size_t)pushed && fifo.empty();
+
+    // Room again, and the next records wrap.
+    int got = 0;
+    for (int i = 0; i < 5; i++) ok = ok && fifo.push(100 + i, 0.0, s, 64, 2);
+    fifo.drain([&](const SampleBlockHeader& h, const float*, const float*) {
+        ok = ok && h.attr == 100 + got++;
+    });
+    ok = ok && got == 5;
+
+    if (ok) {
+        PASS();
+    } else {
+        FAIL("full/discard handling wrong");
+    }
+}
+
+// ============================================================
+// Test 5: Concurrent producer/consumer across many wraps
+// ============================================================
+static void test_concurrent_stream() {
+    TEST("concurrent varying-size stream arrives complete and in order");
+
+    SampleFifo fifo;
+    // Blocks stay under maxFramesPerBlock (2044 stereo frames here): an
+    // unsplit record is at most half the FIFO, so it always fits once the
+    // consumer catches up and the retry loop below terminates.
+    fifo.allocate(32 * 1024);
+    constexpr int kBlocks = 20000;
+    std::atomic<bool> done{false};
+    bool ok = true;
+    long long expect = 0;
+    int last_attr = -1;
+
+    std::thread consumer([&] {
+        auto check = [&](const SampleBlockHeader& h, const float* s1, const float* s2) {
+            if (h.attr != last_attr + 1) ok = false;
+            last_attr = h.attr;
+            for (int i = 0; i < h.sample_count; i++) {
+                if (s1[i] != (float)(expect % 65536) || s2[i] != -s1[i]) ok = false;
+                ++expect;
+            }
+        };
+        while (!done.load(std::memory_order_acquire)) {
+            fifo.drain(check);
+            std::this_thread::yield();
+        }
+        fifo.drain(check);
+    });
+
+    std::vector<float> l(1500), r(1500);
+    long long sample = 0;
+    for (int b = 0; b < kBlocks; b++) {
+        const int n = (b * 37) % 1500;   // includes 0-length blocks
+        for (int i = 0; i < n; i++) {
+            l[i] = (float)((sample + i) % 65536);
+            r[i] = -l[i];
+        }
+        while (!fifo.push(b, 0.0, l.data(), n, 2, r.data())) std::this_thread::yield();
+        sample += n;
+    }
+    done.store(true, std::memory_order_release);
+    consumer.join();
+
+    ok = ok && last_attr == kBlocks - 1 && expect == sample && fifo.empty();
+
+    if (ok) {
+        PASS();
+    } else {
+        FAIL("stream corrupted, reordered or incomplete");
+    }
+}
+
+// ============================================================
+// Main
+// ============================================================
+int main() {
+    printf("=== Sample FIFO Tests ===\n\n");
+
+    test_unallocated_and_invalid();
+    test_markers_and_channels();
+    test_split_large_block();
+    test_full_and_discard();
+    test_concurrent_stream();
+
+    printf("\n=== Results: %d/%d tests passed ===\n", tests_passed, tests_run);
+
+    return (tests_passed == tests_run) ? 0 : 1;
+}
@@ -0,0 +1,301 @@
+/*
+    JamWide Plugin - test_session_archive.cpp
+    Time-indexed session archive (src/core/session_archive.h).
+
+    Writes a small multitrack session through SessionArchiveWriter, then
+    checks the reader: track table, (start, track) ordering, O(log n) findAt
+    at interval edges and in gaps, firstStartingAt and per-track seek,
+    zero-copy payloads that match what was written, and index recovery from
+    an archive whose writer never reached close(). Links session_archive.cpp + interval_store.cpp
+    (no NJClient).
+*/
+
+#include <cstdio>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "core/session_archive.h"
+
+using jamwide::SessionArchiveEntry;
+using jamwide::SessionArchiveReader;
+using jamwide::SessionArchiveWriter;
+
+static int tests_run = 0;
+static int tests_passed = 0;
+
+#define TEST(name) \
+    do { \
+        tests_run++; \
+        printf("  TEST: %s ... ", name); \
+        fflush(stdout); \
+    } while(0)
+
+#define PASS() \
+    do { \
+        tests_passed++; \
+        printf("PASSED\n"); \
+    } while(0)
+
+#define FAIL(msg) \
+    do { \
+        printf("FAILED: %s\n", msg); \
+    } while(0)
+
+static const unsigned int kOGGv = 'O' | ('G' << 8) | ('G' << 16) | ('v' << 24);
+static const uint32_t kIntervalMs = 8000;
+
+static std::string temp_path(const char* tag)
+{
+    char buf[512];
+    const char* dir = getenv("TMPDIR");
+#ifdef _WIN32
+    if (!dir) dir = getenv("TEMP");
+#endif
+    if (!dir) dir = "/tmp";
+    snprintf(buf, sizeof(buf), "%s/jamwide_session_archive_%s.jwsa", dir, tag);
+    return buf;
+}
+
+static std::vector<unsigned char> payload_for(int track, int k)
+{
+    std::vector<unsigned char> v(1000 + 37 * k + track);
+    for (size_t i = 0; i < v.size(); i++) v[i] = (unsigned char)(i * 7 + k * 13 + track);
+    return v;
+}
+
+static void guid_for(int track, int k, unsigned char g[16])
+{
+    for (int i = 0; i < 16; i++) g[i] = (unsigned char)(track * 16 + k + i);
+}
+
+// Track 0 ("alice", 0): intervals 0..9 back to back.
+// Track 1 ("bob", 1):   intervals 2, 3, 7 only (joined late, dropped out).
+// Track 2 ("local", 0): interval 5 only.
+static const int kBobIntervals[] = { 2, 3, 7 };
+
+static bool write_session(SessionArchiveWriter& w)
+{
+    const int alice = w.track("alice", 0);
+    const int bob = w.track("bob", 1);
+    const int local = w.track("local", 0);
+    if (alice != 0 || bob != 1 || local != 2 || w.track("alice", 0) != 0) return false;
+
+    for (int k = 0; k < 10; k++) {
+        unsigned char g[16];
+        // interleave tracks the way a live session delivers them
+        for (int b : kBobIntervals) {
+            if (b != k) continue;
+            guid_for(bob, k, g);
+            std::vector<unsigned char> p = payload_for(bob, k);
+            if (!w.appendInterval(bob, g, kOGGv, k * (int64_t)kIntervalMs, kIntervalMs, p.data(), p.size())) return false;
+        }
+        guid_for(alice, k, g);
+        std::vector<unsigned char> p = payload_for(alice, k);
+        if (!w.appendInterval(alice, g, kOGGv, k * (int64_t)kIntervalMs, kIntervalMs, p.data(), p.size())) return false;
+        if (k == 5) {
+            guid_for(local, k, g);
+            std::vector<unsigned char> lp = payload_for(local, k);
+            if (!w.appendInterval(local, g, kOGGv, k * (int64_t)kIntervalMs, kIntervalMs, lp.data(), lp.size())) return false;
+        }
+    }
+    return true;
+}
+
+static bool open_reader(SessionArchiveReader& r, const std::string& path)
+{
+    FILE* fp = fopen(path.c_str(), "rb");
+    if (!fp) return false;
+    const bool ok = r.open(fp);
+    fclose(fp);
+    return ok;
+}
+
+static bool check_payloads(const SessionArchiveReader& r)
+{
+    for (size_t i = 0; i < r.numEntries(); i++) {
+        const SessionArchiveEntry& e = r.entry(i);
+        const int k = (int)(e.start_ms / kIntervalMs);
+        const std::vector<unsigned char> want = payload_for(e.track, k);
+        unsigned char g[16];
+        guid_for(e.track, k, g);
+        const unsigned char* p = r.payload(e);
+        if (!p || e.size != want.size() || memcmp(p, want.data(), want.size()) ||
+            memcmp(e.guid, g, 16) || e.fourcc != kOGGv) return false;
+    }
+    return true;
+}
+
+// ============================================================
+// Test 1: round trip — tracks, ordering, payloads
+// ============================================================
+static void test_roundtrip() {
+    TEST("write/close/open round trip");
+
+    const std::string path = temp_path("roundtrip");
+    SessionArchiveWriter w;
+    const bool wrote = w.open(path.c_str()) && write_session(w) && w.close();
+
+    SessionArchiveReader r;
+    const bool opened = open_reader(r, path);
+    bool sorted = true;
+    for (size_t i = 1; i < r.numEntries(); i++)
+        sorted = sorted && r.entry(i - 1).start_ms <= r.entry(i).start_ms;
+
+    const bool ok = wrote && opened && !r.recovered() && r.numTracks() == 3 &&
+                    r.trackInfo(1).user == "bob" && r.trackInfo(1).channel == 1 &&
+                    r.numEntries() == 14 && sorted && check_payloads(r) &&
+                    r.lengthMs() == 10 * (int64_t)kIntervalMs &&
+                    r.findTrack("local", 0) == 2 && r.findTrack("bob", 0) == -1;
+    r.close();
+    remove(path.c_str());
+    if (ok) {
+        PASS();
+    } else {
+        FAIL("archive contents did not round-trip");
+    }
+}
+
+// ============================================================
+// Test 2: findAt at edges, inside and in gaps
+// ============================================================
+static void test_find_at() {
+    TEST("findAt edges and gaps");
+
+    const std::string path = temp_path("find");
+    SessionArchiveWriter w;
+    if (!w.open(path.c_str()) || !write_session(w) || !w.close()) {
+        FAIL("writer setup failed");
+        return;
+    }
+    SessionArchiveReader r;
+    if (!open_reader(r, path)) {
+        FAIL("reader open failed");
+        remove(path.c_str());
+        return;
+    }
+
+    auto start_of = [&](int idx) { return idx < 0 ? (int64_t)-1 : r.entry(idx).start_ms; };
+    bool ok = true;
+    // alice: covered everywhere in [0, 80000)
+    ok = ok && start_of(r.findAt(0, 0)) == 0;
+    ok = ok && start_of(r.findAt(0, 7999)) == 0;
+    ok = ok && start_of(r.findAt(0, 8000)) == 8000;
+    ok = ok && start_of(r.findAt(0, 79999)) == 72000;
+    ok = ok && r.findAt(0, 80000) == -1;
+    ok = ok && r.findAt(0, -1) == -1;
+    // bob: 16000..32000 and 56000..64000
+    ok = ok && r.findAt(1, 15999) == -1;
+    ok = ok && start_of(r.findAt(1, 16000)) == 16000;
+    ok = ok && start_of(r.findAt(1, 31999)) == 24000;
+    ok = ok && r.findAt(1, 40000) == -1;
+    ok = ok && start_of(r.findAt(1, 60000)) == 56000;
+    // local: only 40000..48000
+    ok = ok && start_of(r.findAt(2, 45000)) == 40000;
+    ok = ok && r.findAt(2, 48000) == -1;
+    // bad track
+    ok = ok && r.findAt(3, 0) == -1;
+    // firstStartingAt
+    ok = ok && r.entry(r.firstStartingAt(16000)).start_ms == 16000;
+    ok = ok && r.entry(r.firstStartingAt(16001)).start_ms == 24000;
+    ok = ok && r.firstStartingAt(72001) == r.numEntries();
+    // trackSeek: the entry playing at ms, else the next one on the track
+    auto seek_start = [&](int t, int64_t ms) { return start_of(r.trackEntry(t, r.trackSeek(t, ms))); };
+    ok = ok && seek_start(1, 0) == 16000;
+    ok = ok && seek_start(1, 31999) == 24000;
+    ok = ok && seek_start(1, 32000) == 56000;
+    ok = ok && seek_start(0, 8000) == 8000;
+    ok = ok && r.trackSeek(1, 64000) == r.trackSize(1);
+    ok = ok && r.trackSize(2) == 1 && r.trackSize(3) == 0 && r.trackEntry(3, 0) == -1;
+
+    r.close();
+    remove(path.c_str());
+    if (ok) {
+        PASS();
+    } else {
+        FAIL("lookup returned the wrong interval");
+    }
+}
+
+// ============================================================
+// Test 3: writer never closed -> reader rebuilds the index
+// ============================================================
+static void test_recovery() {
+    TEST("index recovered from archive without footer");
+
+    const std::string path = temp_path("recover");
+    SessionArchiveWriter* w = new SessionArchiveWriter;
+    if (!w->open(path.c_str()) || !write_session(*w)) {
+        FAIL("writer setup failed");
+        delete w;
+        return;
+    }
+
+    // Writer is still open: the file has no INDX/footer and a zero-filled
+    // preallocated tail. The shared mapping makes the chunks visible.
+    SessionArchiveReader r;
+    const bool opened = open_reader(r, path);
+    const bool ok = opened && r.recovered() && r.numTracks() == 3 &&
+                    r.numEntries() == 14 && check_payloads(r) &&
+                    r.findAt(1, 60000) >= 0;
+    r.close();
+    delete w;
+    remove(path.c_str());
+    if (ok) {
+        PASS();
+    } else {
+        FAIL("recovery scan did not rebuild the index");
+    }
+}
+
+// ============================================================
+// Test 4: non-archive input and misuse are rejected
+// ============================================================
+static void test_rejects() {
+    TEST("rejects non-archive files and bad appends");
+
+    const std::string path = temp_path("junk");
+    FILE* fp = fopen(path.c_str(), "wb");
+    if (fp) { fputs("OggS this is not a session archive", fp); fclose(fp); }
+    SessionArchiveReader r;
+    const bool opened = open_reader(r, path);
+    remove(path.c_str());
+
+    SessionArchiveWriter w;
+    const unsigned char g[16] = {};
+    const unsigned char b = 1;
+    const bool closed_append = w.appendInterval(0, g, kOGGv, 0, kIntervalMs, &b, 1);
+    const bool closed_track = w.track("x", 0) >= 0;
+
+    const std::string path2 = temp_path("badtrack");
+    bool bad_track_append = true;
+    if (w.open(path2.c_str())) {
+        bad_track_append = w.appendInterval(5, g, kOGGv, 0, kIntervalMs, &b, 1);
+        w.close();
+    }
+    remove(path2.c_str());
+
+    if (!opened && !closed_append && !closed_track && !bad_track_append) {
+        PASS();
+    } else {
+        FAIL("invalid input accepted");
+    }
+}
+
+// ============================================================
+// Main
+// ============================================================
+int main() {
+    printf("=== Session Archive Tests ===\n\n");
+
+    test_roundtrip();
+    test_find_at();
+    test_recovery();
+    test_rejects();
+
+    printf("\n=== Results: %d/%d tests passed ===\n", tests_passed, tests_run);
+
+    return (tests_passed == tests_run) ? 0 : 1;
+}
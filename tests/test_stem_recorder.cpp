@@ -0,0 +1,396 @@
+/*
+    JamWide Plugin - test_stem_recorder.cpp
+    Live multitrack stem recorder (src/core/stem_recorder.h).
+
+    Covers what NJClient's /stems path relies on: nothing is recorded until
+    the next interval boundary; every stem file starts there and ends with
+    the same length, stems that start late or play only in places are
+    padded with silence at the right offsets; several stems are written in
+    parallel by the pool while each stem's audio stays in order; a stalled
+    dispatcher costs dropped blocks but never shifts the timeline; a stem
+    slot taken over by another peer starts a new file, a rename does not;
+    records from an earlier recording never reach the next one, and a
+    restart does not wait for the previous recording's files; a stem whose
+    file cannot be created is counted and the others carry on.
+*/
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "core/stem_recorder.h"
+
+using namespace jamwide;
+
+static int tests_run = 0;
+static int tests_passed = 0;
+
+#define TEST(name) \
+    do { \
+        tests_run++; \
+        printf("  TEST: %s ... ", name); \
+        fflush(stdout); \
+    } while(0)
+
+#define PASS() \
+    do { \
+        tests_passed++; \
+        printf("PASSED\n"); \
+    } while(0)
+
+#define FAIL(msg) \
+    do { \
+        printf("FAILED: %s\n", msg); \
+    } while(0)
+
+// Every file the recorder opened, by label (the recorder calls the factory
+// on its dispatcher thread and writes from the pool).
+struct CapturedAudio {
+    std::vector<float> l, r;
+    int finishes = 0;
+};
+
+struct Capture {
+    std::mutex mutex;
+    std::map<std::string, CapturedAudio> files;
+    std::atomic<int> writing{0};
+    std::atomic<int> max_writing{0};
+    int write_sleep_ms = 0;
+    std::atomic<bool>* gate = nullptr;   // factory waits for it
+    std::string fail_label;              // factory refuses this one
+
+    StemRecorder::SinkFactory factory();
+};
+
+class CaptureSink : public MasterRecorderSink {
+public:
+    CaptureSink(Capture* cap, CapturedAudio* out) : cap_(cap), out_(out) {}
+
+    bool write(const float* l, const float* r, int frames) override
+    {
+        const int now = ++cap_->writing;
+        int seen = cap_->max_writing.load();
+        while (now > seen && !cap_->max_writing.compare_exchange_weak(seen, now)) {}
+        if (cap_->write_sleep_ms)
+            std::this_thread::sleep_for(std::chrono::milliseconds(cap_->write_sleep_ms));
+        l_.insert(l_.end(), l, l + frames);
+        r_.insert(r_.end(), r, r + frames);
+        --cap_->writing;
+        return true;
+    }
+
+    void finish() override
+    {
+        std::lock_guard<std::mutex> lk(cap_->mutex);
+        out_->l = l_;
+        out_->r = r_;
+        out_->finishes++;
+    }
+
+private:
+    Capture* cap_;
+    CapturedAudio* out_;
+    std::vector<float> l_, r_;
+};
+
+StemRecorder::SinkFactory Capture::factory()
+{
+    return [this](int, const std::string& label) -> std::unique_ptr<MasterRecorderSink> {
+        while (gate && !gate->load()) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        if (label == fail_label) return nullptr;
+        std::lock_guard<std::mutex> lk(mutex);
+        return std::unique_ptr<MasterRecorderSink>(new CaptureSink(this, &files[label]));
+    };
+}
+
+// One block of a stem: value `v` in both channels (right negated).
+static bool pushConst(StemRecorder& rec, int gen, int stem, int offset, int frames, float v)
+{
+    std::vector<float> l(frames, v), r(frames, -v);
+    return rec.push(gen, stem, offset, l.data(), r.data(), frames);
+}
+
+// ============================================================
+// Test 1: Interval-aligned start, equal lengths, silence padding
+// ============================================================
+static void test_alignment() {
+    TEST("stems start on the interval, share one length, pad silence in place");
+
+    Capture cap;
+    StemRecorder rec;
+    rec.setStemName(0, "alice#0", "alice_0");
+    rec.setStemName(1, "bob#0", "bob_0");
+    bool ok = rec.start(cap.factory(), 2);
+
+    // Armed: the audio thread sees no generation until the boundary.
+    StemRecorderStats st;
+    rec.getStats(st);
+    ok = ok && st.armed && !st.recording && rec.beginBlock() == 0;
+
+    rec.onInterval();
+    const int kBlock = 512, kBlocks = 300;   // 153600 frames: a few chunks
+    int gen = 0;
+    for (int b = 0; b < kBlocks; b++) {
+        gen = rec.beginBlock();
+        if (!gen) { ok = false; break; }
+        pushConst(rec, gen, 0, 0, kBlock, (float) (b + 1));          // always
+        if (b >= 50 && b < 100)
+            pushConst(rec, gen, 1, 100, 200, 0.5f);                  // part of some blocks
+        if (b >= 200)
+            pushConst(rec, gen, 7, 0, kBlock, 0.25f);                // late, unnamed
+        rec.endBlock(gen, kBlock);
+        if (b % 20 == 0) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    rec.getStats(st);
+    ok = ok && st.recording && st.intervals == 1;
+    rec.stopAndWait();
+    rec.getStats(st);
+
+    const size_t total = (size_t) kBlock * kBlocks;
+    std::lock_guard<std::mutex> lk(cap.mutex);
+    ok = ok && cap.files.size() == 3 && st.stems == 3 && st.length_frames == total;
+    ok = ok && st.blocks_dropped == 0 && st.sink_errors == 0 && !st.finishing;
+    for (auto& f : cap.files)
+        ok = ok && f.second.finishes == 1 && f.second.l.size() == total && f.second.r.size() == total;
+
+    const CapturedAudio& a = cap.files["alice_0"];
+    for (size_t i = 0; ok && i < a.l.size(); i++)
+        ok = a.l[i] == (float) (i / kBlock + 1) && a.r[i] == -a.l[i];
+
+    const CapturedAudio& b = cap.files["bob_0"];
+    for (size_t i = 0; ok && i < b.l.size(); i++) {
+        const size_t blk = i / kBlock, off = i % kBlock;
+        const bool on = blk >= 50 && blk < 100 && off >= 100 && off < 300;
+        ok = b.l[i] == (on ? 0.5f : 0.0f);
+    }
+
+    const CapturedAudio& c = cap.files["stem7"];
+    for (size_t i = 0; ok && i < c.l.size(); i++)
+        ok = c.l[i] == (i >= 200u * kBlock ? 0.25f : 0.0f);
+
+    if (ok) {
+        PASS();
+    } else {
+        FAIL("lengths, offsets or padding wrong");
+    }
+}
+
+// ============================================================
+// Test 2: Parallel encode, per-stem order
+// ============================================================
+static void test_parallel_pool() {
+    TEST("pool writes stems in parallel, each stem in order");
+
+    Capture cap;
+    cap.write_sleep_ms = 5;   // a slow encoder
+    StemRecorder rec;
+    const int kStems = 8;
+    for (int s = 0; s < kStems; s++) {
+        const std::string n = "peer" + std::to_string(s);
+        rec.setStemName(s, n, n);
+    }
+    bool ok = rec.start(cap.factory(), 4);
+    rec.onInterval();
+
+    const int kBlock = 1024, kBlocks = 300;
+    std::vector<float> l(kBlock), r(kBlock);
+    for (int b = 0; b < kBlocks; b++) {
+        const int gen = rec.beginBlock();
+        for (int s = 0; s < kStems; s++) {
+            for (int i = 0; i < kBlock; i++) {
+                l[i] = (float) (b * kBlock + i);
+                r[i] = (float) s;
+            }
+            ok = rec.push(gen, s, 0, l.data(), r.data(), kBlock) && ok;
+        }
+        rec.endBlock(gen, kBlock);
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    StemRecorderStats st;
+    rec.getStats(st);
+    ok = ok && st.workers == 4;
+    rec.stopAndWait();
+    rec.getStats(st);
+
+    std::lock_guard<std::mutex> lk(cap.mutex);
+    ok = ok && (int) cap.files.size() == kStems;
+    for (int s = 0; ok && s < kStems; s++) {
+        const CapturedAudio& f = cap.files["peer" + std::to_string(s)];
+        ok = f.finishes == 1 && f.l.size() == (size_t) kBlock * kBlocks;
+        for (size_t i = 0; ok && i < f.l.size(); i++)
+            ok = f.l[i] == (float) i && f.r[i] == (float) s;
+    }
+    ok = ok && cap.max_writing.load() >= 2;
+    ok = ok && st.chunks_encoded >= (uint64_t) kStems * 4 && st.blocks_dropped == 0;
+    ok = ok && st.max_backlog_frames > 0 && st.workers == 0;
+
+    if (ok) {
+        PASS();
+    } else {
+        FAIL("stems reordered, incomplete or written serially");
+    }
+}
+
+// ============================================================
+// Test 3: Stalled dispatcher -> drops, timeline intact
+// ============================================================
+static void test_stall_keeps_timeline() {
+    TEST("a full ring drops stem blocks but every file keeps the full length");
+
+    Capture cap;
+    std::atomic<bool> gate{false};
+    cap.gate = &gate;                 // first file creation blocks the dispatcher
+    StemRecorder rec(64 * 1024);
+    bool ok = rec.start(cap.factory(), 2);
+    rec.onInterval();
+
+    const int kBlock = 256;
+    int blocks = 0, refused = 0;
+    for (; blocks < 2000 && refused < 20; blocks++) {
+        const int gen = rec.beginBlock();
+        if (!pushConst(rec, gen, 0, 0, kBlock, 1.0f)) refused++;
+        if (!pushConst(rec, gen, 1, 0, kBlock, 1.0f)) refused++;
+        rec.endBlock(gen, kBlock);
+    }
+    gate.store(true);
+    for (int i = 0; i < 50; i++, blocks++) {
+        const int gen = rec.beginBlock();
+        pushConst(rec, gen, 0, 0, kBlock, 2.0f);
+        pushConst(rec, gen, 1, 0, kBlock, 2.0f);
+        rec.endBlock(gen, kBlock);
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    rec.stopAndWait();
+
+    StemRecorderStats st;
+    rec.getStats(st);
+    const size_t total = (size_t) kBlock * blocks;
+    std::lock_guard<std::mutex> lk(cap.mutex);
+    ok = ok && refused >= 20 && st.blocks_dropped >= 20 && cap.files.size() == 2;
+    ok = ok && st.length_frames == total;
+    for (auto& f : cap.files) {
+        ok = ok && f.second.l.size() == total;
+        // Whatever survived is block-aligned: never a partial block.
+        for (size_t i = 0; ok && i < f.second.l.size(); i += kBlock) {
+            const float v = f.second.l[i];
+            for (size_t j = i; ok && j < i + kBlock; j++) ok = f.second.l[j] == v;
+        }
+        // The tail after the stall made it in.
+        ok = ok && f.second.l[total - 1] == 2.0f;
+    }
+
+    if (ok) {
+        PASS();
+    } else {
+        FAIL("timeline shifted or lengths differ after drops");
+    }
+}
+
+// ============================================================
+// Test 4: Generations, slot reuse and failed files
+// ============================================================
+static void test_generations_and_names() {
+    TEST("slot reuse opens a new file, rename does not, stale records discarded");
+
+    Capture cap;
+    cap.fail_label = "broken";
+    StemRecorder rec;
+    bool ok = rec.start(cap.factory(), 1);
+    rec.onInterval();
+    const int gen1 = rec.beginBlock();
+    rec.stopAndWait();
+    // The audio thread still held gen1 for this block.
+    pushConst(rec, gen1, 0, 0, 64, 9.0f);
+    rec.endBlock(gen1, 64);
+    ok = ok && rec.beginBlock() == 0;
+
+    rec.setStemName(0, "carol#0", "carol_0");
+    rec.setStemName(3, "x#0", "broken");
+    ok = ok && rec.start(cap.factory(), 2);
+    rec.onInterval();
+    const int gen2 = rec.beginBlock();
+    ok = ok && gen2 > 0 && gen2 != gen1;
+
+    const int kBlock = 128;
+    for (int b = 0; b < 30; b++) {
+        // Let the dispatcher catch up so the renames land between blocks.
+        if (b % 5 == 0) std::this_thread::sleep_for(std::chrono::milliseconds(30));
+        const int gen = rec.beginBlock();
+        if (b == 10) rec.setStemName(0, "carol#0", "carol_renamed");   // same peer
+        if (b == 20) rec.setStemName(0, "dave#0", "dave_0");           // slot reused
+        pushConst(rec, gen, 0, 0, kBlock, b < 20 ? 1.0f : 3.0f);
+        pushConst(rec, gen, 3, 0, kBlock, 1.0f);
+        rec.endBlock(gen, kBlock);
+    }
+    rec.stopAndWait();
+
+    StemRecorderStats st;
+    rec.getStats(st);
+    const size_t total = (size_t) kBlock * 30;
+    std::lock_guard<std::mutex> lk(cap.mutex);
+    ok = ok && cap.files.size() == 2 && cap.files.count("carol_0") && cap.files.count("dave_0");
+    ok = ok && st.stems == 3 && st.sink_errors == 1;
+    const CapturedAudio& c = cap.files["carol_0"];
+    const CapturedAudio& d = cap.files["dave_0"];
+    ok = ok && c.l.size() == total && d.l.size() == total;
+    for (size_t i = 0; ok && i < total; i++) {
+        const bool early = i < 20u * kBlock;
+        ok = c.l[i] == (early ? 1.0f : 0.0f) && d.l[i] == (early ? 0.0f : 3.0f);
+    }
+
+    // A restart over a recording stuck creating its file returns at once
+    // and arms only after that recording has been written out.
+    Capture stuck, next;
+    std::atomic<bool> gate{false};
+    stuck.gate = &gate;
+    ok = ok && rec.start(stuck.factory(), 1);
+    rec.onInterval();
+    int gen = rec.beginBlock();
+    pushConst(rec, gen, 0, 0, kBlock, 5.0f);
+    rec.endBlock(gen, kBlock);
+    std::this_thread::sleep_for(std::chrono::milliseconds(3 * StemRecorder::kWakeMs));
+    ok = ok && rec.start(next.factory(), 1) && !rec.active();
+    gate.store(true);
+    for (int i = 0; i < 5000 && !rec.active(); i++)
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    rec.onInterval();
+    gen = rec.beginBlock();
+    ok = ok && gen > 0;
+    pushConst(rec, gen, 0, 0, kBlock, 6.0f);
+    rec.endBlock(gen, kBlock);
+    rec.stopAndWait();
+    {
+        std::lock_guard<std::mutex> lk2(stuck.mutex);
+        std::lock_guard<std::mutex> lk3(next.mutex);
+        ok = ok && stuck.files.size() == 1 && next.files.size() == 1;
+        const CapturedAudio& s = stuck.files["dave_0"];
+        const CapturedAudio& n = next.files["dave_0"];
+        ok = ok && s.finishes == 1 && s.l.size() == (size_t) kBlock && s.l[0] == 5.0f;
+        ok = ok && n.finishes == 1 && n.l.size() == (size_t) kBlock && n.l[0] == 6.0f;
+    }
+
+    if (ok) {
+        PASS();
+    } else {
+        FAIL("wrong files, stale audio or errors not counted");
+    }
+}
+
+int main() {
+    printf("=== Stem Recorder Tests ===\n\n");
+
+    test_alignment();
+    test_parallel_pool();
+    test_stall_keeps_timeline();
+    test_generations_and_names();
+
+    printf("\n=== Results: %d/%d tests passed ===\n", tests_passed, tests_run);
+
+    return (tests_passed == tests_run) ? 0 : 1;
+}
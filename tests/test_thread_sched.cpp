@@ -0,0 +1,219 @@
+/*
+    JamWide Plugin - test_thread_sched.cpp
+    Run-thread scheduling helpers (src/core/thread_sched.h).
+
+    Runs each request on a scratch thread so the test process keeps its own
+    scheduling. Checks that a nice value is applied and reverted, that a
+    real-time request either takes effect or falls back to default with the
+    refusal recorded (CI usually lacks RLIMIT_RTPRIO), that an affinity mask
+    pins the thread and 0 restores the set it started with, and the policy
+    names / status line.
+*/
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <thread>
+
+#include "core/thread_sched.h"
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+using namespace jamwide;
+
+static int tests_run = 0;
+static int tests_passed = 0;
+
+#define TEST(name) \
+    do { \
+        tests_run++; \
+        printf("  TEST: %s ... ", name); \
+        fflush(stdout); \
+    } while(0)
+
+#define PASS() \
+    do { \
+        tests_passed++; \
+        printf("PASSED\n"); \
+    } while(0)
+
+#define FAIL(msg) \
+    do { \
+        printf("FAILED: %s\n", msg); \
+    } while(0)
+
+template <typename F>
+static void onScratchThread(F&& f)
+{
+    std::thread t(std::forward<F>(f));
+    t.join();
+}
+
+// ============================================================
+// Test 1: nice value and back
+// ============================================================
+static void test_nice() {
+    TEST("nice policy applies and default reverts it");
+
+    bool ok = true;
+    onScratchThread([&] {
+        ThreadSchedConfig cfg;
+        cfg.policy = kSchedNice;
+        cfg.priority = 5;   // lowering priority never needs privileges
+        ThreadSchedStatus s;
+        ok = applyThreadSched(cfg, &s) && s.policy == kSchedNice && s.priority == 5;
+#if defined(__linux__)
+        const id_t tid = (id_t)syscall(SYS_gettid);
+        ok = ok && getpriority(PRIO_PROCESS, tid) == 5;
+        // Undoing it lowers the nice value again, which needs CAP_SYS_NICE;
+        // either way the status must say what is in effect.
+        cfg.policy = kSchedDefault;
+        const bool reverted = applyThreadSched(cfg, &s);
+        ok = ok && (reverted ? getpriority(PRIO_PROCESS, tid) == 0 && s.policy == kSchedDefault
+                             : s.sched_error != 0);
+#endif
+    });
+
+    if (ok) {
+        PASS();
+    } else {
+        FAIL("nice not applied or status wrong");
+    }
+}
+
+// ============================================================
+// Test 2: real-time request, applied or refused cleanly
+// ============================================================
+static void test_realtime_or_fallback() {
+    TEST("fifo request takes effect or falls back with the error recorded");
+
+    bool ok = true;
+    std::string line;
+    onScratchThread([&] {
+        ThreadSchedConfig cfg;
+        cfg.policy = kSchedFifo;
+        cfg.priority = 500;   // clamped to the policy maximum
+        ThreadSchedStatus s;
+        const bool applied = applyThreadSched(cfg, &s);
+        char buf[160];
+        describeThreadSched(s, buf, sizeof(buf));
+        line = buf;
+        if (applied) {
+            ok = s.policy == kSchedFifo && s.priority >= 1 && s.priority <= 99 && s.sched_error == 0;
+#if defined(__linux__)
+            int pol = -1;
+            sched_param sp{};
+            pthread_getschedparam(pthread_self(), &pol, &sp);
+            ok = ok && pol == SCHED_FIFO && sp.sched_priority == s.priority;
+#endif
+        } else {
+            ok = s.policy == kSchedDefault && s.sched_error != 0 &&
+                 s.requested_policy == kSchedFifo && line.find("refused") != std::string::npos;
+        }
+    });
+
+    if (ok) {
+        PASS();
+    } else {
+        FAIL(line.c_str());
+    }
+}
+
+// ============================================================
+// Test 3: affinity
+// ============================================================
+static void test_affinity() {
+    TEST("cpu mask pins the thread; 0 restores its original set");
+
+    bool ok = true;
+#if defined(__linux__)
+    onScratchThread([&] {
+        cpu_set_t orig;
+        CPU_ZERO(&orig);
+        pthread_getaffinity_np(pthread_self(), sizeof(orig), &orig);
+
+        ThreadSchedConfig cfg;
+        cfg.cpu_mask = 1;   // CPU 0
+        ThreadSchedStatus s;
+        ok = applyThreadSched(cfg, &s) && s.cpu_mask == 1 && s.affinity_error == 0;
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        pthread_getaffinity_np(pthread_self(), sizeof(set), &set);
+        ok = ok && CPU_COUNT(&set) == 1 && CPU_ISSET(0, &set);
+
+        cfg.cpu_mask = 0;
+        ok = ok && applyThreadSched(cfg, &s) && s.cpu_mask == 0;
+        CPU_ZERO(&set);
+        pthread_getaffinity_np(pthread_self(), sizeof(set), &set);
+        ok = ok && CPU_EQUAL(&set, &orig);
+    });
+#endif
+
+    if (ok) {
+        PASS();
+    } else {
+        FAIL("affinity not applied/released");
+    }
+}
+
+// ============================================================
+// Test 4: names, parsing, status line, memory locking
+// ============================================================
+static void test_names_and_status() {
+    TEST("policy names round-trip; status line; lockMemory reports");
+
+    bool ok = true;
+    for (int p = kSchedDefault; p <= kSchedFifo; p++) {
+        int back = -1;
+        ok = ok && parseSchedPolicy(schedPolicyName(p), &back) && back == p;
+    }
+    int dummy = 0;
+    ok = ok && !parseSchedPolicy("batch", &dummy);
+
+    ThreadSchedStatus s;
+    s.policy = kSchedRoundRobin;
+    s.priority = 20;
+    s.cpu_mask = 0x3;
+    s.locked_bytes = 3 * 1024 * 1024 / 2;
+    char buf[160];
+    describeThreadSched(s, buf, sizeof(buf));
+    ok = ok && !strcmp(buf, "rr 20, cpus 0x3, mlock 1536KB");
+
+    // Tiny buffer: truncated, still terminated.
+    char tiny[6];
+    describeThreadSched(s, tiny, sizeof(tiny));
+    ok = ok && strlen(tiny) == 5;
+
+    static char block[64 * 1024];
+    const int err = lockMemory(block, sizeof(block));
+    if (!err) unlockMemory(block, sizeof(block));
+    ok = ok && lockMemory(nullptr, 0) == 0;
+
+    if (ok) {
+        PASS();
+    } else {
+        FAIL(buf);
+    }
+}
+
+// ============================================================
+// Main
+// ============================================================
+int main() {
+    printf("=== Thread Sched Tests ===\n\n");
+
+    test_nice();
+    test_realtime_or_fallback();
+    test_affinity();
+    test_names_and_status();
+
+    printf("\n=== Results: %d/%d tests passed ===\n", tests_passed, tests_run);
+
+    return (tests_passed == tests_run) ? 0 : 1;
+}
@@ -32,6 +32,7 @@ JNL_Connection::JNL_Connection(JNL_IAsyncDNS *dns, int sendbufsize, int recvbufs
   m_remote_port=0;
   m_state=STATE_NOCONNECTION;
   m_localinterfacereq=INADDR_ANY;
+  m_sock_sndbuf=m_sock_rcvbuf=0;
   m_recv_len=m_recv_pos=0;
   m_send_len=m_send_pos=0;
   m_host[0]=0;
@@ -79,6 +80,10 @@ void JNL_Connection::connect(const char *hostname, int port)
       sa.sin_addr.s_addr=m_localinterfacereq;
       bind(m_socket,(struct sockaddr *)&sa,16);
     }
+    if (m_sock_sndbuf > 0)
+      setsockopt(m_socket,SOL_SOCKET,SO_SNDBUF,(const char *)&m_sock_sndbuf,sizeof(m_sock_sndbuf));
+    if (m_sock_rcvbuf > 0)
+      setsockopt(m_socket,SOL_SOCKET,SO_RCVBUF,(const char *)&m_sock_rcvbuf,sizeof(m_sock_rcvbuf));
     SET_SOCK_DEFAULTS(m_socket);
     SET_SOCK_BLOCK(m_socket,0);
     lstrcpyn_safe(m_host,hostname,sizeof(m_host));
@@ -391,6 +396,22 @@ int JNL_Connection::peek_bytes(void *data, int maxlength)
   return maxlength;
 }
 
+int JNL_Connection::peek_contiguous(const void **data)
+{
+  int read_pos=m_recv_pos-m_recv_len;
+  if (read_pos < 0)
+  {
+    read_pos += m_recv_buffer.GetSize();
+  }
+  int len=m_recv_buffer.GetSize()-read_pos;
+  if (len > m_recv_len)
+  {
+    len=m_recv_len;
+  }
+  *data=len > 0 ? m_recv_buffer.Get()+read_pos : NULL;
+  return len > 0 ? len : 0;
+}
+
 int JNL_Connection::recv_bytes(void *_data, int maxlength)
 {
   char *data = static_cast<char *>(_data);
@@ -94,6 +94,9 @@ class JNL_IConnection
                                               // the connection has.)
     virtual int recv_get_linelen()=0; // length in bytes for current line (including \r and/or \n), or 0 if no newline in buffer
     virtual int peek_bytes(void *data, int maxlength)=0; // returns bytes peeked
+    // points *data at the next contiguous run of received bytes without copying (valid until the next
+    // run()/recv call) and returns its length. 0 = nothing buffered or not supported; use peek_bytes().
+    virtual int peek_contiguous(const void **data) { *data=NULL; return 0; }
 
     virtual unsigned int get_interface(void)=0;        // this returns the interface the connection is on
     virtual unsigned int get_remote(void)=0; // remote host ip.
@@ -154,6 +157,7 @@ class JNL_Connection JNL_Connection_PARENTDEF
                                               // the connection has.)
     int recv_get_linelen();                   // length in bytes for current line (including \r and/or \n), or 0 if no newline in buffer
     int peek_bytes(void *data, int maxlength); // returns bytes peeked
+    int peek_contiguous(const void **data);
 
     unsigned int get_interface(void);        // this returns the interface the connection is on
     unsigned int get_remote(void); // remote host ip.
@@ -161,6 +165,11 @@ class JNL_Connection JNL_Connection_PARENTDEF
   
     void set_interface(int useInterface); // call before connect if needed
 
+    // Kernel SO_SNDBUF/SO_RCVBUF in bytes, applied by connect(hostname,port)
+    // before the TCP handshake so the window scale can reflect them.
+    // 0 leaves the OS default (and, on Linux, receive autotuning) alone.
+    void set_socket_buffers(int sndbuf, int rcvbuf) { m_sock_sndbuf=sndbuf; m_sock_rcvbuf=rcvbuf; }
+
     SOCKET get_socket() const { return m_socket; }
 
   protected:
@@ -175,6 +184,7 @@ class JNL_Connection JNL_Connection_PARENTDEF
     int  m_send_len;
 
     int m_localinterfacereq;
+    int m_sock_sndbuf, m_sock_rcvbuf;
     struct sockaddr_in *m_saddr;
     char m_host[256];
 
@@ -0,0 +1,355 @@
+/*
+    WDL - opusencdec.h
+    Copyright (C) 2026 and later, JamWide contributors
+
+    Opus encoding/decoding classes implementing the I_NJEncoder/I_NJDecoder
+    interfaces defined in vorbisencdec.h. Uses the libopus C API directly
+    (no Ogg container) with a minimal length-prefixed packet framing.
+
+    These classes mirror the FlacEncoder/FlacDecoder structure (NJ-prefixed
+    because libopus already owns the OpusEncoder/OpusDecoder type names):
+    - NJOpusEncoder writes compressed output to WDL_Queue outqueue
+    - NJOpusDecoder reads compressed input from WDL_Queue, outputs float samples
+
+    Usage: #include this file after vorbisencdec.h has been included
+    (or after VorbisEncoderInterface/VorbisDecoderInterface are declared).
+
+    Stream layout (one stream per NINJAM interval, like the FLAC STREAMINFO
+    header, so every interval is independently decodable):
+      19-byte ID header laid out like RFC 7845 "OpusHead":
+        "OpusHead" | version(1) | channels(1) | pre-skip(u16 LE)
+        | input rate(u32 LE) | output gain(s16 LE, always 0) | mapping(1, 0)
+      then zero or more packets, each prefixed by its byte length (u16 LE).
+
+    Configuration:
+    - Codec rate: the host rate if libopus supports it natively
+      (8/12/16/24/48 kHz), otherwise 48 kHz with a linear-interpolation
+      resampler in front of the encoder. The decoder always runs at 48 kHz
+      and reports that via GetSampleRate(); mixInChannel's existing resampler
+      converts to the host rate.
+    - Frame size: 20 ms by default. Live (instamode) channels pass a shorter
+      frame (2.5-20 ms) to the constructor, trading bitrate efficiency for
+      latency. Frame durations are snapped to the set libopus accepts.
+*/
+
+#ifndef _OPUSENCDEC_H_
+#define _OPUSENCDEC_H_
+
+#include "opus.h"
+#include "queue.h"
+
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#define OPUSENCDEC_HEADER_SIZE 19
+#define OPUSENCDEC_MAX_PACKET 1500        // > 1275 (largest single Opus frame)
+#define OPUSENCDEC_MAX_FRAME_48K 5760     // 120 ms at 48 kHz
+#define OPUSENCDEC_PLC_FRAME_48K 960      // 20 ms: concealment before any packet
+
+static inline bool OpusIsNativeRate(int srate)
+{
+    return srate == 8000 || srate == 12000 || srate == 16000 ||
+           srate == 24000 || srate == 48000;
+}
+
+class NJOpusEncoder : public VorbisEncoderInterface {
+public:
+    // frame_ms: requested frame duration in milliseconds. Snapped down to the
+    // nearest libopus frame size (2.5, 5, 10, 20); anything else -> 20 ms.
+    NJOpusEncoder(int srate, int nch, int bitrate, int /*serno*/, double frame_ms=20.0)
+    {
+        m_nch = nch < 1 ? 1 : nch > 2 ? 2 : nch;
+        m_in_srate = srate;
+        m_codec_srate = OpusIsNativeRate(srate) ? srate : 48000;
+        m_err = 0;
+        m_encoder = nullptr;
+
+        if (frame_ms >= 20.0) frame_ms = 20.0;
+        else if (frame_ms >= 10.0) frame_ms = 10.0;
+        else if (frame_ms >= 5.0) frame_ms = 5.0;
+        else frame_ms = 2.5;
+        m_frame_size = (int)(m_codec_srate * frame_ms / 1000.0);
+
+        // bitrate arrives in kbps, same units as VorbisEncoder. libopus
+        // accepts 6..510 kbps.
+        int bps = bitrate * 1000;
+        if (bps < 6000) bps = 6000;
+        if (bps > 510000) bps = 510000;
+        m_bitrate = bps;
+
+        int e = 0;
+        m_encoder = opus_encoder_create(m_codec_srate, m_nch,
+            frame_ms < 10.0 ? OPUS_APPLICATION_RESTRICTED_LOWDELAY : OPUS_APPLICATION_AUDIO, &e);
+        if (!m_encoder || e != OPUS_OK) { m_err = 1; return; }
+
+        opus_encoder_ctl(m_encoder, OPUS_SET_BITRATE(m_bitrate));
+        opus_encoder_ctl(m_encoder, OPUS_SET_VBR(1));
+
+        opus_int32 lookahead = 0;
+        opus_encoder_ctl(m_encoder, OPUS_GET_LOOKAHEAD(&lookahead));
+        // pre-skip is always expressed at 48 kHz (RFC 7845 §5.1)
+        m_preskip = (int)((opus_int64)lookahead * 48000 / m_codec_srate);
+
+        m_pcm.reserve((size_t)(m_frame_size * m_nch * 4));
+        resetResampler();
+        writeHeader();
+    }
+
+    ~NJOpusEncoder()
+    {
+        if (m_encoder) opus_encoder_destroy(m_encoder);
+    }
+
+    void Encode(float *in, int inlen, int advance=1, int spacing=1) override
+    {
+        if (m_err || !m_encoder) return;
+
+        if (inlen == 0) {
+            // End-of-stream: zero-pad the partial frame plus the encoder
+            // lookahead so the tail of the interval is not cut off.
+            const int pending = (int)(m_pcm.size() / m_nch);
+            int pad = m_frame_size - (pending % m_frame_size);
+            if (pad == m_frame_size && !pending) pad = 0;
+            pad += m_frame_size;
+            m_pcm.resize(m_pcm.size() + (size_t)pad * m_nch, 0.0f);
+            flushFrames();
+            m_pcm.clear();
+            return;
+        }
+
+        // Same advance/spacing calling convention as FlacEncoder:
+        //   mono:               advance=1, spacing=1 (or 0)
+        //   stereo interleaved: advance=2, spacing=1
+        //   stereo planar:      advance=1, spacing=N
+        for (int i = 0, idx = 0; i < inlen; i++, idx += advance) {
+            float s[2];
+            s[0] = in[idx];
+            s[1] = m_nch > 1 ? in[idx + spacing] : 0.0f;
+
+            if (m_codec_srate == m_in_srate) {
+                for (int c = 0; c < m_nch; c++) m_pcm.push_back(s[c]);
+                continue;
+            }
+
+            // linear interpolation from m_in_srate to m_codec_srate. m_rs_pos
+            // is the next output position in [0,1) between m_rs_last and s.
+            while (m_rs_pos < 1.0) {
+                const float f = (float)m_rs_pos;
+                for (int c = 0; c < m_nch; c++)
+                    m_pcm.push_back(m_rs_last[c] + (s[c] - m_rs_last[c]) * f);
+                m_rs_pos += m_rs_step;
+            }
+            m_rs_pos -= 1.0;
+            m_rs_last[0] = s[0];
+            m_rs_last[1] = s[1];
+        }
+
+        flushFrames();
+    }
+
+    int isError() override { return m_err; }
+    int Available() override { return outqueue.Available(); }
+    void *Get() override { return outqueue.Get(); }
+    void Advance(int amt) override { outqueue.Advance(amt); }
+    void Compact() override { outqueue.Compact(); }
+
+    void reinit(int bla=0) override
+    {
+        if (!bla) {
+            // Drop any stale tail so the next interval starts with a fresh
+            // ID header (same rationale as FlacEncoder::reinit).
+            outqueue.Advance(outqueue.Available());
+            outqueue.Compact();
+            m_pcm.clear();
+            resetResampler();
+
+            if (m_encoder) {
+                opus_encoder_ctl(m_encoder, OPUS_RESET_STATE);
+                m_err = 0;
+                writeHeader();
+            }
+        }
+    }
+
+    WDL_Queue outqueue;
+
+private:
+    void resetResampler()
+    {
+        m_rs_step = (double)m_in_srate / (double)m_codec_srate;
+        m_rs_pos = 0.0;
+        m_rs_last[0] = m_rs_last[1] = 0.0f;
+    }
+
+    void writeHeader()
+    {
+        unsigned char h[OPUSENCDEC_HEADER_SIZE];
+        memcpy(h, "OpusHead", 8);
+        h[8] = 1;
+        h[9] = (unsigned char)m_nch;
+        h[10] = (unsigned char)(m_preskip & 0xff);
+        h[11] = (unsigned char)((m_preskip >> 8) & 0xff);
+        h[12] = (unsigned char)(m_in_srate & 0xff);
+        h[13] = (unsigned char)((m_in_srate >> 8) & 0xff);
+        h[14] = (unsigned char)((m_in_srate >> 16) & 0xff);
+        h[15] = (unsigned char)((m_in_srate >> 24) & 0xff);
+        h[16] = 0;
+        h[17] = 0;
+        h[18] = 0;
+        outqueue.Add(h, OPUSENCDEC_HEADER_SIZE);
+    }
+
+    void flushFrames()
+    {
+        const size_t frame_len = (size_t)m_frame_size * m_nch;
+        size_t rd = 0;
+        while (m_pcm.size() - rd >= frame_len) {
+            unsigned char pkt[OPUSENCDEC_MAX_PACKET];
+            const opus_int32 n = opus_encode_float(m_encoder, m_pcm.data() + rd,
+                m_frame_size, pkt, (opus_int32)sizeof(pkt));
+            rd += frame_len;
+            if (n < 0) { m_err = 1; break; }
+
+            unsigned char lenbuf[2] = {
+                (unsigned char)(n & 0xff), (unsigned char)((n >> 8) & 0xff) };
+            outqueue.Add(lenbuf, 2);
+            if (n > 0) outqueue.Add(pkt, n);
+        }
+        if (rd) m_pcm.erase(m_pcm.begin(), m_pcm.begin() + (std::ptrdiff_t)rd);
+    }
+
+    ::OpusEncoder *m_encoder;
+    int m_nch, m_in_srate, m_codec_srate, m_frame_size, m_bitrate, m_preskip, m_err;
+
+    std::vector<float> m_pcm;  // interleaved, at m_codec_srate
+    double m_rs_step, m_rs_pos;
+    float m_rs_last[2];
+};
+
+
+class NJOpusDecoder : public VorbisDecoderInterface {
+public:
+    NJOpusDecoder()
+    {
+        m_nch = 0;
+        m_preskip_left = 0;
+        m_err = 0;
+        m_inited = false;
+        m_frame = OPUSENCDEC_PLC_FRAME_48K;
+
+        // 15.1-08 CR-11 mitigation (same contract as FlacDecoder): pre-grow
+        // the compressed-byte and float-sample queues on the run thread so
+        // the audio-thread DecodeWrote path does not realloc in steady state.
+        m_inbuf.Prealloc(16384);
+        m_outbuf.Prealloc(OPUSENCDEC_MAX_FRAME_48K * 2 * 2);
+
+        // The decoder state is allocated here (run thread), sized for
+        // stereo, and only initialized in place once the header names the
+        // channel count: opus_decoder_init never allocates.
+        const int sz = opus_decoder_get_size(2);
+        m_decoder = sz > 0 ? (::OpusDecoder *)malloc((size_t)sz) : nullptr;
+        if (!m_decoder) m_err = 1;
+    }
+
+    ~NJOpusDecoder()
+    {
+        free(m_decoder);
+    }
+
+    int GetSampleRate() override { return 48000; }
+    int GetNumChannels() override { return m_nch ? m_nch : 1; }
+
+    void *DecodeGetSrcBuffer(int srclen) override
+    {
+        return m_inbuf.Add(nullptr, srclen);
+    }
+
+    void DecodeWrote(int srclen) override
+    {
+        (void)srclen;
+        if (m_err) return;
+
+        if (!m_inited) {
+            if (m_inbuf.Available() < OPUSENCDEC_HEADER_SIZE) return;
+            const unsigned char *h = (const unsigned char *)m_inbuf.Get();
+            if (memcmp(h, "OpusHead", 8) || (h[9] != 1 && h[9] != 2)) {
+                m_err = 1;
+                return;
+            }
+            m_nch = h[9];
+            m_preskip_left = h[10] | (h[11] << 8);
+            m_inbuf.Advance(OPUSENCDEC_HEADER_SIZE);
+
+            if (opus_decoder_init(m_decoder, 48000, m_nch) != OPUS_OK) { m_err = 1; return; }
+            m_inited = true;
+        }
+
+        for (;;) {
+            const int avail = m_inbuf.Available();
+            if (avail < 2) break;
+            const unsigned char *p = (const unsigned char *)m_inbuf.Get();
+            const int plen = p[0] | (p[1] << 8);
+            if (plen > OPUSENCDEC_MAX_PACKET) { m_err = 1; break; }
+            if (avail < 2 + plen) break;
+
+            // zero-length packet = lost/DTX frame; let libopus conceal one
+            // frame of the size last seen (PLC fills whatever frame_size it
+            // is given, so the 120 ms ceiling would stretch the interval).
+            int n = opus_decode_float(m_decoder, plen ? p + 2 : nullptr, plen,
+                m_scratch, plen ? OPUSENCDEC_MAX_FRAME_48K : m_frame, 0);
+            if (n > 0 && plen) m_frame = n;
+            if (n > 0) {
+                int skip = 0;
+                if (m_preskip_left > 0) {
+                    skip = n < m_preskip_left ? n : m_preskip_left;
+                    m_preskip_left -= skip;
+                }
+                if (n > skip)
+                    m_outbuf.Add(m_scratch + skip * m_nch, (n - skip) * m_nch);
+            }
+            m_inbuf.Advance(2 + plen);
+        }
+        m_inbuf.Compact();
+    }
+
+    void Reset() override
+    {
+        m_inbuf.Advance(m_inbuf.Available());
+        m_inbuf.Compact();
+        m_outbuf.Clear();
+        m_inited = false;
+        m_frame = OPUSENCDEC_PLC_FRAME_48K;
+        m_nch = 0;
+        m_preskip_left = 0;
+        m_err = m_decoder ? 0 : 1;
+    }
+
+    int Available() override { return m_outbuf.Available(); }
+    float *Get() override { return m_outbuf.Get(); }
+
+    void Skip(int amt) override
+    {
+        m_outbuf.Advance(amt);
+        m_outbuf.Compact();
+    }
+
+    int GenerateLappingSamples() override
+    {
+        // Opus frames carry their own overlap internally; nothing to flush.
+        // NINJAM's overlapFadeState handles cross-fade at DecodeState level.
+        return 0;
+    }
+
+private:
+    ::OpusDecoder *m_decoder;   // opus_decoder_get_size(2) bytes, malloc'd once
+    WDL_Queue m_inbuf;
+    WDL_TypedQueue<float> m_outbuf;
+    int m_nch, m_preskip_left, m_err;
+    bool m_inited;
+    int m_frame;                // samples per packet last decoded (PLC length)
+    float m_scratch[OPUSENCDEC_MAX_FRAME_48K * 2];
+};
+
+#endif // _OPUSENCDEC_H_